@@ -11,9 +11,154 @@
 #include "vaBenchmarkTool.h"
 #include "..\System\vaFileStream.h"
 #include "..\vaStringTools.h"
+#include "..\System\vaFileTools.h"
+
+#include <algorithm>
 
 using namespace Vanilla;
 
+namespace
+{
+    // linear interpolation between closest ranks; sorted must not be empty
+    float Percentile( const std::vector<float> & sorted, double fraction )
+    {
+        const double position = fraction * ( sorted.size( ) - 1 );
+        const size_t index = (size_t)position;
+        if( index + 1 >= sorted.size( ) )
+            return sorted.back( );
+        return (float)( sorted[index] + ( sorted[index + 1] - sorted[index] ) * ( position - index ) );
+    }
+
+    void MeanAndStdDev( const float * values, size_t count, double & outMean, double & outStdDev )
+    {
+        double sum = 0.0;
+        for( size_t i = 0; i < count; i++ )
+            sum += values[i];
+        outMean = ( count > 0 ) ? ( sum / count ) : ( 0.0 );
+        double sumSq = 0.0;
+        for( size_t i = 0; i < count; i++ )
+            sumSq += ( values[i] - outMean ) * ( values[i] - outMean );
+        outStdDev = ( count > 1 ) ? ( std::sqrt( sumSq / ( count - 1 ) ) ) : ( 0.0 );
+    }
+
+    // two-sided 95% Student's t critical value (Cornish-Fisher expansion around the normal one; within 1% for df >= 3)
+    double StudentT95( int degreesOfFreedom )
+    {
+        const double z = 1.959964, df = std::max( 1, degreesOfFreedom );
+        return z + ( z*z*z + z ) / ( 4.0 * df ) + ( 5.0*z*z*z*z*z + 16.0*z*z*z + 3.0*z ) / ( 96.0 * df * df );
+    }
+
+    // MSER-5: batch means of 5 samples, truncate the d batches that minimize the standard error of what's left (d <= half).
+    // Samples are first clamped to the outlier fences of the second half (assumed to be past the warmup) - otherwise a single
+    // hitch makes it cut everything up to and including it.
+    int DetectWarmupMSER5( const std::vector<float> & samples, float outlierIQRFactor )
+    {
+        const int batchSize = 5;
+        const int batchCount = (int)samples.size( ) / batchSize;
+        if( batchCount < 4 )
+            return 0;
+        float low = std::numeric_limits<float>::lowest( ), high = std::numeric_limits<float>::max( );
+        if( outlierIQRFactor > 0 )
+        {
+            std::vector<float> secondHalf( samples.begin( ) + samples.size( ) / 2, samples.end( ) );
+            std::sort( secondHalf.begin( ), secondHalf.end( ) );
+            const float q1 = Percentile( secondHalf, 0.25 ), q3 = Percentile( secondHalf, 0.75 );
+            low     = q1 - outlierIQRFactor * ( q3 - q1 );
+            high    = q3 + outlierIQRFactor * ( q3 - q1 );
+        }
+        std::vector<double> batchMeans( batchCount );
+        for( int j = 0; j < batchCount; j++ )
+        {
+            double sum = 0.0;
+            for( int k = 0; k < batchSize; k++ )
+                sum += vaMath::Clamp( samples[j * batchSize + k], low, high );
+            batchMeans[j] = sum / batchSize;
+        }
+
+        // suffix sums so that each candidate is O(1)
+        std::vector<double> suffixSum( batchCount + 1, 0.0 ), suffixSumSq( batchCount + 1, 0.0 );
+        for( int j = batchCount - 1; j >= 0; j-- )
+        {
+            suffixSum[j]    = suffixSum[j + 1] + batchMeans[j];
+            suffixSumSq[j]  = suffixSumSq[j + 1] + batchMeans[j] * batchMeans[j];
+        }
+        int bestD = 0;
+        double bestValue = std::numeric_limits<double>::max( );
+        for( int d = 0; d <= batchCount / 2; d++ )
+        {
+            const double remaining = batchCount - d;
+            const double mean = suffixSum[d] / remaining;
+            const double value = std::max( 0.0, suffixSumSq[d] - remaining * mean * mean ) / ( remaining * remaining );
+            if( value < bestValue )
+            {
+                bestValue = value;
+                bestD = d;
+            }
+        }
+        return bestD * batchSize;
+    }
+
+    // names go into a comma separated file
+    std::string CSVSafe( const std::string & text )
+    {
+        std::string ret = text;
+        std::replace( ret.begin( ), ret.end( ), ',', ';' );
+        std::replace( ret.begin( ), ret.end( ), '\n', ' ' );
+        std::replace( ret.begin( ), ret.end( ), '\r', ' ' );
+        return ret;
+    }
+
+    const char * c_statisticsCSVHeader = "run,metric,better,samples,warmup,outliers,mean,stddev,stderr,ci95_low,ci95_high,min,p50,p90,p99,p99.9,max,hitches,stutters";
+
+    struct StatisticsRow
+    {
+        bool                                HigherIsBetter;
+        vaBenchmarkTool::MetricStatistics   Statistics;
+    };
+
+    bool ReadStatisticsCSV( const wstring & fileName, std::vector<std::pair<std::string, StatisticsRow>> & outRows )
+    {
+        const std::string text = vaFileTools::ReadText( fileName );
+        if( text == "" )
+        {
+            VA_LOG_ERROR( "vaBenchmarkTool: could not read '%s'", vaStringTools::SimpleNarrow( fileName ).c_str( ) );
+            return false;
+        }
+        for( const std::string & line : vaStringTools::Tokenize( text.c_str( ), "\n", " \r" ) )
+        {
+            if( line == "" || line == c_statisticsCSVHeader )
+                continue;
+            std::vector<std::string> columns = vaStringTools::Tokenize( line.c_str( ), ",", " " );
+            if( columns.size( ) != 19 )
+            {
+                VA_LOG_WARNING( "vaBenchmarkTool: skipping unrecognized line '%s' in '%s'", line.c_str( ), vaStringTools::SimpleNarrow( fileName ).c_str( ) );
+                continue;
+            }
+            StatisticsRow row;
+            vaBenchmarkTool::MetricStatistics & stats = row.Statistics;
+            row.HigherIsBetter          = columns[2] == "higher";
+            stats.SampleCount           = std::atoi( columns[3].c_str( ) );
+            stats.WarmupSampleCount     = std::atoi( columns[4].c_str( ) );
+            stats.OutlierCount          = std::atoi( columns[5].c_str( ) );
+            stats.Mean                  = (float)std::atof( columns[6].c_str( ) );
+            stats.StdDev                = (float)std::atof( columns[7].c_str( ) );
+            stats.StandardError         = (float)std::atof( columns[8].c_str( ) );
+            stats.ConfidenceLow         = (float)std::atof( columns[9].c_str( ) );
+            stats.ConfidenceHigh        = (float)std::atof( columns[10].c_str( ) );
+            stats.Minimum               = (float)std::atof( columns[11].c_str( ) );
+            stats.P50                   = (float)std::atof( columns[12].c_str( ) );
+            stats.P90                   = (float)std::atof( columns[13].c_str( ) );
+            stats.P99                   = (float)std::atof( columns[14].c_str( ) );
+            stats.P999                  = (float)std::atof( columns[15].c_str( ) );
+            stats.Maximum               = (float)std::atof( columns[16].c_str( ) );
+            stats.HitchCount            = std::atoi( columns[17].c_str( ) );
+            stats.StutterCount          = std::atoi( columns[18].c_str( ) );
+            outRows.push_back( { columns[0] + "," + columns[1], row } );
+        }
+        return true;
+    }
+}
+
 vaBenchmarkTool::vaBenchmarkTool( ) : m_currentRunIndex( 0 ), m_currentRunSetupDone( false )
 {
     m_active                = false;
@@ -101,6 +246,7 @@ void vaBenchmarkTool::StartNextOrStop( )
 
         m_sampleCache.resize( m_currentRun.MetricNames.size() );
         m_avgMinMaxCache.resize( m_currentRun.MetricNames.size() );
+        m_statisticsCache.resize( m_currentRun.MetricNames.size() );
         m_currentMetricsSampleLog.resize( m_currentRun.MetricNames.size() );
     }
 }
@@ -131,12 +277,14 @@ void vaBenchmarkTool::FinishCurrent( )
                 m_avgMinMaxCache[i].Maximum = vaMath::Max( m_avgMinMaxCache[i].Maximum, m_currentMetricsSampleLog[i][j] );
             }
             m_avgMinMaxCache[i].Average /= (float)m_currentSampleCount;
+
+            m_statisticsCache[i] = ComputeStatistics( m_currentMetricsSampleLog[i], m_currentRun.Statistics );
         }
     }
 
     // report results
     if( !incorrectSampleCount )
-        m_currentRun.FinishedCallback( m_currentRun, m_currentRunIndex, (int)m_benchmarkRuns.size(), m_currentMetricsSampleLog, m_avgMinMaxCache );
+        m_currentRun.FinishedCallback( m_currentRun, m_currentRunIndex, (int)m_benchmarkRuns.size(), m_currentMetricsSampleLog, m_avgMinMaxCache, m_statisticsCache );
 
     m_currentRun            = RunDefinition();
     m_timeFromStart         = 0.0f;
@@ -159,7 +307,7 @@ void vaBenchmarkTool::Stop( )
     m_active                = false;
 }
 
-void vaBenchmarkTool::WriteResultsCSV( const wstring & fileName, bool append, const RunDefinition & runDef, int currentIndex, int totalCount, const std::vector<std::vector<float>>& metricsSamples, const std::vector<AverageMinMax>& metricsAverages )
+void vaBenchmarkTool::WriteResultsCSV( const wstring & fileName, bool append, const RunDefinition & runDef, int currentIndex, int totalCount, const std::vector<std::vector<float>>& metricsSamples, const std::vector<AverageMinMax>& metricsAverages, const std::vector<MetricStatistics> & metricsStatistics )
 {
     vaFileStream outFile;
     outFile.Open( fileName, (append)?(FileCreationMode::Append):(FileCreationMode::Create) );
@@ -215,5 +363,188 @@ void vaBenchmarkTool::WriteResultsCSV( const wstring & fileName, bool append, co
         outFile.WriteTXT( "\r\n" );
     }
 
+    // statistics (after warmup)
+    if( metricsStatistics.size() > 0 )
+    {
+        auto writeRow = [&]( const char * name, auto getter, const char * format )
+        {
+            outFile.WriteTXT( name );
+            for( size_t i = 0; i < metricsStatistics.size(); i++ )
+                outFile.WriteTXT( vaStringTools::Format( format, getter( metricsStatistics[i] ) ) );
+            outFile.WriteTXT( "\r\n" );
+        };
+        writeRow( " warmup samples, ",  [ ]( const MetricStatistics & s ) { return s.WarmupSampleCount; },   "%d, " );
+        writeRow( " outliers, ",        [ ]( const MetricStatistics & s ) { return s.OutlierCount; },        "%d, " );
+        writeRow( " mean, ",            [ ]( const MetricStatistics & s ) { return (double)s.Mean; },        "%.3f, " );
+        writeRow( " ci95 low, ",        [ ]( const MetricStatistics & s ) { return (double)s.ConfidenceLow; },  "%.3f, " );
+        writeRow( " ci95 high, ",       [ ]( const MetricStatistics & s ) { return (double)s.ConfidenceHigh; }, "%.3f, " );
+        writeRow( " p50, ",             [ ]( const MetricStatistics & s ) { return (double)s.P50; },         "%.3f, " );
+        writeRow( " p90, ",             [ ]( const MetricStatistics & s ) { return (double)s.P90; },         "%.3f, " );
+        writeRow( " p99, ",             [ ]( const MetricStatistics & s ) { return (double)s.P99; },         "%.3f, " );
+        writeRow( " p99.9, ",           [ ]( const MetricStatistics & s ) { return (double)s.P999; },        "%.3f, " );
+        writeRow( " hitches, ",         [ ]( const MetricStatistics & s ) { return s.HitchCount; },          "%d, " );
+        writeRow( " stutters, ",        [ ]( const MetricStatistics & s ) { return s.StutterCount; },        "%d, " );
+    }
+
     //outFile.WriteTXT( )
 }
+
+vaBenchmarkTool::MetricStatistics vaBenchmarkTool::ComputeStatistics( const std::vector<float> & allSamples, const StatisticsSettings & settings )
+{
+    MetricStatistics stats;
+    stats.SampleCount       = (int)allSamples.size( );
+    stats.WarmupSampleCount = ( settings.DetectWarmup ) ? ( DetectWarmupMSER5( allSamples, settings.OutlierIQRFactor ) ) : ( 0 );
+    if( stats.SampleCount - stats.WarmupSampleCount <= 0 )
+        return stats;
+    const std::vector<float> samples( allSamples.begin( ) + stats.WarmupSampleCount, allSamples.end( ) );
+
+    std::vector<float> sorted = samples;
+    std::sort( sorted.begin( ), sorted.end( ) );
+    stats.Minimum   = sorted.front( );
+    stats.Maximum   = sorted.back( );
+    stats.P50       = Percentile( sorted, 0.50 );
+    stats.P90       = Percentile( sorted, 0.90 );
+    stats.P99       = Percentile( sorted, 0.99 );
+    stats.P999      = Percentile( sorted, 0.999 );
+
+    for( size_t i = 0; i < samples.size( ); i++ )
+    {
+        if( samples[i] > settings.HitchFactor * stats.P50 )
+            stats.HitchCount++;
+        if( i > 0 && std::abs( samples[i] - samples[i - 1] ) > settings.StutterFactor * stats.P50 )
+            stats.StutterCount++;
+    }
+
+    // outlier rejection (Tukey's fences) - keeps the order, the batch means below need it
+    std::vector<float> kept;
+    kept.reserve( samples.size( ) );
+    if( settings.OutlierIQRFactor > 0 )
+    {
+        const float q1 = Percentile( sorted, 0.25 ), q3 = Percentile( sorted, 0.75 );
+        const float low = q1 - settings.OutlierIQRFactor * ( q3 - q1 ), high = q3 + settings.OutlierIQRFactor * ( q3 - q1 );
+        for( float sample : samples )
+            if( sample >= low && sample <= high )
+                kept.push_back( sample );
+    }
+    else
+        kept = samples;
+    stats.OutlierCount = (int)( samples.size( ) - kept.size( ) );
+
+    double mean, stdDev;
+    MeanAndStdDev( kept.data( ), kept.size( ), mean, stdDev );
+    stats.Mean      = (float)mean;
+    stats.StdDev    = (float)stdDev;
+
+    // standard error from (up to) 20 batch means when there's enough samples, otherwise from the samples directly
+    const int c_batchCount = 20;
+    double standardError;
+    int degreesOfFreedom;
+    if( kept.size( ) >= c_batchCount * 2 )
+    {
+        const size_t batchSize = kept.size( ) / c_batchCount;
+        float batchMeans[c_batchCount];
+        for( int j = 0; j < c_batchCount; j++ )
+        {
+            double batchMean, batchStdDev;
+            MeanAndStdDev( kept.data( ) + j * batchSize, batchSize, batchMean, batchStdDev );
+            batchMeans[j] = (float)batchMean;
+        }
+        double meanOfBatches, stdDevOfBatches;
+        MeanAndStdDev( batchMeans, c_batchCount, meanOfBatches, stdDevOfBatches );
+        standardError       = stdDevOfBatches / std::sqrt( (double)c_batchCount );
+        degreesOfFreedom    = c_batchCount - 1;
+    }
+    else
+    {
+        standardError       = ( kept.size( ) > 0 ) ? ( stdDev / std::sqrt( (double)kept.size( ) ) ) : ( 0.0 );
+        degreesOfFreedom    = (int)kept.size( ) - 1;
+    }
+    const double halfInterval = StudentT95( degreesOfFreedom ) * standardError;
+    stats.StandardError     = (float)standardError;
+    stats.ConfidenceLow     = (float)( mean - halfInterval );
+    stats.ConfidenceHigh    = (float)( mean + halfInterval );
+    return stats;
+}
+
+bool vaBenchmarkTool::WriteStatisticsCSV( const wstring & fileName, bool append, const RunDefinition & runDef, const std::vector<MetricStatistics> & metricsStatistics )
+{
+    assert( metricsStatistics.size( ) == runDef.MetricNames.size( ) );
+    const bool writeHeader = !append || !vaFileTools::FileExists( fileName );
+
+    vaFileStream outFile;
+    if( !outFile.Open( fileName, ( append ) ? ( FileCreationMode::Append ) : ( FileCreationMode::Create ) ) )
+    {
+        VA_LOG_ERROR( "vaBenchmarkTool: could not open '%s' for writing", vaStringTools::SimpleNarrow( fileName ).c_str( ) );
+        return false;
+    }
+    if( writeHeader )
+        outFile.WriteTXT( std::string( c_statisticsCSVHeader ) + "\r\n" );
+
+    for( size_t i = 0; i < metricsStatistics.size( ) && i < runDef.MetricNames.size( ); i++ )
+    {
+        const MetricStatistics & s = metricsStatistics[i];
+        const bool higherIsBetter = i < runDef.MetricHigherIsBetter.size( ) && runDef.MetricHigherIsBetter[i];
+        outFile.WriteTXT( vaStringTools::Format( "%s,%s,%s,%d,%d,%d,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g,%d,%d\r\n",
+            CSVSafe( runDef.Name ).c_str( ), CSVSafe( runDef.MetricNames[i] ).c_str( ), ( higherIsBetter ) ? ( "higher" ) : ( "lower" ),
+            s.SampleCount, s.WarmupSampleCount, s.OutlierCount, s.Mean, s.StdDev, s.StandardError, s.ConfidenceLow, s.ConfidenceHigh,
+            s.Minimum, s.P50, s.P90, s.P99, s.P999, s.Maximum, s.HitchCount, s.StutterCount ) );
+    }
+    return true;
+}
+
+bool vaBenchmarkTool::CompareStatisticsCSV( const wstring & baselineFileName, const wstring & currentFileName, const ComparisonSettings & settings, std::vector<ComparisonResult> & outResults )
+{
+    std::vector<std::pair<std::string, StatisticsRow>> baselineRows, currentRows;
+    if( !ReadStatisticsCSV( baselineFileName, baselineRows ) || !ReadStatisticsCSV( currentFileName, currentRows ) )
+        return false;
+
+    outResults.clear( );
+    for( const auto & current : currentRows )
+    {
+        auto baseline = std::find_if( baselineRows.begin( ), baselineRows.end( ), [ & ]( const auto & row ) { return row.first == current.first; } );
+        if( baseline == baselineRows.end( ) )
+            continue;
+        const MetricStatistics & b = baseline->second.Statistics;
+        const MetricStatistics & c = current.second.Statistics;
+
+        ComparisonResult result;
+        const size_t separator  = current.first.find( ',' );
+        result.RunName          = current.first.substr( 0, separator );
+        result.MetricName       = current.first.substr( separator + 1 );
+        result.HigherIsBetter   = current.second.HigherIsBetter;
+        result.BaselineMean     = b.Mean;
+        result.CurrentMean      = c.Mean;
+        result.BaselineP99      = b.P99;
+        result.CurrentP99       = c.P99;
+        result.RelativeChange   = ( b.Mean != 0 ) ? ( ( c.Mean - b.Mean ) / std::abs( b.Mean ) ) : ( 0.0f );
+
+        // Welch's t with the (batch means) standard errors of both runs
+        const double combinedError = std::sqrt( (double)b.StandardError * b.StandardError + (double)c.StandardError * c.StandardError );
+        result.TScore           = ( combinedError > 0 ) ? ( (float)( ( c.Mean - b.Mean ) / combinedError ) ) : ( ( c.Mean != b.Mean ) ? ( std::numeric_limits<float>::infinity( ) ) : ( 0.0f ) );
+
+        const bool significant  = std::abs( result.TScore ) >= settings.MinTScore && std::abs( result.RelativeChange ) >= settings.MinRelativeChange;
+        const bool worse        = ( result.HigherIsBetter ) ? ( c.Mean < b.Mean ) : ( c.Mean > b.Mean );
+        result.Regression       = significant && worse;
+        result.Improvement      = significant && !worse;
+        outResults.push_back( result );
+    }
+    return true;
+}
+
+std::string vaBenchmarkTool::FormatComparison( const std::vector<ComparisonResult> & results, bool onlyFlagged )
+{
+    std::string report;
+    int regressions = 0, improvements = 0;
+    for( const ComparisonResult & r : results )
+    {
+        regressions     += ( r.Regression ) ? ( 1 ) : ( 0 );
+        improvements    += ( r.Improvement ) ? ( 1 ) : ( 0 );
+        if( onlyFlagged && !r.Regression && !r.Improvement )
+            continue;
+        report += vaStringTools::Format( "%-12s %s / %s: mean %.3f -> %.3f (%+.2f%%, t %.1f), p99 %.3f -> %.3f\n", 
+            ( r.Regression ) ? ( "REGRESSION" ) : ( ( r.Improvement ) ? ( "improvement" ) : ( "" ) ), r.RunName.c_str( ), r.MetricName.c_str( ),
+            r.BaselineMean, r.CurrentMean, r.RelativeChange * 100.0f, r.TScore, r.BaselineP99, r.CurrentP99 );
+    }
+    report += vaStringTools::Format( "%d metric(s) compared, %d regression(s), %d improvement(s)\n", (int)results.size( ), regressions, improvements );
+    return report;
+}
@@ -29,6 +29,57 @@ namespace Vanilla
             float                           Maximum;
         };
 
+        struct StatisticsSettings
+        {
+            bool                            DetectWarmup        = true;     // drop the initial transient (MSER-5 truncation, at most half of the samples)
+            float                           OutlierIQRFactor    = 3.0f;     // samples outside [Q1 - f*IQR, Q3 + f*IQR] don't count toward mean/stddev/confidence (0 disables)
+            float                           HitchFactor         = 2.0f;     // a sample above HitchFactor * median is a hitch
+            float                           StutterFactor       = 0.5f;     // a change from the previous sample of more than StutterFactor * median is a stutter
+        };
+
+        // All except SampleCount/WarmupSampleCount are computed after the warmup samples were dropped; percentiles, hitches and
+        // stutters include the outliers, mean/stddev/confidence interval don't.
+        struct MetricStatistics
+        {
+            int                             SampleCount         = 0;
+            int                             WarmupSampleCount   = 0;
+            int                             OutlierCount        = 0;
+            float                           Mean                = 0;
+            float                           StdDev              = 0;
+            float                           StandardError       = 0;        // of the mean, from batch means so that correlation between consecutive frames doesn't make it look more precise than it is
+            float                           ConfidenceLow       = 0;        // 95% confidence interval of the mean
+            float                           ConfidenceHigh      = 0;
+            float                           Minimum             = 0;
+            float                           Maximum             = 0;
+            float                           P50                 = 0;
+            float                           P90                 = 0;
+            float                           P99                 = 0;
+            float                           P999                = 0;
+            int                             HitchCount          = 0;
+            int                             StutterCount        = 0;
+        };
+
+        struct ComparisonSettings
+        {
+            float                           MinRelativeChange   = 0.02f;    // smaller changes are never flagged, however significant
+            float                           MinTScore           = 3.0f;     // Welch's t of the difference in means needed to call it significant
+        };
+
+        struct ComparisonResult
+        {
+            std::string                     RunName;
+            std::string                     MetricName;
+            bool                            HigherIsBetter      = false;
+            float                           BaselineMean        = 0;
+            float                           CurrentMean         = 0;
+            float                           BaselineP99         = 0;
+            float                           CurrentP99          = 0;
+            float                           RelativeChange      = 0;        // (current - baseline) / baseline of the mean
+            float                           TScore              = 0;
+            bool                            Regression          = false;    // significantly worse by at least MinRelativeChange
+            bool                            Improvement         = false;    // significantly better by at least MinRelativeChange
+        };
+
         struct RunDefinition
         {
             std::string                                                         Name;
@@ -38,12 +89,14 @@ namespace Vanilla
             int                                                                 SamplingTotalCount;
             float                                                               DelayStartTime;
             std::vector<std::string>                                            MetricNames;
+            std::vector<bool>                                                   MetricHigherIsBetter;   // optional, per metric; default is lower is better (times)
+            StatisticsSettings                                                  Statistics;
 
             std::function< void( const RunDefinition & ) >                      SettingsSetupCallback;
             std::function< void( const RunDefinition &, std::vector<float> & ) >  
                                                                                 CollectSamplesCallback;
-            // finished run info, finished run index, total run count, finished run samples, finished run averaged samples
-            std::function< void( const RunDefinition &, int, int, const std::vector< std::vector<float> > &, const std::vector<AverageMinMax> & ) > 
+            // finished run info, finished run index, total run count, finished run samples, finished run averaged samples, finished run statistics
+            std::function< void( const RunDefinition &, int, int, const std::vector< std::vector<float> > &, const std::vector<AverageMinMax> &, const std::vector<MetricStatistics> & ) > 
                                                                                 FinishedCallback;
 
             RunDefinition( ) { SamplingPeriod = 0.0f; SamplingTotalCount = 0; DelayStartTime = 1.0f; }
@@ -61,6 +114,7 @@ namespace Vanilla
         std::vector< float >                m_sampleCache;
         std::vector< std::vector<float> >   m_currentMetricsSampleLog;
         std::vector< AverageMinMax >        m_avgMinMaxCache;
+        std::vector< MetricStatistics >     m_statisticsCache;
 
         std::time_t                         m_runStartTime;
 
@@ -85,7 +139,15 @@ namespace Vanilla
 
         float                                               GetRemainingBenchmarkTime( )                { return m_currentRun.SamplingPeriod * m_currentRun.SamplingTotalCount - m_timeFromStart; }
 
-        static void                                         WriteResultsCSV( const wstring & fileName, bool append, const RunDefinition & runDef, int currentIndex, int totalCount, const std::vector< std::vector<float> > & metricsSamples, const std::vector<AverageMinMax> & metricsAverages );
+        static void                                         WriteResultsCSV( const wstring & fileName, bool append, const RunDefinition & runDef, int currentIndex, int totalCount, const std::vector< std::vector<float> > & metricsSamples, const std::vector<AverageMinMax> & metricsAverages, const std::vector<MetricStatistics> & metricsStatistics = {} );
+
+        static MetricStatistics                             ComputeStatistics( const std::vector<float> & samples, const StatisticsSettings & settings );
+
+        // One row per run and metric, machine readable - these are what CompareStatisticsCSV diffs (nightly runs vs a baseline)
+        static bool                                         WriteStatisticsCSV( const wstring & fileName, bool append, const RunDefinition & runDef, const std::vector<MetricStatistics> & metricsStatistics );
+        // Matches rows by run and metric name; rows that are in only one of the files are skipped
+        static bool                                         CompareStatisticsCSV( const wstring & baselineFileName, const wstring & currentFileName, const ComparisonSettings & settings, std::vector<ComparisonResult> & outResults );
+        static std::string                                  FormatComparison( const std::vector<ComparisonResult> & results, bool onlyFlagged );
 
     protected:
         void                                                StartNextOrStop( );
@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation 
+// 
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "vaRadixSort.h"
+
+using namespace Vanilla;
+
+namespace
+{
+    inline uint32 Digit( uint64 key, int pass )     { return (uint32)( key >> ( pass * vaRadixSort::c_DigitBits ) ) & ( vaRadixSort::c_BucketCount - 1 ); }
+}
+
+void vaRadixSort::Begin( uint32 count, int chunkCount )
+{
+    m_count         = count;
+    m_chunkCount    = std::max( 1, std::min( chunkCount, (int)std::max( 1u, count ) ) );
+    for( int i = 0; i < 2; i++ )
+    {
+        m_keys[i].resize( count );
+        m_values[i].resize( count );
+    }
+    m_histograms.resize( (size_t)m_chunkCount * c_BucketCount );
+    m_passSource[0] = 0;
+    for( int pass = 0; pass < c_PassCount; pass++ )
+    {
+        m_passSource[pass+1]    = 0;
+        m_passSkipped[pass]     = false;
+    }
+}
+
+std::pair<uint32, uint32> vaRadixSort::ChunkRange( int chunk ) const
+{
+    assert( chunk >= 0 && chunk < m_chunkCount );
+    const uint64 begin  = (uint64)m_count * chunk / m_chunkCount;
+    const uint64 end    = (uint64)m_count * ( chunk + 1 ) / m_chunkCount;
+    return { (uint32)begin, (uint32)end };
+}
+
+void vaRadixSort::Histogram( int pass, int chunk )
+{
+    uint32 * histogram = &m_histograms[(size_t)chunk * c_BucketCount];
+    std::fill( histogram, histogram + c_BucketCount, 0 );
+
+    const uint64 * keys = m_keys[m_passSource[pass]].data( );
+    const auto [begin, end] = ChunkRange( chunk );
+    for( uint32 i = begin; i < end; i++ )
+        histogram[Digit( keys[i], pass )]++;
+}
+
+void vaRadixSort::PrefixSum( int pass )
+{
+    // all keys in one bucket? nothing to do for this pass, and the next one reads from the same buffer
+    bool skip = m_count == 0;
+    for( int bucket = 0; bucket < c_BucketCount; bucket++ )
+    {
+        uint32 total = 0;
+        for( int chunk = 0; chunk < m_chunkCount; chunk++ )
+            total += m_histograms[(size_t)chunk * c_BucketCount + bucket];
+        if( total != 0 )
+        {
+            // first non-empty bucket decides: either it has everything or there are at least two non-empty buckets
+            skip = total == m_count;
+            break;
+        }
+    }
+    m_passSkipped[pass]     = skip;
+    m_passSource[pass+1]    = ( skip ) ? ( m_passSource[pass] ) : ( 1 - m_passSource[pass] );
+    if( skip )
+        return;
+
+    // bucket-major, chunk-minor offsets keep the sort stable
+    uint32 offset = 0;
+    for( int bucket = 0; bucket < c_BucketCount; bucket++ )
+        for( int chunk = 0; chunk < m_chunkCount; chunk++ )
+        {
+            uint32 & counter = m_histograms[(size_t)chunk * c_BucketCount + bucket];
+            const uint32 count = counter;
+            counter = offset;
+            offset += count;
+        }
+    assert( offset == m_count );
+}
+
+void vaRadixSort::Scatter( int pass, int chunk )
+{
+    if( m_passSkipped[pass] )
+        return;
+
+    uint32 * offsets = &m_histograms[(size_t)chunk * c_BucketCount];
+    const int src = m_passSource[pass];
+    const uint64 * srcKeys      = m_keys[src].data( );
+    const uint32 * srcValues    = m_values[src].data( );
+    uint64 * dstKeys            = m_keys[1-src].data( );
+    uint32 * dstValues          = m_values[1-src].data( );
+
+    const auto [begin, end] = ChunkRange( chunk );
+    for( uint32 i = begin; i < end; i++ )
+    {
+        const uint32 dst = offsets[Digit( srcKeys[i], pass )]++;
+        dstKeys[dst]    = srcKeys[i];
+        dstValues[dst]  = srcValues[i];
+    }
+}
+
+void vaRadixSort::SortSerial( )
+{
+    // single chunk, but all histograms are built in one read of the keys instead of one per pass
+    m_chunkCount = 1;
+    std::vector<uint32> & histograms = m_histograms;     // (Begin resizes it back for the parallel steps)
+    histograms.assign( (size_t)c_PassCount * c_BucketCount, 0 );
+    const uint64 * keys = m_keys[0].data( );
+    for( uint32 i = 0; i < m_count; i++ )
+        for( int pass = 0; pass < c_PassCount; pass++ )
+            histograms[(size_t)pass * c_BucketCount + Digit( keys[i], pass )]++;
+
+    for( int pass = 0; pass < c_PassCount; pass++ )
+    {
+        uint32 * histogram = &histograms[(size_t)pass * c_BucketCount];
+        bool skip = m_count == 0;
+        uint32 offset = 0;
+        for( int bucket = 0; bucket < c_BucketCount; bucket++ )
+        {
+            const uint32 count = histogram[bucket];
+            skip |= count == m_count;
+            histogram[bucket] = offset;
+            offset += count;
+        }
+        m_passSkipped[pass]     = skip;
+        m_passSource[pass+1]    = ( skip ) ? ( m_passSource[pass] ) : ( 1 - m_passSource[pass] );
+        if( skip )
+            continue;
+
+        const int src = m_passSource[pass];
+        const uint64 * srcKeys      = m_keys[src].data( );
+        const uint32 * srcValues    = m_values[src].data( );
+        uint64 * dstKeys            = m_keys[1-src].data( );
+        uint32 * dstValues          = m_values[1-src].data( );
+        for( uint32 i = 0; i < m_count; i++ )
+        {
+            const uint32 dst = histogram[Digit( srcKeys[i], pass )]++;
+            dstKeys[dst]    = srcKeys[i];
+            dstValues[dst]  = srcValues[i];
+        }
+    }
+}
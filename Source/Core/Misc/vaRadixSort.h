@@ -0,0 +1,68 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation 
+// 
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Core/vaCoreIncludes.h"
+
+namespace Vanilla
+{
+    // Stable LSD radix sort of 64-bit keys with 32-bit values (usually indices into whatever is being sorted); the CPU counterpart
+    // of vaGPUSort (FFX_ParallelSort). 8 bits per pass, and passes where all keys have the same digit are skipped, so keys that
+    // only use some of the bits (or have large constant parts) are cheaper.
+    //
+    // The parallel version is split into steps so it can be driven by any task system: after Begin and filling Keys/Values, for
+    // each pass in [0, c_PassCount): Histogram( pass, chunk ) for all chunks -> PrefixSum( pass ) -> Scatter( pass, chunk ) for
+    // all chunks; steps on different chunks of the same pass can run concurrently. SortSerial does all of it on the calling thread.
+    // Buffers are kept between sorts so reusing the object avoids allocations.
+    class vaRadixSort
+    {
+    public:
+        static constexpr int                c_DigitBits         = 8;
+        static constexpr int                c_BucketCount       = 1 << c_DigitBits;
+        static constexpr int                c_PassCount         = 64 / c_DigitBits;
+
+    private:
+        std::vector<uint64>                 m_keys[2];
+        std::vector<uint32>                 m_values[2];
+        // c_BucketCount counters per chunk; after PrefixSum these become per-chunk per-bucket output offsets
+        std::vector<uint32>                 m_histograms;
+        uint32                              m_count             = 0;
+        int                                 m_chunkCount        = 0;
+        // which of the two buffers the pass reads from; [c_PassCount] is where the sorted result ends up
+        int                                 m_passSource[c_PassCount+1];
+        bool                                m_passSkipped[c_PassCount];
+
+    public:
+        vaRadixSort( )                      { Begin( 0, 1 ); }
+
+        // Sets up for sorting 'count' items split into 'chunkCount' chunks for the parallel steps
+        void                                Begin( uint32 count, int chunkCount );
+        // input, write before sorting
+        uint64 *                            Keys( )                                 { return m_keys[0].data( ); }
+        uint32 *                            Values( )                               { return m_values[0].data( ); }
+        uint32                              Count( ) const                          { return m_count; }
+        int                                 ChunkCount( ) const                     { return m_chunkCount; }
+        // [begin, end) item range of a chunk
+        std::pair<uint32, uint32>           ChunkRange( int chunk ) const;
+
+        // parallel steps
+        void                                Histogram( int pass, int chunk );
+        void                                PrefixSum( int pass );
+        void                                Scatter( int pass, int chunk );
+
+        // all steps on the calling thread, in one chunk regardless of what was passed to Begin
+        void                                SortSerial( );
+
+        // output, valid after the last pass
+        const uint64 *                      SortedKeys( ) const                     { return m_keys[m_passSource[c_PassCount]].data( ); }
+        const uint32 *                      SortedValues( ) const                   { return m_values[m_passSource[c_PassCount]].data( ); }
+    };
+}
@@ -33,8 +33,6 @@ using namespace Vanilla;
 
 vaXXHash64::vaXXHash64( uint64 seed )
 {
-    assert( false ); // code below never tested - please run through debugger to make sure it's all fine
-
     m_state = XXH64_createState();
     XXH64_reset( m_state, seed );
 }
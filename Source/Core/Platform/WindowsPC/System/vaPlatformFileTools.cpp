@@ -311,4 +311,43 @@ void vaFileTools::OpenSystemExplorerFolder( const wstring & folderPath )
         SHOpenFolderAndSelectItems(pidl, 1, pidlNull, 0);
         ILFree(pidl);
     }
-}
\ No newline at end of file
+}
+
+bool vaMappedFile::Open( const wstring & filePath )
+{
+    Close( );
+
+    HANDLE file = ::CreateFileW( filePath.c_str( ), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+    if( file == INVALID_HANDLE_VALUE )
+        return false;
+    m_file = file;
+
+    LARGE_INTEGER size;
+    // can't map empty files
+    if( !::GetFileSizeEx( file, &size ) || size.QuadPart == 0 )
+        { Close( ); return false; }
+
+    m_mapping = ::CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL );
+    if( m_mapping == NULL )
+        { Close( ); return false; }
+
+    m_data = (const byte *)::MapViewOfFile( m_mapping, FILE_MAP_READ, 0, 0, 0 );
+    if( m_data == nullptr )
+        { Close( ); return false; }
+    m_size = size.QuadPart;
+    return true;
+}
+
+void vaMappedFile::Close( )
+{
+    if( m_data != nullptr )
+        ::UnmapViewOfFile( m_data );
+    if( m_mapping != nullptr )
+        ::CloseHandle( m_mapping );
+    if( m_file != nullptr )
+        ::CloseHandle( m_file );
+    m_data      = nullptr;
+    m_mapping   = nullptr;
+    m_file      = nullptr;
+    m_size      = 0;
+}
@@ -25,6 +25,8 @@
 
 #include <tchar.h>
 
+#include <psapi.h>
+
 bool evilg_inOtherMessageLoop_PreventTick = false;
 
 namespace Vanilla
@@ -160,6 +162,16 @@ string vaCore::GetCPUIDName( )
     return CPUBrandString;
 }
 
+int64 vaCore::GetProcessPrivateMemory( )
+{
+    PROCESS_MEMORY_COUNTERS_EX counters = { };
+    counters.cb = sizeof( counters );
+    // (the kernel32 version so there's no need to link psapi.lib)
+    if( !K32GetProcessMemoryInfo( GetCurrentProcess( ), reinterpret_cast<PROCESS_MEMORY_COUNTERS *>( &counters ), sizeof( counters ) ) )
+        return 0;
+    return (int64)counters.PrivateUsage;
+}
+
 bool vaFileTools::EnsureDirectoryExists( const wchar_t * path )
 {
     //if( DirectoryExists( path ) )
@@ -147,6 +147,30 @@ namespace Vanilla
       static void                               Deinitialize( );
    };
 
+   // Read-only view of a whole file mapped into memory; pages get loaded on first access so it's cheap to open large files and
+   // only touch parts of them. The view is valid until Close (or destruction); the file can't be written to while it's open.
+   class vaMappedFile
+   {
+      void *                                    m_file          = nullptr;
+      void *                                    m_mapping       = nullptr;
+      const byte *                              m_data          = nullptr;
+      int64                                     m_size          = 0;
+
+   public:
+      vaMappedFile( )                           { }
+      vaMappedFile( const vaMappedFile & )      = delete;
+      vaMappedFile & operator = ( const vaMappedFile & ) = delete;
+      ~vaMappedFile( )                          { Close( ); }
+
+      bool                                      Open( const wstring & filePath );
+      bool                                      Open( const string & filePath )                         { return Open( vaStringTools::SimpleWiden( filePath ) ); }
+      void                                      Close( );
+
+      bool                                      IsOpen( ) const                                         { return m_data != nullptr; }
+      const byte *                              Data( ) const                                           { return m_data; }
+      int64                                     Size( ) const                                           { return m_size; }
+   };
+
 
 }
 
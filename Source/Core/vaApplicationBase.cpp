@@ -239,6 +239,10 @@ void vaApplicationBase::Tick( float deltaTime )
         VA_TRACE_CPU_SCOPE( vaFramePtrStatic_NextFrame );
         vaFramePtrStatic::NextFrame();
     }
+    {
+        VA_TRACE_CPU_SCOPE( vaFrameArena_NextFrame );
+        vaFrameArena::NextFrame();
+    }
 
     if( vaCore::GetAppQuitFlag() )
         Quit();
@@ -11,6 +11,7 @@
 #pragma once
 
 #include "vaCore.h"
+#include "vaFrameArena.h"
 
 #include <memory>
 #include <shared_mutex>
@@ -37,7 +38,11 @@ namespace Vanilla
     // I don't know what this should be called, I'm sure I'm reinventing the wheel, but it's a low contention atomic tool 
     // for fast summing up or incrementing or decrementing or whatever values from many threads. Fast to write,
     // slow to read (adjustable with BlockCount parameter).
-    // TODO: most if it is unimplemented yet!
+    // Each thread writes into one of the BlockCount cache line padded blocks (picked by vaConcurrency::ThreadHash), so
+    // writers only contend if they map to the same block. Readers go through all blocks.
+    // The same counter is meant to be used either as a sum (add/sum) or as a min/max tracker (store/min/max/lowest/highest)
+    // since they interpret the blocks differently: the constructor, reset and reset_and_read set up a sum (value in the first
+    // block, zero in the rest), while reset_minmax and reset_and_read_minmax put the value into every block.
     template< typename CounterType, int BlockCount = 17 > // 3, 5, 9, 17, 31, 61, 101...
     class lc_atomic_counter
     {
@@ -50,25 +55,85 @@ namespace Vanilla
         Block                        m_blocks[BlockCount];
         alignas( VA_ALIGN_PAD ) char m_padding[VA_ALIGN_PAD];
 
+    public:
+        // result of reset_and_read( ) - all values are from the same, exact, set of writes
+        struct snapshot
+        {
+            CounterType             Sum;
+            CounterType             Lowest;
+            CounterType             Highest;
+        };
+
     public:
         lc_atomic_counter( )                                        { reset( 0 );           }
-        lc_atomic_counter( CounterType initialValue )               { reset(initialValue);  }
+        explicit lc_atomic_counter( CounterType initialValue )      { reset(initialValue);  }
 
-        void                        reset( CounterType value )      { for( int i = 0; i < countof( m_blocks ); i++ ) m_blocks[i].Value.store( value, std::memory_order_release ); }
+        // sum( ) == value after this
+        void                        reset( CounterType value )      { m_blocks[0].Value.store( value, std::memory_order_release ); for( int i = 1; i < countof( m_blocks ); i++ ) m_blocks[i].Value.store( 0, std::memory_order_release ); }
+        // lowest( ) == highest( ) == value after this
+        void                        reset_minmax( CounterType value ) { for( int i = 0; i < countof( m_blocks ); i++ ) m_blocks[i].Value.store( value, std::memory_order_release ); }
 
         void                        store( CounterType value )      { m_blocks[thread_index()].Value.store( value, std::memory_order_release ); }
-        //void                        add( CounterType value )      // not implemented yet
+        void                        add( CounterType value )        { m_blocks[thread_index()].Value.fetch_add( value, std::memory_order_relaxed ); }
 
+        // keep the lowest/highest value written (blocks are shared between threads so this can't be a plain store)
+        void                        min( CounterType value )
+        {
+            std::atomic<CounterType> & block = m_blocks[thread_index()].Value;
+            CounterType prev = block.load( std::memory_order_relaxed );
+            while( value < prev && !block.compare_exchange_weak( prev, value, std::memory_order_release, std::memory_order_relaxed ) ) { }
+        }
+        void                        max( CounterType value )
+        {
+            std::atomic<CounterType> & block = m_blocks[thread_index()].Value;
+            CounterType prev = block.load( std::memory_order_relaxed );
+            while( value > prev && !block.compare_exchange_weak( prev, value, std::memory_order_release, std::memory_order_relaxed ) ) { }
+        }
+
+        // these are not a consistent snapshot if there are concurrent writes - use reset_and_read for that
+        CounterType                 sum( ) const
+        {
+            CounterType sumVal = m_blocks[0].Value.load( std::memory_order_acquire );
+            for( int i = 1; i < countof( m_blocks ); i++ ) 
+                sumVal += m_blocks[i].Value.load( std::memory_order_acquire );
+            return sumVal;
+        }
+        CounterType                 lowest( ) const
+        {
+            CounterType minVal = m_blocks[0].Value.load( std::memory_order_acquire );
+            for( int i = 1; i < countof( m_blocks ); i++ ) 
+                minVal = std::min( minVal, m_blocks[i].Value.load( std::memory_order_acquire ) );
+            return minVal;
+        }
         CounterType                 highest( ) const
         {
-            CounterType maxVal = m_blocks[0].Value;
+            CounterType maxVal = m_blocks[0].Value.load( std::memory_order_acquire );
             for( int i = 1; i < countof( m_blocks ); i++ ) 
                 maxVal = std::max( maxVal, m_blocks[i].Value.load( std::memory_order_acquire ) );
             return maxVal;
         }
 
+        // Atomically swaps each block with its reset value (as in reset / reset_minmax) and returns what was there: every write
+        // lands either in the returned snapshot or in the counter after the reset, never in both or neither, which makes this
+        // usable for per-frame counters while writers keep going.
+        snapshot                    reset_and_read( CounterType resetValue )            { return exchange_all( resetValue, 0 ); }
+        snapshot                    reset_and_read_minmax( CounterType resetValue )     { return exchange_all( resetValue, resetValue ); }
 
     private:
+        snapshot                    exchange_all( CounterType firstValue, CounterType otherValue )
+        {
+            snapshot ret;
+            ret.Sum = ret.Lowest = ret.Highest = m_blocks[0].Value.exchange( firstValue, std::memory_order_acq_rel );
+            for( int i = 1; i < countof( m_blocks ); i++ ) 
+            {
+                CounterType value = m_blocks[i].Value.exchange( otherValue, std::memory_order_acq_rel );
+                ret.Sum     += value;
+                ret.Lowest  = std::min( ret.Lowest, value );
+                ret.Highest = std::max( ret.Highest, value );
+            }
+            return ret;
+        }
+
         int         thread_index( )
         {
             thread_local static int threadIndex = vaConcurrency::ThreadHash() % BlockCount;
@@ -97,9 +162,16 @@ namespace Vanilla
     // While in consuming (IsConsuming) state, only Count, [] access operator and GetItemsUnsafe are allowed.
     //
     // This container is unbound (will grow as needed) - Clear will remove all allocated memory.
-    template< typename ElementType, int MaxThreadsSupported = 128, int BlockElementCount = 384 >
+    //
+    // With a frame-scoped Allocator (vaFrameAllocator) the storage is dropped on every transition to 'appending' instead of
+    // being reused, so it never outlives the vaFrameArena frame ring; it gets pre-reserved to the previous count.
+    template< typename ElementType, int MaxThreadsSupported = 128, int BlockElementCount = 384, typename Allocator = std::allocator<ElementType> >
     class vaAppendConsumeList
     {
+    public:
+        typedef std::vector<ElementType, Allocator>     MasterListType;
+
+    private:
         struct LocalBlock
         {
             int                         Counter         = 0;
@@ -109,7 +181,7 @@ namespace Vanilla
         std::atomic_bool            m_consuming         = false;
 
         std::mutex                  m_masterListMutex;
-        std::vector<ElementType>    m_masterList;
+        MasterListType              m_masterList;
 
         static constexpr int        c_localBlockCount   = MaxThreadsSupported;
         std::array<LocalBlock, c_localBlockCount>    
@@ -142,8 +214,7 @@ namespace Vanilla
             return { m_masterList.data(), m_masterList.size() };
         }
 
-        std::vector<ElementType> &
-                                    GetVectorUnsafe( )
+        MasterListType &            GetVectorUnsafe( )
         {
             assert( m_consuming );
             return  m_masterList;
@@ -193,7 +264,10 @@ namespace Vanilla
             std::unique_lock masterLock( m_masterListMutex );
             for( int i = 0; i < c_localBlockCount; i++ )
                 CommitNoLock( m_localBlocks[i] );
-            m_masterList.clear(); // std::swap( m_masterList, std::vector<ElementType>{} );
+            if constexpr( vaIsFrameAllocator<Allocator>::value )
+                m_masterList = MasterListType( );
+            else
+                m_masterList.clear(); // std::swap( m_masterList, std::vector<ElementType>{} );
         }
 
         vaAppendConsumeList( const vaAppendConsumeList & )              = delete;
@@ -217,7 +291,14 @@ namespace Vanilla
             else
             {
                 // transitioning from consuming to appending
-                m_masterList.clear( );
+                if constexpr( vaIsFrameAllocator<Allocator>::value )
+                {
+                    const size_t lastCount = m_masterList.size( );
+                    m_masterList = MasterListType( );
+                    m_masterList.reserve( lastCount );
+                }
+                else
+                    m_masterList.clear( );
             }
             return true;
         }
@@ -255,6 +336,345 @@ namespace Vanilla
         }
     };
 
+    // Alternative to vaAppendConsumeList with a lock-free commit. Appending threads reserve whole chunks of BlockElementCount 
+    // elements with a single atomic increment of the chunk tail and then fill them with no synchronization at all; chunks 
+    // live in a two level (page -> chunk) directory so existing chunks never move and pages are installed with a CAS. 
+    // There is no per-thread storage so there is no MaxThreadsSupported cap - any thread (task pool or not) can append.
+    //
+    // Each thread caches the chunk it is filling for the last c_threadCacheSize lists it appended to. When all of the thread's
+    // cache entries are in recent use by other lists, the element goes into a partially filled chunk borrowed from the list's 
+    // lock-free stack of them (or a newly reserved one) which is pushed back right after, so a thread going round-robin over
+    // more lists than it can cache doesn't leave a trail of nearly empty chunks behind, and nothing ever takes a lock.
+    //
+    // Same StartAppending()/StartConsuming() contract as vaAppendConsumeList, with these differences:
+    //  * storage is not contiguous so there's no GetItemsUnsafe/GetVectorUnsafe - use Count and the [] access operator
+    //  * element order is unspecified (going from 'appending' to 'consuming' fills the partially filled chunks - the ones 
+    //    threads were filling, ones left behind by evicted cache entries and the borrowable ones - by moving elements from 
+    //    the back)
+    //  * chunks are kept and reused between appending/consuming cycles - Clear will remove all allocated memory
+    //
+    // Capacity is c_maxPageCount * c_chunksPerPage * BlockElementCount elements (~400M with the default BlockElementCount).
+    template< typename ElementType, int BlockElementCount = 384 >
+    class vaLockFreeAppendConsumeList
+    {
+        struct Chunk
+        {
+            int                         Counter         = 0;
+            uint32                      Index           = 0;        // in the chunk directory
+            std::atomic<uint32>         NextPartial     = 0;        // Index + 1 of the next one in m_partialChunks, 0 for none
+            ElementType                 Data[BlockElementCount];
+        };
+
+        // each thread remembers the chunk it is filling for the last few lists it appended to (fully associative, least recently
+        // used gets evicted, but only once it's been idle for a while); Current is dropped when m_epoch changes (StartAppending/
+        // Clear), which is unique across all lists of the same type
+        struct ThreadCacheEntry
+        {
+            const vaLockFreeAppendConsumeList * Owner   = nullptr;
+            uint64                      Epoch           = 0;
+            Chunk *                     Current         = nullptr;
+            uint64                      LastUse         = 0;
+        };
+
+        static constexpr uint32     c_chunksPerPage     = 1024;
+        static constexpr uint32     c_maxPageCount      = 1024;
+        static constexpr uint32     c_maxChunkCount     = c_chunksPerPage * c_maxPageCount;
+        static constexpr int        c_threadCacheSize   = 8;
+        // a cache entry only gets evicted after the thread did this many appends (to any list) without touching it, so each
+        // partially filled chunk left behind by an eviction was preceded by at least as many elements, which bounds memory
+        static constexpr uint64     c_evictionAge       = BlockElementCount;
+
+        static inline std::atomic<uint64>
+                                    s_epochCounter      = 0;
+
+        std::atomic_bool            m_consuming         = false;
+        uint64                      m_epoch             = 0;
+        size_t                      m_count             = 0;
+        uint32                      m_usedChunkCount    = 0;        // reserved chunks in the last appending cycle, valid while consuming
+
+        alignas( VA_ALIGN_PAD ) std::atomic<uint32>
+                                    m_chunkTail         = 0;
+        // Treiber stack of borrowable partially filled chunks: Index + 1 of the top one in the low 32 bits, a tag that changes 
+        // on every push and pop (against ABA) in the high 32 bits
+        alignas( VA_ALIGN_PAD ) std::atomic<uint64>
+                                    m_partialChunks     = 0;
+        alignas( VA_ALIGN_PAD ) std::atomic<Chunk**>
+                                    m_pages[c_maxPageCount];
+
+    public:
+        vaLockFreeAppendConsumeList( ) noexcept
+        {
+            for( uint32 i = 0; i < c_maxPageCount; i++ )
+                m_pages[i].store( nullptr, std::memory_order_relaxed );
+            m_epoch = NextEpoch( );
+        }
+        ~vaLockFreeAppendConsumeList( ) noexcept                                        { ReleaseChunks( ); }
+
+        vaLockFreeAppendConsumeList( const vaLockFreeAppendConsumeList & )              = delete;
+        vaLockFreeAppendConsumeList& operator=( const vaLockFreeAppendConsumeList& )    = delete;
+
+        // for debugging/asserting
+        bool                        IsConsuming( ) const noexcept                       { return m_consuming; }
+
+        // returns true if state changed
+        bool                        StartAppending( ) noexcept                          { return Transition( false ); }
+        bool                        StartConsuming( ) noexcept                          { return Transition( true ); }
+
+        size_t                      Count( ) const noexcept
+        { 
+            assert( m_consuming ); 
+            if( m_consuming.load() ) 
+                return m_count; 
+            else
+                return 0;
+        }
+
+        // chunks reserved in the last appending cycle (for memory use diagnostics)
+        uint32                      UsedChunkCount( ) const noexcept                    { assert( m_consuming ); return m_usedChunkCount; }
+
+        ElementType & operator [] ( size_t index ) noexcept
+        {
+            assert( m_consuming && index < m_count );
+            return GetChunk( (uint32)( index / BlockElementCount ) )->Data[index % BlockElementCount];
+        }
+
+        const ElementType & operator [] ( size_t index ) const noexcept
+        {
+            assert( m_consuming && index < m_count );
+            return GetChunk( (uint32)( index / BlockElementCount ) )->Data[index % BlockElementCount];
+        }
+
+        void                        Append( const ElementType & element ) noexcept
+        {
+            Append( std::move(ElementType{element}) );
+        }
+        void                        Append( ElementType && element ) noexcept
+        {
+            assert( !m_consuming.load( std::memory_order_relaxed ) );
+            ThreadCacheEntry * entry = GetThreadCacheEntry( );
+
+            // the thread's cache is busy with other lists - borrow a chunk just for this one element
+            if( entry == nullptr )
+            {
+                Chunk * chunk = PopPartialChunk( );
+                if( chunk == nullptr )
+                    chunk = AcquireChunk( m_chunkTail.fetch_add( 1, std::memory_order_relaxed ) );
+                chunk->Data[chunk->Counter++] = std::move(element);
+                if( chunk->Counter < BlockElementCount )
+                    PushPartialChunk( *chunk );
+                return;
+            }
+
+            // if full (or none yet), take a borrowable one or reserve a new one
+            Chunk * & chunk = entry->Current;
+            if( chunk == nullptr || chunk->Counter == BlockElementCount )
+            {
+                chunk = PopPartialChunk( );
+                if( chunk == nullptr )
+                    chunk = AcquireChunk( m_chunkTail.fetch_add( 1, std::memory_order_relaxed ) );
+            }
+
+            chunk->Data[chunk->Counter++] = std::move(element);
+        }
+
+        // This one ignores the thread's current chunk and reserves enough new chunks for the whole batch with one atomic op
+        void                        AppendBatch( const ElementType * elements, const int arrayCount ) noexcept
+        {
+            assert( !m_consuming.load( std::memory_order_relaxed ) );
+            if( arrayCount <= 0 )
+                return;
+
+            const uint32 chunkCount = ( arrayCount + BlockElementCount - 1 ) / BlockElementCount;
+            const uint32 firstChunk = m_chunkTail.fetch_add( chunkCount, std::memory_order_relaxed );
+            for( uint32 i = 0; i < chunkCount; i++ )
+            {
+                Chunk * chunk = AcquireChunk( firstChunk + i );
+                const int offset = (int)i * BlockElementCount;
+                chunk->Counter = std::min( BlockElementCount, arrayCount - offset );
+                for( int j = 0; j < chunk->Counter; j++ )
+                    chunk->Data[j] = elements[offset + j];
+            }
+        }
+
+        // Not thread-safe (can't be called while other threads are appending)
+        void                        Clear( )
+        {
+            ReleaseChunks( );
+            m_chunkTail.store( 0, std::memory_order_relaxed );
+            m_partialChunks.store( 0, std::memory_order_relaxed );
+            m_usedChunkCount    = 0;
+            m_count             = 0;
+            m_epoch             = NextEpoch( );
+        }
+
+    private:
+
+        static uint64               NextEpoch( ) noexcept                               { return s_epochCounter.fetch_add( 1, std::memory_order_relaxed ) + 1; }
+
+        bool                        Transition( bool consuming ) noexcept
+        {
+            bool prevVal = m_consuming.exchange( consuming );
+            if( prevVal == consuming )
+                return false;     // transitioning into the same state - relaxed the same way as vaAppendConsumeList
+
+            if( !prevVal )  // transitioning from appending to consuming
+            {
+                m_usedChunkCount = std::min( m_chunkTail.load( std::memory_order_relaxed ), c_maxChunkCount );
+                Compact( );
+            }
+            else
+            {
+                // transitioning from consuming to appending - keep the chunks for reuse, just empty them
+                for( uint32 i = 0; i < m_usedChunkCount; i++ )
+                    GetChunk( i )->Counter = 0;
+                m_chunkTail.store( 0, std::memory_order_relaxed );
+                m_partialChunks.store( 0, std::memory_order_relaxed );
+                m_usedChunkCount    = 0;
+                m_count             = 0;
+                m_epoch             = NextEpoch( );
+            }
+            return true;
+        }
+
+        // Fill partially filled chunks from the front with elements from the back so that all chunks except the last are full
+        void                        Compact( ) noexcept
+        {
+            uint32 front = 0;
+            uint32 back = m_usedChunkCount;     // one past
+            while( front + 1 < back )
+            {
+                Chunk & frontChunk = *GetChunk( front );
+                if( frontChunk.Counter == BlockElementCount )
+                {
+                    front++;
+                    continue;
+                }
+                Chunk & backChunk = *GetChunk( back - 1 );
+                if( backChunk.Counter == 0 )
+                {
+                    back--;
+                    continue;
+                }
+                const int moveCount = std::min( BlockElementCount - frontChunk.Counter, backChunk.Counter );
+                for( int i = 0; i < moveCount; i++ )
+                    frontChunk.Data[frontChunk.Counter++] = std::move( backChunk.Data[--backChunk.Counter] );
+            }
+            m_count = (size_t)front * BlockElementCount + ( ( front < m_usedChunkCount ) ? ( GetChunk( front )->Counter ) : ( 0 ) );
+        }
+
+        Chunk *                     GetChunk( uint32 chunkIndex ) const noexcept
+        {
+            return m_pages[chunkIndex / c_chunksPerPage].load( std::memory_order_relaxed )[chunkIndex % c_chunksPerPage];
+        }
+
+        // Only the thread that reserved 'chunkIndex' (in this appending cycle) touches its directory slot
+        Chunk *                     AcquireChunk( uint32 chunkIndex ) noexcept
+        {
+            const uint32 pageIndex = chunkIndex / c_chunksPerPage;
+            if( pageIndex >= c_maxPageCount )
+            {
+                // this is catastrophic - you need to either increase BlockElementCount or figure out what is adding so many elements
+                assert( false );
+                abort( );
+            }
+
+            Chunk ** page = m_pages[pageIndex].load( std::memory_order_acquire );
+            if( page == nullptr )
+            {
+                Chunk ** newPage = new Chunk*[c_chunksPerPage]( );
+                if( m_pages[pageIndex].compare_exchange_strong( page, newPage, std::memory_order_acq_rel, std::memory_order_acquire ) )
+                    page = newPage;
+                else
+                    delete[] newPage;   // someone else installed it first, 'page' now points to theirs
+            }
+
+            Chunk * & chunk = page[chunkIndex % c_chunksPerPage];
+            if( chunk == nullptr )
+            {
+                chunk = new Chunk;
+                chunk->Index = chunkIndex;
+            }
+            assert( chunk->Counter == 0 && chunk->Index == chunkIndex );
+            return chunk;
+        }
+
+        // A popped chunk is owned by the popping thread until it's pushed back (if ever), so its Counter and Data need no
+        // synchronization beyond the release/acquire of the push/pop; chunks are never freed while appending so reading
+        // NextPartial of one that another thread popped in the meantime is harmless (the tag makes that CAS fail)
+        void                        PushPartialChunk( Chunk & chunk ) noexcept
+        {
+            uint64 head = m_partialChunks.load( std::memory_order_relaxed );
+            uint64 newHead;
+            do
+            {
+                chunk.NextPartial.store( (uint32)head, std::memory_order_relaxed );
+                newHead = ( ( ( head >> 32 ) + 1 ) << 32 ) | (uint64)( chunk.Index + 1 );
+            } while( !m_partialChunks.compare_exchange_weak( head, newHead, std::memory_order_release, std::memory_order_relaxed ) );
+        }
+
+        Chunk *                     PopPartialChunk( ) noexcept
+        {
+            uint64 head = m_partialChunks.load( std::memory_order_acquire );
+            while( (uint32)head != 0 )
+            {
+                Chunk * chunk = GetChunk( (uint32)head - 1 );
+                const uint64 newHead = ( ( ( head >> 32 ) + 1 ) << 32 ) | (uint64)chunk->NextPartial.load( std::memory_order_relaxed );
+                if( m_partialChunks.compare_exchange_weak( head, newHead, std::memory_order_acquire, std::memory_order_acquire ) )
+                    return chunk;
+            }
+            return nullptr;
+        }
+
+        // nullptr if all entries are in recent use by other lists
+        ThreadCacheEntry *          GetThreadCacheEntry( ) noexcept
+        {
+            thread_local static ThreadCacheEntry s_threadCache[c_threadCacheSize];
+            thread_local static uint64 s_useCounter = 0;
+            const uint64 useCounter = ++s_useCounter;
+
+            ThreadCacheEntry * victim = &s_threadCache[0];
+            for( ThreadCacheEntry & entry : s_threadCache )
+            {
+                if( entry.Owner == this )
+                {
+                    // chunks got recycled since - the old one is not ours any more
+                    if( entry.Epoch != m_epoch )
+                    {
+                        entry.Epoch     = m_epoch;
+                        entry.Current   = nullptr;
+                    }
+                    entry.LastUse = useCounter;
+                    return &entry;
+                }
+                if( entry.LastUse < victim->LastUse )
+                    victim = &entry;
+            }
+
+            if( victim->Owner != nullptr && useCounter - victim->LastUse <= c_evictionAge )
+                return nullptr;
+
+            // evicted entry's partially filled chunk (if any) just stays that way until Compact
+            victim->Owner           = this;
+            victim->Epoch           = m_epoch;
+            victim->Current         = nullptr;
+            victim->LastUse         = useCounter;
+            return victim;
+        }
+
+        void                        ReleaseChunks( ) noexcept
+        {
+            for( uint32 i = 0; i < c_maxPageCount; i++ )
+            {
+                Chunk ** page = m_pages[i].exchange( nullptr, std::memory_order_relaxed );
+                if( page == nullptr )
+                    continue;
+                for( uint32 j = 0; j < c_chunksPerPage; j++ )
+                    delete page[j];
+                delete[] page;
+            }
+        }
+    };
+
     // Very similar to the vaAppendConsumeList, except it holds unique elements using an unordered_set
     template< typename ElementType, int MaxThreadsSupported = 128, int BlockElementCount = 128 >
     class vaAppendConsumeSet
@@ -56,6 +56,7 @@ std::vector<weak_ptr<bool>> vaCore::s_contentDirtyFlags;
 LARGE_INTEGER   vaCore::s_appStartTime;
 LARGE_INTEGER   vaCore::s_timerFrequency;
 double          vaCore::s_timerFrequencyRD;
+uint64          vaCore::s_appStartTSC;
 #else
 std::chrono::time_point<std::chrono::steady_clock>
 vaCore::s_appStartTime;
@@ -81,6 +82,7 @@ void vaCore::Initialize( bool liveRestart )
     {
 #ifdef VA_USE_NATIVE_WINDOWS_TIMER
         ::QueryPerformanceCounter(&s_appStartTime);
+        s_appStartTSC = __rdtsc( );
         ::QueryPerformanceFrequency(&s_timerFrequency);
         s_timerFrequencyRD = 1.0 / double(s_timerFrequency.QuadPart);
 #else
@@ -201,6 +203,8 @@ void vaCore::Deinitialize( bool liveRestart )
 
         vaFramePtrStatic::Cleanup( );
 
+        vaFrameArena::Cleanup( );
+
         vaMemory::Deinitialize( );
     }
     else
@@ -211,6 +215,27 @@ void vaCore::Deinitialize( bool liveRestart )
     s_initialized = false;
 }
 
+#ifdef VA_USE_NATIVE_WINDOWS_TIMER
+double vaCore::TimeTickPeriod( )
+{
+    // TSC rate from QPC over the time since app start; the longer the span the better, so it's done as late as possible (first
+    // use) and it waits until there's at least c_minSpan to measure over
+    static const double period = [ ]( )
+    {
+        constexpr double c_minSpan = 0.02;
+        LARGE_INTEGER now; uint64 tsc;
+        do
+        {
+            ::QueryPerformanceCounter( &now );
+            tsc = __rdtsc( );
+        } while( ( now.QuadPart - s_appStartTime.QuadPart ) * s_timerFrequencyRD < c_minSpan );
+        const double seconds = ( now.QuadPart - s_appStartTime.QuadPart ) * s_timerFrequencyRD;
+        return seconds / (double)( ( tsc - s_appStartTSC ) >> c_timeTickTSCShift );
+    }( );
+    return period;
+}
+#endif
+
 void vaCore::DebugOutput( const wstring & message )
 {
     vaPlatformBase::DebugOutput( message.c_str( ) );
@@ -16,5 +16,6 @@
 #include "vaMemory.h"
 #include "vaLog.h"
 #include "vaFramePtr.h"
+#include "vaFrameArena.h"
 
 #include "System/vaThreading.h"
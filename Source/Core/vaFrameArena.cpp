@@ -0,0 +1,168 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "vaFrameArena.h"
+
+#include "vaConcurrency.h"
+
+#include <mutex>
+
+using namespace Vanilla;
+
+std::atomic_uint64_t vaFrameArena::s_frameCounter = 0;
+
+namespace
+{
+    struct ArenaBlock
+    {
+        uint8 *                             Data                = nullptr;
+        size_t                              Size                = 0;
+    };
+
+    // all blocks used by one thread during one frame
+    struct ArenaSlot
+    {
+        std::vector<ArenaBlock>             Blocks;
+        size_t                              Current             = 0;    // index of the block being bumped
+        size_t                              Offset              = 0;    // within Blocks[Current]
+    };
+
+    // only ever touched by its thread, except for the stats (atomics) and Cleanup
+    struct alignas( VA_ALIGN_PAD ) ThreadArena
+    {
+        ArenaSlot                           Slots[vaFrameArena::c_FramesInFlight];
+        ArenaSlot *                         Active              = nullptr;
+        uint64                              ActiveFrame         = std::numeric_limits<uint64>::max( );
+
+        std::atomic_uint64_t                Allocations         = 0;
+        std::atomic_uint64_t                Bytes               = 0;
+        std::atomic_uint64_t                HeapAllocations     = 0;
+    };
+
+    // list of all thread arenas - only locked when a thread allocates for the first time, for stats and on cleanup
+    std::mutex                              s_arenasMutex;
+    std::vector<ThreadArena *>              s_arenas;
+    vaFrameArena::Stats                     s_lastFrameStats;
+    vaFrameArena::Stats                     s_lastTotals;
+
+    thread_local ThreadArena *              s_threadArena       = nullptr;
+
+    ThreadArena & GetThreadArena( )
+    {
+        if( s_threadArena == nullptr )
+        {
+            // owned by s_arenas and not by the thread: memory allocated on a thread can outlive it (for up to c_FramesInFlight frames)
+            s_threadArena = new ThreadArena;
+            std::unique_lock lock( s_arenasMutex );
+            s_arenas.push_back( s_threadArena );
+        }
+        return *s_threadArena;
+    }
+
+    inline uint8 * AlignUp( uint8 * pointer, size_t alignment )
+    {
+        return reinterpret_cast<uint8*>( ( reinterpret_cast<uintptr_t>( pointer ) + alignment - 1 ) & ~( (uintptr_t)alignment - 1 ) );
+    }
+}
+
+void * vaFrameArena::Allocate( size_t size, size_t alignment )
+{
+    assert( alignment > 0 && ( alignment & ( alignment - 1 ) ) == 0 );
+    ThreadArena & arena = GetThreadArena( );
+
+    // first allocation on this thread in a new frame: switch to the slot for it - its contents are c_FramesInFlight frames old
+    const uint64 frame = CurrentFrame( );
+    if( frame != arena.ActiveFrame )
+    {
+        arena.ActiveFrame   = frame;
+        arena.Active        = &arena.Slots[frame % c_FramesInFlight];
+        arena.Active->Current   = 0;
+        arena.Active->Offset    = 0;
+    }
+    ArenaSlot & slot = *arena.Active;
+
+    arena.Allocations.store( arena.Allocations.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+    arena.Bytes.store( arena.Bytes.load( std::memory_order_relaxed ) + size, std::memory_order_relaxed );
+
+    // bump through existing blocks; the ones that are too small for this allocation get skipped for the rest of the frame
+    for( ; slot.Current < slot.Blocks.size( ); slot.Current++, slot.Offset = 0 )
+    {
+        const ArenaBlock & block = slot.Blocks[slot.Current];
+        uint8 * pointer = AlignUp( block.Data + slot.Offset, alignment );
+        if( pointer + size <= block.Data + block.Size )
+        {
+            slot.Offset = ( pointer + size ) - block.Data;
+            return pointer;
+        }
+    }
+
+    // out of space - new block (kept by the slot from now on)
+    ArenaBlock block;
+    block.Size  = std::max( c_BlockSize, size + alignment );
+    block.Data  = static_cast<uint8*>( ::operator new( block.Size ) );
+    arena.HeapAllocations.store( arena.HeapAllocations.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+    slot.Blocks.push_back( block );
+    slot.Current = slot.Blocks.size( ) - 1;
+
+    uint8 * pointer = AlignUp( block.Data, alignment );
+    slot.Offset = ( pointer + size ) - block.Data;
+    return pointer;
+}
+
+vaFrameArena::Stats vaFrameArena::TotalStats( )
+{
+    std::unique_lock lock( s_arenasMutex );
+    Stats totals;
+    for( ThreadArena * arena : s_arenas )
+    {
+        totals.Allocations      += arena->Allocations.load( std::memory_order_relaxed );
+        totals.Bytes            += arena->Bytes.load( std::memory_order_relaxed );
+        totals.HeapAllocations  += arena->HeapAllocations.load( std::memory_order_relaxed );
+    }
+    return totals;
+}
+
+vaFrameArena::Stats vaFrameArena::LastFrameStats( )
+{
+    std::unique_lock lock( s_arenasMutex );
+    return s_lastFrameStats;
+}
+
+void vaFrameArena::NextFrame( )
+{
+    const Stats totals = TotalStats( );
+    {
+        std::unique_lock lock( s_arenasMutex );
+        s_lastFrameStats.Allocations        = totals.Allocations     - s_lastTotals.Allocations;
+        s_lastFrameStats.Bytes              = totals.Bytes           - s_lastTotals.Bytes;
+        s_lastFrameStats.HeapAllocations    = totals.HeapAllocations - s_lastTotals.HeapAllocations;
+        s_lastTotals = totals;
+    }
+    s_frameCounter.fetch_add( 1, std::memory_order_relaxed );
+}
+
+void vaFrameArena::Cleanup( )
+{
+    std::unique_lock lock( s_arenasMutex );
+    for( ThreadArena * arena : s_arenas )
+    {
+        for( ArenaSlot & slot : arena->Slots )
+            for( ArenaBlock & block : slot.Blocks )
+                ::operator delete( block.Data );
+        delete arena;
+    }
+    s_arenas.clear( );
+    s_arenas.shrink_to_fit( );
+    s_lastFrameStats    = Stats( );
+    s_lastTotals        = Stats( );
+    // threads that allocate after this will get a new arena, but the thread_local pointers of existing threads can't be
+    // reached from here - so this is only safe at shutdown, after the thread pool is gone
+    s_threadArena       = nullptr;
+}
@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "vaCore.h"
+
+#include <atomic>
+#include <vector>
+
+namespace Vanilla
+{
+    // Per-thread bump allocator for transient, frame-scoped data.
+    // Each thread gets its own set of c_FramesInFlight slots of memory blocks; allocating is a pointer bump in the calling
+    // thread's slot for the current frame, with no locks and no atomics other than reading the frame counter. Memory is never
+    // freed individually - a slot (and everything allocated from it) gets reused by its thread c_FramesInFlight frames later,
+    // so anything allocated during frame N stays valid until the end of frame N + c_FramesInFlight - 1. Blocks are kept (not
+    // returned to the heap) so after warmup there are no heap allocations at all.
+    // NextFrame must be called once per frame (vaApplicationBase does it together with vaFramePtrStatic::NextFrame).
+    // Use through vaFrameAllocator / vaFrameVector; containers using it must not outlive the frame ring - release them (assign
+    // an empty container) at least every c_FramesInFlight-1 frames.
+    class vaFrameArena final
+    {
+        friend class vaCore;
+
+    public:
+        static constexpr int                c_FramesInFlight    = 3;
+        static constexpr size_t             c_BlockSize         = 1024 * 1024;
+
+        struct Stats
+        {
+            uint64                          Allocations         = 0;    // number of Allocate calls
+            uint64                          Bytes               = 0;    // total bytes allocated
+            uint64                          HeapAllocations     = 0;    // number of new blocks allocated from the heap
+        };
+
+    private:
+        static std::atomic_uint64_t         s_frameCounter;
+
+    public:
+        // thread-safe (lock-free); never returns nullptr
+        static void *                       Allocate( size_t size, size_t alignment );
+
+        static uint64                       CurrentFrame( ) noexcept        { return s_frameCounter.load( std::memory_order_relaxed ); }
+
+        // stats for the previous frame (totals across all threads)
+        static Stats                        LastFrameStats( );
+        // running totals across all threads since startup
+        static Stats                        TotalStats( );
+
+        // advances the frame counter; main thread only (vaApplicationBase calls it once per frame), Allocate can be called concurrently
+        static void                         NextFrame( );
+
+    private:
+        // frees all memory; no allocations must be alive and no other threads must be using the arena
+        static void                         Cleanup( );
+    };
+
+    // STL compatible allocator adapter for vaFrameArena; deallocate is a no-op (there's no safe way to tell a stale pointer from
+    // a live one that ended up at the same address) - see vaFrameArena for lifetime rules.
+    template< typename Type >
+    class vaFrameAllocator
+    {
+    public:
+        typedef Type                        value_type;
+        typedef std::true_type              is_frame_scoped;        // see vaIsFrameAllocator
+
+        vaFrameAllocator( ) noexcept        { }
+        template< typename OtherType >
+        vaFrameAllocator( const vaFrameAllocator<OtherType> & ) noexcept { }
+
+        Type *                              allocate( size_t count )                        { return static_cast<Type*>( vaFrameArena::Allocate( count * sizeof( Type ), alignof( Type ) ) ); }
+        void                                deallocate( Type *, size_t ) noexcept           { }
+
+        template< typename OtherType >
+        bool                                operator == ( const vaFrameAllocator<OtherType> & ) const noexcept  { return true; }
+        template< typename OtherType >
+        bool                                operator != ( const vaFrameAllocator<OtherType> & ) const noexcept  { return false; }
+    };
+
+    template< typename Type >
+    using vaFrameVector = std::vector< Type, vaFrameAllocator<Type> >;
+
+    // for containers that can work with both regular and frame allocators and need to know whether to drop their storage each frame
+    template< typename Allocator, typename = void >
+    struct vaIsFrameAllocator : std::false_type { };
+    template< typename Allocator >
+    struct vaIsFrameAllocator< Allocator, std::void_t<typename Allocator::is_frame_scoped> > : Allocator::is_frame_scoped { };
+}
@@ -11,6 +11,7 @@
 #pragma once
 
 #include "Core/vaProfiler.h"
+#include "Core/vaTracerStream.h"
 #include "Core/System/vaThreading.h"
 
 #include "Core/vaApplicationBase.h"
@@ -72,9 +73,18 @@ alignas( VA_ALIGN_PAD * 2 ) std::mutex                                  vaTracer
 //std::map< std::thread::id, std::weak_ptr<vaTracer::ThreadContext> >     vaTracer::s_threadContexts;
 std::vector< std::weak_ptr<vaTracer::ThreadContext> >                   vaTracer::s_threadContexts;
 std::weak_ptr<vaTracer::ThreadContext>                                  vaTracer::s_mainThreadContext;
+std::shared_mutex                                                       vaTracer::s_namesMutex;
+vaStringDictionary                                                      vaTracer::s_namesDictionary;
+std::vector<vaMappedString>                                             vaTracer::s_names;
+std::unordered_map<const char *, uint32>                                vaTracer::s_nameIDs;
+std::thread                                                             vaTracer::s_collectorThread;
+std::mutex                                                              vaTracer::s_collectorMutex;
+std::condition_variable                                                 vaTracer::s_collectorCV;
+bool                                                                    vaTracer::s_collectorExit = false;
 
 vaTracer::ThreadContext::ThreadContext( const string & name, const std::thread::id & threadID, bool automaticFrameIncrement, bool isGPU ) : Name( name ), ThreadID( threadID ), AutomaticFrameIncrement( automaticFrameIncrement ), IsGPU( isGPU )
 {
+    Ring = std::make_unique<CompactEntry[]>( c_RingCapacity );
     m_UI_ProfilingThreadNamesDirty = true;
 }
 
@@ -83,6 +93,157 @@ vaTracer::ThreadContext::~ThreadContext( )
     m_UI_ProfilingThreadNamesDirty = true;
 }
 
+static bool EntryOrder( const vaTracer::Entry & a, const vaTracer::Entry & b )
+{
+    return ( a.Beginning != b.Beginning ) ? ( a.Beginning < b.Beginning ) : ( a.Depth < b.Depth );
+}
+
+void vaTracer::ThreadContext::CollectNoLock( )
+{
+    const uint64 head = RingHead.load( std::memory_order_acquire );
+    uint64 tail = RingTail.load( std::memory_order_relaxed );
+    if( head == tail && PendingGroup.empty( ) )
+        return;
+
+    const double period = vaCore::TimeTickPeriod( );
+    for( ; tail != head; tail++ )
+    {
+        const CompactEntry & record = Ring[tail & ( c_RingCapacity - 1 )];
+        const uint32 nameID = record.NameIDAndDepth & c_NameIDMask;
+        if( nameID == c_BaseRecordNameID )
+        {
+            ConsumerBase = (int64)( ( (uint64)record.Duration << 32 ) | (uint64)record.BeginDelta );
+            continue;
+        }
+
+        const int64 begin = ConsumerBase + record.BeginDelta;
+        Entry entry( NameFromID( nameID ), (int)( record.NameIDAndDepth >> 24 ), begin * period, record.SubID );
+        entry.End = ( begin + (int64)record.Duration ) * period;
+        PendingGroup.push_back( entry );
+
+        // records come in the order scopes end, so a top level one closes the group
+        if( entry.Depth == 0 )
+        {
+            std::sort( PendingGroup.begin( ), PendingGroup.end( ), EntryOrder );
+            AppendCompletedNoLock( PendingGroup.data( ), (int)PendingGroup.size( ), false );
+            PendingGroup.clear( );
+        }
+    }
+    RingTail.store( tail, std::memory_order_release );
+
+    // anything the open top level scope can't close (there is none, or they began before it - BatchAddSingleLevelEntries
+    // outside of any scope for ex.) would otherwise wait for the next top level scope to end, which might never come
+    if( PendingGroup.empty( ) )
+        return;
+    const int64 openRootBegin = OpenRootBegin.load( std::memory_order_acquire );
+    // a top level scope that ended (or a new one that began after one ended) since 'head' was read: its record isn't
+    // drained yet so leave everything for the next drain
+    if( RingHead.load( std::memory_order_acquire ) != head )
+        return;
+    auto stillOpen = PendingGroup.begin( );
+    if( openRootBegin == c_NoOpenRoot )
+        stillOpen = PendingGroup.end( );
+    else
+    {
+        const double openRootBeginning = openRootBegin * period;
+        stillOpen = std::stable_partition( PendingGroup.begin( ), PendingGroup.end( ), [openRootBeginning]( const Entry & entry ) { return entry.Beginning < openRootBeginning; } );
+    }
+    if( stillOpen == PendingGroup.begin( ) )
+        return;
+    std::sort( PendingGroup.begin( ), stillOpen, EntryOrder );
+    AppendCompletedNoLock( PendingGroup.data( ), (int)( stillOpen - PendingGroup.begin( ) ), false );
+    PendingGroup.erase( PendingGroup.begin( ), stillOpen );
+}
+
+void vaTracer::ThreadContext::AppendCompletedNoLock( Entry * entries, int count, bool incrementFrameCounter )
+{
+    // if there's a viewer attached
+    auto attachedViewer = AttachedViewer.lock( );
+    if( attachedViewer != nullptr )
+        attachedViewer->UpdateCallback( entries, count, incrementFrameCounter );
+
+    if( vaTracerStream::IsActive( ) )
+        vaTracerStream::OnEntries( *this, entries, count );
+
+    Timeline.Append( entries, count );
+
+    // remove older
+    Timeline.Defrag( vaCore::TimeFromAppStart( ) - c_maxCaptureDuration );
+}
+
+uint32 vaTracer::RegisterName( const char * name )
+{
+    std::unique_lock lock( s_namesMutex );
+    vaMappedString mappedName = s_namesDictionary.Map( name );
+    auto it = s_nameIDs.find( mappedName );
+    if( it != s_nameIDs.end( ) )
+        return it->second;
+
+    const uint32 nameID = (uint32)s_names.size( );
+    assert( nameID < c_BaseRecordNameID );
+    s_names.push_back( mappedName );
+    s_nameIDs.insert( { mappedName, nameID } );
+    return nameID;
+}
+
+vaMappedString vaTracer::NameFromID( uint32 nameID )
+{
+    std::shared_lock lock( s_namesMutex );
+    assert( nameID < s_names.size( ) );
+    return s_names[nameID];
+}
+
+void vaTracer::Collect( )
+{
+    std::vector<shared_ptr<ThreadContext>> contexts;
+    {
+        std::lock_guard lock( s_globalMutex );
+        contexts.reserve( s_threadContexts.size( ) );
+        for( auto & weakContext : s_threadContexts )
+            if( auto context = weakContext.lock( ) )
+                contexts.push_back( context );
+    }
+    for( auto & context : contexts )
+    {
+        std::lock_guard lock( context->TimelineMutex );
+        context->CollectNoLock( );
+    }
+}
+
+void vaTracer::StartCollectorNoLock( )
+{
+    if( s_collectorThread.joinable( ) )
+        return;
+    s_collectorExit = false;
+    s_collectorThread = std::thread( &vaTracer::CollectorLoop );
+}
+
+void vaTracer::StopCollector( )
+{
+    {
+        std::lock_guard lock( s_collectorMutex );
+        s_collectorExit = true;
+    }
+    s_collectorCV.notify_all( );
+    if( s_collectorThread.joinable( ) )
+        s_collectorThread.join( );
+}
+
+// not instrumented - it would be tracing itself
+void vaTracer::CollectorLoop( )
+{
+    vaThreading::SetThreadName( "vaTracer::CollectorLoop" );
+    std::unique_lock lock( s_collectorMutex );
+    while( !s_collectorExit )
+    {
+        lock.unlock( );
+        Collect( );
+        vaTracerStream::Tick( );
+        lock.lock( );
+        s_collectorCV.wait_for( lock, c_collectInterval, [ ] { return s_collectorExit; } );
+    }
+}
+
 void vaTracer::DumpChromeTracingReportToFile( double duration )
 {
     string report = vaTracer::CreateChromeTracingReport( duration );
@@ -234,6 +395,12 @@ void vaTracer::Cleanup( bool soft )
     m_UI_ProfilingThreadNames.clear();
     m_UI_ProfilingSelectedThreadIndex = -1;
 
+    if( !soft )
+    {
+        vaTracerStream::Stop( );
+        StopCollector( );
+    }
+
     {
         std::lock_guard lock( s_globalMutex );
         if( !soft )
@@ -265,6 +432,22 @@ void vaTracer::TickImGui( vaApplicationBase & application, float deltaTime )
         vaTracer::DumpChromeTracingReportToFile();
     if( ImGui::IsItemHovered() )  ImGui::SetTooltip( "This writes out a chrome tracing report to a file located \nin the same folder as executable - to view open Chrome tab, \nnavigate to 'chrome://tracing/' and drag & drop file into it" );
 
+    if( !vaTracerStream::IsActive( ) )
+    {
+        if( ImGui::Button( "Start streaming capture to file", {-1, 0} ) )
+        {
+            static int captureIndex = 0; captureIndex++;
+            vaTracerStream::Start( vaCore::GetExecutableDirectory( ) + vaStringTools::SimpleWiden( vaStringTools::Format( "tracer_stream_%03d.vatrace", captureIndex ) ) );
+        }
+        if( ImGui::IsItemHovered() )  ImGui::SetTooltip( "Continuously writes everything traced (all threads and GPU) to a compressed file \nin the same folder as executable, until stopped - for long captures; convert with \n'-traceconvert <file> [-traceformat perfetto]'" );
+    }
+    else
+    {
+        vaTracerStream::Stats stats = vaTracerStream::GetStats( );
+        if( ImGui::Button( vaStringTools::Format( "Stop streaming capture (%.1f MB, %llu dropped)", stats.BytesWritten / ( 1024.0 * 1024.0 ), stats.DroppedEntries ).c_str( ), {-1, 0} ) )
+            vaTracerStream::Stop( );
+    }
+
     ImGui::Separator();
     
     // first time initialize 
@@ -16,6 +16,7 @@
 #include "Core/vaCoreIncludes.h"
 
 #include <unordered_map>
+#include <condition_variable>
 
 namespace Vanilla
 {
@@ -46,6 +47,23 @@ namespace Vanilla
 
         };
 
+        // What ThreadContext::OnEnd writes into the context's ring - one 16 byte record per finished scope. Times are in
+        // vaCore::TimeTicksFromAppStart ticks, as 32-bit deltas from the ring's current base (a base record sets a new one when
+        // a delta would not fit); names are IDs from RegisterName.
+        struct CompactEntry
+        {
+            uint32                                              NameIDAndDepth;     // [23..0] name ID (c_BaseRecordNameID for base records), [31..24] depth
+            int32                                               SubID;
+            uint32                                              BeginDelta;         // from the base; low 32 bits of the new base for base records
+            uint32                                              Duration;           // saturated (~90s, see vaCore::TimeTicksFromAppStart); high 32 bits of the new base for base records
+        };
+        static_assert( sizeof( CompactEntry ) == 16, "CompactEntry is meant to be 16 bytes" );
+
+        static constexpr uint32                                 c_NameIDMask        = 0x00FFFFFF;
+        static constexpr uint32                                 c_BaseRecordNameID  = c_NameIDMask;
+        static constexpr uint32                                 c_RingCapacity      = 1 << 14;      // CompactEntry-s per thread context (256kB); records that don't fit get dropped
+        static constexpr int                                    c_MaxOpenDepth      = 64;           // scopes nested deeper than this are not recorded
+
         struct TimelineContainer
         {
             std::vector<Entry>                                  ContainerA;
@@ -85,6 +103,9 @@ namespace Vanilla
             }
         };
 
+        // Producer side (OnBegin/OnEnd/BatchAddSingleLevelEntries) is wait-free and must only be used by one thread at a time: open
+        // scopes are kept in a fixed size stack and finished ones get written into a fixed size single-producer ring, which the
+        // background collector (or Capture) drains into Timeline and to the attached viewer - one finished top level scope at a time.
         struct ThreadContext
         {
             string                                              Name;
@@ -94,45 +115,78 @@ namespace Vanilla
 
             vaStringDictionary                                  NameDictionary;
 
-            std::shared_mutex                                   TimelineMutex;
+            std::shared_mutex                                   TimelineMutex;          // consumer side only - producers never lock
             TimelineContainer                                   Timeline;
 
-            int                                                 SortOrderCounter    = 0;
-
-            std::vector<Entry>                                  LocalTimeline;
-            std::vector<int>                                    CurrentOpenStack;       // stack of LocalTimeline indices
-            double                                              NextDefragTime      = 0;
-
             std::weak_ptr<vaTracerView>                         AttachedViewer;         // secured with TimelineMutex!!!
 
             // just a marker saying that it needs to get re-created
             std::atomic_bool                                    Abandoned           = false;
 
+        private:
+            friend class vaTracer;
+            friend class vaTracerStream;
+
+            static constexpr int64                              c_NoOpenRoot        = 0x7FFFFFFFFFFFFFFFll;
+
+            struct OpenScope
+            {
+                uint32                                          NameID;
+                int32                                           SubID;
+                int64                                           Begin;
+            };
+
+            // producer side
+            OpenScope                                           OpenStack[c_MaxOpenDepth];
+            int                                                 OpenDepth           = 0;
+            int64                                               ProducerBase        = 0;
+            uint64                                              CachedTail          = 0;
+            std::unordered_map<string_view, uint32>             NameIDCache;            // name -> RegisterName ID; keys point into vaTracer's copies of the names
+
+            std::unique_ptr<CompactEntry[]>                     Ring;
+            alignas( VA_ALIGN_PAD ) std::atomic_uint64_t        RingHead            = 0;    // written by the producer
+            std::atomic_uint64_t                                Dropped             = 0;    // written by the producer
+            std::atomic_int64_t                                 OpenRootBegin       = c_NoOpenRoot; // written by the producer; begin of the open top level scope
+            alignas( VA_ALIGN_PAD ) std::atomic_uint64_t        RingTail            = 0;    // written by the consumer
+
+            // consumer side, secured with TimelineMutex
+            int64                                               ConsumerBase        = 0;
+            std::vector<Entry>                                  PendingGroup;           // finished scopes of the top level scope that is still open
+            uint64                                              StreamSession       = 0;    // vaTracerStream capture this context was declared in
+            uint32                                              StreamContextID     = 0;
+
+        public:
             ThreadContext( const string & name, const std::thread::id & id = std::thread::id(), bool automaticFrameIncrement = true, bool isGPU = false );
             ~ThreadContext( );
 
             vaMappedString                                      MapName( const string & name )       { return NameDictionary.Map( name ); }
             vaMappedString                                      MapName( const char * name )         { return NameDictionary.Map( name ); }
 
-            // inline void                                         OnEvent( const string & name )  { name; assert( false ); }
+            // ID of a name (doesn't have to be mapped); cached per context so this only locks the first time
+            inline uint32                                       NameID( const char * name );
 
-//            inline void                                         OnBegin( const string & name, int subID =0  )
-//            {
-//                OnBegin( MapName(name), subID );
-//            }
-
-            inline void                                         OnBegin( vaMappedString name, int subID = 0 )
+            // returns the depth the scope was opened at
+            inline int                                          OnBegin( uint32 nameID, int subID = 0 )
             {
-                auto now = vaCore::TimeFromAppStart( );
-                LocalTimeline.emplace_back( Entry( name, (int)CurrentOpenStack.size( ), now, subID ) );
-                CurrentOpenStack.push_back( (int)LocalTimeline.size( ) - 1 );
+                const int depth = OpenDepth++;
+                if( depth < c_MaxOpenDepth )
+                {
+                    const int64 now = vaCore::TimeTicksFromAppStart( );
+                    OpenStack[depth] = { nameID, subID, now };
+                    if( depth == 0 )
+                        OpenRootBegin.store( now, std::memory_order_release );
+                }
+                return depth;
             }
+            inline int                                          OnBegin( const char * name, int subID = 0 )     { return OnBegin( NameID( name ), subID ); }
+            // number of scopes currently open
+            int                                                 GetOpenDepth( ) const               { return OpenDepth; }
 
 #ifdef _DEBUG
-            inline void                                         OnEnd( vaMappedString verifyName );
+            inline void                                         OnEnd( const char * verifyName );
 #else
             inline void                                         OnEnd( );
-            inline void                                         OnEnd( vaMappedString verifyName ) { verifyName; OnEnd(); }
+            inline void                                         OnEnd( const char * verifyName )    { verifyName; OnEnd(); }
 #endif
             // populate a single level (depth) of entries; Entry::Depth must be -1 to acknowledge they'll use current level
             inline void                                         BatchAddSingleLevelEntries( Entry * entries, int count );
@@ -140,15 +194,13 @@ namespace Vanilla
             // populate entire frame of entries and advance frame; make sure AutomaticFrameIncrement == false
             inline void                                         BatchAddFrame( Entry * entries, int count );
 
+            // number of scopes that didn't fit into the ring (the collector didn't keep up)
+            uint64                                              DroppedCount( ) const               { return Dropped.load( std::memory_order_relaxed ); }
+
             inline void                                         Capture( std::vector<Entry> & outEntries )
             {
                 std::lock_guard lock( TimelineMutex );
-                // outEntries;
-                // move;
-                // if( move )
-                //     outEntries = std::move( Timeline );
-                // else
-                //     outEntries = Timeline;
+                CollectNoLock( );
 
                 outEntries.insert( outEntries.end( ), Timeline.Front->begin( ) + Timeline.FrontFirstValidIndex, Timeline.Front->end( ) );
                 outEntries.insert( outEntries.end( ), Timeline.Back->begin( ), Timeline.Back->end( ) );
@@ -156,19 +208,21 @@ namespace Vanilla
             inline void                                         CaptureLast( std::vector<Entry> & outEntries, double oldestAge )
             {
                 std::lock_guard lock( TimelineMutex );
-                // for( auto it = Timeline.rbegin(); it != Timeline.rend(); it++ )
-                // {
-                //     outEntries.emplace_back( *it );
-                //     if( it->Depth == 0 && it->End < oldestAge ) // stop only at depth == 0 or otherwise it will be ugly to parse
-                //         break;
-                // }
-                // 
+                CollectNoLock( );
 
                 assert( false ); // warning, this is cleaning up Timeline for older than oldestAge permanently - is this what we really want?
                 Timeline.Defrag( oldestAge );
                 outEntries.insert( outEntries.end( ), Timeline.Front->begin( ) + Timeline.FrontFirstValidIndex, Timeline.Front->end( ) );
                 outEntries.insert( outEntries.end( ), Timeline.Back->begin( ), Timeline.Back->end( ) );
             }
+
+        private:
+            // earliestBegin must be <= the beginning of anything that can still be pushed (the outermost open scope)
+            inline void                                         Push( uint32 nameID, int depth, int32 subID, int64 begin, int64 end, int64 earliestBegin );
+            // drains the ring into PendingGroup and from there into Timeline and AttachedViewer, one top level scope at a time; what
+            // the open top level scope can't close (began before it, or there is none) goes out once the ring is drained; TimelineMutex must be locked
+            void                                                CollectNoLock( );
+            void                                                AppendCompletedNoLock( Entry * entries, int count, bool incrementFrameCounter );
         };
 
     private:
@@ -180,6 +234,19 @@ namespace Vanilla
                                                                 s_threadContexts;
         static weak_ptr<ThreadContext>                          s_mainThreadContext;
         static constexpr double                                 c_maxCaptureDuration  = 4.0; // seconds
+
+        // name IDs used by CompactEntry; names get copied into s_namesDictionary so they outlive whatever they were mapped with
+        static std::shared_mutex                                s_namesMutex;
+        static vaStringDictionary                               s_namesDictionary;
+        static std::vector<vaMappedString>                      s_names;
+        static std::unordered_map<const char *, uint32>         s_nameIDs;              // s_namesDictionary mapped name -> ID
+
+        // background collector that drains all rings every c_collectInterval
+        static constexpr std::chrono::milliseconds              c_collectInterval   = std::chrono::milliseconds( 2 );
+        static std::thread                                      s_collectorThread;
+        static std::mutex                                       s_collectorMutex;
+        static std::condition_variable                          s_collectorCV;
+        static bool                                             s_collectorExit;
 //
 //        static thread_local shared_ptr<Thread>                  s_threads;
 
@@ -192,6 +259,9 @@ namespace Vanilla
         }
 
     public:
+        // this thread's context if it has one, without creating it
+        inline static ThreadContext *                           LocalThreadContextIfAny( )          { return LocalThreadContextSharedPtr( ).get( ); }
+
         inline static ThreadContext *                           LocalThreadContext( )
         {
             shared_ptr<ThreadContext> & localThreadContext = LocalThreadContextSharedPtr();
@@ -209,6 +279,7 @@ namespace Vanilla
                     localThreadContext = std::make_shared<ThreadContext>( vaThreading::GetThreadName(), std::this_thread::get_id() );
                     // s_threadContexts.emplace( std::this_thread::get_id(), localThreadContext );
                     s_threadContexts.push_back( localThreadContext );
+                    StartCollectorNoLock( );
                     if( vaThreading::ThreadLocal().MainThread )
                     {
                         assert( !vaThreading::ThreadLocal().MainThreadSynced );
@@ -226,9 +297,16 @@ namespace Vanilla
             shared_ptr<ThreadContext> retContext = std::make_shared<ThreadContext>( name, std::thread::id(), automaticIncrementFrameCounter, isGPU );
             // s_threadContexts.emplace( std::this_thread::get_id(), localThreadContext );
             s_threadContexts.push_back( retContext );
+            StartCollectorNoLock( );
             return retContext;
         }
 
+        // thread-safe but locks - cache the result (vaScopeTraceStaticPart and ThreadContext::NameID do)
+        static uint32                                           RegisterName( const char * name );
+
+        // drains all thread context rings right away instead of waiting for the background collector
+        static void                                             Collect( );
+
         static void                                             DumpChromeTracingReportToFile( double duration = c_maxCaptureDuration );
         static string                                           CreateChromeTracingReport( double duration = c_maxCaptureDuration );
         static void                                             ListAllThreadNames( std::vector<string> & outNames );
@@ -264,6 +342,11 @@ namespace Vanilla
     private:
         friend vaCore;
         static void                                             Cleanup( bool soft );
+
+        static vaMappedString                                   NameFromID( uint32 nameID );
+        static void                                             StartCollectorNoLock( );    // s_globalMutex must be locked
+        static void                                             StopCollector( );
+        static void                                             CollectorLoop( );
     };
 
     // A look into traces on a specific thread captured by vaTracer; 
@@ -518,103 +601,98 @@ namespace Vanilla
         const Node *        FindNodeRecursive( const string & name ) const;
     };
 
-#ifdef _DEBUG
-    inline void vaTracer::ThreadContext::OnEnd( vaMappedString verifyName )
-#else
-    inline void vaTracer::ThreadContext::OnEnd( )
-#endif
+    inline uint32 vaTracer::ThreadContext::NameID( const char * name )
     {
-        double now = vaCore::TimeFromAppStart( );
-        assert( CurrentOpenStack.size( ) > 0 );
-        if( CurrentOpenStack.size( ) == 0 )
-            return;
+        auto it = NameIDCache.find( string_view( name ) );
+        if( it != NameIDCache.end( ) )
+            return it->second;
+        const uint32 nameID = vaTracer::RegisterName( name );
+        NameIDCache.insert( { string_view( vaTracer::NameFromID( nameID ) ), nameID } );
+        return nameID;
+    }
 
-#ifdef _DEBUG
-        // if this triggers, you have overlapping scopes - shouldn't happen but it did so fix it please :)
-        assert( verifyName == LocalTimeline[CurrentOpenStack.back( )].Name );
-#endif
-        LocalTimeline[CurrentOpenStack.back( )].End = now;
-        CurrentOpenStack.pop_back( );
+    inline void vaTracer::ThreadContext::Push( uint32 nameID, int depth, int32 subID, int64 begin, int64 end, int64 earliestBegin )
+    {
+        // need room for the record and a possible base record; only re-read the consumer's tail when it looks full
+        uint64 head = RingHead.load( std::memory_order_relaxed );
+        if( head + 2 - CachedTail > c_RingCapacity )
+        {
+            CachedTail = RingTail.load( std::memory_order_acquire );
+            if( head + 2 - CachedTail > c_RingCapacity )
+            {
+                Dropped.store( Dropped.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+                return;
+            }
+        }
 
-        const int itemsBeforeDefrag = 16;
-        if( CurrentOpenStack.size( ) == 0 && ( LocalTimeline.size( ) >= itemsBeforeDefrag /*|| NextDefragTime > now*/ ) )
+        if( begin < ProducerBase || (uint64)( begin - ProducerBase ) > 0xFFFFFFFFull )
         {
-            std::lock_guard lock( TimelineMutex );
+            // prefer a base that covers everything still open so their records don't need another one
+            ProducerBase = ( earliestBegin <= begin && (uint64)( begin - earliestBegin ) <= 0xFFFFFFFFull ) ? ( earliestBegin ) : ( begin );
+            CompactEntry & baseRecord   = Ring[head++ & ( c_RingCapacity - 1 )];
+            baseRecord.NameIDAndDepth   = c_BaseRecordNameID;
+            baseRecord.SubID            = 0;
+            baseRecord.BeginDelta       = (uint32)( (uint64)ProducerBase & 0xFFFFFFFFull );
+            baseRecord.Duration         = (uint32)( (uint64)ProducerBase >> 32 );
+        }
 
-            // if there's a viewer attached
-            auto attachedViewer = AttachedViewer.lock( );
-            if( attachedViewer != nullptr ) // if attached viewer callback returns false, we're no longer connected
-                attachedViewer->UpdateCallback( LocalTimeline.data(), (int)LocalTimeline.size() );
+        CompactEntry & record   = Ring[head++ & ( c_RingCapacity - 1 )];
+        record.NameIDAndDepth   = ( nameID & c_NameIDMask ) | ( (uint32)depth << 24 );
+        record.SubID            = subID;
+        record.BeginDelta       = (uint32)( begin - ProducerBase );
+        record.Duration         = (uint32)std::min( end - begin, (int64)0xFFFFFFFF );
+        RingHead.store( head, std::memory_order_release );
+    }
 
-#if 0
-            Timeline.AppendMove( std::move(LocalTimeline) );
+#ifdef _DEBUG
+    inline void vaTracer::ThreadContext::OnEnd( const char * verifyName )
 #else
-            Timeline.Append( LocalTimeline );
-            LocalTimeline.clear();
+    inline void vaTracer::ThreadContext::OnEnd( )
 #endif
+    {
+        const int64 now = vaCore::TimeTicksFromAppStart( );
+        assert( OpenDepth > 0 );
+        if( OpenDepth == 0 )
+            return;
 
-            // const int arrsize = (int)LocalTimeline.size( );
-            // for( int i = 0; i < arrsize; i++ )
-            //     Timeline.emplace_back( std::move(LocalTimeline[i]) );
-            // 
-            // // done with this, clear!
-            // LocalTimeline.clear( );
+        const int depth = --OpenDepth;
+        if( depth >= c_MaxOpenDepth )
+            return;
 
-            // remove older (do it here because this way there is no global locking and the cost is spread across all threads and is proportional to use)
-            //if( NextDefragTime < now )
-            //{
-            //    NextDefragTime = now + 0.0333f;   // ~30 times per second sounds reasonable?
-                auto oldest = now - c_maxCaptureDuration;
-            //    // while( Timeline.size( ) > 0 && Timeline.begin( )->Beginning < oldest )
-            //    //     Timeline.pop_front( );
-            //
-                Timeline.Defrag( oldest );
-            //}
-        }
+        const OpenScope & scope = OpenStack[depth];
+#ifdef _DEBUG
+        // if this triggers, you have overlapping scopes - shouldn't happen but it did so fix it please :)
+        assert( NameID( verifyName ) == scope.NameID );
+#endif
+        Push( scope.NameID, depth, scope.SubID, scope.Begin, now, OpenStack[0].Begin );
+        if( depth == 0 )
+            OpenRootBegin.store( c_NoOpenRoot, std::memory_order_release );
     }
 
     inline void vaTracer::ThreadContext::BatchAddSingleLevelEntries( Entry* entries, int count )
     {
+        const double ticksPerSecond = 1.0 / vaCore::TimeTickPeriod( );
+        const int depth = std::min( OpenDepth + 1, 255 );
         for( int i = 0; i < count; i++ )
         {
-            Entry e = entries[i];
+            const Entry & e = entries[i];
             assert( e.Depth == -1 );
-            e.Depth = (int)CurrentOpenStack.size()+1;
-            LocalTimeline.emplace_back( e );
+            const int64 begin   = (int64)( e.Beginning * ticksPerSecond );
+            const int64 end     = std::max( begin, (int64)( e.End * ticksPerSecond ) );
+            Push( NameID( e.Name ), depth, e.SubID, begin, end, ( OpenDepth > 0 ) ? ( std::min( begin, OpenStack[0].Begin ) ) : ( begin ) );
         }
     }
-            
 
     inline void vaTracer::ThreadContext::BatchAddFrame( Entry* entries, int count )
     {
-        assert( CurrentOpenStack.size( ) == 0 );
-        if( CurrentOpenStack.size( ) != 0 )
+        assert( OpenDepth == 0 );
+        if( OpenDepth != 0 )
             return;
 
         assert( !AutomaticFrameIncrement );
 
-        double now = vaCore::TimeFromAppStart( );
-
         std::lock_guard lock( TimelineMutex );
-
-        // if there's a viewer attached
-        {
-            auto attachedViewer = AttachedViewer.lock( );
-            if( attachedViewer != nullptr ) // if attached viewer callback returns false, we're no longer connected
-            {
-                assert( AutomaticFrameIncrement == false );
-                attachedViewer->UpdateCallback( entries, count, true );
-            }
-        }
-
-        Timeline.Append( entries, count );
-
-        // cleanup always
-        {
-            auto oldest = now - c_maxCaptureDuration;
-
-            Timeline.Defrag( oldest );
-        }
+        AppendCompletedNoLock( entries, count, true );
     }
 
 #ifdef VA_SCOPE_TRACE_ENABLED
@@ -624,33 +702,31 @@ namespace Vanilla
     struct vaScopeTraceStaticPart
     {
         vaMappedString const                MappedName;
+        uint32 const                        NameID;
 
-        alignas( VA_ALIGN_PAD )  char       m_fptPadding1[VA_ALIGN_PAD];
-        atomic_int32                        LoopID = 0;
-        alignas( VA_ALIGN_PAD )  char       m_fptPadding2[VA_ALIGN_PAD];
+        int32                               LoopID = 0;         // only ever used as thread_local so no need for atomics (or padding)
  
-        vaScopeTraceStaticPart( const char * name, bool selectInUI ) : MappedName( vaCore::MapString( name ) ) { if( selectInUI ) vaTracer::SelectNodeInUI( name ); }
+        vaScopeTraceStaticPart( const char * name, bool selectInUI ) : MappedName( vaCore::MapString( name ) ), NameID( vaTracer::RegisterName( name ) ) { if( selectInUI ) vaTracer::SelectNodeInUI( name ); }
     };
 
     struct vaScopeTrace
     {
         vaRenderDeviceContext * const       m_renderDeviceContext   = nullptr;
         int                                 m_GPUTraceHandle        = -1;
+        // the context is looked up again on end instead of keeping a pointer to it - vaTracer::Cleanup can release it in between
+        int                                 m_depth                 = -1;
 
 #ifdef _DEBUG
         vaMappedString const                m_name;
 #endif
 
+        // CPU only custom names go straight to the context's name ID cache - no global string dictionary lookup
         vaScopeTrace( const char * customName )
 #ifdef _DEBUG
             : m_name( vaCore::MapString( customName ) )
 #endif
         {
-            vaMappedString mappedName = vaCore::MapString( customName );
-#ifdef _DEBUG
-            assert( mappedName == m_name );
-#endif
-            vaTracer::LocalThreadContext( )->OnBegin( mappedName, 0 );
+            m_depth = vaTracer::LocalThreadContext( )->OnBegin( customName, 0 );
         }
 
         vaScopeTrace( const string & customName )
@@ -658,11 +734,7 @@ namespace Vanilla
             : m_name( vaCore::MapString( customName.c_str() ) )
 #endif
         {
-            vaMappedString mappedName = vaCore::MapString( customName.c_str() );
-#ifdef _DEBUG
-            assert( mappedName == m_name );
-#endif
-            vaTracer::LocalThreadContext( )->OnBegin( mappedName, 0 );
+            m_depth = vaTracer::LocalThreadContext( )->OnBegin( customName.c_str(), 0 );
         }
 
         vaScopeTrace( const string & customName, vaRenderDeviceContext * renderDeviceContext ) : 
@@ -675,7 +747,7 @@ namespace Vanilla
 #ifdef _DEBUG
             assert( mappedName == m_name );
 #endif
-            vaTracer::LocalThreadContext( )->OnBegin( mappedName, 0 );
+            m_depth = vaTracer::LocalThreadContext( )->OnBegin( mappedName, 0 );
             BeginGPUTrace( mappedName, 0 );
         }
 
@@ -684,8 +756,8 @@ namespace Vanilla
             : m_name( info.MappedName )
 #endif
         { 
-            int subID = info.LoopID++; //.fetch_add( 1 );
-            vaTracer::LocalThreadContext( )->OnBegin( info.MappedName, subID ); 
+            int subID = info.LoopID++;
+            m_depth = vaTracer::LocalThreadContext( )->OnBegin( info.NameID, subID ); 
 #ifdef VA_USE_PIX3_HIGH_FREQUENCY_CPU_TIMERS
             BeginExternalCPUTrace( info.MappedName, subID );
 #endif
@@ -697,8 +769,8 @@ namespace Vanilla
 #endif
             m_renderDeviceContext(renderDeviceContext)  
         { 
-            int subID = info.LoopID++; //.fetch_add( 1 );
-            vaTracer::LocalThreadContext( )->OnBegin( info.MappedName, subID ); 
+            int subID = info.LoopID++;
+            m_depth = vaTracer::LocalThreadContext( )->OnBegin( info.NameID, subID ); 
             BeginGPUTrace( info.MappedName, subID );
         }
         ~vaScopeTrace( )                    
@@ -709,10 +781,14 @@ namespace Vanilla
             else
                 EndExternalCPUTrace();
 #endif
+            // no context or a new one (one that didn't see the begin) - nothing to end
+            vaTracer::ThreadContext * threadContext = vaTracer::LocalThreadContextIfAny( );
+            if( threadContext == nullptr || threadContext->GetOpenDepth( ) <= m_depth )
+                return;
 #ifdef _DEBUG
-            vaTracer::LocalThreadContext( )->OnEnd( m_name ); 
+            threadContext->OnEnd( m_name ); 
 #else
-            vaTracer::LocalThreadContext( )->OnEnd( ); 
+            threadContext->OnEnd( ); 
 #endif
         }
 
@@ -16,13 +16,196 @@
 
 using namespace Vanilla;
 
+namespace
+{
+    // Just enough of a json scanner to find where values begin and end without parsing them; anything it doesn't reject
+    // still goes through nlohmann::json::parse before it's used, so this only has to be strict about the structure.
+    inline const char * SkipWhitespace( const char * p, const char * end )
+    {
+        while( p < end && ( *p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' ) )
+            p++;
+        return p;
+    }
+
+    // p is at the opening quote; returns one past the closing quote or nullptr
+    inline const char * SkipString( const char * p, const char * end )
+    {
+        for( p++; p < end; p++ )
+        {
+            if( *p == '\\' )
+                p++;
+            else if( *p == '"' )
+                return p + 1;
+        }
+        return nullptr;
+    }
+}
+
+struct vaSerializer::StreamSource
+{
+    struct CompositeRange
+    {
+        const char *                Begin;      // '{' or '['
+        const char *                End;        // one past the matching '}' or ']'
+    };
+
+    vaMappedFile                    File;
+
+    // Every object and array in the file, in order of appearance; found in a single pass on open so that skipping over
+    // one is a lookup instead of a rescan at every level it's nested in.
+    std::vector<CompositeRange>     Composites;
+
+    bool                            FindComposites( const char * begin, const char * end );
+    const char *                    SkipValue( const char * p, const char * end ) const;
+    bool                            Index( const char * begin, const char * end, std::vector<StreamEntry> & outEntries ) const;
+};
+
+struct vaSerializer::StreamTarget
+{
+    static const size_t     c_flushSize     = 256 * 1024;
+
+    string                  FilePath;
+    string                  TempPath;                   // written into this and moved to FilePath once complete
+    vaFileStream            File;
+    string                  Buffer;
+    bool                    Failed          = false;
+
+    void                    Write( const char * text, size_t length )   { Buffer.append( text, length ); if( Buffer.size( ) >= c_flushSize ) Flush( ); }
+    void                    Write( const string & text )                { Write( text.data( ), text.size( ) ); }
+    void                    Indent( int depth )                         { Buffer.append( (size_t)depth * 4, ' ' ); }
+    void                    Flush( )
+    {
+        if( !Failed && !Buffer.empty( ) && !File.Write( Buffer.data( ), (int64)Buffer.size( ) ) )
+            Failed = true;
+        Buffer.clear( );
+    }
+};
+
+bool vaSerializer::StreamSource::FindComposites( const char * begin, const char * end )
+{
+    std::vector<size_t> open;
+    for( const char * p = begin; p < end; p++ )
+    {
+        const char c = *p;
+        if( c == '"' )
+        {
+            p = SkipString( p, end );
+            if( p == nullptr )
+                return false;
+            p--;
+        }
+        else if( c == '{' || c == '[' )
+        {
+            open.push_back( Composites.size( ) );
+            Composites.push_back( { p, nullptr } );
+        }
+        else if( c == '}' || c == ']' )
+        {
+            if( open.empty( ) || ( ( *Composites[open.back( )].Begin == '{' ) != ( c == '}' ) ) )
+                return false;
+            Composites[open.back( )].End = p + 1;
+            open.pop_back( );
+        }
+    }
+    return open.empty( );
+}
+
+// p is at the first character of the value; returns one past its last character or nullptr
+const char * vaSerializer::StreamSource::SkipValue( const char * p, const char * end ) const
+{
+    if( p >= end )
+        return nullptr;
+    if( *p == '"' )
+        return SkipString( p, end );
+    if( *p == '{' || *p == '[' )
+    {
+        auto it = std::lower_bound( Composites.begin( ), Composites.end( ), p, [ ]( const CompositeRange & range, const char * pos ) { return range.Begin < pos; } );
+        return ( it != Composites.end( ) && it->Begin == p && it->End <= end ) ? ( it->End ) : ( nullptr );
+    }
+    // number, true, false, null
+    const char * start = p;
+    while( p < end && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r' )
+        p++;
+    return ( p != start ) ? ( p ) : ( nullptr );
+}
+
+// collects keys and value ranges of an object, or item ranges of an array, at [begin, end)
+bool vaSerializer::StreamSource::Index( const char * begin, const char * end, std::vector<StreamEntry> & outEntries ) const
+{
+    const bool isObject = *begin == '{';
+    const char closing  = ( isObject ) ? ( '}' ) : ( ']' );
+    const char * p = SkipWhitespace( begin + 1, end );
+    if( p < end && *p == closing )
+        return true;
+    while( p < end )
+    {
+        StreamEntry entry;
+        if( isObject )
+        {
+            if( *p != '"' )
+                return false;
+            const char * keyEnd = SkipString( p, end );
+            if( keyEnd == nullptr )
+                return false;
+            if( std::find( p + 1, keyEnd - 1, '\\' ) == keyEnd - 1 )
+                entry.Key.assign( p + 1, keyEnd - 1 );
+            else
+            {
+                json key = json::parse( p, keyEnd, nullptr, false );
+                if( !key.is_string( ) )
+                    return false;
+                entry.Key = key.get<string>( );
+            }
+            p = SkipWhitespace( keyEnd, end );
+            if( p >= end || *p != ':' )
+                return false;
+            p = SkipWhitespace( p + 1, end );
+        }
+        entry.Begin = p;
+        entry.End   = SkipValue( p, end );
+        if( entry.End == nullptr )
+            return false;
+        outEntries.push_back( std::move( entry ) );
+        p = SkipWhitespace( outEntries.back( ).End, end );
+        if( p < end && *p == ',' )
+            p = SkipWhitespace( p + 1, end );
+        else
+            return p < end && *p == closing && p + 1 == end;
+    }
+    return false;
+}
+
+namespace
+{
+    // nlohmann's dump( 4, ' ' ) of a nested value, with its lines shifted to where it gets written
+    string DumpIndented( const json & value, int depth )
+    {
+        string text = value.dump( 4, ' ' );
+        if( depth == 0 || text.find( '\n' ) == string::npos )
+            return text;
+        const string newLine = "\n" + string( (size_t)depth * 4, ' ' );
+        string retVal; retVal.reserve( text.size( ) * 2 );
+        for( char c : text )
+        {
+            if( c == '\n' )
+                retVal += newLine;
+            else
+                retVal += c;
+        }
+        return retVal;
+    }
+}
+
 vaSerializer::vaSerializer( vaSerializer && src ) :
-    m_json( std::move(src.m_json) ), m_isReading( src.m_isReading ), m_isWriting( src.m_isWriting ), m_type( std::move( src.m_type ) )
+    m_json( std::move(src.m_json) ), m_isReading( src.m_isReading ), m_isWriting( src.m_isWriting ), m_type( std::move( src.m_type ) ),
+    m_source( std::move( src.m_source ) ), m_sourceBegin( src.m_sourceBegin ), m_sourceEnd( src.m_sourceEnd ), m_sourceEntries( std::move( src.m_sourceEntries ) ),
+    m_target( std::move( src.m_target ) ), m_targetDepth( src.m_targetDepth ), m_targetItems( src.m_targetItems ), m_targetRoot( src.m_targetRoot ), 
+    m_targetOpen( src.m_targetOpen ), m_targetDone( src.m_targetDone ), m_targetKeys( std::move( src.m_targetKeys ) )
 {
     src.m_isReading = false;
     src.m_isWriting = false;
-    assert( src.m_type == "" );
-    assert( src.m_json.is_null() );
+    src.m_type.clear( );
+    src.m_json      = nullptr;
 }
 
 vaSerializer::vaSerializer( nlohmann::json && src, bool forReading ) 
@@ -48,8 +231,37 @@ vaSerializer::vaSerializer( const string & type ) : m_isReading( false ), m_isWr
         m_json["!type"]      = type;
 }
 
+vaSerializer::vaSerializer( const shared_ptr<StreamSource> & source, const char * begin, const char * end )
+    : m_source( source ), m_sourceBegin( begin ), m_sourceEnd( end )
+{
+    assert( *begin == '{' || *begin == '[' );
+    if( !source->Index( begin, end, m_sourceEntries ) )
+    {
+        m_source = nullptr;
+        return; // not reading - caller handles it as a corrupted value
+    }
+    m_isReading = true;
+    if( *begin == '{' )
+    {
+        const StreamEntry * typeEntry = FindEntry( "!type" );
+        if( typeEntry != nullptr )
+        {
+            json type = json::parse( typeEntry->Begin, typeEntry->End, nullptr, false );
+            if( type.is_string( ) )
+                type.get_to<std::string>( m_type );
+        }
+    }
+}
+
 vaSerializer::~vaSerializer( )
 {
+    if( m_target != nullptr )
+    {
+        if( m_targetRoot )
+            Close( );
+        else if( !m_targetDone )
+            m_target->Failed = true;    // abandoned half-way (serialization error) - the output is broken
+    }
     if( IsWriting( ) )
     {
         if( m_type != "" )
@@ -61,6 +273,32 @@ vaSerializer::~vaSerializer( )
     }
 }
 
+nlohmann::json & vaSerializer::JSON( )
+{
+    const vaSerializer & constThis = *this;
+    constThis.JSON( );
+    return m_json;
+}
+
+const nlohmann::json & vaSerializer::JSON( ) const
+{
+    // streamed node used directly (by an adapter or through DOM()): parse the whole range now; the index stays valid
+    if( m_source != nullptr && m_json.is_null( ) )
+    {
+        m_json = json::parse( m_sourceBegin, m_sourceEnd, nullptr, false );
+        if( m_json.is_discarded( ) )
+            { assert( false ); m_json = nullptr; }
+    }
+    return m_json;
+}
+
+bool vaSerializer::Has( const string & key ) const
+{
+    if( m_source != nullptr )
+        return FindEntry( key ) != nullptr;
+    return m_json.contains( key );
+}
+
 vaSerializer vaSerializer::OpenReadFile( const string & filePath, const string & assertType )
 {
     json j = json::parse( vaFileTools::ReadText( filePath ), nullptr, false );
@@ -75,6 +313,27 @@ vaSerializer vaSerializer::OpenReadFile( const string & filePath, const string &
     return retVal;
 }
 
+vaSerializer vaSerializer::OpenReadStream( const string & filePath, const string & assertType )
+{
+    shared_ptr<StreamSource> source = std::make_shared<StreamSource>( );
+    if( !source->File.Open( filePath ) )
+        return vaSerializer( );
+    const char * begin  = reinterpret_cast<const char *>( source->File.Data( ) );
+    const char * end    = begin + source->File.Size( );
+    if( end - begin >= 3 && memcmp( begin, "\xEF\xBB\xBF", 3 ) == 0 )
+        begin += 3;
+    begin = SkipWhitespace( begin, end );
+    if( !source->FindComposites( begin, end ) )
+        return vaSerializer( );
+    const char * valueEnd = source->SkipValue( begin, end );
+    if( valueEnd == nullptr || SkipWhitespace( valueEnd, end ) != end )
+        return vaSerializer( );
+
+    vaSerializer retVal = ReadValue( source, begin, valueEnd );
+    assert( !retVal.IsReading() || assertType == "" || assertType == retVal.Type() ); assertType;
+    return retVal;
+}
+
 vaSerializer vaSerializer::OpenReadString( const string & jsonData, const string & assertType )
 {
     json j = json::parse( jsonData, nullptr, false );
@@ -89,9 +348,33 @@ vaSerializer vaSerializer::OpenReadString( const string & jsonData, const string
     return retVal;
 }
 
+vaSerializer vaSerializer::OpenReadDOM( nlohmann::json && dom, const string & assertType )
+{
+    vaSerializer retVal( std::move(dom), true );
+    assert( assertType == "" || assertType == retVal.Type() ); assertType;
+    return retVal;
+}
+
+vaSerializer vaSerializer::OpenWriteStream( const string & filePath, const string & type )
+{
+    shared_ptr<StreamTarget> target = std::make_shared<StreamTarget>( );
+    target->FilePath = filePath;
+    target->TempPath = filePath + ".tmp";
+    if( !target->File.Open( target->TempPath, FileCreationMode::Create ) )
+    {
+        VA_LOG_ERROR( "vaSerializer::OpenWriteStream(%s) - unable to create file for saving", target->TempPath.c_str( ) );
+        return vaSerializer( );
+    }
+    vaSerializer retVal( type );
+    retVal.m_target     = target;
+    retVal.m_targetRoot = true;
+    return retVal;
+}
+
 string vaSerializer::Dump( ) const
 {
-    return m_json.dump(4, ' ');
+    assert( m_target == nullptr );  // streamed out already
+    return JSON( ).dump(4, ' ');
 }
 
 bool vaSerializer::Write( vaStream & stream ) const
@@ -103,6 +386,7 @@ bool vaSerializer::Write( vaStream & stream ) const
 bool vaSerializer::Write( const string & filePath ) const
 {
     assert( m_isWriting );
+    assert( m_target == nullptr );  // use Close( ) with OpenWriteStream
     vaFileStream outFile;
     if( !outFile.Open( filePath, FileCreationMode::Create ) )
     {
@@ -113,6 +397,283 @@ bool vaSerializer::Write( const string & filePath ) const
 
 }
 
+bool vaSerializer::Close( bool keep )
+{
+    assert( m_target != nullptr && m_targetRoot );
+    if( m_target == nullptr || !m_targetRoot )
+        return false;
+    StreamFinish( );
+    m_target->Flush( );
+    m_target->File.Close( );
+    bool retVal = !m_target->Failed && keep;
+    if( retVal )
+    {
+        // same as vaShaderCache::SaveIndex; if the move fails the complete output is still there in the .tmp
+        vaFileTools::DeleteFile( m_target->FilePath );
+        if( !vaFileTools::MoveFile( m_target->TempPath, m_target->FilePath ) )
+        {
+            VA_LOG_ERROR( "vaSerializer::Close() - unable to replace '%s' with '%s'", m_target->FilePath.c_str( ), m_target->TempPath.c_str( ) );
+            retVal = false;
+        }
+    }
+    else
+    {
+        if( m_target->Failed )
+            VA_LOG_ERROR( "vaSerializer::Close() - error while writing '%s', the file was left unchanged", m_target->FilePath.c_str( ) );
+        vaFileTools::DeleteFile( m_target->TempPath );
+    }
+    m_target    = nullptr;
+    m_isWriting = false;
+    return retVal;
+}
+
+const vaSerializer::StreamEntry * vaSerializer::FindEntry( const string & key ) const
+{
+    if( m_source == nullptr || *m_sourceBegin != '{' )
+        return nullptr;
+    for( const StreamEntry & entry : m_sourceEntries )
+        if( entry.Key == key )
+            return &entry;
+    return nullptr;
+}
+
+vaSerializer vaSerializer::ReadValue( const shared_ptr<StreamSource> & source, const char * begin, const char * end )
+{
+    if( *begin == '{' || *begin == '[' )
+        return vaSerializer( source, begin, end );
+    // most values are plain strings - no need to go through the parser for those
+    if( *begin == '"' && std::find( begin + 1, end - 1, '\\' ) == end - 1 )
+        return vaSerializer( json( string( begin + 1, end - 1 ) ), true );
+    json value = json::parse( begin, end, nullptr, false );
+    if( value.is_discarded( ) )
+        return vaSerializer( );
+    return vaSerializer( std::move( value ), true );
+}
+
+vaSerializer vaSerializer::ReadChild( const string & key ) const
+{
+    if( m_source == nullptr )
+    {
+        if( key == "" )
+            return vaSerializer( json( m_json ), true );
+        auto it = m_json.find( key );
+        return vaSerializer( ( it != m_json.end( ) ) ? ( json( *it ) ) : ( json( ) ), true );
+    }
+
+    const char * begin = m_sourceBegin, * end = m_sourceEnd;
+    if( key != "" )
+    {
+        const StreamEntry * entry = FindEntry( key );
+        if( entry == nullptr )
+            return vaSerializer( json( ), true );
+        begin = entry->Begin; end = entry->End;
+    }
+    vaSerializer retVal = ReadValue( m_source, begin, end );
+    if( !retVal.IsReading( ) )
+        { assert( false ); return vaSerializer( json( ), true ); }     // corrupted data
+    return retVal;
+}
+
+bool vaSerializer::IsNull( ) const
+{
+    return m_source == nullptr && m_json.is_null( );
+}
+
+bool vaSerializer::IsArray( ) const
+{
+    return ( m_source != nullptr ) ? ( *m_sourceBegin == '[' ) : ( m_json.is_array( ) );
+}
+
+size_t vaSerializer::ItemCount( ) const
+{
+    assert( IsArray( ) );
+    return ( m_source != nullptr ) ? ( m_sourceEntries.size( ) ) : ( m_json.size( ) );
+}
+
+vaSerializer vaSerializer::ReadItem( size_t index ) const
+{
+    assert( index < ItemCount( ) );
+    if( m_source == nullptr )
+        return vaSerializer( json( m_json[index] ), true );
+    vaSerializer retVal = ReadValue( m_source, m_sourceEntries[index].Begin, m_sourceEntries[index].End );
+    if( !retVal.IsReading( ) )
+        { assert( false ); return vaSerializer( json( ), true ); }     // corrupted data
+    return retVal;
+}
+
+bool vaSerializer::ReadVectorItems( const string & key, std::vector<vaSerializer> & outItems ) const
+{
+    assert( key != "!type" && key != "" );
+    assert( outItems.size( ) == 0 );
+    if( !m_isReading )
+        { assert( false ); return false; }
+    if( !Has( key ) )
+        return false;
+    vaSerializer arrayNode = ReadChild( key );
+    if( arrayNode.IsNull( ) )
+        return true;
+    if( !arrayNode.IsArray( ) )
+        { assert( false ); return false; }                  // same conventions as SerializeVector
+    const size_t count = arrayNode.ItemCount( );
+    outItems.reserve( count );
+    for( size_t i = 0; i < count; i++ )
+    {
+        outItems.push_back( arrayNode.ReadItem( i ) );
+        if( outItems.back( ).IsNull( ) )
+            { assert( false ); outItems.clear( ); return false; }
+    }
+    return true;
+}
+
+vaSerializer vaSerializer::WriteChildBegin( const string & key, const string & type )
+{
+    if( m_target == nullptr )
+    {
+        if( ( key == "" && !m_json.empty( ) ) || m_json.contains( key ) )
+            return vaSerializer( );
+        return vaSerializer( type );
+    }
+    if( m_targetDone || m_targetItems >= 0 )
+        return vaSerializer( );
+    if( key == "" )
+    {
+        // the child takes over the whole node
+        if( m_targetOpen || !m_json.empty( ) )
+            return vaSerializer( );
+        m_targetDone = true;
+        return StreamChild( m_targetDepth, type );
+    }
+    if( !StreamKey( key ) )
+        return vaSerializer( );
+    return StreamChild( m_targetDepth + 1, type );
+}
+
+bool vaSerializer::WriteChildEnd( const string & key, vaSerializer & child )
+{
+    if( m_target == nullptr )
+    {
+        if( key == "" )
+            m_json = std::move( child.m_json );
+        else
+            m_json[key] = std::move( child.m_json );
+        child.m_isWriting = false;  // (moved out)
+        return true;
+    }
+    return child.StreamFinish( );
+}
+
+bool vaSerializer::WriteArrayBegin( const string & key )
+{
+    if( m_target == nullptr )
+    {
+        if( m_json.contains( key ) )
+            return false;
+        m_json[key] = nullptr;      // empty gets stored as null
+        return true;
+    }
+    if( m_targetDone || m_targetItems >= 0 || !StreamKey( key ) )
+        return false;
+    m_targetItems = 0;
+    return true;
+}
+
+vaSerializer vaSerializer::WriteArrayItemBegin( const string & type )
+{
+    if( m_target == nullptr )
+        return vaSerializer( type );
+    assert( m_targetItems >= 0 );
+    m_target->Write( ( m_targetItems == 0 ) ? ( "[\n" ) : ( ",\n" ), 2 );
+    m_target->Indent( m_targetDepth + 2 );
+    m_targetItems++;
+    return StreamChild( m_targetDepth + 2, type );
+}
+
+bool vaSerializer::WriteArrayItemEnd( const string & key, vaSerializer & item )
+{
+    if( m_target == nullptr )
+    {
+        m_json[key].push_back( std::move( item.m_json ) );
+        item.m_isWriting = false;   // (moved out)
+        return true;
+    }
+    return item.StreamFinish( );
+}
+
+bool vaSerializer::WriteArrayEnd( )
+{
+    if( m_target == nullptr )
+        return true;
+    assert( m_targetItems >= 0 );
+    if( m_targetItems == 0 )
+        m_target->Write( "null", 4 );
+    else
+    {
+        m_target->Write( "\n", 1 );
+        m_target->Indent( m_targetDepth + 1 );
+        m_target->Write( "]", 1 );
+    }
+    m_targetItems = -1;
+    return !m_target->Failed;
+}
+
+vaSerializer vaSerializer::StreamChild( int depth, const string & type )
+{
+    vaSerializer retVal( type );
+    retVal.m_target         = m_target;
+    retVal.m_targetDepth    = depth;
+    return retVal;
+}
+
+bool vaSerializer::StreamKey( const string & key )
+{
+    assert( m_target != nullptr && !m_targetDone && m_targetItems < 0 );
+    if( std::find( m_targetKeys.begin( ), m_targetKeys.end( ), key ) != m_targetKeys.end( ) )
+        return false;
+    if( !m_targetOpen )
+    {
+        // something was already written directly through JSON( ) - can't mix the two
+        if( !m_json.is_null( ) && !( m_json.is_object( ) && m_json.size( ) == 1 && m_type != "" ) )
+            return false;
+        m_target->Write( "{", 1 );
+        m_targetOpen = true;
+        if( m_type != "" )
+        {
+            m_target->Write( "\n", 1 );
+            m_target->Indent( m_targetDepth + 1 );
+            m_target->Write( "\"!type\": " + json( m_type ).dump( ) );
+        }
+    }
+    if( m_type != "" || !m_targetKeys.empty( ) )
+        m_target->Write( ",", 1 );
+    m_target->Write( "\n", 1 );
+    m_target->Indent( m_targetDepth + 1 );
+    m_target->Write( json( key ).dump( ) + ": " );
+    m_targetKeys.push_back( key );
+    return true;
+}
+
+bool vaSerializer::StreamFinish( )
+{
+    assert( m_target != nullptr );
+    if( m_targetDone )
+        return !m_target->Failed;
+    m_targetDone = true;
+    if( m_targetItems >= 0 )
+        { assert( false ); m_target->Failed = true; }
+    if( m_targetOpen )
+    {
+        // anything written through JSON( ) after the first key would get lost
+        if( !m_json.is_null( ) && !( m_json.is_object( ) && m_json.size( ) == 1 && m_type != "" ) )
+            { assert( false ); m_target->Failed = true; }
+        m_target->Write( "\n", 1 );
+        m_target->Indent( m_targetDepth );
+        m_target->Write( "}", 1 );
+    }
+    else
+        m_target->Write( DumpIndented( m_json, m_targetDepth ) );  // 'value' node or nothing written (null)
+    return !m_target->Failed;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////
 // vaSerializer adapters!
 ////////////////////////////////////////////////////////////////////////////////////////////////
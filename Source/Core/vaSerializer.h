@@ -19,14 +19,46 @@ namespace Vanilla
 
     // This is a wrapper that for nlohmann::json that exposes a simple serialization interface.
     // It reserves "!type" key for (optionally) defining type.
+    //
+    // Besides working on a whole in-memory json tree (OpenReadFile/OpenReadString/OpenWrite), it can also stream:
+    //  * OpenReadStream memory-maps the file and only indexes the keys of objects (and items of arrays) as they get visited,
+    //    skipping over the values without parsing them; a value is only parsed when it gets read, so the full tree never exists.
+    //  * OpenWriteStream writes each key to the file as soon as it's serialized, and vectors element by element; keys end up
+    //    in the order they were serialized in (instead of sorted) but the formatting is otherwise the same as Dump(). It all
+    //    goes into '<filePath>.tmp' first, which replaces the file on a successful Close( ), so a failed save can't damage it.
+    // vaSerializerAdapter-s that use JSON() directly keep working in both: such nodes are just small values.
     class vaSerializer
     {
-        nlohmann::json          m_json;
-
-        bool                    m_isReading = false;
-        bool                    m_isWriting = false;
-
-        string                  m_type      = "";
+        struct StreamSource;
+        struct StreamTarget;
+        struct StreamEntry
+        {
+            string                  Key;                        // empty for array items
+            const char *            Begin;
+            const char *            End;
+        };
+
+        mutable nlohmann::json      m_json;
+
+        bool                        m_isReading     = false;
+        bool                        m_isWriting     = false;
+
+        string                      m_type          = "";
+
+        // streaming read: this node is an object or an array still in text form (m_json gets filled in only if JSON() is used)
+        shared_ptr<StreamSource>    m_source;
+        const char *                m_sourceBegin   = nullptr;
+        const char *                m_sourceEnd     = nullptr;
+        std::vector<StreamEntry>    m_sourceEntries;
+
+        // streaming write: m_json only ever holds "!type" or, for 'value' nodes, what the adapter wrote through JSON()
+        shared_ptr<StreamTarget>    m_target;
+        int                         m_targetDepth   = 0;        // indentation level
+        int                         m_targetItems   = -1;       // number of items written to the currently open array, -1 if none is open
+        bool                        m_targetRoot    = false;    // the one returned by OpenWriteStream
+        bool                        m_targetOpen    = false;    // '{' was written, at least one key followed
+        bool                        m_targetDone    = false;
+        std::vector<string>         m_targetKeys;
 
     protected:
         // failed/uninitialized
@@ -35,36 +67,47 @@ namespace Vanilla
         // generic
         vaSerializer( nlohmann::json && src, bool forReading );
 
-        // move
-        vaSerializer( vaSerializer && src );
-
         // this one is for writing
         vaSerializer( const string & type );
 
     public:
+        // move
+        vaSerializer( vaSerializer && src );
         ~vaSerializer( );
 
+        // streaming read node
+        vaSerializer( const shared_ptr<StreamSource> & source, const char * begin, const char * end );
+
     protected:
         // only to be used by the vaSerializerAdapter!
         template< typename _Type > friend  struct vaSerializerAdapter;
-        nlohmann::json &        JSON( )                                                     { return m_json; }
-        const nlohmann::json &  JSON( ) const                                               { return m_json; }
+        nlohmann::json &        JSON( );
+        const nlohmann::json &  JSON( ) const;
 
     public:
         string                  Dump( ) const;                              // output everything to string
         bool                    Write( vaStream & stream ) const;           // output everything to a stream
         bool                    Write( const string & filePath ) const;     // output everything to a file
+        bool                    Close( bool keep = true );                  // OpenWriteStream only: finish writing and close the file; false if anything failed (also done on destruction); the file is only replaced if this succeeds and 'keep' is true, otherwise it is left as it was
 
     public:
         static vaSerializer     OpenWrite( const string & type = "" )                       { return vaSerializer(type); }
+        static vaSerializer     OpenWriteStream( const string & filePath, const string & type = "" );
         static vaSerializer     OpenReadFile( const string & filePath, const string & assertType = "" );
+        static vaSerializer     OpenReadStream( const string & filePath, const string & assertType = "" );
         static vaSerializer     OpenReadString( const string & jsonData, const string & assertType = "" );
+        // Takes an already built tree - for formats that store it differently (see Scene::BinarySave/BinaryLoad)
+        static vaSerializer     OpenReadDOM( nlohmann::json && dom, const string & assertType = "" );
+
+    public:
+        // Read-only access to the underlying tree for the same purpose; serialization code should only use Serialize* below
+        const nlohmann::json &  DOM( ) const                                                { return JSON( ); }
 
     public:
         const string &          Type( ) const                                               { return m_type; }
         bool                    IsReading( ) const                                          { return m_isReading; }
         bool                    IsWriting( ) const                                          { return m_isWriting; }
-        bool                    Has( const string & key ) const                             { return m_json.contains( key ); }
+        bool                    Has( const string & key ) const;
 
         template< typename ValueType >
         bool                    Serialize( const string & key, ValueType & value );
@@ -104,6 +147,9 @@ namespace Vanilla
         bool                    SerializeVector( const string & key, std::vector<ValueType> & valueVector, const std::vector<ValueType> & defaultValue, const ValueType & initValue = ValueType() );
         template< typename ValueType >
         bool                    SerializeArray( const string & key, ValueType * valueArray, size_t arrayCount );
+        // Reading only: nodes of all items of the array under 'key' (none for null), for deserializing them separately - in any
+        // order and on any thread, as long as each is used by one thread at a time. Same return value as SerializeVector.
+        bool                    ReadVectorItems( const string & key, std::vector<vaSerializer> & outItems ) const;
         //
         template< typename ValueType >
         bool                    SerializePtrVector( const string & key, std::vector<shared_ptr<ValueType>> & ptrVector, const std::function< shared_ptr<ValueType> ( ) > & newObj = [ ]( ) { return std::make_shared<ValueType>( ); } );
@@ -112,6 +158,27 @@ namespace Vanilla
             const std::function< shared_ptr<BaseType>( const string & typeName ) > & newObj,
             const std::function< const char * ( const BaseType & object ) > & typeOf,
             const std::function< bool( const string & typeName, vaSerializer & serializer, BaseType & object ) > & serialize );
+
+    private:
+        // reading; these never fail - a missing key (or a corrupted value, which also asserts) gives a null node
+        vaSerializer            ReadChild( const string & key ) const;
+        bool                    IsNull( ) const;
+        bool                    IsArray( ) const;
+        size_t                  ItemCount( ) const;
+        vaSerializer            ReadItem( size_t index ) const;
+        const StreamEntry *     FindEntry( const string & key ) const;
+        static vaSerializer     ReadValue( const shared_ptr<StreamSource> & source, const char * begin, const char * end );
+
+        // writing; WriteChildBegin returns a non-writing node if the key is already there (or key-less data isn't allowed)
+        vaSerializer            WriteChildBegin( const string & key, const string & type );
+        bool                    WriteChildEnd( const string & key, vaSerializer & child );
+        bool                    WriteArrayBegin( const string & key );
+        vaSerializer            WriteArrayItemBegin( const string & type );
+        bool                    WriteArrayItemEnd( const string & key, vaSerializer & item );
+        bool                    WriteArrayEnd( );
+        vaSerializer            StreamChild( int depth, const string & type );
+        bool                    StreamKey( const string & key );
+        bool                    StreamFinish( );
     };
 
     // This has to be template-specialized for every type that wants to support serialization with vaSerializer. 
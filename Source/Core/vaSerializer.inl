@@ -142,26 +142,21 @@ inline bool vaSerializer::Serialize( const string & key, ValueType & value )
 
     if( m_isReading )
     {
-        auto jtemp = (key=="")?(m_json):(m_json[ key ]);
-        if( jtemp.is_null() )
+        vaSerializer readNode = ReadChild( key );
+        if( readNode.IsNull() )
             return false;   // this is ok, the value just isn't there
-        vaSerializer readNode = vaSerializer( std::move(jtemp), true );
         if( readNode.Type() != vaSerializerAdapter<ValueType>::Type() )
             { assert( false ); return false; }              // Type mismatch is probably a code error so we assert and return false; null node is ok - just return false
         return vaSerializerAdapter<ValueType>::Serialize( readNode, value );
     }
     else if( m_isWriting )
     {
-        if( (key=="" && !m_json.empty()) || m_json.contains( key ) )
+        vaSerializer writeNode = WriteChildBegin( key, vaSerializerAdapter<ValueType>::Type() );
+        if( !writeNode.IsWriting() )
             { assert( false ); return false; }              // Convention: if overwriting existing key (or key-less data), assert and return false. 
-        vaSerializer writeNode = vaSerializer::OpenWrite( vaSerializerAdapter<ValueType>::Type() );
         if( !vaSerializerAdapter<ValueType>::Serialize( writeNode, value ) )
             { assert( false ); return false; }              // Not being able to write is probably a code error so we assert and return false
-        if( key=="" )
-            m_json = writeNode.m_json;
-        else
-            m_json[key] = writeNode.m_json;
-        return true;
+        return WriteChildEnd( key, writeNode );
     }
     else { assert( false ); return false; }
 }
@@ -188,24 +183,19 @@ inline bool vaSerializer::Serialize( const string & key, const string & typeName
 
     if( m_isReading )
     {
-        auto jtemp = (key=="")?(m_json):(m_json[ key ]);
-        vaSerializer readNode = vaSerializer( std::move(jtemp), true );
+        vaSerializer readNode = ReadChild( key );
         if( readNode.Type() != typeName )
             { assert( false ); return false; }              // Type mismatch is probably a code error so we assert and return false
         return serialize( readNode );
     }
     else if( m_isWriting )
     {
-        if( (key=="" && !m_json.empty()) || m_json.contains( key ) )
+        vaSerializer writeNode = WriteChildBegin( key, typeName );
+        if( !writeNode.IsWriting() )
             { assert( false ); return false; }              // Convention: if overwriting existing key (or key-less data), assert and return false. 
-        vaSerializer writeNode = vaSerializer::OpenWrite( typeName );
         if( !serialize( writeNode ) )
             { assert( false ); return false; }              // Not being able to write is probably a code error so we assert and return false
-        if( key == "" )
-            m_json = writeNode.m_json;
-        else
-            m_json[key] = writeNode.m_json;
-        return true;
+        return WriteChildEnd( key, writeNode );
     }
     else { assert( false ); return false; }
 
@@ -243,10 +233,9 @@ inline bool vaSerializer::SerializeDynamicPtr( const string & key, shared_ptr<Ba
     if( m_isReading )
     {
         assert( object == nullptr );                        // Convention: if pointer is non-null, although there's no issues on serialization side, there's a good chance it's an user error / unintentional.
-        auto jtemp = (key=="")?(m_json):(m_json[ key ]);
-        if( jtemp.is_null( ) )
+        vaSerializer readNode = ReadChild( key );
+        if( readNode.IsNull( ) )
             return false;
-        vaSerializer readNode( std::move(jtemp), true );
         object = newObj( readNode.Type() );
         return serialize( readNode.Type(), readNode, *object );
     }
@@ -254,16 +243,12 @@ inline bool vaSerializer::SerializeDynamicPtr( const string & key, shared_ptr<Ba
     {
         if( object == nullptr  )
             { assert( false ); return false; }              // Convention: saving null dynamic pointer not allowed because we can't figure out the type.
-        if( (key=="" && !m_json.empty()) || m_json.contains( key ) )
+        vaSerializer writeNode = WriteChildBegin( key, typeOf(*object) );
+        if( !writeNode.IsWriting() )
             { assert( false ); return false; }              // Convention: if overwriting existing key (or key-less data), assert and return false. 
-        vaSerializer writeNode = vaSerializer::OpenWrite( typeOf(*object) );
         if( !serialize( writeNode.Type(), writeNode, *object ) )
             return false;
-        if( key == "" )
-            m_json = writeNode.m_json;
-        else
-            m_json[key] = writeNode.m_json;
-        return true;
+        return WriteChildEnd( key, writeNode );
     }
     else
         { assert( false ); return false; }
@@ -278,23 +263,22 @@ inline bool vaSerializer::SerializeVector( const string & key, std::vector<Value
     if( m_isReading )
     {
         assert( valueVector.size() == 0 );                  // Convention: if vector is not empty, although there's no issues on serialization side, there's a good chance it's an user error / unintentional.
-        if( !m_json.contains(key) )
+        if( !Has( key ) )
             return false;
-        auto jtemp = m_json[ key ];
-        if( jtemp.is_null( ) )
+        vaSerializer arrayNode = ReadChild( key );
+        if( arrayNode.IsNull( ) )
         {
             valueVector.clear();
             return true;
         }
-        if( !jtemp.is_array( ) )
+        if( !arrayNode.IsArray( ) )
             { assert( false ); return false; }              // Json node is there but it's not an array? This is likely an user error / unintentional!
-        valueVector.resize( jtemp.size(), initValue );
+        valueVector.resize( arrayNode.ItemCount(), initValue );
         for( size_t i = 0; i < valueVector.size(); i++ )
         {
-            auto itemTemp = jtemp[i];
-            if( itemTemp.is_null( ) )
+            vaSerializer readNode = arrayNode.ReadItem( i );
+            if( readNode.IsNull( ) )
                 { assert( false ); return false; }          // Convention: null array item? it's likely data corruption or user error, so assert.
-            vaSerializer readNode( std::move( itemTemp ), true );
             if( !vaSerializerAdapter<ValueType>::Serialize( readNode, valueVector[i] ) )
                 { assert( false ); return false; }          // Convention: if serialization of an individual array item failed, it's likely data corruption or user error, so assert.
         }
@@ -302,18 +286,18 @@ inline bool vaSerializer::SerializeVector( const string & key, std::vector<Value
     }
     else if( m_isWriting )
     {
-        if( m_json.contains( key ) )
+        if( !WriteArrayBegin( key ) )
             { assert( false ); return false; }              // Convention: if key already in, assert and return false. Also, input is null is user error.
-        json jarr; size_t valueVectorSize = valueVector.size();
+        size_t valueVectorSize = valueVector.size();
         for( size_t i = 0; i < valueVectorSize; i++ )
         {
-            vaSerializer writeNode = vaSerializer::OpenWrite( vaSerializerAdapter<ValueType>::Type() );
+            vaSerializer writeNode = WriteArrayItemBegin( vaSerializerAdapter<ValueType>::Type() );
             if( !vaSerializerAdapter<ValueType>::Serialize( writeNode, valueVector[i] ) )
                 { assert( false ); return false; }          // Convention: Not being able to write is probably a code error so we assert and return false;
-            jarr.push_back( writeNode.m_json );
+            if( !WriteArrayItemEnd( key, writeNode ) )
+                return false;
         }
-        m_json[key] = jarr;
-        return true;
+        return WriteArrayEnd( );
     }
     assert( false );
     return false;
@@ -345,22 +329,21 @@ inline bool vaSerializer::SerializeArray( const string & key, ValueType * valueA
 
     if( m_isReading )
     {
-        if( !m_json.contains( key ) )
+        if( !Has( key ) )
             return false;
-        auto jtemp = m_json[key];
-        if( jtemp.is_null( ) )
+        vaSerializer arrayNode = ReadChild( key );
+        if( arrayNode.IsNull( ) )
         {
             assert( arrayCount == 0 );
             return arrayCount == 0;
         }
-        if( !jtemp.is_array( ) || jtemp.size( ) != arrayCount )
+        if( !arrayNode.IsArray( ) || arrayNode.ItemCount( ) != arrayCount )
             { assert( false ); return false; }              // Json node is there but it's not an array, or there is a size mismatch? This is likely an user error / unintentional!
         for( size_t i = 0; i < arrayCount; i++ )
         {
-            auto itemTemp = jtemp[i];
-            if( itemTemp.is_null( ) )
+            vaSerializer readNode = arrayNode.ReadItem( i );
+            if( readNode.IsNull( ) )
                 { assert( false ); return false; }          // Convention: null array item? it's likely data corruption or user error, so assert.
-            vaSerializer readNode( std::move( itemTemp ), true );
             if( !vaSerializerAdapter<ValueType>::Serialize( readNode, valueArray[i] ) )
                 { assert( false ); return false; }          // Convention: if serialization of an individual array item failed, it's likely data corruption or user error, so assert.
         }
@@ -368,18 +351,17 @@ inline bool vaSerializer::SerializeArray( const string & key, ValueType * valueA
     }
     else if( m_isWriting )
     {
-        if( m_json.contains( key ) )
+        if( !WriteArrayBegin( key ) )
             { assert( false ); return false; }              // Convention: if key already in, assert and return false. Also, input is null is user error.
-        json jarr;
         for( size_t i = 0; i < arrayCount; i++ )
         {
-            vaSerializer writeNode = vaSerializer::OpenWrite( vaSerializerAdapter<ValueType>::Type() );
+            vaSerializer writeNode = WriteArrayItemBegin( vaSerializerAdapter<ValueType>::Type() );
             if( !vaSerializerAdapter<ValueType>::Serialize( writeNode, valueArray[i] ) )
                 { assert( false ); return false; }          // Convention: Not being able to write is probably a code error so we assert and return false;
-            jarr.push_back( writeNode.m_json );
+            if( !WriteArrayItemEnd( key, writeNode ) )
+                return false;
         }
-        m_json[key] = jarr;
-        return true;
+        return WriteArrayEnd( );
     }
     assert( false );
     return false;
@@ -394,23 +376,22 @@ inline bool vaSerializer::SerializePtrVector( const string & key, std::vector<sh
     if( m_isReading )
     {
         assert( ptrVector.size() == 0 );                    // Convention: if vector is not empty, although there's no issues on serialization side, there's a good chance it's an user error / unintentional.
-        if( !m_json.contains( key ) )
+        if( !Has( key ) )
             return false;
-        auto jtemp = m_json[key];
-        if( jtemp.is_null( ) )
+        vaSerializer arrayNode = ReadChild( key );
+        if( arrayNode.IsNull( ) )
         {
-            valueVector.clear( );
+            ptrVector.clear( );
             return true;
         }
-        if( !jtemp.is_array( ) )
+        if( !arrayNode.IsArray( ) )
             { assert( false ); return false; }              // Json node is there but it's not an array? This is likely an user error / unintentional!
-        ptrVector.resize( jtemp.size() );
+        ptrVector.resize( arrayNode.ItemCount() );
         for( size_t i = 0; i < ptrVector.size(); i++ )
         {
-            auto itemTemp = jtemp[i];
-            if( itemTemp.is_null( ) )
+            vaSerializer readNode = arrayNode.ReadItem( i );
+            if( readNode.IsNull( ) )
                 { assert( false ); return false; }          // Convention: null array item? it's likely data corruption or user error, so assert.
-            vaSerializer readNode( std::move( itemTemp ), true );
             ptrVector[i] = newObj( );
             if( !vaSerializerAdapter<ValueType>::Serialize( readNode, *ptrVector[i] ) )
                 { assert( false ); return false; }          // Convention: if serialization of an individual array item failed, it's likely data corruption or user error, so assert.
@@ -419,18 +400,18 @@ inline bool vaSerializer::SerializePtrVector( const string & key, std::vector<sh
     }
     else if( m_isWriting )
     {
-        if( m_json.contains( key ) )
+        if( !WriteArrayBegin( key ) )
             { assert( false ); return false; }              // Convention: if key already in, assert and return false. Also, input is null is user error.
-        json jarr; size_t ptrVectorSize = ptrVector.size();
+        size_t ptrVectorSize = ptrVector.size();
         for( size_t i = 0; i < ptrVectorSize; i++ )
         {
-            vaSerializer writeNode = vaSerializer::OpenWrite( vaSerializerAdapter<ValueType>::Type() );
+            vaSerializer writeNode = WriteArrayItemBegin( vaSerializerAdapter<ValueType>::Type() );
             if( !vaSerializerAdapter<ValueType>::Serialize( writeNode, *ptrVector[i] ) )
                 { assert( false ); return false; }          // Convention: Not being able to write is probably a code error so we assert and return false;
-            jarr.push_back( writeNode.m_json );
+            if( !WriteArrayItemEnd( key, writeNode ) )
+                return false;
         }
-        m_json[key] = jarr;
-        return true;
+        return WriteArrayEnd( );
     }
     assert( false );
     return false;
@@ -448,23 +429,22 @@ inline bool vaSerializer::SerializeDynamicPtrVector( const string & key, std::ve
     if( m_isReading )
     {
         assert( ptrVector.size() == 0 );                    // Convention: if vector is not empty, although there's no issues on serialization side, there's a good chance it's an user error / unintentional.
-        if( !m_json.contains( key ) )
+        if( !Has( key ) )
             return false;
-        auto jtemp = m_json[key];
-        if( jtemp.is_null( ) )
+        vaSerializer arrayNode = ReadChild( key );
+        if( arrayNode.IsNull( ) )
         {
-            valueVector.clear( );
+            ptrVector.clear( );
             return true;
         }
-        if( !jtemp.is_array( ) )
+        if( !arrayNode.IsArray( ) )
             { assert( false ); return false; }              // Json node is there but it's not an array? This is likely an user error / unintentional!
-        ptrVector.resize( jtemp.size() );
+        ptrVector.resize( arrayNode.ItemCount() );
         for( size_t i = 0; i < ptrVector.size(); i++ )
         {
-            auto itemTemp = jtemp[i];
-            if( itemTemp.is_null( ) )
+            vaSerializer readNode = arrayNode.ReadItem( i );
+            if( readNode.IsNull( ) )
                 { assert( false ); return false; }          // Convention: null array item? it's likely data corruption or user error, so assert.
-            vaSerializer readNode( std::move( itemTemp ), true );
             ptrVector[i] = newObj( readNode.Type( ) );
             if( !serialize( readNode.Type(), readNode, *ptrVector[i] ) )
                 { assert( false ); return false; }          // Convention: if serialization of an individual array item failed, it's likely data corruption or user error, so assert.
@@ -473,18 +453,18 @@ inline bool vaSerializer::SerializeDynamicPtrVector( const string & key, std::ve
     }
     else if( m_isWriting )
     {
-        if( m_json.contains( key ) )
+        if( !WriteArrayBegin( key ) )
             { assert( false ); return false; }              // Convention: if key already in, assert and return false. Also, input is null is user error.
-        json jarr; size_t ptrVectorSize = ptrVector.size();
+        size_t ptrVectorSize = ptrVector.size();
         for( size_t i = 0; i < ptrVectorSize; i++ )
         {
-            vaSerializer writeNode = vaSerializer::OpenWrite( typeOf( *ptrVector[i] ) );
+            vaSerializer writeNode = WriteArrayItemBegin( typeOf( *ptrVector[i] ) );
             if( !serialize( writeNode.Type(), writeNode, *ptrVector[i] ) )
                 { assert( false ); return false; }          // Convention: Not being able to write is probably a code error so we assert and return false;
-            jarr.push_back( writeNode.m_json );
+            if( !WriteArrayItemEnd( key, writeNode ) )
+                return false;
         }
-        m_json[key] = jarr;
-        return true;
+        return WriteArrayEnd( );
     }
     assert( false );
     return false;
@@ -0,0 +1,483 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation 
+// 
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "vaTracerStream.h"
+
+#include "Core/System/vaFileStream.h"
+#include "Core/System/vaMemoryStream.h"
+#include "Core/System/vaCompressionStream.h"
+
+using namespace Vanilla;
+
+std::atomic_bool vaTracerStream::s_active = false;
+
+namespace
+{
+    // s_fileMutex is always taken before s_pendingMutex; OnEntries only ever takes s_pendingMutex so compressing and writing
+    // a chunk never blocks the collector or GPU timer threads
+    std::mutex                                  s_fileMutex;
+    std::mutex                                  s_pendingMutex;
+
+    std::unique_ptr<vaFileStream>               s_file;                 // secured with s_fileMutex
+    std::unique_ptr<vaMemoryStream>             s_writing;              // secured with s_fileMutex
+    std::unique_ptr<vaMemoryStream>             s_compressed;           // secured with s_fileMutex
+
+    struct StreamName
+    {
+        uint32                                  ID;
+        string                                  Name;                   // to detect a mapped name pointer reused for another string
+    };
+
+    std::unique_ptr<vaMemoryStream>             s_pending;              // everything below secured with s_pendingMutex
+    double                                      s_pendingSince          = 0.0;
+    uint64                                      s_session               = 0;
+    uint32                                      s_nextContextID         = 0;
+    uint32                                      s_nextNameID            = 0;
+    std::unordered_map<const char *, StreamName> s_names;
+    vaTracerStream::Stats                       s_stats;
+
+    inline uint64 ToNanoseconds( double seconds )       { return (uint64)( std::max( 0.0, seconds ) * 1e9 + 0.5 ); }
+
+    void AppendJSONEscaped( string & out, const string & text )
+    {
+        for( char c : text )
+        {
+            if( c == '"' || c == '\\' )
+                { out += '\\'; out += c; }
+            else if( (unsigned char)c < 0x20 )
+                out += vaStringTools::Format( "\\u%04x", (uint32)c );
+            else
+                out += c;
+        }
+    }
+
+    // minimal protobuf encoding, just enough for the handful of Perfetto trace messages written below
+    struct ProtoWriter
+    {
+        string                                  Data;
+
+        void Varint( uint64 value )                                 { while( value >= 0x80 ) { Data += (char)( ( value & 0x7F ) | 0x80 ); value >>= 7; } Data += (char)value; }
+        void Tag( uint32 field, uint32 wireType )                   { Varint( ( (uint64)field << 3 ) | wireType ); }
+        void UInt( uint32 field, uint64 value )                     { Tag( field, 0 ); Varint( value ); }
+        void Int( uint32 field, int64 value )                       { Tag( field, 0 ); Varint( (uint64)value ); }
+        void String( uint32 field, const string & value )           { Tag( field, 2 ); Varint( value.size( ) ); Data += value; }
+        void Message( uint32 field, const ProtoWriter & message )   { String( field, message.Data ); }
+    };
+
+    // Perfetto trace.proto field numbers
+    enum : uint32
+    {
+        c_tracePacket                   = 1,    // Trace.packet
+        c_packetTimestamp               = 8,    // TracePacket.timestamp
+        c_packetSequenceID              = 10,   // TracePacket.trusted_packet_sequence_id
+        c_packetTrackEvent              = 11,   // TracePacket.track_event
+        c_packetSequenceFlags           = 13,   // TracePacket.sequence_flags
+        c_packetTrackDescriptor         = 60,   // TracePacket.track_descriptor
+        c_trackDescriptorUUID           = 1,    // TrackDescriptor.uuid
+        c_trackDescriptorName           = 2,    // TrackDescriptor.name
+        c_trackDescriptorParentUUID     = 5,    // TrackDescriptor.parent_uuid
+        c_trackEventDebugAnnotations    = 4,    // TrackEvent.debug_annotations
+        c_trackEventType                = 9,    // TrackEvent.type
+        c_trackEventTrackUUID           = 11,   // TrackEvent.track_uuid
+        c_trackEventName                = 23,   // TrackEvent.name
+        c_debugAnnotationIntValue       = 4,    // DebugAnnotation.int_value
+        c_debugAnnotationName           = 10,   // DebugAnnotation.name
+        c_trackEventTypeSliceBegin      = 1,
+        c_trackEventTypeSliceEnd        = 2,
+        c_sequenceIncrementalStateCleared = 1,
+    };
+    const uint64                                c_perfettoCPUTrack      = 1;
+    const uint64                                c_perfettoGPUTrack      = 2;
+    const uint64                                c_perfettoContextTrack  = 0x100;    // + context ID
+    const uint32                                c_perfettoSequence      = 1;
+
+    void AppendPerfettoPacket( string & out, const ProtoWriter & packet )
+    {
+        ProtoWriter trace;
+        trace.Message( c_tracePacket, packet );
+        out += trace.Data;
+    }
+
+    void AppendPerfettoTrack( string & out, uint64 uuid, uint64 parentUUID, const string & name, bool firstPacket )
+    {
+        ProtoWriter descriptor;
+        descriptor.UInt( c_trackDescriptorUUID, uuid );
+        descriptor.String( c_trackDescriptorName, name );
+        if( parentUUID != 0 )
+            descriptor.UInt( c_trackDescriptorParentUUID, parentUUID );
+
+        ProtoWriter packet;
+        packet.UInt( c_packetSequenceID, c_perfettoSequence );
+        if( firstPacket )
+            packet.UInt( c_packetSequenceFlags, c_sequenceIncrementalStateCleared );
+        packet.Message( c_packetTrackDescriptor, descriptor );
+        AppendPerfettoPacket( out, packet );
+    }
+
+    void AppendPerfettoSlice( string & out, uint64 trackUUID, uint64 timestamp, bool begin, const string * name, int32 subID )
+    {
+        ProtoWriter event;
+        event.UInt( c_trackEventType, ( begin ) ? ( c_trackEventTypeSliceBegin ) : ( c_trackEventTypeSliceEnd ) );
+        event.UInt( c_trackEventTrackUUID, trackUUID );
+        if( begin )
+        {
+            event.String( c_trackEventName, *name );
+            ProtoWriter annotation;
+            annotation.String( c_debugAnnotationName, "subID" );
+            annotation.Int( c_debugAnnotationIntValue, subID );
+            event.Message( c_trackEventDebugAnnotations, annotation );
+        }
+
+        ProtoWriter packet;
+        packet.UInt( c_packetTimestamp, timestamp );
+        packet.UInt( c_packetSequenceID, c_perfettoSequence );
+        packet.Message( c_packetTrackEvent, event );
+        AppendPerfettoPacket( out, packet );
+    }
+}
+
+bool vaTracerStream::Start( const wstring & filePath )
+{
+    Stop( );
+
+    auto file = std::make_unique<vaFileStream>( );
+    if( !file->Open( filePath, FileCreationMode::Create, FileAccessMode::Write ) )
+    {
+        VA_LOG_ERROR( "vaTracerStream: could not open '%s' for writing", vaStringTools::SimpleNarrow( filePath ).c_str( ) );
+        return false;
+    }
+    if( !file->WriteValue<uint32>( c_FileMagic ) || !file->WriteValue<uint32>( c_FileVersion ) )
+    {
+        VA_LOG_ERROR( "vaTracerStream: could not write to '%s'", vaStringTools::SimpleNarrow( filePath ).c_str( ) );
+        return false;
+    }
+
+    {
+        std::scoped_lock lock( s_fileMutex, s_pendingMutex );
+        s_file          = std::move( file );
+        s_writing       = std::make_unique<vaMemoryStream>( (int64)0, (int64)c_ChunkSize );
+        s_compressed    = std::make_unique<vaMemoryStream>( (int64)0, (int64)c_ChunkSize );
+        s_pending       = std::make_unique<vaMemoryStream>( (int64)0, (int64)c_ChunkSize );
+        s_pendingSince  = vaCore::TimeFromAppStart( );
+        s_session++;
+        s_nextContextID = 0;
+        s_nextNameID    = 0;
+        s_names.clear( );
+        s_stats         = Stats( );
+        s_active.store( true );
+    }
+    VA_LOG( "vaTracerStream: capturing to '%s'", vaStringTools::SimpleNarrow( filePath ).c_str( ) );
+    return true;
+}
+
+void vaTracerStream::Stop( )
+{
+    if( !IsActive( ) )
+        return;
+
+    // get everything that's finished so far
+    vaTracer::Collect( );
+    s_active.store( false );
+    WriteChunk( true );
+
+    Stats stats;
+    {
+        std::scoped_lock lock( s_fileMutex, s_pendingMutex );
+        if( s_file != nullptr )
+            s_file->Close( );
+        s_file          = nullptr;
+        s_writing       = nullptr;
+        s_compressed    = nullptr;
+        s_pending       = nullptr;
+        s_names.clear( );
+        stats           = s_stats;
+    }
+    VA_LOG( "vaTracerStream: capture stopped - %llu entries (%llu dropped), %llu chunks, %.2f MB", stats.Entries, stats.DroppedEntries, stats.Chunks, stats.BytesWritten / ( 1024.0 * 1024.0 ) );
+}
+
+vaTracerStream::Stats vaTracerStream::GetStats( )
+{
+    std::lock_guard lock( s_pendingMutex );
+    return s_stats;
+}
+
+void vaTracerStream::OnEntries( vaTracer::ThreadContext & context, const vaTracer::Entry * entries, int count )
+{
+    std::lock_guard lock( s_pendingMutex );
+    if( !IsActive( ) || s_pending == nullptr || count <= 0 )
+        return;
+
+    s_stats.Entries += count;
+    if( (size_t)s_pending->GetPosition( ) + count * sizeof( StreamEntry ) > c_MaxPendingBytes )
+    {
+        s_stats.DroppedEntries += count;
+        return;
+    }
+    if( s_pending->GetPosition( ) == 0 )
+        s_pendingSince = vaCore::TimeFromAppStart( );
+
+    vaMemoryStream & out = *s_pending;
+    if( context.StreamSession != s_session )
+    {
+        context.StreamSession   = s_session;
+        context.StreamContextID = s_nextContextID++;
+        out.WriteValue<uint8>( (uint8)RecordType::Context );
+        out.WriteValue<uint32>( context.StreamContextID );
+        out.WriteValue<uint8>( ( context.IsGPU ) ? ( 1 ) : ( 0 ) );
+        out.WriteString( context.Name );
+    }
+
+    // names first, so the entries can go out in one write
+    thread_local std::vector<StreamEntry> streamEntries;
+    streamEntries.resize( count );
+    for( int i = 0; i < count; i++ )
+    {
+        const vaTracer::Entry & entry = entries[i];
+        auto it = s_names.find( entry.Name );
+        if( it == s_names.end( ) || it->second.Name != entry.Name )
+        {
+            StreamName name = { s_nextNameID++, entry.Name };
+            out.WriteValue<uint8>( (uint8)RecordType::Name );
+            out.WriteValue<uint32>( name.ID );
+            out.WriteString( name.Name );
+            it = s_names.insert_or_assign( entry.Name, std::move( name ) ).first;
+        }
+        streamEntries[i] = { it->second.ID, entry.Depth, entry.SubID, 0, entry.Beginning, entry.End };
+    }
+    out.WriteValue<uint8>( (uint8)RecordType::Entries );
+    out.WriteValue<uint32>( context.StreamContextID );
+    out.WriteValue<uint32>( (uint32)count );
+    out.Write( streamEntries.data( ), count * sizeof( StreamEntry ) );
+}
+
+void vaTracerStream::Tick( )
+{
+    if( IsActive( ) )
+        WriteChunk( false );
+}
+
+void vaTracerStream::WriteChunk( bool force )
+{
+    std::lock_guard fileLock( s_fileMutex );
+    if( s_file == nullptr )
+        return;
+
+    {
+        std::lock_guard lock( s_pendingMutex );
+        const int64 pendingSize = s_pending->GetPosition( );
+        if( pendingSize == 0 || ( !force && (size_t)pendingSize < c_ChunkSize && ( vaCore::TimeFromAppStart( ) - s_pendingSince ) < c_ChunkMaxAge ) )
+            return;
+        std::swap( s_pending, s_writing );
+        s_pending->Resize( 0 );
+    }
+
+    s_compressed->Resize( 0 );
+    {
+        vaCompressionStream compressor( false, s_compressed.get( ) );
+        compressor.Write( s_writing->GetBuffer( ), s_writing->GetPosition( ) );
+    }
+    const int64 compressedSize  = s_compressed->GetPosition( );
+    const int64 rawSize         = s_writing->GetPosition( );
+
+    bool allOk = true;
+    allOk &= s_file->WriteValue<uint32>( c_ChunkMagic );
+    allOk &= s_file->WriteValue<uint64>( (uint64)compressedSize );
+    allOk &= s_file->WriteValue<uint64>( (uint64)rawSize );
+    allOk &= s_file->Write( s_compressed->GetBuffer( ), compressedSize );
+    if( !allOk )
+        VA_LOG_ERROR( "vaTracerStream: error writing a %.2f MB chunk", compressedSize / ( 1024.0 * 1024.0 ) );
+
+    std::lock_guard lock( s_pendingMutex );
+    s_stats.Chunks++;
+    s_stats.BytesWritten += sizeof( uint32 ) + 2 * sizeof( uint64 ) + compressedSize;
+}
+
+bool vaTracerStream::Convert( const wstring & inputPath, const wstring & outputPath, ExportFormat format )
+{
+    vaFileStream input;
+    if( !input.Open( inputPath, FileCreationMode::Open, FileAccessMode::Read ) )
+    {
+        VA_LOG_ERROR( "vaTracerStream: could not open '%s'", vaStringTools::SimpleNarrow( inputPath ).c_str( ) );
+        return false;
+    }
+    uint32 magic = 0, version = 0;
+    if( !input.ReadValue<uint32>( magic ) || !input.ReadValue<uint32>( version ) || magic != c_FileMagic || version != c_FileVersion )
+    {
+        VA_LOG_ERROR( "vaTracerStream: '%s' is not a trace capture (or is from an incompatible version)", vaStringTools::SimpleNarrow( inputPath ).c_str( ) );
+        return false;
+    }
+
+    vaFileStream output;
+    if( !output.Open( outputPath, FileCreationMode::Create, FileAccessMode::Write ) )
+    {
+        VA_LOG_ERROR( "vaTracerStream: could not open '%s' for writing", vaStringTools::SimpleNarrow( outputPath ).c_str( ) );
+        return false;
+    }
+
+    struct ConvertContext
+    {
+        string                                  Name;
+        bool                                    IsGPU       = false;
+    };
+    std::vector<ConvertContext> contexts;
+    std::vector<string>         names;
+    std::vector<StreamEntry>    entries;
+    std::vector<std::pair<uint64, double>> openSlices;      // track, End
+    string                      text;
+    bool                        firstJSONEvent = true;
+
+    // header
+    if( format == ExportFormat::ChromeJSON )
+    {
+        text += "[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CPU\"}},";
+        text += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"GPU\"}}";
+        firstJSONEvent = false;
+    }
+    else
+    {
+        AppendPerfettoTrack( text, c_perfettoCPUTrack, 0, "CPU", true );
+        AppendPerfettoTrack( text, c_perfettoGPUTrack, 0, "GPU", false );
+    }
+
+    vaMemoryStream compressed( (int64)0, (int64)c_ChunkSize );
+    vaMemoryStream raw( (int64)0, (int64)c_ChunkSize );
+    uint64 chunkCount = 0, entryCount = 0;
+    bool valid = true;
+    for( ;; )
+    {
+        // a capture that wasn't stopped cleanly ends with an incomplete chunk - convert everything before it
+        uint32 chunkMagic = 0;
+        uint64 compressedSize = 0, rawSize = 0;
+        if( !input.ReadValue<uint32>( chunkMagic ) )
+            break;
+        // sizes come from the file - check them before allocating anything
+        if( chunkMagic != c_ChunkMagic || !input.ReadValue<uint64>( compressedSize ) || !input.ReadValue<uint64>( rawSize )
+            || compressedSize > (uint64)( input.GetLength( ) - input.GetPosition( ) ) || rawSize > c_MaxChunkRawSize )
+        {
+            VA_LOG_WARNING( "vaTracerStream: '%s' chunk %llu header is corrupt or truncated, stopping there", vaStringTools::SimpleNarrow( inputPath ).c_str( ), chunkCount );
+            break;
+        }
+        compressed.Resize( (int64)compressedSize );
+        raw.Resize( (int64)rawSize );
+        bool chunkOk = input.Read( compressed.GetBuffer( ), (int64)compressedSize );
+        if( chunkOk )
+        {
+            vaMemoryStream source( compressed.GetBuffer( ), (int64)compressedSize );
+            vaCompressionStream decompressor( true, &source );
+            chunkOk = decompressor.Read( raw.GetBuffer( ), (int64)rawSize );
+        }
+        if( !chunkOk )
+        {
+            VA_LOG_WARNING( "vaTracerStream: '%s' chunk %llu is corrupt or truncated, stopping there", vaStringTools::SimpleNarrow( inputPath ).c_str( ), chunkCount );
+            break;
+        }
+        chunkCount++;
+
+        raw.Seek( 0 );
+        while( valid && raw.GetPosition( ) < (int64)rawSize )
+        {
+            uint8 recordType = 0;
+            valid &= raw.ReadValue<uint8>( recordType );
+            if( recordType == (uint8)RecordType::Context )
+            {
+                uint32 contextID = 0; uint8 isGPU = 0; ConvertContext context;
+                valid &= raw.ReadValue<uint32>( contextID ) && raw.ReadValue<uint8>( isGPU ) && raw.ReadString( context.Name );
+                valid &= contextID == contexts.size( );
+                if( !valid )
+                    break;
+                context.IsGPU = isGPU != 0;
+                contexts.push_back( context );
+
+                const int pid = ( context.IsGPU ) ? ( 2 ) : ( 1 );
+                if( format == ExportFormat::ChromeJSON )
+                {
+                    text += vaStringTools::Format( ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"", pid, contextID );
+                    AppendJSONEscaped( text, context.Name );
+                    text += "\"}}";
+                }
+                else
+                    AppendPerfettoTrack( text, c_perfettoContextTrack + contextID, ( context.IsGPU ) ? ( c_perfettoGPUTrack ) : ( c_perfettoCPUTrack ), context.Name, false );
+            }
+            else if( recordType == (uint8)RecordType::Name )
+            {
+                uint32 nameID = 0; string name;
+                valid &= raw.ReadValue<uint32>( nameID ) && raw.ReadString( name );
+                valid &= nameID == names.size( );
+                if( valid )
+                    names.push_back( std::move( name ) );
+            }
+            else if( recordType == (uint8)RecordType::Entries )
+            {
+                uint32 contextID = 0, count = 0;
+                valid &= raw.ReadValue<uint32>( contextID ) && raw.ReadValue<uint32>( count ) && contextID < contexts.size( );
+                valid &= (uint64)count * sizeof( StreamEntry ) <= (uint64)( (int64)rawSize - raw.GetPosition( ) );
+                if( !valid )
+                    break;
+                entries.resize( count );
+                valid &= raw.Read( entries.data( ), count * sizeof( StreamEntry ) );
+                for( const StreamEntry & entry : entries )
+                    valid &= entry.NameID < names.size( );
+                if( !valid )
+                    break;
+                entryCount += count;
+
+                const int pid = ( contexts[contextID].IsGPU ) ? ( 2 ) : ( 1 );
+                const uint64 track = c_perfettoContextTrack + contextID;
+                for( const StreamEntry & entry : entries )
+                {
+                    if( format == ExportFormat::ChromeJSON )
+                    {
+                        text += ",{\"cat\":\"va\",\"name\":\"";
+                        AppendJSONEscaped( text, names[entry.NameID] );
+                        text += vaStringTools::Format( "\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"subID\":%d}}",
+                            pid, contextID, entry.Beginning * 1e6, ( entry.End - entry.Beginning ) * 1e6, entry.SubID );
+                    }
+                    else
+                    {
+                        // entries are sorted by beginning with parents first, so close whatever ended before this one begins;
+                        // children get clamped to their parent so the begin/end pairs always nest
+                        while( !openSlices.empty( ) && openSlices.back( ).second <= entry.Beginning )
+                        {
+                            AppendPerfettoSlice( text, track, ToNanoseconds( openSlices.back( ).second ), false, nullptr, 0 );
+                            openSlices.pop_back( );
+                        }
+                        const double end = ( openSlices.empty( ) ) ? ( entry.End ) : ( std::min( entry.End, openSlices.back( ).second ) );
+                        AppendPerfettoSlice( text, track, ToNanoseconds( entry.Beginning ), true, &names[entry.NameID], entry.SubID );
+                        openSlices.push_back( { track, std::max( end, entry.Beginning ) } );
+                    }
+                }
+                // each Entries record is a complete set of top level scopes (or a GPU frame)
+                while( !openSlices.empty( ) )
+                {
+                    AppendPerfettoSlice( text, openSlices.back( ).first, ToNanoseconds( openSlices.back( ).second ), false, nullptr, 0 );
+                    openSlices.pop_back( );
+                }
+            }
+            else
+                valid = false;
+        }
+        if( !valid )
+        {
+            VA_LOG_ERROR( "vaTracerStream: '%s' chunk %llu contains invalid data", vaStringTools::SimpleNarrow( inputPath ).c_str( ), chunkCount - 1 );
+            break;
+        }
+
+        output.Write( text.data( ), (int64)text.size( ) );
+        text.clear( );
+    }
+
+    if( format == ExportFormat::ChromeJSON )
+        text += "]\n";
+    output.Write( text.data( ), (int64)text.size( ) );
+    output.Close( );
+
+    VA_LOG( "vaTracerStream: converted %llu entries from %llu chunks into '%s'", entryCount, chunkCount, vaStringTools::SimpleNarrow( outputPath ).c_str( ) );
+    return valid;
+}
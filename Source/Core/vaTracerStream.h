@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation 
+// 
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Core/vaProfiler.h"
+
+namespace Vanilla
+{
+    class vaMemoryStream;
+
+    // Streaming capture of everything vaTracer collects (all CPU thread contexts and GPU contexts) to a file, for long runs
+    // (soak tests) where the 4 second in-memory timeline isn't enough. Entries are appended to an in-memory chunk as they
+    // are collected; the collector thread compresses and writes a chunk out (through vaCompressionStream) once it reaches
+    // c_ChunkSize or gets older than c_ChunkMaxAge, so memory use stays bounded - if the disk can't keep up, entries get
+    // dropped once c_MaxPendingBytes are waiting (see GetStats).
+    // Captures are converted offline with Convert (the Project exe does it headless with '-traceconvert').
+    //
+    // File layout: FileHeader, then chunks of { ChunkHeader, vaCompressionStream data }. Decompressed, a chunk is a sequence
+    // of records (RecordType byte + payload); context and name IDs are declared (in an earlier or the same chunk) before use.
+    class vaTracerStream final
+    {
+    public:
+        static constexpr size_t                                 c_ChunkSize             = 1024 * 1024;
+        static constexpr size_t                                 c_MaxPendingBytes       = 4 * c_ChunkSize;
+        static constexpr double                                 c_ChunkMaxAge           = 1.0;          // seconds
+
+        enum class ExportFormat
+        {
+            ChromeJSON,                 // chrome://tracing, ui.perfetto.dev - CPU and GPU contexts as separate processes
+            PerfettoProtobuf,           // ui.perfetto.dev, trace_processor - CPU and GPU contexts as separate parent tracks
+        };
+
+        struct Stats
+        {
+            uint64                                              Entries             = 0;
+            uint64                                              DroppedEntries      = 0;
+            uint64                                              Chunks              = 0;
+            uint64                                              BytesWritten        = 0;    // compressed, including headers
+        };
+
+    private:
+        friend class vaTracer;
+
+        static constexpr uint32                                 c_FileMagic             = 0x52544156;   // 'VATR'
+        static constexpr uint32                                 c_FileVersion           = 1;
+        static constexpr uint32                                 c_ChunkMagic            = 0x4B4E4843;   // 'CHNK'
+        // a chunk is at most c_MaxPendingBytes of entries plus the name and context records that came with them; Convert treats
+        // anything above this as a corrupt chunk header
+        static constexpr size_t                                 c_MaxChunkRawSize       = 2 * c_MaxPendingBytes;
+
+        enum class RecordType : uint8
+        {
+            Context             = 1,    // uint32 contextID, uint8 isGPU, string name
+            Name                = 2,    // uint32 nameID, string name
+            Entries             = 3,    // uint32 contextID, uint32 count, StreamEntry[count] - Beginning-sorted, parents first
+        };
+
+        struct StreamEntry
+        {
+            uint32                                              NameID;
+            int32                                               Depth;
+            int32                                               SubID;
+            uint32                                              Padding;
+            double                                              Beginning;
+            double                                              End;
+        };
+        static_assert( sizeof( StreamEntry ) == 32, "StreamEntry is written as-is" );
+
+        static std::atomic_bool                                 s_active;
+
+    public:
+        // Starts a new capture (stops the current one, if any); overwrites filePath
+        static bool                                             Start( const wstring & filePath );
+        // Collects everything pending, writes the last chunk out and closes the file
+        static void                                             Stop( );
+        static bool                                             IsActive( )                         { return s_active.load( std::memory_order_relaxed ); }
+        static Stats                                            GetStats( );
+
+        // Converts a capture into another format; only ever holds one chunk's worth of data in memory
+        static bool                                             Convert( const wstring & inputPath, const wstring & outputPath, ExportFormat format );
+
+    private:
+        // from vaTracer::ThreadContext::AppendCompletedNoLock (under context.TimelineMutex)
+        static void                                             OnEntries( vaTracer::ThreadContext & context, const vaTracer::Entry * entries, int count );
+        // from the collector thread after each collect
+        static void                                             Tick( );
+        static void                                             WriteChunk( bool force );
+    };
+}
@@ -26,15 +26,14 @@ namespace Vanilla
                 return; 
             w; 
             auto context = vaTracer::LocalThreadContext(); 
-            context->OnBegin( context->MapName( task_view.name() ) );  
+            context->OnBegin( task_view.name().c_str() );  
         };
 #ifdef _DEBUG
         virtual void on_exit( tf::WorkerView w, tf::TaskView task_view ) override     
         { 
             if( task_view.name().length() == 0 ) return; 
             w;
-            auto context = vaTracer::LocalThreadContext(); 
-            vaTracer::LocalThreadContext()->OnEnd( context->MapName( task_view.name() ) );
+            vaTracer::LocalThreadContext()->OnEnd( task_view.name().c_str() );
         };
 #else
         virtual void on_exit( tf::WorkerView w, tf::TaskView task_view ) override
@@ -0,0 +1,248 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation 
+// 
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmarks.h"
+
+#include "Core/System/vaFileTools.h"
+#include "Core/Misc/vaBenchmarkTool.h"
+
+#include <sstream>
+#include <random>
+
+using namespace Vanilla;
+
+namespace
+{
+    // function-local static so that the registration order across translation units does not matter
+    std::vector<std::pair<string, BenchmarkFunction>> & BenchmarkRegistry( )
+    {
+        static std::vector<std::pair<string, BenchmarkFunction>> registry;
+        return registry;
+    }
+
+    const wchar_t * c_baselinesFileName = L"baselines.txt";
+}
+
+BenchmarkRegistrar::BenchmarkRegistrar( const char * name, BenchmarkFunction function )
+{
+    BenchmarkRegistry( ).push_back( std::make_pair( string( name ), function ) );
+}
+
+BenchmarkContext::BenchmarkContext( const wstring & dataDirectory ) : DataDirectory( dataDirectory )
+{
+    string text = vaFileTools::ReadText( DataDirectory + c_baselinesFileName );
+    std::istringstream stream( text );
+    string key; double value;
+    while( stream >> key >> value )
+        m_baselines[key] = value;
+}
+
+BenchmarkContext::~BenchmarkContext( )
+{
+    if( m_baselinesDirty )
+    {
+        string text;
+        for( const auto & baseline : m_baselines )
+            text += vaStringTools::Format( "%s %.6f\n", baseline.first.c_str( ), baseline.second );
+        vaFileTools::EnsureDirectoryExists( DataDirectory );
+        if( !vaFileTools::WriteText( vaStringTools::SimpleNarrow( DataDirectory + c_baselinesFileName ), text ) )
+            VA_LOG_ERROR( L"Unable to write benchmark baselines to '%s'", ( DataDirectory + c_baselinesFileName ).c_str( ) );
+    }
+}
+
+void BenchmarkContext::Report( const char * format, ... )
+{
+    va_list args; va_start( args, format );
+    string line = vaStringTools::Format( format, args );
+    va_end( args );
+
+    m_report += "  " + line + "\n";
+    VA_LOG( "  %s", line.c_str( ) );
+}
+
+void BenchmarkContext::Fail( const char * format, ... )
+{
+    va_list args; va_start( args, format );
+    string line = vaStringTools::Format( format, args );
+    va_end( args );
+
+    m_failureCount++;
+    m_report += "  FAIL: " + line + "\n";
+    VA_LOG_ERROR( "  FAIL: %s", line.c_str( ) );
+}
+
+bool BenchmarkContext::CheckThroughput( const string & key, double value, const char * units )
+{
+    const string fullKey = m_currentBenchmark + "." + vaStringTools::ReplaceSpacesWithUnderscores( key );
+    auto it = m_baselines.find( fullKey );
+    if( UpdateReferences || it == m_baselines.end( ) )
+    {
+        Report( "%-40s %10.3f %s (baseline %s)", key.c_str( ), value, units, ( it == m_baselines.end( ) ) ? ( "created" ) : ( "updated" ) );
+        m_baselines[fullKey] = value;
+        m_baselinesDirty = true;
+        return true;
+    }
+    const double baseline = it->second;
+    const double relative = ( baseline > 0.0 ) ? ( value / baseline ) : ( 1.0 );
+    if( relative < 1.0 - ThroughputTolerance )
+    {
+        Fail( "%-40s %10.3f %s, baseline %.3f (%+.1f%%) - throughput regression", key.c_str( ), value, units, baseline, ( relative - 1.0 ) * 100.0 );
+        return false;
+    }
+    Report( "%-40s %10.3f %s, baseline %.3f (%+.1f%%)", key.c_str( ), value, units, baseline, ( relative - 1.0 ) * 100.0 );
+    return true;
+}
+
+void BenchmarkContext::BeginBenchmark( const string & name )
+{
+    m_currentBenchmark = name;
+    m_report += name + "\n";
+    VA_LOG( "Benchmark '%s'", name.c_str( ) );
+}
+
+void BenchmarkContext::EndBenchmark( )
+{
+    m_currentBenchmark = "";
+}
+
+bool Vanilla::IsBenchmarkRun( const std::vector<std::pair<wstring, wstring>> & cmdLineParams )
+{
+    for( const auto & param : cmdLineParams )
+        if( vaStringTools::CompareNoCase( param.first, L"benchmark" ) == 0 )
+            return true;
+    return false;
+}
+
+int Vanilla::RunBenchmarks( const std::vector<std::pair<wstring, wstring>> & cmdLineParams )
+{
+    wstring filter;
+    wstring dataDirectory = vaCore::GetMediaRootDirectory( ) + L"Benchmarks\\";
+    bool updateReferences = false;
+    int iterations = -1;
+    double tolerance = -1.0;
+    for( const auto & param : cmdLineParams )
+    {
+        const wstring name = vaStringTools::ToLower( param.first );
+        if( name == L"benchmark" )
+            filter = vaStringTools::ToLower( param.second );
+        else if( name == L"benchmarkdata" && param.second != L"" )
+            dataDirectory = vaFileTools::GetAbsolutePath( param.second ) + L"\\";
+        else if( name == L"benchmarkupdate" )
+            updateReferences = true;
+        else if( name == L"benchmarkiterations" )
+            iterations = (int)vaStringTools::StringToFloat( param.second.c_str( ) );
+        else if( name == L"benchmarktolerance" )
+            tolerance = vaStringTools::StringToFloat( param.second.c_str( ) );
+    }
+
+    int failureCount = 0;
+    string report;
+    {
+        BenchmarkContext context( dataDirectory );
+        context.UpdateReferences = updateReferences;
+        if( iterations > 0 )
+            context.Iterations = iterations;
+        if( tolerance >= 0.0 )
+            context.ThroughputTolerance = tolerance;
+
+        int runCount = 0;
+        for( const auto & benchmark : BenchmarkRegistry( ) )
+        {
+            if( filter != L"" && vaStringTools::SimpleWiden( vaStringTools::ToLower( benchmark.first ) ).find( filter ) == wstring::npos )
+                continue;
+            context.BeginBenchmark( benchmark.first );
+            benchmark.second( context );
+            context.EndBenchmark( );
+            runCount++;
+        }
+        if( runCount == 0 )
+            context.Fail( "no benchmarks match filter '%s'", vaStringTools::SimpleNarrow( filter ).c_str( ) );
+
+        failureCount = context.FailureCount( );
+        report = context.GetReport( ) + vaStringTools::Format( "%d benchmark(s) run, %d failure(s)\n", runCount, failureCount );
+    }
+
+    vaFileTools::WriteText( vaCore::GetExecutableDirectoryNarrow( ) + "benchmark_report.txt", report );
+    vaCore::DebugOutput( report );
+    if( failureCount == 0 )
+        VA_LOG_SUCCESS( "Benchmarks passed" );
+    else
+        VA_LOG_ERROR( "Benchmarks failed with %d failure(s)", failureCount );
+
+    return failureCount;
+}
+
+// Self-check of vaBenchmarkTool statistics on synthetic frame times: a decaying warmup has to be detected and dropped, a 2.5%
+// shift in the mean (just above ComparisonSettings::MinRelativeChange) has to be flagged as a regression, while a 1.5% one
+// (clearly significant, but below it) and a rerun of the same distribution must not be flagged
+VA_BENCHMARK( BenchmarkStatistics )
+{
+    const int warmupCount = 60, sampleCount = 2000;
+    auto makeSamples = [ & ]( uint32 seed, float mean )
+    {
+        std::mt19937 rng( seed );
+        std::normal_distribution<float> noise( 0.0f, mean * 0.05f );
+        std::vector<float> samples;
+        for( int i = 0; i < warmupCount; i++ )
+            samples.push_back( mean * ( 3.0f - 2.0f * i / warmupCount ) + noise( rng ) );
+        for( int i = 0; i < sampleCount; i++ )
+            samples.push_back( mean + noise( rng ) + ( ( i % 500 == 250 ) ? ( mean * 3.0f ) : ( 0.0f ) ) );     // few hitches
+        return samples;
+    };
+
+    vaBenchmarkTool::RunDefinition runDef;
+    runDef.Name         = "Synthetic";
+    runDef.MetricNames  = { "FrameTime" };
+
+    const wstring directory = vaCore::GetExecutableDirectory( );
+    const wstring files[4] = { directory + L"benchmark_statistics_base.csv", directory + L"benchmark_statistics_same.csv", directory + L"benchmark_statistics_slower.csv", directory + L"benchmark_statistics_slightly_slower.csv" };
+    const uint32 seeds[4] = { 1, 2, 3, 4 };
+    const float means[4] = { 10.0f, 10.0f, 10.25f, 10.15f };
+    for( int i = 0; i < countof( files ); i++ )
+    {
+        const vaBenchmarkTool::MetricStatistics stats = vaBenchmarkTool::ComputeStatistics( makeSamples( seeds[i], means[i] ), runDef.Statistics );
+        if( i == 0 )
+        {
+            context.Report( "warmup %d (of %d), outliers %d, mean %.3f [%.3f, %.3f], p50 %.3f, p99 %.3f, hitches %d", stats.WarmupSampleCount, warmupCount,
+                stats.OutlierCount, stats.Mean, stats.ConfidenceLow, stats.ConfidenceHigh, stats.P50, stats.P99, stats.HitchCount );
+            // MSER tends to drop a few batches too many, which is fine - it must not keep any of the warmup though
+            if( stats.WarmupSampleCount < warmupCount - 10 || stats.WarmupSampleCount > warmupCount * 2 )
+                context.Fail( "warmup detected as %d samples, expected about %d", stats.WarmupSampleCount, warmupCount );
+            if( stats.HitchCount != sampleCount / 500 )
+                context.Fail( "%d hitches detected, expected %d", stats.HitchCount, sampleCount / 500 );
+            if( std::abs( stats.Mean - means[i] ) > 3.0f * stats.StandardError )
+                context.Fail( "mean %.3f is more than 3 standard errors (%.4f) away from %.3f", stats.Mean, stats.StandardError, means[i] );
+        }
+        vaBenchmarkTool::WriteStatisticsCSV( files[i], false, runDef, { stats } );
+    }
+
+    vaBenchmarkTool::ComparisonSettings settings;
+    std::vector<vaBenchmarkTool::ComparisonResult> same, slower, slightlySlower;
+    if( !vaBenchmarkTool::CompareStatisticsCSV( files[0], files[1], settings, same ) || !vaBenchmarkTool::CompareStatisticsCSV( files[0], files[2], settings, slower ) 
+        || !vaBenchmarkTool::CompareStatisticsCSV( files[0], files[3], settings, slightlySlower ) || same.size( ) != 1 || slower.size( ) != 1 || slightlySlower.size( ) != 1 )
+        context.Fail( "could not compare statistics CSV files" );
+    else
+    {
+        context.Report( "same distribution: %s", vaBenchmarkTool::FormatComparison( same, false ).c_str( ) );
+        context.Report( "2.5%% slower: %s", vaBenchmarkTool::FormatComparison( slower, false ).c_str( ) );
+        context.Report( "1.5%% slower: %s", vaBenchmarkTool::FormatComparison( slightlySlower, false ).c_str( ) );
+        if( same[0].Regression || same[0].Improvement )
+            context.Fail( "rerun of the same distribution flagged as a change (t %.2f)", same[0].TScore );
+        if( !slower[0].Regression )
+            context.Fail( "2.5%% slower run not flagged as a regression (t %.2f, %+.2f%%)", slower[0].TScore, slower[0].RelativeChange * 100.0f );
+        if( slightlySlower[0].Regression || slightlySlower[0].Improvement )
+            context.Fail( "1.5%% slower run flagged as a change - it's under the %.1f%% threshold (t %.2f, %+.2f%%)", settings.MinRelativeChange * 100.0f, slightlySlower[0].TScore, slightlySlower[0].RelativeChange * 100.0f );
+        else if( std::abs( slightlySlower[0].TScore ) < settings.MinTScore )
+            context.Fail( "1.5%% slower run isn't significant (t %.2f) so it doesn't test the relative change threshold", slightlySlower[0].TScore );
+    }
+    for( const wstring & file : files )
+        vaFileTools::DeleteFile( file );
+}
+
@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation 
+// 
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Core/vaCoreIncludes.h"
+
+namespace Vanilla
+{
+    // Headless (no render device, no window) benchmark and regression runner, started with:
+    //
+    //   Vanilla.exe -benchmark [filter] [-benchmarkdata <dir>] [-benchmarkupdate] [-benchmarkiterations <n>] [-benchmarktolerance <x>]
+    //
+    //  * 'filter' is a case-insensitive substring of benchmark names; all benchmarks are run if empty
+    //  * '-benchmarkdata' is where captures, references and baselines are; defaults to "<exe>\Media\Benchmarks\"
+    //  * '-benchmarkupdate' (re)writes references and baselines instead of comparing against them
+    //  * '-benchmarktolerance' is the allowed relative throughput drop vs baseline (default 0.1, 10%)
+    //
+    // Report is written into "<exe>\benchmark_report.txt" (and vaLog); the process exit code is the number of failures.
+    class BenchmarkContext
+    {
+    public:
+        wstring                                     DataDirectory;
+        bool                                        UpdateReferences            = false;
+        int                                         Iterations                  = 10;
+        double                                      ThroughputTolerance         = 0.1;
+
+    protected:
+        string                                      m_currentBenchmark;
+        string                                      m_report;
+        int                                         m_failureCount              = 0;
+
+        // "key value" pairs stored in DataDirectory + "baselines.txt"; throughput is machine specific so keep them per-machine
+        std::map<string, double>                    m_baselines;
+        bool                                        m_baselinesDirty            = false;
+
+    public:
+        BenchmarkContext( const wstring & dataDirectory );
+        ~BenchmarkContext( );
+
+        void                                        Report( const char * format, ... );
+        void                                        Fail( const char * format, ... );
+        int                                         FailureCount( ) const                               { return m_failureCount; }
+
+        // Higher is better - fails if value dropped by more than ThroughputTolerance vs the stored baseline; stores the baseline if
+        // updating or if there's none. Key is prefixed with the current benchmark name.
+        bool                                        CheckThroughput( const string & key, double value, const char * units );
+
+        // Runs the callable Iterations times (after one warmup run) and returns the median time in milliseconds
+        template< typename CallableType >
+        double                                      MeasureMedian( CallableType && callable );
+
+        const string &                              GetReport( ) const                                  { return m_report; }
+
+    private:
+        friend int RunBenchmarks( const std::vector<std::pair<wstring, wstring>> & );
+        void                                        BeginBenchmark( const string & name );
+        void                                        EndBenchmark( );
+    };
+
+    typedef void ( *BenchmarkFunction )( BenchmarkContext & context );
+
+    struct BenchmarkRegistrar
+    {
+        BenchmarkRegistrar( const char * name, BenchmarkFunction function );
+    };
+
+    // Use in Project .cpp files to register a benchmark; the body gets a 'BenchmarkContext & context'
+#define VA_BENCHMARK( name )                                                                                            \
+    static void Benchmark_##name( BenchmarkContext & context );                                                         \
+    static BenchmarkRegistrar s_benchmarkRegistrar_##name( #name, Benchmark_##name );                                   \
+    static void Benchmark_##name( BenchmarkContext & context )
+
+    // Returns true if '-benchmark' is present
+    bool                                            IsBenchmarkRun( const std::vector<std::pair<wstring, wstring>> & cmdLineParams );
+
+    // Returns the number of failures (0 is success); expects vaCore to be initialized.
+    int                                             RunBenchmarks( const std::vector<std::pair<wstring, wstring>> & cmdLineParams );
+
+    // Headless scene benchmark (vaSceneHeadlessRunner - fixed delta time ticks, no render device needed), started with:
+    //
+    //   Vanilla.exe -scenebench [script] [-scenebenchscene <scene.json>] [-scenebenchout <file.csv>] [-scenebenchframes <n>]
+    //
+    //  * 'script' is one of the built-in scripts (see BenchmarksHeadless.cpp), "sweep" if empty
+    //  * without '-scenebenchscene' a synthetic scene is generated
+    //  * results are vaBenchmarkTool::WriteStatisticsCSV rows, by default in "<exe>\scene_benchmark.csv"; compare two of them
+    //    with '-benchmarkcompare'
+    //  * '-scenebenchframes' is the number of sampled frames per run (default 600)
+    bool                                            IsSceneBenchmarkRun( const std::vector<std::pair<wstring, wstring>> & cmdLineParams );
+
+    // Returns 0 on success; expects vaCore to be initialized.
+    int                                             RunSceneBenchmark( const std::vector<std::pair<wstring, wstring>> & cmdLineParams );
+
+    template< typename CallableType >
+    inline double BenchmarkContext::MeasureMedian( CallableType && callable )
+    {
+        callable( );  // warmup
+        std::vector<double> times( std::max( 1, Iterations ) );
+        for( double & time : times )
+        {
+            double start = vaCore::TimeFromAppStart( );
+            callable( );
+            time = ( vaCore::TimeFromAppStart( ) - start ) * 1000.0;
+        }
+        std::sort( times.begin( ), times.end( ) );
+        return times[times.size( ) / 2];
+    }
+}
@@ -0,0 +1,545 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmarks.h"
+
+#include "Core/vaConcurrency.h"
+#include "Core/vaProfiler.h"
+
+#include <functional>
+#include <thread>
+
+using namespace Vanilla;
+
+namespace
+{
+    const int c_threadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+    // Starts threadCount threads, lines them up and runs work( threadIndex ) on each; returns time in milliseconds from start
+    // (all threads released) to all done.
+    template< typename WorkType >
+    double RunOnThreads( int threadCount, WorkType && work )
+    {
+        std::atomic<int> readyCount = 0;
+        std::atomic<bool> go = false;
+        std::vector<std::thread> threads;
+        for( int i = 0; i < threadCount; i++ )
+            threads.emplace_back( [ &, i ]( )
+            {
+                readyCount++;
+                while( !go.load( std::memory_order_acquire ) )
+                    std::this_thread::yield( );
+                work( i );
+            } );
+        while( readyCount.load( ) != threadCount )
+            std::this_thread::yield( );
+        const double start = vaCore::TimeFromAppStart( );
+        go.store( true, std::memory_order_release );
+        for( std::thread & thread : threads )
+            thread.join( );
+        return ( vaCore::TimeFromAppStart( ) - start ) * 1000.0;
+    }
+
+    // Same as RunOnThreads but with threads that persist between runs - needed for anything that permanently assigns a slot to 
+    // each thread that ever touched it (such as vaAppendConsumeList, with its MaxThreadsSupported limit)
+    class ThreadTeam
+    {
+        std::vector<std::thread>        m_threads;
+        std::function<void( int )>      m_work;
+        int                             m_activeCount   = 0;
+        std::atomic<int>                m_generation    = 0;
+        std::atomic<int>                m_doneCount     = 0;
+        std::atomic<bool>               m_exit          = false;
+
+    public:
+        ThreadTeam( int threadCount )
+        {
+            for( int i = 0; i < threadCount; i++ )
+                m_threads.emplace_back( [ this, i ]( )
+                {
+                    int seenGeneration = 0;
+                    for( ;; )
+                    {
+                        int generation;
+                        while( ( generation = m_generation.load( std::memory_order_acquire ) ) == seenGeneration && !m_exit.load( ) )
+                            std::this_thread::yield( );
+                        if( m_exit.load( ) )
+                            return;
+                        seenGeneration = generation;
+                        if( i < m_activeCount )
+                            m_work( i );
+                        m_doneCount.fetch_add( 1, std::memory_order_release );
+                    }
+                } );
+        }
+        ~ThreadTeam( )
+        {
+            m_exit.store( true );
+            for( std::thread & thread : m_threads )
+                thread.join( );
+        }
+
+        // Runs work( threadIndex ) on the first threadCount threads; returns time in milliseconds
+        double Run( int threadCount, const std::function<void( int )> & work )
+        {
+            assert( threadCount <= (int)m_threads.size( ) );
+            m_work          = work;
+            m_activeCount   = threadCount;
+            m_doneCount.store( 0 );
+            const double start = vaCore::TimeFromAppStart( );
+            m_generation.fetch_add( 1, std::memory_order_release );
+            while( m_doneCount.load( std::memory_order_acquire ) != (int)m_threads.size( ) )
+                std::this_thread::yield( );
+            return ( vaCore::TimeFromAppStart( ) - start ) * 1000.0;
+        }
+
+        // Same as Run but times only work( threadIndex ) itself: the threads line up at a start barrier first, and the time is
+        // from the first one leaving it to the last one done, in milliseconds (waking the team up isn't part of it)
+        double RunBetweenBarriers( int threadCount, const std::function<void( int )> & work )
+        {
+            std::atomic<int> arrivedCount = 0;
+            std::vector<double> starts( threadCount ), ends( threadCount );
+            Run( threadCount, [ & ]( int threadIndex )
+            {
+                arrivedCount.fetch_add( 1, std::memory_order_acq_rel );
+                while( arrivedCount.load( std::memory_order_acquire ) != threadCount )
+                    std::this_thread::yield( );
+                starts[threadIndex] = vaCore::TimeFromAppStart( );
+                work( threadIndex );
+                ends[threadIndex]   = vaCore::TimeFromAppStart( );
+            } );
+            return ( *std::max_element( ends.begin( ), ends.end( ) ) - *std::min_element( starts.begin( ), starts.end( ) ) ) * 1000.0;
+        }
+    };
+
+    // Median of iterations runs (after one warmup run) of a callable that returns its own time in milliseconds - for when
+    // BenchmarkContext::MeasureMedian would time too much
+    template< typename CallableType >
+    double MedianOfTimed( int iterations, CallableType && timedCallable )
+    {
+        timedCallable( );
+        std::vector<double> times( std::max( 1, iterations ) );
+        for( double & time : times )
+            time = timedCallable( );
+        std::sort( times.begin( ), times.end( ) );
+        return times[times.size( ) / 2];
+    }
+
+    std::atomic<int64>  s_countedHeapAllocations   = 0;
+
+    // std::allocator that counts allocations into s_countedHeapAllocations
+    template< typename Type >
+    class CountingAllocator : public std::allocator<Type>
+    {
+    public:
+        template< typename OtherType >
+        struct rebind { typedef CountingAllocator<OtherType> other; };
+
+        CountingAllocator( ) noexcept       { }
+        template< typename OtherType >
+        CountingAllocator( const CountingAllocator<OtherType> & ) noexcept { }
+
+        Type *  allocate( size_t count )    { s_countedHeapAllocations.fetch_add( 1, std::memory_order_relaxed ); return std::allocator<Type>::allocate( count ); }
+    };
+
+    struct TransientFramesResult
+    {
+        double  MSPerFrame;
+        double  HeapAllocationsPerFrame;
+        bool    Valid;
+    };
+
+    // The vaRenderInstanceList pattern: every frame each list gets filled from all threads (vaAppendConsumeList), then gets
+    // a sort index array, and gets reset; item counts vary from frame to frame. With a frame allocator, storage is dropped on
+    // reset (as the sorter does), otherwise it's kept and reused (as it was before).
+    template< template< typename > class AllocatorType >
+    TransientFramesResult RunTransientFrames( ThreadTeam & team, int threadCount, int listCount, int warmupFrames, int frameCount, int baseItemCount )
+    {
+        typedef vaAppendConsumeList<uint32, 128, 384, AllocatorType<uint32>>   ListType;
+        typedef std::vector<int, AllocatorType<int>>                            IndicesType;
+        constexpr bool frameScoped = vaIsFrameAllocator<AllocatorType<int>>::value;
+
+        std::vector<std::unique_ptr<ListType>> lists;
+        std::vector<IndicesType> indices( listCount );
+        for( int i = 0; i < listCount; i++ )
+            lists.push_back( std::make_unique<ListType>( ) );
+
+        auto heapAllocations = [ ]( ) { return ( frameScoped ) ? ( (int64)vaFrameArena::TotalStats( ).HeapAllocations ) : ( s_countedHeapAllocations.load( ) ); };
+
+        TransientFramesResult result = { 0, 0, true };
+        int64 allocationsStart = 0;
+        double timeStart = 0;
+        for( int frame = 0; frame < warmupFrames + frameCount; frame++ )
+        {
+            if( frame == warmupFrames )
+            {
+                allocationsStart    = heapAllocations( );
+                timeStart           = vaCore::TimeFromAppStart( );
+            }
+            for( int l = 0; l < listCount; l++ )
+            {
+                const int itemCount = baseItemCount / 2 + (int)( ( (uint32)( frame * 7919 + l * 104729 ) * 2654435761u ) % (uint32)baseItemCount );
+                ListType & list = *lists[l];
+                list.StartAppending( );
+                team.Run( threadCount, [ & ]( int threadIndex )
+                {
+                    for( int i = itemCount * threadIndex / threadCount; i < itemCount * ( threadIndex + 1 ) / threadCount; i++ )
+                        list.Append( (uint32)i );
+                } );
+                list.StartConsuming( );
+
+                IndicesType & sortIndices = indices[l];
+                sortIndices.resize( list.Count( ) );
+                for( int i = 0; i < (int)sortIndices.size( ); i++ )
+                    sortIndices[i] = (int)list[sortIndices.size( ) - 1 - i];
+                result.Valid &= (int)list.Count( ) == itemCount;
+
+                if constexpr( frameScoped )
+                    sortIndices = IndicesType( );
+                else
+                    sortIndices.clear( );
+            }
+            vaFrameArena::NextFrame( );
+        }
+        result.MSPerFrame               = ( vaCore::TimeFromAppStart( ) - timeStart ) * 1000.0 / frameCount;
+        result.HeapAllocationsPerFrame  = (double)( heapAllocations( ) - allocationsStart ) / frameCount;
+        return result;
+    }
+}
+
+// lc_atomic_counter::add vs a single std::atomic fetch_add, plus an exactness check of reset_and_read under concurrent writes
+VA_BENCHMARK( LCAtomicCounter )
+{
+    const int64 addsPerThread = 1 << 20;
+
+    ThreadTeam team( c_threadCounts[countof( c_threadCounts ) - 1] );
+    for( int threadCount : c_threadCounts )
+    {
+        std::atomic<int64> plainCounter = 0;
+        const double plainMS = MedianOfTimed( context.Iterations, [ & ]( )
+        {
+            return team.RunBetweenBarriers( threadCount, [ & ]( int ) { for( int64 i = 0; i < addsPerThread; i++ ) plainCounter.fetch_add( 1, std::memory_order_relaxed ); } );
+        } );
+
+        lc_atomic_counter<int64> shardedCounter;
+        const double shardedMS = MedianOfTimed( context.Iterations, [ & ]( )
+        {
+            shardedCounter.reset( 0 );
+            return team.RunBetweenBarriers( threadCount, [ & ]( int ) { for( int64 i = 0; i < addsPerThread; i++ ) shardedCounter.add( 1 ); } );
+        } );
+        if( shardedCounter.sum( ) != addsPerThread * threadCount )
+            context.Fail( "%d threads: lc_atomic_counter sum %lld, expected %lld", threadCount, shardedCounter.sum( ), addsPerThread * threadCount );
+
+        const double totalMOps = (double)( addsPerThread * threadCount ) / 1e6;
+        context.Report( "%2d threads: std::atomic %8.2f Mop/s, lc_atomic_counter %8.2f Mop/s (%.2fx)", threadCount,
+            totalMOps / ( plainMS / 1000.0 ), totalMOps / ( shardedMS / 1000.0 ), plainMS / shardedMS );
+        context.CheckThroughput( vaStringTools::Format( "add.%dThreads", threadCount ), totalMOps / ( shardedMS / 1000.0 ), "Mop/s" );
+    }
+
+    // initial / reset values count once in the sum, and once per block for min/max
+    {
+        lc_atomic_counter<int64> seeded( 42 );
+        seeded.add( 1 );
+        lc_atomic_counter<int64> tracked;
+        tracked.reset_minmax( -1 );
+        if( seeded.sum( ) != 43 || seeded.reset_and_read( 7 ).Sum != 43 || seeded.sum( ) != 7 )
+            context.Fail( "lc_atomic_counter initial / reset value isn't counted exactly once in the sum" );
+        if( tracked.highest( ) != -1 || tracked.lowest( ) != -1 )
+            context.Fail( "lc_atomic_counter reset_minmax: lowest %lld, highest %lld, expected -1", tracked.lowest( ), tracked.highest( ) );
+    }
+
+    // reset_and_read while writers are running: snapshots plus what's left must add up to exactly what was written; min/max too
+    {
+        const int threadCount = std::max( 2, (int)std::thread::hardware_concurrency( ) );
+        lc_atomic_counter<int64> counter;
+        lc_atomic_counter<int64> highest;
+        highest.reset_minmax( std::numeric_limits<int64>::min( ) );
+        std::atomic<int> writersDone = 0;
+        int64 snapshotsSum = 0;
+        int64 snapshotsHighest = std::numeric_limits<int64>::min( );
+        RunOnThreads( threadCount + 1, [ & ]( int threadIndex )
+        {
+            if( threadIndex == threadCount )
+            {
+                while( writersDone.load( ) != threadCount )
+                {
+                    snapshotsSum += counter.reset_and_read( 0 ).Sum;
+                    snapshotsHighest = std::max( snapshotsHighest, highest.reset_and_read_minmax( std::numeric_limits<int64>::min( ) ).Highest );
+                }
+                return;
+            }
+            for( int64 i = 0; i < addsPerThread; i++ )
+            {
+                counter.add( 1 );
+                highest.max( threadIndex * addsPerThread + i );
+            }
+            writersDone++;
+        } );
+        const int64 total = snapshotsSum + counter.reset_and_read( 0 ).Sum;
+        snapshotsHighest = std::max( snapshotsHighest, highest.reset_and_read_minmax( std::numeric_limits<int64>::min( ) ).Highest );
+        if( total != addsPerThread * threadCount )
+            context.Fail( "reset_and_read: total %lld, expected %lld", total, addsPerThread * threadCount );
+        else if( snapshotsHighest != threadCount * addsPerThread - 1 )
+            context.Fail( "reset_and_read: highest %lld, expected %lld", snapshotsHighest, threadCount * addsPerThread - 1 );
+        else
+            context.Report( "reset_and_read exact under %d concurrent writers", threadCount );
+    }
+}
+
+// vaAppendConsumeList vs vaLockFreeAppendConsumeList with all threads appending at once (the scene selection pattern), including
+// the StartConsuming collation; also checks that every appended element comes out exactly once
+VA_BENCHMARK( AppendConsumeList )
+{
+    const int elementsPerThread = 1 << 16;
+
+    ThreadTeam team( c_threadCounts[countof( c_threadCounts ) - 1] );
+    auto lockedList     = std::make_unique<vaAppendConsumeList<uint32>>( );
+    auto lockFreeList   = std::make_unique<vaLockFreeAppendConsumeList<uint32>>( );
+
+    auto verify = [ & ]( auto & list, const char * name, int threadCount )
+    {
+        const size_t expectedCount = (size_t)elementsPerThread * threadCount;
+        if( list.Count( ) != expectedCount )
+        {
+            context.Fail( "%d threads: %s has %zu elements, expected %zu", threadCount, name, list.Count( ), expectedCount );
+            return;
+        }
+        std::vector<bool> seen( expectedCount, false );
+        for( size_t i = 0; i < expectedCount; i++ )
+        {
+            const uint32 value = list[i];
+            if( value >= expectedCount || seen[value] )
+            {
+                context.Fail( "%d threads: %s element %zu has unexpected or duplicated value %u", threadCount, name, i, value );
+                return;
+            }
+            seen[value] = true;
+        }
+    };
+
+    for( int threadCount : c_threadCounts )
+    {
+        auto appendAll = [ & ]( auto & list )
+        {
+            list.StartAppending( );
+            team.Run( threadCount, [ & ]( int threadIndex ) 
+            { 
+                for( int i = 0; i < elementsPerThread; i++ ) 
+                    list.Append( (uint32)( threadIndex * elementsPerThread + i ) ); 
+            } );
+            list.StartConsuming( );
+        };
+
+        const double lockedMS   = context.MeasureMedian( [ & ]( ) { appendAll( *lockedList ); } );
+        verify( *lockedList, "vaAppendConsumeList", threadCount );
+        const double lockFreeMS = context.MeasureMedian( [ & ]( ) { appendAll( *lockFreeList ); } );
+        verify( *lockFreeList, "vaLockFreeAppendConsumeList", threadCount );
+
+        const double totalMItems = (double)elementsPerThread * threadCount / 1e6;
+        context.Report( "%2d threads: vaAppendConsumeList %8.2f Mitems/s, vaLockFreeAppendConsumeList %8.2f Mitems/s (%.2fx)", threadCount,
+            totalMItems / ( lockedMS / 1000.0 ), totalMItems / ( lockFreeMS / 1000.0 ), lockedMS / lockFreeMS );
+        context.CheckThroughput( vaStringTools::Format( "append.%dThreads", threadCount ), totalMItems / ( lockFreeMS / 1000.0 ), "Mitems/s" );
+    }
+}
+
+// vaLockFreeAppendConsumeList with each thread going round-robin over several lists, one Append at a time: fewer lists than 
+// the per-thread chunk cache holds (each thread fills its own chunks) and more (appends to the lists that don't fit go through
+// each list's borrowable partially filled chunks), up to many threads contending for the same lists; vaAppendConsumeList 
+// doing the same for reference. Checks contents and that memory stays bounded - a thread that can't cache all the lists it
+// appends to must not reserve a new chunk per Append.
+VA_BENCHMARK( AppendConsumeListRoundRobin )
+{
+    const int   elementsPerThread   = 1 << 16;
+    const int   blockElementCount   = 384;      // vaLockFreeAppendConsumeList default
+    const int   threadCounts[]      = { 1, 8, 64 };
+    // own thread slots - ThreadTeam threads keep theirs and the AppendConsumeList benchmark already used 64 of the default 128
+    typedef vaAppendConsumeList<uint32, 256> LockedListType;
+
+    ThreadTeam team( threadCounts[countof( threadCounts ) - 1] );
+    for( int listCount : { 2, 32 } )
+    {
+        std::vector<std::unique_ptr<vaLockFreeAppendConsumeList<uint32>>> lists;
+        std::vector<std::unique_ptr<LockedListType>> lockedLists;
+        for( int i = 0; i < listCount; i++ )
+        {
+            lists.push_back( std::make_unique<vaLockFreeAppendConsumeList<uint32>>( ) );
+            lockedLists.push_back( std::make_unique<LockedListType>( ) );
+        }
+
+        for( int threadCount : threadCounts )
+        {
+            auto appendAll = [ & ]( auto & allLists )
+            {
+                for( auto & list : allLists )
+                    list->StartAppending( );
+                team.Run( threadCount, [ & ]( int threadIndex )
+                {
+                    for( int i = 0; i < elementsPerThread; i++ )
+                        allLists[i % listCount]->Append( (uint32)( threadIndex * elementsPerThread + i ) );
+                } );
+                for( auto & list : allLists )
+                    list->StartConsuming( );
+            };
+            const double lockedMS   = context.MeasureMedian( [ & ]( ) { appendAll( lockedLists ); } );
+            const double ms         = context.MeasureMedian( [ & ]( ) { appendAll( lists ); } );
+
+            const size_t totalCount = (size_t)elementsPerThread * threadCount;
+            std::vector<bool> seen( totalCount, false );
+            size_t count = 0;
+            uint32 chunkCount = 0, maxChunkCount = 0;
+            bool valid = true;
+            for( int listIndex = 0; listIndex < listCount; listIndex++ )
+            {
+                const vaLockFreeAppendConsumeList<uint32> & list = *lists[listIndex];
+                count += list.Count( );
+                chunkCount += list.UsedChunkCount( );
+                // dense chunks plus up to one partial one per thread - either its own or a borrowable one
+                const uint32 denseChunkCount = (uint32)( ( list.Count( ) + blockElementCount - 1 ) / blockElementCount );
+                maxChunkCount += denseChunkCount + threadCount;
+                for( size_t i = 0; i < list.Count( ); i++ )
+                {
+                    const uint32 value = list[i];
+                    valid &= value < totalCount && !seen[value] && (int)( value % elementsPerThread ) % listCount == listIndex;
+                    if( value < totalCount )
+                        seen[value] = true;
+                }
+            }
+            if( !valid || count != totalCount )
+                context.Fail( "%d lists, %d threads: %zu elements, expected %zu, or unexpected/duplicated/misplaced values", listCount, threadCount, count, totalCount );
+            if( chunkCount > maxChunkCount )
+                context.Fail( "%d lists, %d threads: %u chunks reserved for %zu elements (expected at most %u)", listCount, threadCount, chunkCount, count, maxChunkCount );
+
+            const double mitems = (double)totalCount / 1e6;
+            context.Report( "%2d lists, %2d threads: %8.2f Mitems/s (vaAppendConsumeList %8.2f Mitems/s, %.2fx), %u chunks (%.1f%% full)", listCount, threadCount, 
+                mitems / ( ms / 1000.0 ), mitems / ( lockedMS / 1000.0 ), lockedMS / ms, chunkCount, 100.0 * count / ( (double)chunkCount * blockElementCount ) );
+            context.CheckThroughput( vaStringTools::Format( "%dLists.%dThreads", listCount, threadCount ), mitems / ( ms / 1000.0 ), "Mitems/s" );
+        }
+    }
+}
+
+// Per-frame transient render lists (fill from all threads, build sort indices, reset) with heap storage that each list keeps
+// between frames vs with vaFrameArena storage; reports heap allocations and time per frame for both
+VA_BENCHMARK( FrameArena )
+{
+    const int listCount     = 8;
+    const int warmupFrames  = 8;
+    const int frameCount    = 64;
+
+    ThreadTeam team( 8 );
+    for( int threadCount : { 1, 8 } )
+        for( int baseItemCount : { 4096, 65536 } )
+        {
+            const TransientFramesResult heap    = RunTransientFrames<CountingAllocator>( team, threadCount, listCount, warmupFrames, frameCount, baseItemCount );
+            const TransientFramesResult arena   = RunTransientFrames<vaFrameAllocator>( team, threadCount, listCount, warmupFrames, frameCount, baseItemCount );
+            if( !heap.Valid || !arena.Valid )
+            {
+                context.Fail( "%d threads, %d items: list item count mismatch", threadCount, baseItemCount );
+                continue;
+            }
+            context.Report( "%d threads, %5d..%5d items x %d lists: heap %6.2f allocs/frame %7.3f ms/frame, frame arena %6.2f heap allocs/frame %7.3f ms/frame",
+                threadCount, baseItemCount / 2, baseItemCount / 2 + baseItemCount - 1, listCount, heap.HeapAllocationsPerFrame, heap.MSPerFrame, arena.HeapAllocationsPerFrame, arena.MSPerFrame );
+            context.CheckThroughput( vaStringTools::Format( "frames.%dThreads.%dItems", threadCount, baseItemCount ), 1000.0 / arena.MSPerFrame, "frames/s" );
+        }
+}
+
+// Cost of a VA_TRACE_CPU_SCOPE (begin + end into the thread's ring) on each of N threads at once, flat and 4 deep; the
+// collector is drained between runs so nothing is dropped. Budget is c_budgetNS per scope.
+VA_BENCHMARK( TracerScope )
+{
+#ifdef VA_SCOPE_TRACE_ENABLED
+    const double    c_budgetNS      = 20.0;
+    const int       scopesPerRun    = 8192;     // must fit into vaTracer::c_RingCapacity
+    const int       runCount        = 16;
+
+    // scope times are TSC based ticks calibrated against QPC - they have to agree with TimeFromAppStart
+    {
+        const double timeBefore = vaCore::TimeFromAppStart( );
+        const double tickTime   = vaCore::TimeTicksFromAppStart( ) * vaCore::TimeTickPeriod( );
+        const double timeAfter  = vaCore::TimeFromAppStart( );
+        if( std::abs( tickTime - ( timeBefore + timeAfter ) * 0.5 ) > std::max( 1e-4, timeAfter * 1e-3 ) )
+            context.Fail( "tick time %.6fs doesn't match TimeFromAppStart %.6fs", tickTime, timeAfter );
+    }
+
+    // the two clock reads every scope needs, for reference - on hardware where these alone get close to the budget
+    // there's nothing left for the tracer itself
+    double clockNS = std::numeric_limits<double>::max( );
+    for( int run = 0; run < runCount; run++ )
+    {
+        int64 elapsed = 0;
+        const double start = vaCore::TimeFromAppStart( );
+        for( int i = 0; i < scopesPerRun; i++ )
+        {
+            const int64 begin = vaCore::TimeTicksFromAppStart( );
+            elapsed += vaCore::TimeTicksFromAppStart( ) - begin;
+        }
+        clockNS = std::min( clockNS, ( vaCore::TimeFromAppStart( ) - start ) * 1e9 / scopesPerRun );
+        if( elapsed < 0 )
+            context.Fail( "TimeTicksFromAppStart went backwards" );
+    }
+    context.Report( "two TimeTicksFromAppStart reads: %6.2f ns", clockNS );
+
+    ThreadTeam team( 8 );
+    for( int threadCount : { 1, 2, 4, 8 } )
+        for( bool nested : { false, true } )
+        {
+            std::vector<double> bestNS( threadCount, std::numeric_limits<double>::max( ) );
+            std::vector<uint64> dropped( threadCount, 0 );
+            for( int run = 0; run < runCount; run++ )
+            {
+                vaTracer::Collect( );
+                team.Run( threadCount, [ & ]( int threadIndex )
+                {
+                    const uint64 droppedBefore = vaTracer::LocalThreadContext( )->DroppedCount( );
+                    const double start = vaCore::TimeFromAppStart( );
+                    if( !nested )
+                    {
+                        for( int i = 0; i < scopesPerRun; i++ )
+                        {
+                            VA_TRACE_CPU_SCOPE( TracerBenchFlat );
+                        }
+                    }
+                    else
+                    {
+                        for( int i = 0; i < scopesPerRun / 4; i++ )
+                        {
+                            VA_TRACE_CPU_SCOPE( TracerBench0 );
+                            {
+                                VA_TRACE_CPU_SCOPE( TracerBench1 );
+                                {
+                                    VA_TRACE_CPU_SCOPE( TracerBench2 );
+                                    {
+                                        VA_TRACE_CPU_SCOPE( TracerBench3 );
+                                    }
+                                }
+                            }
+                        }
+                    }
+                    const double ns = ( vaCore::TimeFromAppStart( ) - start ) * 1e9 / scopesPerRun;
+                    bestNS[threadIndex]     = std::min( bestNS[threadIndex], ns );
+                    dropped[threadIndex]   += vaTracer::LocalThreadContext( )->DroppedCount( ) - droppedBefore;
+                } );
+            }
+            vaTracer::Collect( );
+
+            const double worstNS        = *std::max_element( bestNS.begin( ), bestNS.end( ) );
+            uint64 totalDropped = 0;
+            for( uint64 d : dropped ) totalDropped += d;
+
+            context.Report( "%d threads, %s: %6.2f ns/scope (slowest thread), %llu dropped", threadCount, ( nested ) ? ( "4 deep" ) : ( "flat  " ), worstNS, totalDropped );
+            if( totalDropped > 0 )
+                context.Fail( "%d threads, %s: %llu scopes dropped with an empty ring", threadCount, ( nested ) ? ( "nested" ) : ( "flat" ), totalDropped );
+            if( worstNS > c_budgetNS )
+                context.Fail( "%d threads, %s: %.2f ns/scope is over the %.0f ns budget (%.2f ns of it are the clock reads)", threadCount, ( nested ) ? ( "nested" ) : ( "flat" ), worstNS, c_budgetNS, clockNS );
+            context.CheckThroughput( vaStringTools::Format( "%s.%dThreads", ( nested ) ? ( "nested" ) : ( "flat" ), threadCount ), 1000.0 / worstNS, "Mscopes/s" );
+        }
+#else
+    context.Report( "VA_SCOPE_TRACE_ENABLED not defined, nothing to measure" );
+#endif
+}
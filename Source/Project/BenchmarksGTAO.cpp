@@ -0,0 +1,289 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation 
+// 
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmarks.h"
+
+#include "Core/System/vaFileTools.h"
+#include "Core/System/vaFileStream.h"
+#include "Core/System/vaMemoryStream.h"
+
+#include "Rendering/Effects/vaGTAOCPU.h"
+
+#ifdef VA_TASKFLOW_INTEGRATION_ENABLED
+#include "IntegratedExternals/vaTaskflowIntegration.h"
+#endif
+
+using namespace Vanilla;
+
+namespace
+{
+    // Captured XeGTAO inputs (*.gtaocapture files in the benchmark data directory)
+    struct GTAOCapture
+    {
+        static const uint32                 c_magic             = 0x43544758;   // 'XGTC'
+        static const int32                  c_version           = 1;
+
+        string                              Name;
+        int                                 Width               = 0;
+        int                                 Height              = 0;
+        vaMatrix4x4                         ProjMatrix          = vaMatrix4x4::Identity;
+        std::vector<float>                  NDCDepth;
+        std::vector<uint32>                 ViewspaceNormals;   // R11G11B10_UNORM; optional
+
+        bool Save( const wstring & filePath ) const
+        {
+            vaFileStream outFile;
+            if( !outFile.Open( filePath, FileCreationMode::Create, FileAccessMode::Write ) )
+                return false;
+            bool ok = outFile.WriteValue<uint32>( c_magic ) && outFile.WriteValue<int32>( c_version );
+            ok = ok && outFile.WriteValue<int32>( Width ) && outFile.WriteValue<int32>( Height ) && outFile.WriteValue<vaMatrix4x4>( ProjMatrix );
+            ok = ok && outFile.WriteValueVector<float>( NDCDepth ) && outFile.WriteValueVector<uint32>( ViewspaceNormals );
+            return ok;
+        }
+
+        bool Load( const wstring & filePath )
+        {
+            auto inStream = vaFileTools::LoadMemoryStream( filePath );
+            if( inStream == nullptr )
+                return false;
+            uint32 magic = 0; int32 version = 0;
+            if( !inStream->ReadValue<uint32>( magic ) || magic != c_magic || !inStream->ReadValue<int32>( version ) || version != c_version )
+                return false;
+            int32 width = 0, height = 0;
+            bool ok = inStream->ReadValue<int32>( width ) && inStream->ReadValue<int32>( height ) && inStream->ReadValue<vaMatrix4x4>( ProjMatrix );
+            ok = ok && inStream->ReadValueVector<float>( NDCDepth ) && inStream->ReadValueVector<uint32>( ViewspaceNormals );
+            if( !ok || width <= 0 || height <= 0 || NDCDepth.size( ) != (size_t)width * height || ( ViewspaceNormals.size( ) != 0 && ViewspaceNormals.size( ) != NDCDepth.size( ) ) )
+                return false;
+            Width = width; Height = height;
+            wstring fileName;
+            vaFileTools::SplitPath( filePath, nullptr, &fileName, nullptr );
+            Name = vaStringTools::SimpleNarrow( fileName );
+            return true;
+        }
+
+        // Procedural scene (floor, back wall, a few spheres and a box) for when there are no captures; not as representative as
+        // real captures but covers edges, thin features and distance falloff.
+        static GTAOCapture Synthetic( int width, int height )
+        {
+            GTAOCapture ret;
+            ret.Name        = vaStringTools::Format( "Synthetic%dx%d", width, height );
+            ret.Width       = width;
+            ret.Height      = height;
+            const float fovY    = 55.0f / 180.0f * VA_PIf;
+            const float aspect  = (float)width / (float)height;
+            ret.ProjMatrix  = vaMatrix4x4::PerspectiveFovLH( fovY, aspect, 0.1f, 1000.0f );
+            ret.NDCDepth.resize( (size_t)width * height );
+
+            const float tanHalfY = std::tan( fovY * 0.5f );
+            const float tanHalfX = tanHalfY * aspect;
+            const vaVector4 spheres[] = { { -1.5f, -0.4f, 5.0f, 0.6f }, { 0.3f, -0.7f, 4.2f, 0.3f }, { 1.8f, 0.2f, 7.5f, 1.2f }, { -0.2f, -0.9f, 3.0f, 0.1f } };
+            const vaBoundingBox box( { -3.0f, -1.0f, 8.0f }, { 1.5f, 2.0f, 1.0f } );
+
+            for( int y = 0; y < height; y++ )
+                for( int x = 0; x < width; x++ )
+                {
+                    const float ndcX = ( (float)x + 0.5f ) / (float)width * 2.0f - 1.0f;
+                    const float ndcY = 1.0f - ( (float)y + 0.5f ) / (float)height * 2.0f;
+                    const vaVector3 dir( ndcX * tanHalfX, ndcY * tanHalfY, 1.0f );
+
+                    float t = 12.0f;                                                    // back wall at z = 12
+                    if( dir.y < 0.0f )
+                        t = std::min( t, -1.0f / dir.y );                               // floor at y = -1
+                    for( const vaVector4 & sphere : spheres )
+                    {
+                        const vaVector3 center = sphere.AsVec3( );
+                        const float b = vaVector3::Dot( dir, center );
+                        const float c = vaVector3::Dot( center, center ) - sphere.w * sphere.w;
+                        const float a = vaVector3::Dot( dir, dir );
+                        const float disc = b * b - a * c;
+                        if( disc >= 0.0f )
+                        {
+                            const float ts = ( b - std::sqrt( disc ) ) / a;
+                            if( ts > 0.0f )
+                                t = std::min( t, ts );
+                        }
+                    }
+                    {
+                        float tmin = 0.0f, tmax = t;
+                        bool hit = true;
+                        for( int i = 0; i < 3 && hit; i++ )
+                        {
+                            const float invD = 1.0f / dir[i];
+                            float t0 = box.Min[i] * invD;                          // ray starts at the camera (0, 0, 0)
+                            float t1 = ( box.Min[i] + box.Size[i] ) * invD;
+                            if( invD < 0.0f ) std::swap( t0, t1 );
+                            tmin = std::max( tmin, t0 ); tmax = std::min( tmax, t1 );
+                            hit = tmax > tmin;
+                        }
+                        if( hit )
+                            t = tmin;
+                    }
+                    const float viewZ = t * dir.z;
+                    ret.NDCDepth[(size_t)y * width + x] = ( viewZ * ret.ProjMatrix.m[2][2] + ret.ProjMatrix.m[3][2] ) / viewZ;
+                }
+            return ret;
+        }
+    };
+
+    struct GTAOPreset
+    {
+        const char *                        Name;
+        int                                 QualityLevel;
+        int                                 DenoisePasses;
+        bool                                BentNormals;
+    };
+    const GTAOPreset c_gtaoPresets[] = {
+        { "Low",            0, 1, false },
+        { "Medium",         1, 1, false },
+        { "High",           2, 1, false },
+        { "Ultra",          3, 1, false },
+        { "HighSoft",       2, 3, false },
+        { "HighBentNormals",2, 1, true  },
+    };
+
+    // output vs reference must be at least this similar; CPU path is deterministic so any difference comes from code or settings changes
+    const double c_gtaoMinPSNR      = 45.0;
+}
+
+VA_BENCHMARK( XeGTAOCPU )
+{
+    std::vector<GTAOCapture> captures;
+    for( const wstring & filePath : vaFileTools::FindFiles( context.DataDirectory, L"*.gtaocapture", false ) )
+    {
+        GTAOCapture capture;
+        if( capture.Load( filePath ) )
+            captures.push_back( std::move( capture ) );
+        else
+            context.Fail( "unable to load capture '%s'", vaStringTools::SimpleNarrow( filePath ).c_str( ) );
+    }
+    if( captures.size( ) == 0 )
+    {
+        context.Report( "no *.gtaocapture files in '%s', using a synthetic scene", vaStringTools::SimpleNarrow( context.DataDirectory ).c_str( ) );
+        captures.push_back( GTAOCapture::Synthetic( 1920, 1080 ) );
+    }
+
+    vaFileTools::EnsureDirectoryExists( context.DataDirectory );
+
+    // store the synthetic scene so that later runs use the exact same inputs as the references were generated with
+    if( context.UpdateReferences && captures.size( ) == 1 && !vaFileTools::FileExists( context.DataDirectory + vaStringTools::SimpleWiden( captures[0].Name ) + L".gtaocapture" ) )
+        captures[0].Save( context.DataDirectory + vaStringTools::SimpleWiden( captures[0].Name ) + L".gtaocapture" );
+
+    vaGTAOCPU gtao;
+    std::vector<uint32> output;
+    for( const GTAOCapture & capture : captures )
+    {
+        vaGTAOCPU::Inputs inputs;
+        inputs.Width            = capture.Width;
+        inputs.Height           = capture.Height;
+        inputs.NDCDepth         = capture.NDCDepth.data( );
+        inputs.ViewspaceNormals = ( capture.ViewspaceNormals.size( ) > 0 ) ? ( capture.ViewspaceNormals.data( ) ) : ( nullptr );
+        inputs.ProjMatrix       = capture.ProjMatrix;
+
+        const double megaPixels = (double)capture.Width * capture.Height / 1e6;
+
+        for( const GTAOPreset & preset : c_gtaoPresets )
+        {
+            const string testName = capture.Name + "." + preset.Name;
+            gtao.Settings( )                = XeGTAO::GTAOSettings( );
+            gtao.Settings( ).QualityLevel   = preset.QualityLevel;
+            gtao.Settings( ).DenoisePasses  = preset.DenoisePasses;
+
+            vaGTAOCPU::Timings passTimes;
+            int runs = 0;
+            const double medianMS = context.MeasureMedian( [ & ]( )
+            {
+                gtao.Compute( inputs, preset.BentNormals, output );
+                passTimes.GenerateNormals   += gtao.LastTimings( ).GenerateNormals;
+                passTimes.PrefilterDepths   += gtao.LastTimings( ).PrefilterDepths;
+                passTimes.MainPass          += gtao.LastTimings( ).MainPass;
+                passTimes.Denoise           += gtao.LastTimings( ).Denoise;
+                runs++;
+            } );
+
+            // pass spans overlap because the passes are pipelined tile-by-tile
+            context.Report( "%s: %.3fms median; average per pass span: normals %.3fms, prefilter %.3fms, main %.3fms, denoise %.3fms", testName.c_str( ), medianMS,
+                passTimes.GenerateNormals / runs, passTimes.PrefilterDepths / runs, passTimes.MainPass / runs, passTimes.Denoise / runs );
+            context.CheckThroughput( testName, megaPixels / ( medianMS / 1000.0 ), "MP/s" );
+
+            // quality vs stored reference
+            const wstring referencePath = context.DataDirectory + vaStringTools::SimpleWiden( testName ) + L".gtaoref";
+            auto referenceStream = ( context.UpdateReferences ) ? ( shared_ptr<vaMemoryStream>( nullptr ) ) : ( vaFileTools::LoadMemoryStream( referencePath ) );
+            if( referenceStream == nullptr )
+            {
+                if( !vaFileTools::WriteBuffer( referencePath, output.data( ), output.size( ) * sizeof( uint32 ) ) )
+                    context.Fail( "%s: unable to write reference '%s'", testName.c_str( ), vaStringTools::SimpleNarrow( referencePath ).c_str( ) );
+                else
+                    context.Report( "%s: reference %s", testName.c_str( ), ( context.UpdateReferences ) ? ( "updated" ) : ( "created" ) );
+                continue;
+            }
+            if( referenceStream->GetLength( ) != (int64)( output.size( ) * sizeof( uint32 ) ) )
+            {
+                context.Fail( "%s: reference size mismatch", testName.c_str( ) );
+                continue;
+            }
+            const uint32 * reference = reinterpret_cast<const uint32 *>( referenceStream->GetBuffer( ) );
+            const int channels = ( preset.BentNormals ) ? ( 4 ) : ( 1 );
+            double sumSqError = 0.0;
+            for( size_t i = 0; i < output.size( ); i++ )
+                for( int c = 0; c < channels; c++ )
+                {
+                    const double diff = (double)( ( output[i] >> ( c * 8 ) ) & 0xFF ) - (double)( ( reference[i] >> ( c * 8 ) ) & 0xFF );
+                    sumSqError += diff * diff;
+                }
+            const double mse  = sumSqError / ( (double)output.size( ) * channels );
+            const double psnr = ( mse > 0.0 ) ? ( 10.0 * std::log10( 255.0 * 255.0 / mse ) ) : ( std::numeric_limits<double>::infinity( ) );
+            if( psnr < c_gtaoMinPSNR )
+                context.Fail( "%s: MSE %.4f, PSNR %.2fdB below %.2fdB threshold - quality regression", testName.c_str( ), mse, psnr, c_gtaoMinPSNR );
+            else
+                context.Report( "%s: MSE %.4f, PSNR %.2fdB", testName.c_str( ), mse, psnr );
+        }
+    }
+}
+
+#ifdef VA_TASKFLOW_INTEGRATION_ENABLED
+// Thread count sweep on a 4K input with the High preset; reports speedup and parallel efficiency vs 1 thread.
+VA_BENCHMARK( XeGTAOCPUScaling )
+{
+    const GTAOCapture capture = GTAOCapture::Synthetic( 3840, 2160 );
+    const double megaPixels = (double)capture.Width * capture.Height / 1e6;
+
+    vaGTAOCPU::Inputs inputs;
+    inputs.Width        = capture.Width;
+    inputs.Height       = capture.Height;
+    inputs.NDCDepth     = capture.NDCDepth.data( );
+    inputs.ProjMatrix   = capture.ProjMatrix;
+
+    vaGTAOCPU gtao;
+    gtao.Settings( ).QualityLevel   = 2;
+    gtao.Settings( ).DenoisePasses  = 1;
+
+    std::vector<int> threadCounts;
+    const int maxThreads = std::max( 1, (int)std::thread::hardware_concurrency( ) );
+    for( int threadCount = 1; threadCount < maxThreads; threadCount *= 2 )
+        threadCounts.push_back( threadCount );
+    threadCounts.push_back( maxThreads );
+
+    std::vector<uint32> output;
+    double singleThreadMS = 0.0;
+    for( int threadCount : threadCounts )
+    {
+        tf::Executor executor( threadCount );
+        gtao.SetExecutor( &executor );
+        const double medianMS = context.MeasureMedian( [ & ]( ) { gtao.Compute( inputs, false, output ); } );
+        gtao.SetExecutor( nullptr );
+
+        if( threadCount == 1 )
+            singleThreadMS = medianMS;
+        const double speedup = singleThreadMS / medianMS;
+        context.Report( "%2d thread(s): %9.3fms, speedup %6.2fx, efficiency %5.1f%%", threadCount, medianMS, speedup, speedup / threadCount * 100.0 );
+        context.CheckThroughput( vaStringTools::Format( "4K.High.%dThreads", threadCount ), megaPixels / ( medianMS / 1000.0 ), "MP/s" );
+    }
+}
+#endif
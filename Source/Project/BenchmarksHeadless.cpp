@@ -0,0 +1,409 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmarks.h"
+
+#include "Core/System/vaFileTools.h"
+#include "Core/System/vaFileStream.h"
+#include "Core/vaSerializer.h"
+
+#include "Scene/vaSceneHeadlessRunner.h"
+#include "Scene/vaCameraControllers.h"
+#include "Scene/vaSceneSystems.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace Vanilla;
+
+namespace
+{
+    struct SceneBenchmarkOptions
+    {
+        int                                 SampleFrames        = 600;
+        int                                 WarmupFrames        = 60;
+        wstring                             OutputCSV;
+    };
+
+    typedef std::function<bool( vaMiniScriptInterface &, vaSceneHeadlessRunner &, const SceneBenchmarkOptions & )> SceneBenchmarkScript;
+
+    // Synthetic 'city' that only needs CPU-side components: a grid of blocks, each a root with a few levels of children with
+    // Scene::CustomBoundingBox (so they get Scene::WorldBounds and go through selection); every 8th block spins, which keeps
+    // transforms and bounds busy every frame
+    void CreateSyntheticScene( vaScene & scene, int gridSize )
+    {
+        vaRandom random( gridSize );
+        for( int y = 0; y < gridSize; y++ )
+            for( int x = 0; x < gridSize; x++ )
+            {
+                const vaVector3 blockCenter( ( x - gridSize * 0.5f ) * 20.0f, ( y - gridSize * 0.5f ) * 20.0f, 0.0f );
+                entt::entity block = scene.CreateEntity( vaStringTools::Format( "block_%d_%d", x, y ), vaMatrix4x4::Translation( blockCenter ) );
+                if( ( x + y * gridSize ) % 8 == 0 )
+                    scene.Registry( ).emplace<Scene::SimpleScript>( block ).TypeName = "HeadlessSpin";
+                for( int building = 0; building < 4; building++ )
+                {
+                    const vaVector3 offset( random.NextFloatRange( -8.0f, 8.0f ), random.NextFloatRange( -8.0f, 8.0f ), 0.0f );
+                    const float height = random.NextFloatRange( 3.0f, 30.0f );
+                    entt::entity parent = scene.CreateEntity( "building", vaMatrix4x4::Translation( offset ), block );
+                    scene.Registry( ).emplace<Scene::CustomBoundingBox>( parent, vaBoundingBox( vaVector3( -2.0f, -2.0f, 0.0f ), vaVector3( 4.0f, 4.0f, height ) ) );
+                    for( int detail = 0; detail < 4; detail++ )
+                    {
+                        entt::entity child = scene.CreateEntity( "detail", vaMatrix4x4::Translation( 0.0f, 0.0f, height * ( detail + 1 ) / 5.0f ), parent );
+                        scene.Registry( ).emplace<Scene::CustomBoundingBox>( child, vaBoundingBox( vaVector3( -2.2f, -2.2f, -0.1f ), vaVector3( 4.4f, 4.4f, 0.2f ) ) );
+                    }
+                }
+            }
+    }
+
+    // Highest vaCore::GetProcessPrivateMemory above what was in use before, while 'function' runs; sampled from another thread
+    // every millisecond so a very short spike could be missed, which is fine for comparing approaches
+    int64 MeasurePeakMemory( const std::function<void( )> & function )
+    {
+        const int64 before = vaCore::GetProcessPrivateMemory( );
+        std::atomic<int64> peak = before;
+        std::atomic<bool> done = false;
+        auto sample = [&peak]( ) { const int64 current = vaCore::GetProcessPrivateMemory( ); int64 previous = peak.load( ); while( current > previous && !peak.compare_exchange_weak( previous, current ) ) { } };
+        std::thread sampler( [&]( ) { while( !done.load( ) ) { sample( ); std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) ); } } );
+        function( );
+        sample( );
+        done = true;
+        sampler.join( );
+        return std::max( (int64)0, peak.load( ) - before );
+    }
+
+    // circle around the center at street level, looking ahead
+    shared_ptr<vaCameraControllerFlythrough> CreateCirclePath( float radius, float height, float duration )
+    {
+        auto path = std::make_shared<vaCameraControllerFlythrough>( );
+        const int keyCount = 16;
+        vaCameraBase helper;
+        for( int i = 0; i <= keyCount; i++ )
+        {
+            const float angle = i / (float)keyCount * 2.0f * VA_PIf;
+            const vaVector3 position( radius * std::cos( angle ), radius * std::sin( angle ), height );
+            const vaVector3 ahead( radius * std::cos( angle + 0.3f ), radius * std::sin( angle + 0.3f ), height );
+            helper.SetPosition( position );
+            helper.SetOrientationLookAt( ahead );
+            path->AddKey( vaCameraControllerFlythrough::Keyframe( position, helper.GetOrientation( ), i / (float)keyCount * duration ) );
+        }
+        return path;
+    }
+
+    // Transform updates through the registry vs vaSceneTransformHierarchy, each with a static and a moving camera
+    bool ScriptSweep( vaMiniScriptInterface & script, vaSceneHeadlessRunner & runner, const SceneBenchmarkOptions & options )
+    {
+        // one frame so that async node names are known
+        if( !script.YieldExecution( ) )
+            return false;
+
+        const float pathDuration = options.SampleFrames * runner.FixedDeltaTime( );
+        auto staticCamera = [ ]( vaCameraBase & camera )
+        {
+            camera.AttachController( nullptr );
+            camera.SetPosition( vaVector3( -150.0f, -150.0f, 60.0f ) );
+            camera.SetOrientationLookAt( vaVector3( 0.0f, 0.0f, 0.0f ) );
+        };
+        auto movingCamera = [pathDuration]( vaCameraBase & camera )
+        {
+            camera.AttachController( CreateCirclePath( 200.0f, 10.0f, pathDuration ) );
+        };
+
+        std::vector<vaBenchmarkTool::RunDefinition> runs;
+        for( bool useHierarchy : { false, true } )
+        {
+            const string transforms = ( useHierarchy ) ? ( "hierarchy" ) : ( "registry" );
+            runs.push_back( runner.MakeRun( "static camera, " + transforms + " transforms", options.SampleFrames, options.WarmupFrames,
+                [staticCamera, useHierarchy]( vaSceneHeadlessRunner & target ) { staticCamera( target.Camera( ) ); target.Scene( )->SetUseTransformHierarchy( useHierarchy ); } ) );
+            runs.push_back( runner.MakeRun( "flythrough, " + transforms + " transforms", options.SampleFrames, options.WarmupFrames,
+                [movingCamera, useHierarchy]( vaSceneHeadlessRunner & target ) { movingCamera( target.Camera( ) ); target.Scene( )->SetUseTransformHierarchy( useHierarchy ); } ) );
+        }
+
+        // write all runs into one file, machine readable, for CompareStatisticsCSV / -benchmarkcompare
+        bool firstRun = true;
+        for( auto & run : runs )
+        {
+            auto logResults = run.FinishedCallback;
+            run.FinishedCallback = [logResults, &firstRun, &options]( const vaBenchmarkTool::RunDefinition & runDef, int index, int count, const std::vector<std::vector<float>> & samples, const std::vector<vaBenchmarkTool::AverageMinMax> & averages, const std::vector<vaBenchmarkTool::MetricStatistics> & statistics )
+            {
+                logResults( runDef, index, count, samples, averages, statistics );
+                vaBenchmarkTool::WriteStatisticsCSV( options.OutputCSV, !firstRun, runDef, statistics );
+                firstRun = false;
+            };
+        }
+        return runner.RunBenchmark( script, runs );
+    }
+
+    typedef std::function<bool( entt::registry & registry, const string & path )> SceneFileFunction;
+
+    struct SceneFileResult
+    {
+        int64                               FileSize            = 0;
+        double                              LoadMS              = 0.0;
+        // only with measureSaveAndPeakMemory
+        double                              SaveMS              = 0.0;
+        int64                               SavePeak            = 0;
+        int64                               LoadPeak            = 0;
+    };
+
+    // What the scene file benchmarks compare scenes by: saved with JSONSave and read back as a tree. Only scenes loaded into a
+    // fresh registry compare equal to their source - ClearAll-ed ones recycle entity IDs, which changes the order.
+    nlohmann::json SceneJSONTree( entt::registry & registry, const string & tempPath )
+    {
+        nlohmann::json tree;
+        if( Scene::JSONSave( registry, tempPath ) )
+            tree = vaSerializer::OpenReadFile( tempPath ).DOM( );
+        vaFileTools::DeleteFile( tempPath );
+        return tree;
+    }
+
+    // The scene file benchmark fixture: 'save' the source scene into 'path', run the optional 'check' on the file (it calls
+    // context.Fail itself), 'load' it into a fresh scene which has to give 'sourceTree' (SceneJSONTree of the source) back, then time
+    // ClearAll + 'load' and check the entity count. Failures are prefixed with 'name'; the file is deleted at the end.
+    SceneFileResult MeasureSceneFile( BenchmarkContext & context, const string & name, vaScene & source, const nlohmann::json & sourceTree, const string & path,
+        const SceneFileFunction & save, const SceneFileFunction & load, bool measureSaveAndPeakMemory, const std::function<void( const string & path )> & check = nullptr )
+    {
+        SceneFileResult result;
+        entt::registry & sourceRegistry = source.Registry( );
+        if( !save( sourceRegistry, path ) )
+        {
+            context.Fail( "%s: unable to save '%s'", name.c_str( ), path.c_str( ) );
+            vaFileTools::DeleteFile( path );
+            return result;
+        }
+        {
+            vaFileStream file;
+            if( file.Open( path ) )
+                result.FileSize = file.GetLength( );
+        }
+
+        if( check != nullptr )
+            check( path );
+
+        {
+            shared_ptr<vaScene> freshScene = vaScene::Create( name );
+            if( !load( freshScene->Registry( ), path ) || SceneJSONTree( freshScene->Registry( ), path + ".roundtrip" ) != sourceTree )
+                context.Fail( "%s: loading the saved file doesn't give the source scene", name.c_str( ) );
+        }
+
+        shared_ptr<vaScene> loadScene = vaScene::Create( name );
+        bool savedOK = true, loadedOK = true;
+        auto saveOnce = [&]( ) { savedOK &= save( sourceRegistry, path ); };
+        auto loadOnce = [&]( ) { loadScene->ClearAll( ); loadedOK &= load( loadScene->Registry( ), path ); };
+        if( measureSaveAndPeakMemory )
+        {
+            result.SavePeak = MeasurePeakMemory( saveOnce );
+            result.SaveMS   = context.MeasureMedian( saveOnce );
+            result.LoadPeak = MeasurePeakMemory( loadOnce );
+        }
+        result.LoadMS = context.MeasureMedian( loadOnce );
+        if( !savedOK || !loadedOK || loadScene->Registry( ).alive( ) != sourceRegistry.alive( ) )
+            context.Fail( "%s: save/load failed or entity count mismatch", name.c_str( ) );
+
+        loadScene = nullptr;
+        vaFileTools::DeleteFile( path );
+        return result;
+    }
+
+    const std::vector<std::pair<string, SceneBenchmarkScript>> & SceneBenchmarkScripts( )
+    {
+        static const std::vector<std::pair<string, SceneBenchmarkScript>> scripts = {
+            { "sweep", ScriptSweep },
+        };
+        return scripts;
+    }
+}
+
+// JSON vs binary scene files with the same content: sizes and load times; loading either has to give the same scene
+VA_BENCHMARK( SceneBinaryLoad )
+{
+    shared_ptr<vaScene> scene = vaScene::Create( "SceneBinaryLoad" );
+    CreateSyntheticScene( *scene, 32 );
+    // some UIDs too, those go into the GUID table
+    std::vector<entt::entity> entities;
+    scene->Registry( ).each( [&]( entt::entity entity ) { entities.push_back( entity ); } );
+    for( size_t i = 0; i < entities.size( ); i += 4 )
+        scene->Registry( ).ctx<Scene::UIDRegistry>( ).GetOrCreate( entities[i] );
+
+    const string directory              = vaCore::GetExecutableDirectoryNarrow( );
+    const string roundTripPath          = directory + "benchmark_scene_roundtrip.vaScene";
+    const string roundTripBinaryPath    = directory + "benchmark_scene_roundtrip.vaSceneBin";
+    const nlohmann::json sourceTree     = SceneJSONTree( scene->Registry( ), roundTripPath );
+    auto sameAsSource = [&sourceTree]( const string & path ) { return vaSerializer::OpenReadFile( path ).DOM( ) == sourceTree; };
+
+    // the file-to-file converters have to give the same content too (compared as trees since BinaryToJSON writes keys sorted
+    // and JSONSave doesn't)
+    const SceneFileResult jsonFile = MeasureSceneFile( context, "JSON", *scene, sourceTree, directory + "benchmark_scene.vaScene",
+        [ ]( entt::registry & registry, const string & path ) { return Scene::JSONSave( registry, path ); },
+        [ ]( entt::registry & registry, const string & path ) { return Scene::JSONLoad( registry, path ); }, false,
+        [&]( const string & path )
+        {
+            if( !Scene::BinaryFromJSON( path, roundTripBinaryPath ) || !Scene::BinaryToJSON( roundTripBinaryPath, roundTripPath ) || !sameAsSource( roundTripPath ) )
+                context.Fail( "JSON -> binary -> JSON conversion isn't lossless" );
+        } );
+    const SceneFileResult binaryFile = MeasureSceneFile( context, "binary", *scene, sourceTree, directory + "benchmark_scene.vaSceneBin",
+        [ ]( entt::registry & registry, const string & path ) { return Scene::BinarySave( registry, path ); },
+        [ ]( entt::registry & registry, const string & path ) { return Scene::BinaryLoad( registry, path ); }, false,
+        [&]( const string & path )
+        {
+            if( !Scene::BinaryToJSON( path, roundTripPath ) || !sameAsSource( roundTripPath ) )
+                context.Fail( "BinaryToJSON doesn't match the JSON" );
+        } );
+
+    context.Report( "%d entities; JSON %.2f MB, load %.2f ms; binary %.2f MB (%.1fx smaller), load %.2f ms (%.1fx faster)", (int)entities.size( ),
+        jsonFile.FileSize / ( 1024.0 * 1024.0 ), jsonFile.LoadMS, binaryFile.FileSize / ( 1024.0 * 1024.0 ), (double)jsonFile.FileSize / (double)std::max( (int64)1, binaryFile.FileSize ), binaryFile.LoadMS, jsonFile.LoadMS / binaryFile.LoadMS );
+    context.CheckThroughput( "Load.binary", (double)entities.size( ) / 1e3 / ( binaryFile.LoadMS / 1000.0 ), "Kentities/s" );
+
+    scene = nullptr;
+    vaFileTools::DeleteFile( roundTripPath );
+    vaFileTools::DeleteFile( roundTripBinaryPath );
+}
+
+// JSON scene save/load through the streaming vaSerializer modes vs building the whole JSON tree: time and peak memory on a
+// large scene; both have to write the same content and load the same scene
+VA_BENCHMARK( SceneJSONStreaming )
+{
+    shared_ptr<vaScene> scene = vaScene::Create( "SceneJSONStreaming" );
+    CreateSyntheticScene( *scene, 64 );
+    const size_t entityCount = scene->Registry( ).alive( );
+
+    const string directory          = vaCore::GetExecutableDirectoryNarrow( );
+    const nlohmann::json sourceTree = SceneJSONTree( scene->Registry( ), directory + "benchmark_scene_reference.vaScene" );
+    SceneFileResult results[2];
+    for( int streaming = 0; streaming < 2; streaming++ )
+    {
+        const bool stream = streaming != 0;
+        results[streaming] = MeasureSceneFile( context, ( stream ) ? ( "streaming" ) : ( "tree" ), *scene, sourceTree, directory + ( ( stream ) ? ( "benchmark_scene_streaming.vaScene" ) : ( "benchmark_scene_tree.vaScene" ) ),
+            [stream]( entt::registry & registry, const string & path ) { return Scene::JSONSave( registry, path, nullptr, stream ); },
+            [stream]( entt::registry & registry, const string & path ) { return Scene::JSONLoad( registry, path, stream ); }, true,
+            [&]( const string & path )
+            {
+                if( vaSerializer::OpenReadFile( path ).DOM( ) != sourceTree )
+                    context.Fail( "%s save has different content", ( stream ) ? ( "streaming" ) : ( "tree" ) );
+                if( !stream )
+                    return;
+                // a streaming save that doesn't go through must leave the previous file as it was, and no .tmp behind
+                vaSerializer abandoned = vaSerializer::OpenWriteStream( path, "VanillaScene" );
+                string name = "abandoned";
+                abandoned.Serialize<string>( "Name", name );
+                if( abandoned.Close( false ) || vaFileTools::FileExists( path + ".tmp" ) || vaSerializer::OpenReadFile( path ).DOM( ) != sourceTree )
+                    context.Fail( "discarded streaming save changed the target file" );
+            } );
+    }
+
+    const double megabyte = 1024.0 * 1024.0;
+    const SceneFileResult & tree = results[0], & streamed = results[1];
+    context.Report( "%d entities, %.1f MB JSON; load: tree %.1f ms, %.1f MB peak, streaming %.1f ms, %.1f MB peak; save: tree %.1f ms, %.1f MB peak, streaming %.1f ms, %.1f MB peak",
+        (int)entityCount, streamed.FileSize / megabyte, tree.LoadMS, tree.LoadPeak / megabyte, streamed.LoadMS, streamed.LoadPeak / megabyte, tree.SaveMS, tree.SavePeak / megabyte, streamed.SaveMS, streamed.SavePeak / megabyte );
+    context.CheckThroughput( "Load.streaming", (double)entityCount / 1e3 / ( streamed.LoadMS / 1000.0 ), "Kentities/s" );
+    context.CheckThroughput( "Save.streaming", (double)entityCount / 1e3 / ( streamed.SaveMS / 1000.0 ), "Kentities/s" );
+}
+
+// JSONLoad decoding on vaTF workers vs on the calling thread only, on a scene with thousands of root entities and
+// EntityReference-s pointing across them; both have to load the scene that was saved
+VA_BENCHMARK( SceneJSONParallelLoad )
+{
+    shared_ptr<vaScene> scene = vaScene::Create( "SceneJSONParallelLoad" );
+    CreateSyntheticScene( *scene, 64 );
+    std::vector<entt::entity> roots;
+    scene->Registry( ).each( [&]( entt::entity entity ) { if( Scene::GetParent( scene->Registry( ), entity ) == entt::null ) roots.push_back( entity ); } );
+    // references from one end of the root list to the other so they always cross decode ranges
+    for( size_t i = 0; i < roots.size( ); i += 16 )
+        scene->Registry( ).emplace<Scene::EmissiveMaterialDriver>( roots[i] ).ReferenceLightEntity.Set( scene->Registry( ), roots[roots.size( ) - 1 - i] );
+    const size_t entityCount = scene->Registry( ).alive( );
+
+    const string directory          = vaCore::GetExecutableDirectoryNarrow( );
+    const nlohmann::json sourceTree = SceneJSONTree( scene->Registry( ), directory + "benchmark_scene_parallel_reference.vaScene" );
+    double loadMS[2] = { };
+    for( int parallel = 0; parallel < 2; parallel++ )
+    {
+        const bool useWorkers = parallel != 0;
+        loadMS[parallel] = MeasureSceneFile( context, ( useWorkers ) ? ( "parallel" ) : ( "serial" ), *scene, sourceTree, directory + "benchmark_scene_parallel.vaScene",
+            [ ]( entt::registry & registry, const string & path ) { return Scene::JSONSave( registry, path ); },
+            [useWorkers]( entt::registry & registry, const string & path ) { return Scene::JSONLoad( registry, path, true, useWorkers ); }, false ).LoadMS;
+    }
+
+    context.Report( "%d entities, %d roots; load: serial %.1f ms, parallel %.1f ms (%.2fx on %d threads)", (int)entityCount, (int)roots.size( ),
+        loadMS[0], loadMS[1], loadMS[0] / std::max( 1e-3, loadMS[1] ), vaTF::ThreadCount( ) );
+    context.CheckThroughput( "Load.parallel", (double)entityCount / 1e3 / ( loadMS[1] / 1000.0 ), "Kentities/s" );
+}
+
+bool Vanilla::IsSceneBenchmarkRun( const std::vector<std::pair<wstring, wstring>> & cmdLineParams )
+{
+    for( const auto & param : cmdLineParams )
+        if( vaStringTools::ToLower( param.first ) == L"scenebench" )
+            return true;
+    return false;
+}
+
+int Vanilla::RunSceneBenchmark( const std::vector<std::pair<wstring, wstring>> & cmdLineParams )
+{
+    string scriptName = "sweep";
+    wstring sceneFile;
+    SceneBenchmarkOptions options;
+    options.OutputCSV = vaCore::GetExecutableDirectory( ) + L"scene_benchmark.csv";
+    for( const auto & param : cmdLineParams )
+    {
+        const wstring name = vaStringTools::ToLower( param.first );
+        if( name == L"scenebench" && param.second != L"" )
+            scriptName = vaStringTools::SimpleNarrow( vaStringTools::ToLower( param.second ) );
+        else if( name == L"scenebenchscene" )
+            sceneFile = vaFileTools::GetAbsolutePath( param.second );
+        else if( name == L"scenebenchout" && param.second != L"" )
+            options.OutputCSV = vaFileTools::GetAbsolutePath( param.second );
+        else if( name == L"scenebenchframes" )
+            options.SampleFrames = std::max( 1, (int)vaStringTools::StringToFloat( param.second.c_str( ) ) );
+    }
+
+    const auto & scripts = SceneBenchmarkScripts( );
+    auto script = std::find_if( scripts.begin( ), scripts.end( ), [&]( const auto & item ) { return item.first == scriptName; } );
+    if( script == scripts.end( ) )
+    {
+        VA_LOG_ERROR( "Scene benchmark: unknown script '%s'", scriptName.c_str( ) );
+        return -1;
+    }
+
+    shared_ptr<vaScene> scene = vaScene::Create( "HeadlessBenchmark" );
+    if( sceneFile != L"" )
+    {
+        // only what doesn't need a render device will work - render meshes never get bounds for ex.
+        if( !scene->LoadJSON( vaStringTools::SimpleNarrow( sceneFile ) ) )
+        {
+            VA_LOG_ERROR( L"Scene benchmark: unable to load '%s'", sceneFile.c_str( ) );
+            return -1;
+        }
+    }
+    else
+        CreateSyntheticScene( *scene, 64 );
+
+    auto aliveToken = std::make_shared<int>( 0 );
+    scene->RegisterSimpleScript( "HeadlessSpin", aliveToken, [ ]( vaScene & tickingScene, const string &, entt::entity entity, Scene::SimpleScript &, float, int64 )
+    {
+        Scene::TransformLocal & local = tickingScene.Registry( ).get<Scene::TransformLocal>( entity );
+        local = vaMatrix4x4::RotationZ( 0.5f * (float)tickingScene.GetTime( ) ) * vaMatrix4x4::Translation( local.GetTranslation( ) );
+        tickingScene.SetTransformDirtyRecursive( entity );
+    } );
+
+    bool success;
+    {
+        vaSceneHeadlessRunner runner( scene );
+        // generous limit: all runs with warmups plus some slack for the script's own frames
+        const int64 maxFrames = 8 * (int64)( options.SampleFrames + options.WarmupFrames + 2 ) + 1000;
+        bool scriptResult = false;
+        success = runner.Run( [&]( vaMiniScriptInterface & scriptInterface, vaSceneHeadlessRunner & scriptRunner ) { scriptResult = script->second( scriptInterface, scriptRunner, options ); }, maxFrames );
+        success &= scriptResult;
+    }
+    scene = nullptr;
+
+    if( success )
+        VA_LOG_SUCCESS( L"Scene benchmark '%s' done, results in '%s'", vaStringTools::SimpleWiden( scriptName ).c_str( ), options.OutputCSV.c_str( ) );
+    else
+        VA_LOG_ERROR( "Scene benchmark '%s' failed", scriptName.c_str( ) );
+    return ( success ) ? ( 0 ) : ( 1 );
+}
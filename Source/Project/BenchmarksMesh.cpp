@@ -0,0 +1,309 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation 
+// 
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmarks.h"
+
+#include "Core/System/vaMemoryStream.h"
+#include "Core/System/vaCompressionStream.h"
+
+#include "Rendering/vaStandardShapes.h"
+#include "Rendering/vaRenderMeshLODBuilder.h"
+#include "Rendering/vaRenderMeshOptimizer.h"
+
+#include "IntegratedExternals/vaMeshoptimizerIntegration.h"
+
+using namespace Vanilla;
+
+namespace
+{
+    // shareVertices icosphere: 10 * 4^level + 2 vertices, 20 * 4^level triangles
+    size_t SphereVertexCount( int tessellationLevel )       { return (size_t)10 * ( (size_t)1 << ( 2 * tessellationLevel ) ) + 2; }
+
+    // triangle soup (non shared vertices) sphere welded back with or without vaVertexWeldIndex
+    void WeldSoup( const std::vector<vaVector3> & soup, std::vector<vaVector3> & outVertices, std::vector<uint32> & outIndices, bool useWeldIndex )
+    {
+        outVertices.clear( );
+        outIndices.clear( );
+        vaVertexWeldIndex weldIndex( 0.0f, ( useWeldIndex ) ? ( soup.size( ) / 3 ) : ( 0 ) );
+        for( size_t i = 0; i < soup.size( ); i += 3 )
+        {
+            if( useWeldIndex )
+                vaTriangleMeshTools::AddTriangle_MergeSamePositionVertices( outVertices, outIndices, soup[i + 0], soup[i + 1], soup[i + 2], weldIndex );
+            else
+                vaTriangleMeshTools::AddTriangle_MergeSamePositionVertices( outVertices, outIndices, soup[i + 0], soup[i + 1], soup[i + 2] );
+        }
+    }
+
+    // shared vertex icosphere with a smooth, seed dependent, bumpy surface so that simplification has something to preserve
+    vaRenderMeshLODBuilder::Mesh CreateBumpySphere( int tessellationLevel, int seed )
+    {
+        std::vector<vaVector3>  positions;
+        std::vector<uint32>     indices;
+        vaStandardShapes::CreateSphere( positions, indices, tessellationLevel, true );
+
+        const float phase = (float)seed;
+        vaRenderMeshLODBuilder::Mesh mesh;
+        mesh.FrontFaceWinding = vaWindingOrder::Clockwise;
+        mesh.Indices = indices;
+        for( const vaVector3 & position : positions )
+        {
+            const float radius = 1.0f + 0.1f * std::sinf( 3.0f * position.x + phase ) * std::sinf( 4.0f * position.y ) * std::sinf( 2.0f * position.z + 1.0f );
+            mesh.Vertices.push_back( vaRenderMesh::StandardVertex( position * radius, vaVector4( position, 0.0f ), 0xFF808080 ) );
+        }
+        return mesh;
+    }
+}
+
+// Vertex welding: vaStandardShapes::CreateSphere with shared vertices at high tessellation, welding a triangle soup with the 
+// linear FindOrAdd search vs vaVertexWeldIndex, and MergeNormalsForEqualPositions on a soup
+VA_BENCHMARK( VertexWelding )
+{
+    std::vector<vaVector3>  vertices;
+    std::vector<uint32>     indices;
+
+    {
+        const int level = 8;
+        const double ms = context.MeasureMedian( [ & ]( ) { vaStandardShapes::CreateSphere( vertices, indices, level, true ); } );
+        if( vertices.size( ) != SphereVertexCount( level ) )
+            context.Fail( "CreateSphere level %d: %zu vertices, expected %zu", level, vertices.size( ), SphereVertexCount( level ) );
+        const double mtris = (double)( indices.size( ) / 3 ) / 1e6;
+        context.Report( "CreateSphere level %d shared: %zu vertices, %zu triangles, %.2f ms", level, vertices.size( ), indices.size( ) / 3, ms );
+        context.CheckThroughput( vaStringTools::Format( "CreateSphere.Level%d", level ), mtris / ( ms / 1000.0 ), "Mtris/s" );
+    }
+
+    {
+        std::vector<vaVector3>  soup;
+        std::vector<uint32>     soupIndices;
+        for( int level : { 4, 8 } )
+        {
+            vaStandardShapes::CreateSphere( soup, soupIndices, level, false );
+            const double indexMS = context.MeasureMedian( [ & ]( ) { WeldSoup( soup, vertices, indices, true ); } );
+            if( vertices.size( ) != SphereVertexCount( level ) || indices.size( ) != soup.size( ) )
+                context.Fail( "weld level %d: %zu vertices, expected %zu", level, vertices.size( ), SphereVertexCount( level ) );
+            const double mverts = (double)soup.size( ) / 1e6;
+
+            // linear search is O(n^2) - only feasible at low tessellation
+            if( level <= 4 )
+            {
+                std::vector<uint32> weldIndices = indices;
+                const double linearMS = context.MeasureMedian( [ & ]( ) { WeldSoup( soup, vertices, indices, false ); } );
+                if( indices != weldIndices )
+                    context.Fail( "weld level %d: vaVertexWeldIndex and linear search results differ", level );
+                context.Report( "weld level %d (%zu soup vertices): linear %.2f ms, vaVertexWeldIndex %.2f ms (%.1fx)", level, soup.size( ), linearMS, indexMS, linearMS / indexMS );
+            }
+            else
+                context.Report( "weld level %d (%zu soup vertices): vaVertexWeldIndex %.2f ms", level, soup.size( ), indexMS );
+            context.CheckThroughput( vaStringTools::Format( "Weld.Level%d", level ), mverts / ( indexMS / 1000.0 ), "Mverts/s" );
+        }
+    }
+
+    // face normals of a triangle soup sphere merged back into smooth ones must point outwards
+    {
+        const int level = 6;
+        vaStandardShapes::CreateSphere( vertices, indices, level, false );
+        std::vector<vaVector3> faceNormals( vertices.size( ) );
+        vaTriangleMeshTools::GenerateNormals( faceNormals, vertices, indices, vaWindingOrder::Clockwise );
+        std::vector<vaVector3> normals;
+        const double ms = context.MeasureMedian( [ & ]( ) { normals = faceNormals; vaTriangleMeshTools::MergeNormalsForEqualPositions( normals, vertices ); } );
+        float worstDot = 1.0f;
+        for( size_t i = 0; i < vertices.size( ); i++ )
+            worstDot = std::min( worstDot, vaVector3::Dot( normals[i], vertices[i].Normalized( ) ) );
+        if( worstDot < 0.999f )
+            context.Fail( "MergeNormalsForEqualPositions level %d: worst normal vs position dot %.5f", level, worstDot );
+        context.Report( "MergeNormalsForEqualPositions level %d (%zu vertices): %.2f ms, worst normal dot %.5f", level, vertices.size( ), ms, worstDot );
+        context.CheckThroughput( vaStringTools::Format( "MergeNormals.Level%d", level ), (double)vertices.size( ) / 1e6 / ( ms / 1000.0 ), "Mverts/s" );
+    }
+}
+
+// vaRenderMeshLODBuilder: LOD chains for a batch of meshes built one by one on the calling thread vs concurrently on the task 
+// system; both must produce identical results
+VA_BENCHMARK( LODBuilder )
+{
+    std::vector<vaRenderMeshLODBuilder::Mesh> sourceMeshes;
+    for( int i = 0; i < 48; i++ )
+        sourceMeshes.push_back( CreateBumpySphere( 4 + i % 3, i ) );
+
+    vaRenderMeshLODBuilder::Settings settings;
+
+    std::vector<vaRenderMeshLODBuilder::Mesh> serialMeshes;
+    const double serialMS = context.MeasureMedian( [ & ]( )
+    {
+        serialMeshes = sourceMeshes;
+        for( vaRenderMeshLODBuilder::Mesh & mesh : serialMeshes )
+            vaRenderMeshLODBuilder::Build( mesh, settings );
+    } );
+
+    std::vector<vaRenderMeshLODBuilder::Mesh> batchMeshes;
+    vaRenderMeshLODBuilder::Stats stats;
+    const double batchMS = context.MeasureMedian( [ & ]( )
+    {
+        batchMeshes = sourceMeshes;
+        stats = vaRenderMeshLODBuilder::Build( batchMeshes, settings );
+    } );
+
+    for( size_t i = 0; i < sourceMeshes.size( ); i++ )
+    {
+        const vaRenderMeshLODBuilder::Mesh & serial = serialMeshes[i];
+        const vaRenderMeshLODBuilder::Mesh & batch  = batchMeshes[i];
+        if( serial.LODParts.size( ) < 2 )
+            context.Fail( "mesh %zu: no LODs generated", i );
+        if( serial.Indices != batch.Indices || serial.Vertices.size( ) != batch.Vertices.size( ) || serial.LODParts.size( ) != batch.LODParts.size( ) 
+            || !std::equal( serial.Vertices.begin( ), serial.Vertices.end( ), batch.Vertices.begin( ) ) )
+        {
+            context.Fail( "mesh %zu: serial and batch results differ", i );
+            break;
+        }
+        // every LOD must only reference its own vertices
+        for( size_t lod = 1; lod < serial.LODParts.size( ); lod++ )
+        {
+            const vaRenderMeshLODBuilder::LODPart & part = serial.LODParts[lod];
+            const uint32 firstVertex = *std::min_element( serial.Indices.begin( ) + part.IndexStart, serial.Indices.begin( ) + part.IndexStart + part.IndexCount );
+            const uint32 prevLastIndex = *std::max_element( serial.Indices.begin( ) + serial.LODParts[lod - 1].IndexStart, serial.Indices.begin( ) + part.IndexStart );
+            if( firstVertex <= prevLastIndex )
+                context.Fail( "mesh %zu LOD %zu: references vertices of the previous LOD", i, lod );
+        }
+    }
+
+    const double inputMTris = (double)stats.InputTriangles / 1e6;
+    context.Report( "%d meshes, %lld triangles -> %d LODs, %lld triangles: serial %.2f ms, batch %.2f ms (%.2fx)", stats.MeshCount, 
+        stats.InputTriangles, stats.LODCount, stats.OutputTriangles, serialMS, batchMS, serialMS / batchMS );
+    context.CheckThroughput( "Serial", inputMTris / ( serialMS / 1000.0 ), "Mtris/s" );
+    context.CheckThroughput( "Batch", inputMTris / ( batchMS / 1000.0 ), "Mtris/s" );
+}
+
+// vaRenderMeshOptimizer on LOD chains with shuffled triangle order (the worst case for authoring order); checks that ACMR/ATVR 
+// and overfetch improve and that LOD parts still reference only their own vertices
+VA_BENCHMARK( MeshOptimizer )
+{
+    std::vector<vaRenderMeshLODBuilder::Mesh> sourceMeshes;
+    vaRandom random( 0 );
+    for( int i = 0; i < 32; i++ )
+    {
+        vaRenderMeshLODBuilder::Mesh mesh = CreateBumpySphere( 4 + i % 3, i );
+        vaRenderMeshLODBuilder::Build( mesh, vaRenderMeshLODBuilder::Settings( ) );
+        for( const vaRenderMeshLODBuilder::LODPart & part : mesh.LODParts )
+        {
+            for( int tri = part.IndexCount / 3 - 1; tri > 0; tri-- )
+            {
+                const int other = (int)( random.NextUINT32( ) % (uint32)( tri + 1 ) );
+                for( int k = 0; k < 3; k++ )
+                    std::swap( mesh.Indices[part.IndexStart + tri * 3 + k], mesh.Indices[part.IndexStart + other * 3 + k] );
+            }
+        }
+        sourceMeshes.push_back( std::move( mesh ) );
+    }
+
+    std::vector<vaRenderMeshLODBuilder::Mesh> meshes;
+    vaRenderMeshOptimizer::Stats stats;
+    const double ms = context.MeasureMedian( [ & ]( )
+    {
+        meshes = sourceMeshes;
+        stats = vaRenderMeshOptimizer::Optimize( meshes, vaRenderMeshOptimizer::Settings( ) );
+    } );
+
+    if( stats.After.Triangles != stats.Before.Triangles )
+        context.Fail( "triangle count changed from %lld to %lld", stats.Before.Triangles, stats.After.Triangles );
+    if( stats.After.ACMR( ) >= stats.Before.ACMR( ) || stats.After.ATVR( ) >= stats.Before.ATVR( ) || stats.After.Overfetch( ) > stats.Before.Overfetch( ) )
+        context.Fail( "no improvement: %s", stats.ToString( ).c_str( ) );
+    for( size_t i = 0; i < meshes.size( ); i++ )
+    {
+        const vaRenderMeshLODBuilder::Mesh & mesh = meshes[i];
+        uint32 prevLastVertex = 0;
+        for( size_t lod = 0; lod < mesh.LODParts.size( ); lod++ )
+        {
+            const vaRenderMeshLODBuilder::LODPart & part = mesh.LODParts[lod];
+            const auto range = std::minmax_element( mesh.Indices.begin( ) + part.IndexStart, mesh.Indices.begin( ) + part.IndexStart + part.IndexCount );
+            if( lod > 0 && *range.first <= prevLastVertex )
+                context.Fail( "mesh %zu LOD %zu: references vertices of the previous LOD", i, lod );
+            prevLastVertex = *range.second;
+        }
+        if( (size_t)prevLastVertex + 1 != mesh.Vertices.size( ) )
+            context.Fail( "mesh %zu: %zu vertices but only %u referenced", i, mesh.Vertices.size( ), prevLastVertex + 1 );
+    }
+
+    context.Report( "%s", stats.ToString( ).c_str( ) );
+    context.CheckThroughput( "Optimize", (double)stats.Before.Triangles / 1e6 / ( ms / 1000.0 ), "Mtris/s" );
+}
+
+// APACK mesh geometry storage: raw vectors (file version 4) vs meshopt codec encoded (version 5), with and without quantized
+// attributes, all behind the same whole-file compression that vaAssetPack::SaveAPACK uses; reports size and load (inflate +
+// decode) time over a sample pack of LOD-ed and optimized meshes
+VA_BENCHMARK( MeshStorage )
+{
+    std::vector<vaRenderMeshLODBuilder::Mesh> meshes;
+    int64 triangleCount = 0;
+    for( int i = 0; i < 32; i++ )
+    {
+        vaRenderMeshLODBuilder::Mesh mesh = CreateBumpySphere( 4 + i % 3, i );
+        for( vaRenderMesh::StandardVertex & vertex : mesh.Vertices )
+            vertex.TexCoord0 = vaVector2( vertex.Position.x * 0.5f + 0.5f, vertex.Position.y * 0.5f + 0.5f );
+        vaRenderMeshLODBuilder::Build( mesh, vaRenderMeshLODBuilder::Settings( ) );
+        vaRenderMeshOptimizer::Optimize( mesh, vaRenderMeshOptimizer::Settings( ) );
+        triangleCount += (int64)mesh.Indices.size( ) / 3;
+        meshes.push_back( std::move( mesh ) );
+    }
+
+    enum class Format { Raw, Encoded, EncodedQuantized };
+    const char * formatNames[] = { "raw", "encoded", "encoded+quantized" };
+
+    int64 rawSize = 0;
+    double rawLoadMS = 0.0;
+    for( Format format : { Format::Raw, Format::Encoded, Format::EncodedQuantized } )
+    {
+        vaMemoryStream packed( (int64)0, 1024 * 1024 );
+        {
+            vaMemoryStream inner( (int64)0, 1024 * 1024 );
+            for( const vaRenderMeshLODBuilder::Mesh & mesh : meshes )
+            {
+                if( format == Format::Raw )
+                {
+                    inner.WriteValueVector<uint32>( mesh.Indices );
+                    inner.WriteValueVector<vaRenderMesh::StandardVertex>( mesh.Vertices );
+                }
+                else
+                    vaRenderMesh::SaveGeometryAPACK( inner, mesh.Vertices, mesh.Indices, format == Format::EncodedQuantized );
+            }
+            vaCompressionStream compressor( false, &packed );
+            compressor.Write( inner.GetBuffer( ), inner.GetPosition( ) );
+        }
+        const int64 packedSize = packed.GetPosition( );
+
+        bool loadedOK = true;
+        const double loadMS = context.MeasureMedian( [ & ]( )
+        {
+            vaMemoryStream source( packed.GetBuffer( ), packedSize );
+            vaCompressionStream decompressor( true, &source );
+            for( const vaRenderMeshLODBuilder::Mesh & mesh : meshes )
+            {
+                std::vector<vaRenderMesh::StandardVertex> vertices;
+                std::vector<uint32> indices;
+                if( format == Format::Raw )
+                    loadedOK &= decompressor.ReadValueVector<uint32>( indices ) && decompressor.ReadValueVector<vaRenderMesh::StandardVertex>( vertices );
+                else
+                    loadedOK &= vaRenderMesh::LoadGeometryAPACK( decompressor, vertices, indices );
+                loadedOK &= vertices.size( ) == mesh.Vertices.size( ) && indices.size( ) == mesh.Indices.size( );
+                // lossless formats must round-trip positions exactly (the index codec may rotate triangles, so not compared here)
+                if( loadedOK && format != Format::EncodedQuantized )
+                    loadedOK &= std::equal( vertices.begin( ), vertices.end( ), mesh.Vertices.begin( ) );
+            }
+        } );
+        if( !loadedOK )
+            context.Fail( "%s: load failed or data mismatch", formatNames[(int)format] );
+
+        if( format == Format::Raw )
+        {
+            rawSize     = packedSize;
+            rawLoadMS   = loadMS;
+        }
+        context.Report( "%-18s %8.2f MB, %.2fx smaller than raw; load %7.2f ms, %.2fx faster than raw", formatNames[(int)format], 
+            (double)packedSize / ( 1024.0 * 1024.0 ), (double)rawSize / (double)packedSize, loadMS, rawLoadMS / loadMS );
+        context.CheckThroughput( vaStringTools::Format( "Load.%s", formatNames[(int)format] ), (double)triangleCount / 1e6 / ( loadMS / 1000.0 ), "Mtris/s" );
+    }
+}
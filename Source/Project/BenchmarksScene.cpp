@@ -0,0 +1,462 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation 
+// 
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmarks.h"
+
+#include "Rendering/vaFrustumCulling.h"
+#include "Rendering/vaRenderInstanceList.h"
+
+#include "Core/Misc/vaRadixSort.h"
+
+#include "Scene/vaSceneSystems.h"
+#include "Scene/vaSceneTransformHierarchy.h"
+
+#ifdef VA_TASKFLOW_INTEGRATION_ENABLED
+#include "IntegratedExternals/vaTaskflowIntegration.h"
+#endif
+
+using namespace Vanilla;
+
+namespace
+{
+    const uint32 c_cullingInstanceCount = 1 << 20;
+
+    typedef vaCullingBoundsStorage<c_cullingInstanceCount> CullingBounds;
+
+    // instances scattered through a 2km cube, sizes from pebbles to houses, boxes a bit flatter than their spheres
+    void CreateRandomInstances( std::vector<vaBoundingSphere> & outSpheres, std::vector<vaBoundingBox> & outBoxes, int seed )
+    {
+        vaRandom random( seed );
+        outSpheres.resize( c_cullingInstanceCount );
+        outBoxes.resize( c_cullingInstanceCount );
+        for( uint32 i = 0; i < c_cullingInstanceCount; i++ )
+        {
+            const vaVector3 center( random.NextFloatRange( -1000.0f, 1000.0f ), random.NextFloatRange( -1000.0f, 1000.0f ), random.NextFloatRange( -50.0f, 50.0f ) );
+            const vaVector3 halfSize = vaVector3( 1.0f, 1.0f, 0.5f ) * random.NextFloatRange( 0.1f, 10.0f );
+            outBoxes[i]     = vaBoundingBox( center - halfSize, halfSize * 2.0f );
+            outSpheres[i]   = vaBoundingSphere( center, halfSize.Length( ) );
+        }
+    }
+
+    void CalculateCameraFrustum( vaPlane outPlanes[6], const vaVector3 & position, const vaVector3 & direction )
+    {
+        const vaMatrix4x4 view = vaMatrix4x4::LookAtLH( position, position + direction, vaVector3( 0.0f, 0.0f, 1.0f ) );
+        const vaMatrix4x4 proj = vaMatrix4x4::PerspectiveFovLH( 60.0f / 180.0f * VA_PIf, 16.0f / 9.0f, 0.1f, 1000.0f );
+        vaGeometry::CalculateFrustumPlanes( outPlanes, view * proj );
+    }
+
+    // the same instances as seen by vaSceneRenderer::ProcessInstanceBatch - a window of c_cullingBatchSize items
+    const uint32 c_cullingBatchSize = 512;
+    vaCullingBoundsSoA BatchBounds( const vaCullingBoundsSoA & all, uint32 start )
+    {
+        vaCullingBoundsSoA ret;
+        ret.SphereX     = all.SphereX + start;      ret.SphereY     = all.SphereY + start;      ret.SphereZ     = all.SphereZ + start;
+        ret.SphereRadius= all.SphereRadius + start;
+        ret.BoxX        = all.BoxX + start;         ret.BoxY        = all.BoxY + start;         ret.BoxZ        = all.BoxZ + start;
+        ret.BoxHalfX    = all.BoxHalfX + start;     ret.BoxHalfY    = all.BoxHalfY + start;     ret.BoxHalfZ    = all.BoxHalfZ + start;
+        ret.Count       = std::min( c_cullingBatchSize, all.Count - start );
+        return ret;
+    }
+}
+
+// vaFrustumCulling::Cull (SIMD, SoA) vs per-instance vaBoundingSphere::IntersectFrustum and the scalar SoA reference, on 1M
+// instances from a few camera directions; also checks that SIMD and scalar results are identical
+VA_BENCHMARK( FrustumCulling )
+{
+    std::vector<vaBoundingSphere>   spheres;
+    std::vector<vaBoundingBox>      boxes;
+    CreateRandomInstances( spheres, boxes, 0 );
+
+    auto bounds = std::make_unique<CullingBounds>( );
+    for( uint32 i = 0; i < c_cullingInstanceCount; i++ )
+        bounds->Append( spheres[i], boxes[i] );
+    const vaCullingBoundsSoA soa = bounds->SoA( );
+
+    std::vector<uint32> visibleSIMD( c_cullingInstanceCount );
+    std::vector<uint32> visibleScalar( c_cullingInstanceCount );
+
+    const vaVector3 directions[] = { { 1.0f, 0.0f, 0.0f }, { 0.6f, 0.8f, -0.1f }, { 0.0f, 0.0f, -1.0f } };
+    double timeAoS = 0, timeScalar = 0, timeSpheres = 0, timeSpheresAndBoxes = 0;
+    for( const vaVector3 & direction : directions )
+    {
+        vaPlane planes[6];
+        CalculateCameraFrustum( planes, vaVector3( -200.0f, 0.0f, 20.0f ), direction.Normalized( ) );
+
+        uint32 countAoS = 0;
+        timeAoS += context.MeasureMedian( [ & ]( )
+        {
+            countAoS = 0;
+            for( const vaBoundingSphere & sphere : spheres )
+                countAoS += ( sphere.IntersectFrustum( planes, 6 ) != vaIntersectType::Outside ) ? ( 1 ) : ( 0 );
+        } );
+
+        for( bool testBoxes : { false, true } )
+        {
+            uint32 countScalar = 0, countSIMD = 0;
+            timeScalar += context.MeasureMedian( [ & ]( ) { countScalar = vaFrustumCulling::CullReference( soa, planes, 6, testBoxes, visibleScalar.data( ) ); } );
+            const double timeSIMD = context.MeasureMedian( [ & ]( ) { countSIMD = vaFrustumCulling::Cull( soa, planes, 6, testBoxes, visibleSIMD.data( ) ); } );
+            ( ( testBoxes ) ? ( timeSpheresAndBoxes ) : ( timeSpheres ) ) += timeSIMD;
+
+            if( countSIMD != countScalar || !std::equal( visibleSIMD.begin( ), visibleSIMD.begin( ) + countSIMD, visibleScalar.begin( ) ) )
+                context.Fail( "SIMD and scalar culling results differ (%u vs %u visible, boxes %s)", countSIMD, countScalar, ( testBoxes ) ? ( "on" ) : ( "off" ) );
+            else if( !testBoxes && countSIMD != countAoS )
+                context.Fail( "sphere culling differs from vaBoundingSphere::IntersectFrustum (%u vs %u visible)", countSIMD, countAoS );
+            else
+                context.Report( "direction (%.1f, %.1f, %.1f), boxes %-3s: %7u of %u visible", direction.x, direction.y, direction.z, ( testBoxes ) ? ( "on" ) : ( "off" ), countSIMD, c_cullingInstanceCount );
+        }
+    }
+
+    const double totalMInstances = (double)c_cullingInstanceCount * countof( directions ) / 1e6;
+    timeScalar /= 2;
+    context.Report( "IntersectFrustum (AoS) %8.2f Minstances/s", totalMInstances / ( timeAoS / 1000.0 ) );
+    context.Report( "scalar SoA reference   %8.2f Minstances/s (average of spheres and spheres+boxes)", totalMInstances / ( timeScalar / 1000.0 ) );
+    context.Report( "SIMD spheres           %8.2f Minstances/s (%.2fx vs AoS)", totalMInstances / ( timeSpheres / 1000.0 ), timeAoS / timeSpheres );
+    context.Report( "SIMD spheres+boxes     %8.2f Minstances/s", totalMInstances / ( timeSpheresAndBoxes / 1000.0 ) );
+    context.CheckThroughput( "spheres", totalMInstances / ( timeSpheres / 1000.0 ), "Minstances/s" );
+    context.CheckThroughput( "spheresAndBoxes", totalMInstances / ( timeSpheresAndBoxes / 1000.0 ), "Minstances/s" );
+}
+
+// One camera plus a sweep of point light shadow cubes, culled batch by batch the way the renderer does it: a vaFrustumCulling::Cull
+// per view per batch vs one vaFrustumCulling::CullMultiView per batch followed by an ExtractVisible per view; checks that every
+// view ends up with the same instances either way
+VA_BENCHMARK( MultiViewCulling )
+{
+    std::vector<vaBoundingSphere>   spheres;
+    std::vector<vaBoundingBox>      boxes;
+    CreateRandomInstances( spheres, boxes, 1 );
+
+    auto bounds = std::make_unique<CullingBounds>( );
+    for( uint32 i = 0; i < c_cullingInstanceCount; i++ )
+        bounds->Append( spheres[i], boxes[i] );
+    const vaCullingBoundsSoA soa = bounds->SoA( );
+
+    const int lightCounts[] = { 1, 4, 16, 32, vaFrustumCulling::c_MaxViews - 1 };
+    vaRandom random( 1 );
+    std::vector<vaRenderInstanceList::FilterSettings> views;
+    views.resize( 1 );
+    views[0].FrustumPlanes.resize( 6 );
+    CalculateCameraFrustum( views[0].FrustumPlanes.data( ), vaVector3( -200.0f, 0.0f, 20.0f ), vaVector3( 1.0f, 0.2f, -0.1f ).Normalized( ) );
+    while( (int)views.size( ) < lightCounts[countof( lightCounts ) - 1] + 1 )
+    {
+        const vaVector3 lightCenter( random.NextFloatRange( -800.0f, 800.0f ), random.NextFloatRange( -800.0f, 800.0f ), random.NextFloatRange( 0.0f, 30.0f ) );
+        views.push_back( vaRenderInstanceList::FilterSettings::CubeCull( lightCenter, random.NextFloatRange( 10.0f, 60.0f ) ) );
+    }
+
+    // per view: visible count and a sum of visible indices - enough to catch any difference in practice
+    std::vector<uint64> resultsPerView( views.size( ) * 2 ), resultsMultiView( views.size( ) * 2 );
+    std::vector<uint64> viewMasks( c_cullingBatchSize );
+    std::vector<uint32> visible( c_cullingBatchSize );
+    for( int lightCount : lightCounts )
+    {
+        const int viewCount = lightCount + 1;
+
+        auto viewSet = std::make_unique<vaCullingViewSet>( );
+        for( int v = 0; v < viewCount; v++ )
+            viewSet->AddView( views[v].FrustumPlanes.data( ), (int)views[v].FrustumPlanes.size( ) );
+
+        const double perViewMS = context.MeasureMedian( [ & ]( )
+        {
+            std::fill( resultsPerView.begin( ), resultsPerView.end( ), 0 );
+            for( uint32 start = 0; start < c_cullingInstanceCount; start += c_cullingBatchSize )
+            {
+                const vaCullingBoundsSoA batch = BatchBounds( soa, start );
+                for( int v = 0; v < viewCount; v++ )
+                {
+                    const uint32 count = vaFrustumCulling::Cull( batch, views[v].FrustumPlanes.data( ), (int)views[v].FrustumPlanes.size( ), true, visible.data( ) );
+                    resultsPerView[v * 2 + 0] += count;
+                    for( uint32 i = 0; i < count; i++ )
+                        resultsPerView[v * 2 + 1] += start + visible[i];
+                }
+            }
+        } );
+        const double multiViewMS = context.MeasureMedian( [ & ]( )
+        {
+            std::fill( resultsMultiView.begin( ), resultsMultiView.end( ), 0 );
+            for( uint32 start = 0; start < c_cullingInstanceCount; start += c_cullingBatchSize )
+            {
+                const vaCullingBoundsSoA batch = BatchBounds( soa, start );
+                vaFrustumCulling::CullMultiView( batch, *viewSet, true, viewMasks.data( ) );
+                for( int v = 0; v < viewCount; v++ )
+                {
+                    const uint32 count = vaFrustumCulling::ExtractVisible( viewMasks.data( ), batch.Count, v, visible.data( ) );
+                    resultsMultiView[v * 2 + 0] += count;
+                    for( uint32 i = 0; i < count; i++ )
+                        resultsMultiView[v * 2 + 1] += start + visible[i];
+                }
+            }
+        } );
+
+        uint64 totalVisible = 0;
+        for( int v = 0; v < viewCount; v++ )
+        {
+            totalVisible += resultsMultiView[v * 2 + 0];
+            if( resultsPerView[v * 2 + 0] != resultsMultiView[v * 2 + 0] || resultsPerView[v * 2 + 1] != resultsMultiView[v * 2 + 1] )
+                context.Fail( "%d lights: view %d has %llu visible with per-view culling, %llu with multi-view culling (or different instances)", lightCount, v, resultsPerView[v * 2 + 0], resultsMultiView[v * 2 + 0] );
+        }
+
+        const double totalMInstanceViews = (double)c_cullingInstanceCount * viewCount / 1e6;
+        context.Report( "%2d lights: per-view %7.2f ms, multi-view %7.2f ms (%.2fx), %llu instance-view pairs visible", lightCount, perViewMS, multiViewMS, perViewMS / multiViewMS, totalVisible );
+        context.CheckThroughput( vaStringTools::Format( "multiView.%dLights", lightCount ), totalMInstanceViews / ( multiViewMS / 1000.0 ), "Minstance-views/s" );
+    }
+}
+
+// vaRenderInstanceList sorting: the old (sort group, distance) pair comparator sort vs the packed-key radix sort, serial and split
+// into chunks the way vaRenderInstanceListSorterInstance does it, keys from vaRenderInstanceList::MakeSortKey; the two must produce
+// the same order (the synthetic data has no distance ties within a sort group, so the comparator order is unambiguous)
+VA_BENCHMARK( RenderListSort )
+{
+    for( uint32 count : { 10000u, 100000u, 1000000u } )
+    {
+        // ~2% decals with a few different sort orders, everything else in group 0; distinct distances
+        vaRandom random( (int)count );
+        std::vector<pair<int, float>> sortDistances( count );
+        std::vector<int> materials( count );
+        std::vector<uint64> keys( count );
+        std::vector<uint64> materialKeys( count );
+        const vaRenderInstanceList::SortSettings distanceSettings = vaRenderInstanceList::SortSettings::Standard( vaVector3( 0, 0, 0 ), true, false );
+        const vaRenderInstanceList::SortSettings materialSettings = vaRenderInstanceList::SortSettings::Standard( vaVector3( 0, 0, 0 ), false, true );
+        for( uint32 i = 0; i < count; i++ )
+        {
+            const bool isDecal      = random.NextIntRange( 50 ) == 0;
+            const int decalOrder    = random.NextIntRange( 8 ) - 4;
+            const float distance    = 0.5f + (float)( ( (uint64)i * 2654435761u ) % count ) * 0.01f;
+            sortDistances[i]        = { ( isDecal ) ? ( decalOrder + 100000 ) : ( 0 ), distance };
+            materials[i]            = random.NextIntRange( 1000 );
+            keys[i]                 = vaRenderInstanceList::MakeSortKey( isDecal, decalOrder, distance, materials[i], distanceSettings );
+            materialKeys[i]         = vaRenderInstanceList::MakeSortKey( isDecal, decalOrder, distance, materials[i], materialSettings );
+        }
+
+        // material-first keys (back to front here, as for a blended pass): non-decals by material then distance, decals still 
+        // strictly by distance within their sort order group
+        {
+            std::vector<int> order( count );
+            for( uint32 i = 0; i < count; i++ )
+                order[i] = i;
+            std::stable_sort( order.begin( ), order.end( ), [ & ]( int ia, int ib ) { return materialKeys[ia] < materialKeys[ib]; } );
+            for( uint32 i = 1; i < count; i++ )
+            {
+                const int a = order[i - 1], b = order[i];
+                bool inOrder = sortDistances[a].first <= sortDistances[b].first;
+                if( inOrder && sortDistances[a].first == sortDistances[b].first )
+                {
+                    if( sortDistances[a].first == 0 && materials[a] != materials[b] )
+                        inOrder = materials[a] < materials[b];
+                    else
+                        inOrder = sortDistances[a].second > sortDistances[b].second;
+                }
+                if( !inOrder )
+                {
+                    context.Fail( "%u items: SortByMaterial key order wrong at %u", count, i );
+                    break;
+                }
+            }
+        }
+
+        std::vector<int> comparatorIndices( count );
+        const double comparatorMS = context.MeasureMedian( [ & ]( )
+        {
+            for( uint32 i = 0; i < count; i++ )
+                comparatorIndices[i] = i;
+            std::sort( comparatorIndices.begin( ), comparatorIndices.end( ), [ & ]( int ia, int ib ) 
+            { 
+                if( sortDistances[ia].first != sortDistances[ib].first )
+                    return sortDistances[ia].first < sortDistances[ib].first;
+                return sortDistances[ia].second < sortDistances[ib].second;
+            } );
+        } );
+
+        vaRadixSort radixSort;
+        auto fill = [ & ]( int chunkCount )
+        {
+            radixSort.Begin( count, chunkCount );
+            memcpy( radixSort.Keys( ), keys.data( ), sizeof( uint64 ) * count );
+            for( uint32 i = 0; i < count; i++ )
+                radixSort.Values( )[i] = i;
+        };
+        auto verify = [ & ]( const char * name )
+        {
+            for( uint32 i = 0; i < count; i++ )
+                if( (int)radixSort.SortedValues( )[i] != comparatorIndices[i] )
+                {
+                    context.Fail( "%u items: %s order differs from the comparator sort at %u", count, name, i );
+                    return;
+                }
+        };
+
+        const double serialMS = context.MeasureMedian( [ & ]( ) { fill( 1 ); radixSort.SortSerial( ); } );
+        verify( "serial radix sort" );
+
+        double parallelMS = serialMS;
+#ifdef VA_TASKFLOW_INTEGRATION_ENABLED
+        const int chunkCount = std::max( 1, std::min( vaTF::ThreadCount( ), (int)( count / 8192 ) ) );
+        parallelMS = context.MeasureMedian( [ & ]( ) 
+        { 
+            fill( chunkCount );
+            for( int pass = 0; pass < vaRadixSort::c_PassCount; pass++ )
+            {
+                vaTF::parallel_for( 0, chunkCount, [ &, pass ]( int chunk ) { radixSort.Histogram( pass, chunk ); }, 1, "Histogram" ).wait( );
+                radixSort.PrefixSum( pass );
+                vaTF::parallel_for( 0, chunkCount, [ &, pass ]( int chunk ) { radixSort.Scatter( pass, chunk ); }, 1, "Scatter" ).wait( );
+            }
+        } );
+        verify( "parallel radix sort" );
+#endif
+
+        context.Report( "%7u items: comparator %8.3f ms, radix %8.3f ms (%.2fx), radix parallel %8.3f ms (%.2fx)", count, 
+            comparatorMS, serialMS, comparatorMS / serialMS, parallelMS, comparatorMS / parallelMS );
+        context.CheckThroughput( vaStringTools::Format( "radix.%u", count ), count / serialMS / 1000.0, "Mitems/s" );
+        context.CheckThroughput( vaStringTools::Format( "radixParallel.%u", count ), count / parallelMS / 1000.0, "Mitems/s" );
+    }
+}
+
+namespace
+{
+    // Bare registry with just the components transform updates need (no vaScene, no sibling links)
+    struct BenchmarkHierarchy
+    {
+        entt::registry                      Registry;
+        std::vector<entt::entity>           Roots;
+        std::vector<std::vector<entt::entity>>  RootSubtrees;   // root first, then all of its descendants
+
+        entt::entity                        Add( entt::entity parent, const vaMatrix4x4 & local )
+        {
+            const entt::entity entity = Registry.create( );
+            Scene::Relationship relationship;
+            if( parent != entt::null )
+            {
+                relationship.Parent = parent;
+                relationship.Depth  = Registry.get<Scene::Relationship>( parent ).Depth + 1;
+            }
+            Registry.emplace<Scene::Relationship>( entity, relationship );
+            Registry.emplace<Scene::TransformLocal>( entity ) = local;
+            Registry.emplace<Scene::TransformWorld>( entity ) = vaMatrix4x4::Identity;
+            return entity;
+        }
+
+        // rootCount trees, each with branching[0] children, each of which has branching[1] children and so on
+        void                                Create( int rootCount, const std::vector<int> & branching )
+        {
+            vaRandom random( rootCount );
+            std::function<void( entt::entity, int, std::vector<entt::entity> & )> addChildren = [ & ]( entt::entity parent, int level, std::vector<entt::entity> & subtree )
+            {
+                if( level == (int)branching.size( ) )
+                    return;
+                for( int i = 0; i < branching[level]; i++ )
+                {
+                    const vaVector3 offset( random.NextFloatRange( -2.0f, 2.0f ), random.NextFloatRange( -2.0f, 2.0f ), random.NextFloatRange( 0.0f, 1.0f ) );
+                    const entt::entity child = Add( parent, vaMatrix4x4::RotationZ( random.NextFloatRange( 0.0f, VA_PIf ) ) * vaMatrix4x4::Translation( offset ) );
+                    subtree.push_back( child );
+                    addChildren( child, level + 1, subtree );
+                }
+            };
+            for( int i = 0; i < rootCount; i++ )
+            {
+                const entt::entity root = Add( entt::null, vaMatrix4x4::Translation( (float)( i % 256 ) * 10.0f, (float)( i / 256 ) * 10.0f, 0.0f ) );
+                Roots.push_back( root );
+                RootSubtrees.push_back( { root } );
+                addChildren( root, 0, RootSubtrees.back( ) );
+            }
+        }
+
+        // rotates every dirtyEvery-th root and returns everything that needs updating (same as SetTransformDirtyRecursive would)
+        void                                Animate( int frame, int dirtyEvery, std::vector<entt::entity> & outDirty )
+        {
+            outDirty.clear( );
+            for( size_t i = 0; i < Roots.size( ); i += dirtyEvery )
+            {
+                Registry.get<Scene::TransformLocal>( Roots[i] ) = vaMatrix4x4::RotationZ( frame * 0.01f ) * vaMatrix4x4::Translation( (float)( i % 256 ) * 10.0f, (float)( i / 256 ) * 10.0f, 0.0f );
+                outDirty.insert( outDirty.end( ), RootSubtrees[i].begin( ), RootSubtrees[i].end( ) );
+            }
+        }
+    };
+}
+
+// Scene::UpdateTransforms per entity in depth buckets (what TransformsUpdateWorkNode does by default) vs vaSceneTransformHierarchy,
+// single threaded, on deep, wide and bushy hierarchies with everything or 1/10th of it animated; the world transforms must match
+VA_BENCHMARK( TransformHierarchy )
+{
+    struct Shape { const char * Name; int RootCount; std::vector<int> Branching; };
+    const Shape shapes[] = {
+        { "deep",   4096,   { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 } },     // 16 levels (the maximum)
+        { "wide",   64,     { 1023 } },
+        { "bushy",  16,     { 16, 256 } },
+    };
+
+    for( const Shape & shape : shapes )
+    {
+        for( int dirtyEvery : { 1, 10 } )
+        {
+            BenchmarkHierarchy registryPath, hierarchyPath;
+            registryPath.Create( shape.RootCount, shape.Branching );
+            hierarchyPath.Create( shape.RootCount, shape.Branching );
+            const size_t entityCount = registryPath.Registry.size( );
+
+            Scene::UniqueStaticAppendConsumeList boundsDirtyList;   // (nothing has WorldBounds so it stays empty)
+            std::vector<entt::entity> dirty;
+
+            std::vector<entt::entity> depthBuckets[Scene::Relationship::c_MaxDepthLevels];
+            int registryFrame = 0;
+            const double registryMS = context.MeasureMedian( [ & ]( )
+            {
+                registryPath.Animate( registryFrame++, dirtyEvery, dirty );
+                for( auto & bucket : depthBuckets )
+                    bucket.clear( );
+                for( entt::entity entity : dirty )
+                    depthBuckets[registryPath.Registry.get<Scene::Relationship>( entity ).Depth].push_back( entity );
+                for( auto & bucket : depthBuckets )
+                    for( entt::entity entity : bucket )
+                        Scene::UpdateTransforms( registryPath.Registry, entity, boundsDirtyList );
+            } );
+
+            vaSceneTransformHierarchy hierarchy;
+            const double rebuildStart = vaCore::TimeFromAppStart( );
+            hierarchy.Rebuild( hierarchyPath.Registry );
+            const double rebuildMS = ( vaCore::TimeFromAppStart( ) - rebuildStart ) * 1000.0;
+            auto updateAllLevels = [ & ]( )
+            {
+                for( int depth = 0; depth < vaSceneTransformHierarchy::c_MaxDepthLevels; depth++ )
+                {
+                    const auto range = hierarchy.DirtyRange( depth );
+                    hierarchy.Update( hierarchyPath.Registry, range.first, range.second, boundsDirtyList );
+                }
+                hierarchy.EndUpdate( );
+            };
+            updateAllLevels( );
+
+            int hierarchyFrame = 0;
+            const double hierarchyMS = context.MeasureMedian( [ & ]( )
+            {
+                hierarchyPath.Animate( hierarchyFrame++, dirtyEvery, dirty );
+                vaSceneTransformHierarchy::DirtyRanges ranges;
+                for( entt::entity entity : dirty )
+                    if( !hierarchy.MarkDirty( hierarchyPath.Registry, entity, ranges ) )
+                        break;
+                hierarchy.MergeDirtyRanges( ranges );
+                updateAllLevels( );
+            } );
+            if( hierarchy.NeedsRebuild( ) )
+                context.Fail( "%s: hierarchy invalidated itself with no structural changes", shape.Name );
+
+            int mismatches = 0;
+            registryPath.Registry.view<const Scene::TransformWorld>( ).each( [ & ]( entt::entity entity, const Scene::TransformWorld & world )
+            {
+                if( static_cast<const vaMatrix4x4 &>( world ) != static_cast<const vaMatrix4x4 &>( hierarchyPath.Registry.get<Scene::TransformWorld>( entity ) ) )
+                    mismatches++;
+            } );
+            if( mismatches > 0 )
+                context.Fail( "%s: %d of %zu world transforms differ between the two paths", shape.Name, mismatches, entityCount );
+
+            const string key = vaStringTools::Format( "%s.%s", shape.Name, ( dirtyEvery == 1 ) ? ( "all" ) : ( "tenth" ) );
+            context.Report( "%-12s %6zu entities, %6zu dirty: registry %7.3f ms, flat %7.3f ms (%.2fx), rebuild %.3f ms", key.c_str( ), entityCount, dirty.size( ),
+                registryMS, hierarchyMS, registryMS / hierarchyMS, rebuildMS );
+            context.CheckThroughput( key, dirty.size( ) / 1e6 / ( hierarchyMS / 1000.0 ), "Mentities/s" );
+        }
+    }
+}
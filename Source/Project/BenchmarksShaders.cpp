@@ -0,0 +1,193 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmarks.h"
+
+#include "Core/System/vaFileTools.h"
+#include "Core/System/vaFileStream.h"
+
+#include "Rendering/vaShader.h"
+
+using namespace Vanilla;
+
+namespace
+{
+    // Compiled shader stand-ins: a permutation (entry point + macros) of one of a few source files that each include a few of
+    // the shared headers; "files" are strings, hashed the same way backends hash real ones
+    struct SyntheticShaderSet
+    {
+        struct Entry
+        {
+            vaShaderCacheKey                        Key;
+            std::vector<vaShaderCache::Dependency>  Dependencies;
+            std::vector<byte>                       Blob;
+        };
+
+        std::map<wstring, string>                   Files;
+        std::vector<Entry>                          Entries;
+        uint64                                      TotalBytes  = 0;
+
+        SyntheticShaderSet( int permutationCount )
+        {
+            vaRandom random( permutationCount );
+            for( int i = 0; i < 32; i++ )
+                Files[vaStringTools::Format( L"Shaders\\vaInclude%02d.hlsl", i )] = vaStringTools::Format( "// header %d\n#define HEADER_%d %d\n", i, i, random.NextINT32( ) );
+            for( int i = 0; i < 8; i++ )
+                Files[vaStringTools::Format( L"Shaders\\Materials\\vaMaterial%d.hlsl", i )] = vaStringTools::Format( "// material source %d\n", i );
+
+            const char * entryPoints[] = { "VS_Standard", "PS_DepthOnly", "PS_Forward", "PS_RichPrepass" };
+            for( int i = 0; i < permutationCount; i++ )
+            {
+                const wstring source = vaStringTools::Format( L"Shaders\\Materials\\vaMaterial%d.hlsl", i % 8 );
+                vaShaderMacroContaner macros;
+                for( int bit = 0; bit < 10; bit++ )
+                    macros.push_back( std::make_pair( vaStringTools::Format( "VA_RM_FEATURE_%d", bit ), ( ( ( i / 32 ) >> bit ) & 1 ) ? ( "1" ) : ( "0" ) ) );
+
+                vaShaderCacheKeyBuilder builder;
+                builder.AddMacros( macros );
+                builder.AddString( string( ( entryPoints[( i / 8 ) % 4][0] == 'V' ) ? ( "vs_6_3" ) : ( "ps_6_3" ) ) );
+                builder.AddString( string( entryPoints[( i / 8 ) % 4] ) );
+                builder.AddString( vaStringTools::ToLower( source ) );
+
+                Entry entry;
+                entry.Key = builder.Finalize( );
+                entry.Dependencies.push_back( { source, 0 } );
+                for( int header = 0; header < 6; header++ )
+                    entry.Dependencies.push_back( { vaStringTools::Format( L"Shaders\\vaInclude%02d.hlsl", ( ( i % 8 ) * 4 + header ) % 32 ), 0 } );
+                for( vaShaderCache::Dependency & dependency : entry.Dependencies )
+                    Hash( dependency.FilePath, dependency.ContentHash );
+                entry.Blob.resize( 2048 + random.NextIntRange( 22 * 1024 ) );
+                for( byte & value : entry.Blob )
+                    value = (byte)random.NextUINT32( );
+                TotalBytes += entry.Blob.size( );
+                Entries.push_back( std::move( entry ) );
+            }
+        }
+
+        bool                                        Hash( const wstring & filePath, uint64 & outContentHash ) const
+        {
+            auto it = Files.find( filePath );
+            if( it == Files.end( ) )
+                return false;
+            outContentHash = vaXXHash64::Compute( it->second.data( ), it->second.size( ) );
+            return true;
+        }
+
+        bool                                        Matches( const Entry & entry, const shared_ptr<vaMemoryStream> & data ) const
+        {
+            return data != nullptr && (size_t)data->GetLength( ) == entry.Blob.size( ) && memcmp( data->GetBuffer( ), entry.Blob.data( ), entry.Blob.size( ) ) == 0;
+        }
+
+        bool                                        DependsOn( const Entry & entry, const wstring & filePath ) const
+        {
+            return std::find_if( entry.Dependencies.begin( ), entry.Dependencies.end( ), [&]( const vaShaderCache::Dependency & dependency ) { return dependency.FilePath == filePath; } ) != entry.Dependencies.end( );
+        }
+    };
+}
+
+// vaShaderCache with no GPU involved: cold start (new cache object, index load, then every shader looked up once, which
+// includes hashing dependencies and reading blobs - OS file cache is warm though), invalidation on dependency change and
+// revert, and LRU eviction
+VA_BENCHMARK( ShaderCache )
+{
+    const SyntheticShaderSet shaders( 4096 );
+    auto hashFunction = [&shaders]( const wstring & filePath, uint64 & outContentHash ) { return shaders.Hash( filePath, outContentHash ); };
+    // (the hash function looks at this one for the invalidation part)
+    SyntheticShaderSet editedShaders( 0 );
+    editedShaders.Files = shaders.Files;
+    auto editedHashFunction = [&editedShaders]( const wstring & filePath, uint64 & outContentHash ) { return editedShaders.Hash( filePath, outContentHash ); };
+
+    const wstring directory         = vaCore::GetExecutableDirectory( ) + L"benchmark_shader_cache";
+    const wstring evictionDirectory = vaCore::GetExecutableDirectory( ) + L"benchmark_shader_cache_eviction";
+    vaFileTools::DeleteDirectory( directory );
+    vaFileTools::DeleteDirectory( evictionDirectory );
+
+    {
+        vaShaderCache cache( directory, hashFunction );
+        cache.LoadIndex( );
+        for( const auto & entry : shaders.Entries )
+            cache.Add( entry.Key, entry.Blob.data( ), entry.Blob.size( ), entry.Dependencies );
+        if( cache.GetBlobCount( ) != (int)shaders.Entries.size( ) || cache.GetTotalSize( ) != shaders.TotalBytes )
+            context.Fail( "%d blobs, %llu bytes in cache after adding %d, %llu bytes", cache.GetBlobCount( ), (unsigned long long)cache.GetTotalSize( ), (int)shaders.Entries.size( ), (unsigned long long)shaders.TotalBytes );
+    }
+
+    // cold start
+    std::vector<double> loadIndexMS, lookupMS;
+    bool allFound = true;
+    for( int iteration = 0; iteration < std::max( 1, context.Iterations ); iteration++ )
+    {
+        const double start = vaCore::TimeFromAppStart( );
+        vaShaderCache cache( directory, hashFunction );
+        allFound &= cache.LoadIndex( );
+        const double indexLoaded = vaCore::TimeFromAppStart( );
+        for( const auto & entry : shaders.Entries )
+        {
+            bool foundButModified = false;
+            allFound &= shaders.Matches( entry, cache.Find( entry.Key, foundButModified ) );
+        }
+        loadIndexMS.push_back( ( indexLoaded - start ) * 1000.0 );
+        lookupMS.push_back( ( vaCore::TimeFromAppStart( ) - indexLoaded ) * 1000.0 );
+    }
+    if( !allFound )
+        context.Fail( "index didn't load or not every shader was found with the right contents" );
+    std::sort( loadIndexMS.begin( ), loadIndexMS.end( ) );
+    std::sort( lookupMS.begin( ), lookupMS.end( ) );
+
+    // change a header: only shaders including it miss (as modified), the rest still hit; after reverting it, all hit again
+    {
+        const wstring editedFile = L"Shaders\\vaInclude05.hlsl";
+        vaShaderCache cache( directory, editedHashFunction );
+        cache.LoadIndex( );
+        for( int pass = 0; pass < 2; pass++ )
+        {
+            editedShaders.Files[editedFile] = shaders.Files.at( editedFile ) + ( ( pass == 0 ) ? ( "// edit\n" ) : ( "" ) );
+            cache.ResetDependencyHashes( );
+            int wrong = 0;
+            for( const auto & entry : shaders.Entries )
+            {
+                bool foundButModified = false;
+                shared_ptr<vaMemoryStream> data = cache.Find( entry.Key, foundButModified );
+                const bool expectHit = pass == 1 || !shaders.DependsOn( entry, editedFile );
+                wrong += ( expectHit ) ? ( ( !shaders.Matches( entry, data ) ) ? ( 1 ) : ( 0 ) ) : ( ( data != nullptr || !foundButModified ) ? ( 1 ) : ( 0 ) );
+            }
+            if( wrong > 0 )
+                context.Fail( "%d wrong lookups after %s a dependency", wrong, ( pass == 0 ) ? ( "changing" ) : ( "reverting" ) );
+        }
+    }
+
+    // fill a cache half the size: least recently used get evicted, recent ones stay, evicted ones aren't 'modified'
+    {
+        vaShaderCache cache( evictionDirectory, hashFunction, shaders.TotalBytes / 2 );
+        cache.LoadIndex( );
+        for( const auto & entry : shaders.Entries )
+            cache.Add( entry.Key, entry.Blob.data( ), entry.Blob.size( ), entry.Dependencies );
+        bool foundButModified = false;
+        if( cache.GetTotalSize( ) > cache.GetSizeLimit( ) || cache.GetStatistics( ).Evictions == 0 )
+            context.Fail( "cache is %llu bytes with a limit of %llu, %lld evictions", (unsigned long long)cache.GetTotalSize( ), (unsigned long long)cache.GetSizeLimit( ), (long long)cache.GetStatistics( ).Evictions );
+        if( !shaders.Matches( shaders.Entries.back( ), cache.Find( shaders.Entries.back( ).Key, foundButModified ) ) )
+            context.Fail( "most recently added shader was evicted" );
+        if( cache.Find( shaders.Entries.front( ).Key, foundButModified ) != nullptr || foundButModified )
+            context.Fail( "least recently used shader wasn't evicted (or came back as modified)" );
+        if( (int)vaFileTools::FindFiles( cache.GetDirectory( ), L"*.blob", false ).size( ) != cache.GetBlobCount( ) )
+            context.Fail( "evicted blob files were not deleted" );
+    }
+
+    vaFileStream indexFile;
+    const int64 indexSize = ( indexFile.Open( directory + L"\\index" ) ) ? ( indexFile.GetLength( ) ) : ( 0 );
+    indexFile.Close( );
+    const double medianLoadIndexMS  = loadIndexMS[loadIndexMS.size( ) / 2];
+    const double medianLookupMS     = lookupMS[lookupMS.size( ) / 2];
+    context.Report( "%d shaders, %.1f MB of blobs, %.1f KB index; cold start: index %.2f ms, all lookups %.2f ms (%.2f us per shader)", (int)shaders.Entries.size( ),
+        shaders.TotalBytes / ( 1024.0 * 1024.0 ), indexSize / 1024.0, medianLoadIndexMS, medianLookupMS, medianLookupMS * 1000.0 / shaders.Entries.size( ) );
+    context.CheckThroughput( "ColdStart", (double)shaders.Entries.size( ) / 1e3 / ( ( medianLoadIndexMS + medianLookupMS ) / 1000.0 ), "Kshaders/s" );
+
+    vaFileTools::DeleteDirectory( directory );
+    vaFileTools::DeleteDirectory( evictionDirectory );
+}
@@ -9,9 +9,12 @@
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "Vanilla.h"
+#include "Benchmarks.h"
 
 #include "Core/System/vaFileTools.h"
 #include "Core/vaProfiler.h"
+#include "Core/vaTracerStream.h"
+#include "Core/Misc/vaBenchmarkTool.h"
 
 #include "Rendering/vaGPUTimer.h"
 
@@ -104,6 +107,104 @@ static void Dispatcher( vaRenderDevice & renderDevice, vaApplicationBase & appli
         application.SetWindowTitle( g_workspaces[g_currentWorkspace].first, true );
 }
 
+// '-traceconvert <capture> [-traceout <file>] [-traceformat json|perfetto]' converts a vaTracerStream capture and exits; 
+// '-tracestream <file>' starts a streaming capture right away (it gets stopped on exit)
+static bool HandleTracerCmdLine( const std::vector<std::pair<wstring, wstring>> & cmdLineParams, int & outExitCode )
+{
+    wstring convertInput, convertOutput, streamOutput;
+    vaTracerStream::ExportFormat format = vaTracerStream::ExportFormat::ChromeJSON;
+    for( const auto & param : cmdLineParams )
+    {
+        const wstring name = vaStringTools::ToLower( param.first );
+        if( name == L"traceconvert" )
+            convertInput = param.second;
+        else if( name == L"traceout" )
+            convertOutput = param.second;
+        else if( name == L"traceformat" && vaStringTools::ToLower( param.second ) == L"perfetto" )
+            format = vaTracerStream::ExportFormat::PerfettoProtobuf;
+        else if( name == L"tracestream" )
+            streamOutput = param.second;
+    }
+
+    if( convertInput != L"" )
+    {
+        if( convertOutput == L"" )
+        {
+            wstring directory, fileName;
+            vaFileTools::SplitPath( convertInput, &directory, &fileName, nullptr );
+            convertOutput = directory + fileName + ( ( format == vaTracerStream::ExportFormat::ChromeJSON ) ? ( L".json" ) : ( L".perfetto-trace" ) );
+        }
+        outExitCode = vaTracerStream::Convert( convertInput, convertOutput, format ) ? ( 0 ) : ( 1 );
+        return true;
+    }
+
+    if( streamOutput != L"" )
+        vaTracerStream::Start( vaFileTools::GetAbsolutePath( streamOutput ) );
+    return false;
+}
+
+// '-benchmarkcompare <baseline.csv> -benchmarkcompareto <current.csv> [-benchmarkcomparemin <relative change>]' diffs two
+// vaBenchmarkTool::WriteStatisticsCSV outputs and exits with the number of regressions as the exit code
+static bool HandleBenchmarkCompareCmdLine( const std::vector<std::pair<wstring, wstring>> & cmdLineParams, int & outExitCode )
+{
+    wstring baseline, current;
+    vaBenchmarkTool::ComparisonSettings settings;
+    for( const auto & param : cmdLineParams )
+    {
+        const wstring name = vaStringTools::ToLower( param.first );
+        if( name == L"benchmarkcompare" )
+            baseline = param.second;
+        else if( name == L"benchmarkcompareto" )
+            current = param.second;
+        else if( name == L"benchmarkcomparemin" )
+            settings.MinRelativeChange = (float)std::wcstod( param.second.c_str( ), nullptr );
+    }
+    if( baseline == L"" && current == L"" )
+        return false;
+
+    std::vector<vaBenchmarkTool::ComparisonResult> results;
+    if( baseline == L"" || current == L"" || !vaBenchmarkTool::CompareStatisticsCSV( baseline, current, settings, results ) )
+    {
+        VA_LOG_ERROR( "Benchmark compare needs both '-benchmarkcompare <baseline.csv>' and '-benchmarkcompareto <current.csv>' readable" );
+        outExitCode = -1;
+        return true;
+    }
+    VA_LOG( "%s", vaBenchmarkTool::FormatComparison( results, false ).c_str( ) );
+    outExitCode = (int)std::count_if( results.begin( ), results.end( ), [ ]( const vaBenchmarkTool::ComparisonResult & r ) { return r.Regression; } );
+    return true;
+}
+
+// -sceneconvert <input> -sceneconvertto <output>: JSON (.vaScene) <-> binary (.vaSceneBin) scene, direction from the input file
+static bool HandleSceneConvertCmdLine( const std::vector<std::pair<wstring, wstring>> & cmdLineParams, int & outExitCode )
+{
+    string input, output;
+    for( const auto & param : cmdLineParams )
+    {
+        const wstring name = vaStringTools::ToLower( param.first );
+        if( name == L"sceneconvert" )
+            input = vaStringTools::SimpleNarrow( vaFileTools::GetAbsolutePath( param.second ) );
+        else if( name == L"sceneconvertto" )
+            output = vaStringTools::SimpleNarrow( vaFileTools::GetAbsolutePath( param.second ) );
+    }
+    if( input == "" && output == "" )
+        return false;
+    if( input == "" || output == "" )
+    {
+        VA_LOG_ERROR( "Scene convert needs both '-sceneconvert <input>' and '-sceneconvertto <output>'" );
+        outExitCode = -1;
+        return true;
+    }
+
+    const bool toJSON = Scene::BinaryIsSceneFile( input );
+    const bool success = ( toJSON ) ? ( Scene::BinaryToJSON( input, output ) ) : ( Scene::BinaryFromJSON( input, output ) );
+    if( success )
+        VA_LOG_SUCCESS( "Scene '%s' converted to %s '%s'", input.c_str( ), ( toJSON ) ? ( "JSON" ) : ( "binary" ), output.c_str( ) );
+    else
+        VA_LOG_ERROR( "Unable to convert scene '%s' to '%s'", input.c_str( ), output.c_str( ) );
+    outExitCode = ( success ) ? ( 0 ) : ( 1 );
+    return true;
+}
+
 int APIENTRY _tWinMain( HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPTSTR lpCmdLine, int nCmdShow )
 {
     InitWorkspaces();
@@ -137,6 +238,21 @@ int APIENTRY _tWinMain( HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LP
     {
         VA_GENERIC_RAII_SCOPE( vaCore::Initialize( );, vaCore::Deinitialize( ); );
 
+        // headless benchmarks / regression tests and trace capture conversion - no window or render device; see Benchmarks.h
+        {
+            auto cmdLineParams = vaStringTools::SplitCmdLineParams( lpCmdLine );
+            int exitCode = 0;
+            if( HandleTracerCmdLine( cmdLineParams, exitCode ) )
+                return exitCode;
+            if( HandleBenchmarkCompareCmdLine( cmdLineParams, exitCode ) )
+                return exitCode;
+            if( HandleSceneConvertCmdLine( cmdLineParams, exitCode ) )
+                return exitCode;
+            if( IsBenchmarkRun( cmdLineParams ) )
+                return RunBenchmarks( cmdLineParams );
+            if( IsSceneBenchmarkRun( cmdLineParams ) )
+                return RunSceneBenchmark( cmdLineParams );
+        }
 
         vaApplicationWin::Settings settings( VA_APP_TITLE, lpCmdLine, nCmdShow );
         
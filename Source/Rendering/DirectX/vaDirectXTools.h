@@ -468,11 +468,12 @@ namespace Vanilla
 
     private:
 
-        lc_atomic_counter<int64, 17>        m_lastUsedFrame = -1;
+        lc_atomic_counter<int64, 17>        m_lastUsedFrame;
 
         std::mutex                          m_mutex;                    // user will get unique lock of this before adding object to container, and unlock after the PSO was created (lengthy op)
 
     public:
+        vaBasePSODX12( )                    { m_lastUsedFrame.reset_minmax( -1 ); }
         ~vaBasePSODX12( )                   { }
 
         // this is used to allow cache to be cleared after "a while" (see vaRenderDeviceDX12 for details)
@@ -95,7 +95,7 @@ namespace Vanilla
 
     class vaShaderIncludeHelper12 : public IDxcIncludeHandler// ID3DInclude
     {
-        std::vector<vaShaderCacheEntry12::FileDependencyInfo> &     m_dependenciesCollector;
+        std::vector<vaShaderCache::Dependency> &                    m_dependenciesCollector;
 
         std::vector< std::pair<string, string> >                    m_foundNamePairs;
 
@@ -123,7 +123,7 @@ namespace Vanilla
         }
         ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     public:
-        vaShaderIncludeHelper12( std::vector<vaShaderCacheEntry12::FileDependencyInfo> & dependenciesCollector, const wstring & relativePath, const string & macrosAsIncludeFile ) 
+        vaShaderIncludeHelper12( std::vector<vaShaderCache::Dependency> & dependenciesCollector, const wstring & relativePath, const string & macrosAsIncludeFile ) 
             : m_dwRef(1), m_dependenciesCollector( dependenciesCollector ), m_relativePath( relativePath ), m_macrosAsIncludeFile( macrosAsIncludeFile )
         {
         }
@@ -154,8 +154,8 @@ namespace Vanilla
                 }
             }
 
-            vaShaderCacheEntry12::FileDependencyInfo fileDependencyInfo;
-            std::shared_ptr<vaMemoryStream>        memBuffer;
+            vaShaderCache::Dependency               fileDependencyInfo;
+            std::shared_ptr<vaMemoryStream>         memBuffer;
 
             wstring fileNameR = m_relativePath + wstring( inFileName );
             wstring fileNameA = wstring( inFileName );
@@ -166,8 +166,8 @@ namespace Vanilla
                 fullFileName = vaDirectX12ShaderManager::GetInstance( ).FindShaderFile( fileNameA.c_str( ) );
             if( fullFileName != L"" )
             {
-                fileDependencyInfo = vaShaderCacheEntry12::FileDependencyInfo( fullFileName.c_str( ) );
                 memBuffer = vaFileTools::LoadMemoryStream( fullFileName.c_str( ) );
+                fileDependencyInfo.FilePath = fullFileName;
             }
             else
             {
@@ -185,9 +185,10 @@ namespace Vanilla
                     VA_WARN( L"Error trying to find shader file '%s' / '%s'!", fileNameR.c_str( ), fileNameA.c_str( ) );
                     return E_FAIL;
                 }
-                fileDependencyInfo = vaShaderCacheEntry12::FileDependencyInfo( foundName, embeddedData.TimeStamp );
                 memBuffer = embeddedData.MemStream;
+                fileDependencyInfo.FilePath = foundName;
             }
+            fileDependencyInfo.ContentHash = vaXXHash64::Compute( memBuffer->GetBuffer( ), memBuffer->GetLength( ) );
 
             m_dependenciesCollector.push_back( fileDependencyInfo );
             m_foundNamePairs.push_back( std::make_pair( vaStringTools::SimpleNarrow(inFileName).c_str(), vaStringTools::SimpleNarrow(fullFileName) ) );
@@ -319,32 +320,23 @@ namespace Vanilla
         }
     }
     //
-    void vaShaderDX12::CreateCacheKey( vaShaderCacheKey12 & outKey )
+    void vaShaderDX12::CreateCacheKey( vaShaderCacheKeyBuilder & outKey )
     {
         // m_allShaderDataMutex.assert_locked_by_caller();
 
-        // supposed to be empty!
-        assert( outKey.StringPart.size( ) == 0 );
-        outKey.StringPart.clear( );
-
-        outKey.StringPart += vaStringTools::Format( "%d", (int)m_macros.size( ) ) + " ";
-        for( uint32 i = 0; i < m_macros.size( ); i++ )
-        {
-            outKey.StringPart += m_macros[i].first + " ";
-            outKey.StringPart += m_macros[i].second + " ";
-        }
-        outKey.StringPart += m_shaderModel + " ";
-        outKey.StringPart += m_entryPoint + " ";
-        outKey.StringPart += vaStringTools::ToLower( vaStringTools::SimpleNarrow( m_shaderFilePath ) ) + " ";
+        outKey.AddMacros( m_macros );
+        outKey.AddString( m_shaderModel );
+        outKey.AddString( m_entryPoint );
+        outKey.AddString( vaStringTools::ToLower( m_shaderFilePath ) );
     }
     //
-    void vaVertexShaderDX12::CreateCacheKey( vaShaderCacheKey12 & outKey )
+    void vaVertexShaderDX12::CreateCacheKey( vaShaderCacheKeyBuilder & outKey )
     {
         // m_allShaderDataMutex.assert_locked_by_caller();
 
         vaShaderDX12::CreateCacheKey( outKey );
         
-        outKey.StringPart += m_inputLayout.GetHashString();
+        outKey.AddString( m_inputLayout.GetHashString() );
     }
     //
     
@@ -559,7 +551,7 @@ namespace Vanilla
     }    
     //
     static HRESULT CompileShaderFromFile( const wchar_t* szFileName, const string & macrosAsIncludeFile, LPCSTR szEntryPoint,
-        LPCSTR szShaderModel, shared_ptr<vaShaderDataDX12> & outBlob, std::vector<vaShaderCacheEntry12::FileDependencyInfo> & outDependencies, string & outErrorInfo )
+        LPCSTR szShaderModel, shared_ptr<vaShaderDataDX12> & outBlob, std::vector<vaShaderCache::Dependency> & outDependencies, string & outErrorInfo )
     {
         outDependencies.clear( );
 
@@ -571,9 +563,9 @@ namespace Vanilla
 
         if( fullFileName != L"" )
         {
-            outDependencies.push_back( vaShaderCacheEntry12::FileDependencyInfo( szFileName ) );
-            
             std::shared_ptr<vaMemoryStream> memBuffer = vaFileTools::LoadMemoryStream( fullFileName.c_str( ) );
+            outDependencies.push_back( { szFileName, vaXXHash64::Compute( memBuffer->GetBuffer( ), memBuffer->GetLength( ) ) } );
+
             ansiName = vaStringTools::SimpleNarrow( fullFileName );
 
             wstring relativePath;
@@ -594,7 +586,7 @@ namespace Vanilla
                 return E_FAIL;
             }
 
-            outDependencies.push_back( vaShaderCacheEntry12::FileDependencyInfo( szFileName, embeddedData.TimeStamp ) );
+            outDependencies.push_back( { szFileName, vaXXHash64::Compute( embeddedData.MemStream->GetBuffer( ), embeddedData.MemStream->GetLength( ) ) } );
 
             wstring relativePath;
             vaFileTools::SplitPath( szFileName, &relativePath, nullptr, nullptr );
@@ -610,6 +602,26 @@ namespace Vanilla
         // return E_FAIL;
     }
     //
+    // vaShaderCache::DependencyHashFunction - same lookup as compiling does: file system first, then embedded storage
+    static bool ShaderDependencyContentHash( const wstring & filePath, uint64 & outContentHash )
+    {
+        wstring fullFileName = vaDirectX12ShaderManager::GetInstance( ).FindShaderFile( filePath );
+        if( fullFileName != L"" )
+        {
+            std::shared_ptr<vaMemoryStream> memBuffer = vaFileTools::LoadMemoryStream( fullFileName );
+            if( memBuffer == nullptr )
+                return false;
+            outContentHash = vaXXHash64::Compute( memBuffer->GetBuffer( ), memBuffer->GetLength( ) );
+            return true;
+        }
+
+        vaFileTools::EmbeddedFileData embeddedData = vaFileTools::EmbeddedFilesFind( vaStringTools::SimpleNarrow( wstring( L"shaders:\\" ) + filePath ) );
+        if( !embeddedData.HasContents( ) )
+            return false;
+        outContentHash = vaXXHash64::Compute( embeddedData.MemStream->GetBuffer( ), embeddedData.MemStream->GetLength( ) );
+        return true;
+    }
+    //
     shared_ptr<vaShaderDataDX12> vaShaderDX12::CreateShaderBase( bool & loadedFromCache )
     {
         // m_allShaderDataMutex.assert_locked_by_caller();
@@ -631,8 +643,9 @@ namespace Vanilla
 
         if( m_shaderFilePath.size( ) != 0 )
         {
-            vaShaderCacheKey12 cacheKey;
-            CreateCacheKey( cacheKey );
+            vaShaderCacheKeyBuilder cacheKeyBuilder;
+            CreateCacheKey( cacheKeyBuilder );
+            const vaShaderCacheKey cacheKey = cacheKeyBuilder.Finalize( );
 
 #ifdef VA_SHADER_CACHE_PERSISTENT_STORAGE_ENABLE
             bool foundButModified;
@@ -654,7 +667,7 @@ namespace Vanilla
 
             if( shaderBlob == nullptr )
             {
-                std::vector<vaShaderCacheEntry12::FileDependencyInfo> dependencies;
+                std::vector<vaShaderCache::Dependency> dependencies;
 
                 CompileShaderFromFile( m_shaderFilePath.c_str( ), macrosAsIncludeFile, m_entryPoint.c_str( ), m_shaderModel.c_str( ), shaderBlob, dependencies, m_lastError );
 
@@ -664,7 +677,7 @@ namespace Vanilla
         }
         else if( m_shaderCode.size( ) != 0 )
         {
-            std::vector<vaShaderCacheEntry12::FileDependencyInfo> dependencies;
+            std::vector<vaShaderCache::Dependency> dependencies;
             vaShaderIncludeHelper12 includeHelper( dependencies, L"", macrosAsIncludeFile );
 
             CompileShaderFromBuffer( m_shaderCode.c_str( ), m_shaderCode.size( ), "EmbeddedInCodebase", m_entryPoint.c_str( ), m_shaderModel.c_str( ), shaderBlob, m_lastError, includeHelper );
@@ -899,23 +912,23 @@ namespace Vanilla
         }
 
 #ifdef VA_SHADER_CACHE_PERSISTENT_STORAGE_ENABLE
-        // start loading the cache before initializing anything else as it will continue in background - faster startup!
         {
-            // lock here just in case we put something after the loading task 
-            std::unique_lock<mutex> cacheMutexLock( m_cacheMutex );
-
             // this should maybe be set externally, but good enough for now
-            m_cacheFilePath = vaCore::GetExecutableDirectory( ) + L".cache\\";
-
             // Do we need per-adapter caches? probably not but who cares - different adapter >usually< means different machine so recaching anyway
 #if defined( DEBUG ) || defined( _DEBUG )
-            m_cacheFilePath += L"shaders_dx12_debug_" + vaStringTools::SimpleWiden( vaStringTools::ReplaceSpacesWithUnderscores( GetRenderDevice( ).GetAdapterNameID( ) ) );
+            const wstring cacheName = L"shaders_dx12_debug_" + vaStringTools::SimpleWiden( vaStringTools::ReplaceSpacesWithUnderscores( GetRenderDevice( ).GetAdapterNameID( ) ) );
 #else
-            m_cacheFilePath += L"shaders_dx12_release_" + vaStringTools::SimpleWiden( vaStringTools::ReplaceSpacesWithUnderscores( GetRenderDevice( ).GetAdapterNameID( ) ) );
+            const wstring cacheName = L"shaders_dx12_release_" + vaStringTools::SimpleWiden( vaStringTools::ReplaceSpacesWithUnderscores( GetRenderDevice( ).GetAdapterNameID( ) ) );
 #endif
+            // the old single-file cache had this name; it's a directory now
+            if( vaFileTools::FileExists( vaCore::GetExecutableDirectory( ) + L".cache\\" + cacheName ) )
+                vaFileTools::DeleteFile( vaCore::GetExecutableDirectory( ) + L".cache\\" + cacheName );
+
+            // only the index is read here (blobs are read on use) so there's no need for a background task anymore
+            vaTimerLogScope log( "Loading DirectX12 shader cache index" );
+            m_cache = std::make_shared<vaShaderCache>( vaCore::GetExecutableDirectory( ) + L".cache\\" + cacheName + L"\\", &ShaderDependencyContentHash );
+            m_cache->LoadIndex( );
         }
-
-        LoadCacheInternal( );
 #endif // VA_SHADER_CACHE_PERSISTENT_STORAGE_ENABLE
 
         // if( !vaFileTools::FileExists( s_customDXCPath ) )
@@ -933,12 +946,12 @@ namespace Vanilla
         assert( GetRenderDevice().IsRenderThread() );
 
 #ifdef VA_SHADER_CACHE_PERSISTENT_STORAGE_ENABLE
+        if( m_cache != nullptr )
         {
-            std::unique_lock<mutex> cacheMutexLock( m_cacheMutex );    // this is also needed to make sure loading finished!
-            SaveCacheInternal( );
+            vaTimerLogScope log( "Saving DirectX12 shader cache index" );
+            m_cache = nullptr;
         }
 #endif
-        ClearCache( );
 
         // Ensure no shaders remain
         {
@@ -993,358 +1006,31 @@ namespace Vanilla
         return L"";
     }
     //
-    void vaDirectX12ShaderManager::LoadCacheInternal( )
-    {
-        auto loadingLambda = [this]( vaBackgroundTaskManager::TaskContext & context ) 
-        {
-            vaTimerLogScope log( "Loading DirectX12 shader cache" );
-
-            // lock here just in case we put something after the loading task 
-            std::unique_lock<mutex> cacheMutexLock( m_cacheMutex );
-
-            {
-                std::unique_lock cacheLoadStartedMutexLock( m_cacheLoadStartedMutex );
-                m_cacheLoadStarted = true;
-            }
-            m_cacheLoadStartedCV.notify_all();
-
-            wstring fullFileName = m_cacheFilePath;
-
-            if( fullFileName == L"" )
-                return false;
-
-            if( !vaFileTools::FileExists( fullFileName ) )
-                return false;
-
-            ClearCacheInternal( );
-
-            vaFileStream inFile;
-            if( inFile.Open( fullFileName.c_str( ), FileCreationMode::Open, FileAccessMode::Read ) )
-            {
-                int version = -1;
-                if( inFile.ReadValue<int32>( version ) && version == 1 )
-                {
-                    assert( version == 1 );
-
-                    int32 entryCount = 0;
-                    if( !inFile.ReadValue<int32>( entryCount ) || ( entryCount < 0 ) )
-                    {
-                        VA_WARN( "Error while reading shader cache file, resetting and starting from scratch!" );
-                        ClearCacheInternal( );
-                        return false;
-                    }
-
-                    for( int i = 0; i < entryCount; i++ )
-                    {
-                        context.Progress = float(i)/float(entryCount-1);
-
-                        vaShaderCacheKey12 key;
-                        if( !key.Load( inFile ) )
-                        {
-                            VA_WARN( "Error while reading shader cache file, resetting and starting from scratch!" );
-                            ClearCacheInternal( );
-                            return false;
-                        }
-                        vaShaderCacheEntry12 * entry = new vaShaderCacheEntry12( );
-                        if( !entry->Load( inFile ) )
-                        {
-                            delete entry;
-                            VA_WARN( "Error while reading shader cache file, resetting and starting from scratch!" );
-                            ClearCacheInternal( );
-                            return false;
-                        }
-
-                        m_cache.insert( std::pair<vaShaderCacheKey12, vaShaderCacheEntry12 *>( key, entry ) );
-                    }
-
-                    int32 terminator;
-                    if( !inFile.ReadValue<int32>( terminator ) || terminator != 0xFEEEFEEE )
-                    {
-                        VA_WARN( "Error while reading shader cache file, resetting and starting from scratch!" );
-                        ClearCacheInternal( );
-                        return false;
-                    }
-                }
-                else
-                {
-                    VA_WARN( "Shader cache version upgraded, cannot use old cache, resetting and starting from scratch!" );
-                    ClearCacheInternal();
-                    return false;
-                }
-            }
-            return true;
-        };
-
-        bool multithreaded = true;
-        if( multithreaded )
-        {
-            vaBackgroundTaskManager::GetInstance().Spawn( "Loading Shader Cache", vaBackgroundTaskManager::SpawnFlags::ShowInUI, loadingLambda );
-            
-            // make sure we've started and taken the thread
-            {
-                std::unique_lock<std::mutex> lk(m_cacheLoadStartedMutex);
-                m_cacheLoadStartedCV.wait(lk, [this] { return (bool)m_cacheLoadStarted; } );
-            }
-        }
-        else
-        {
-            loadingLambda( vaBackgroundTaskManager::TaskContext() );
-        }
-    }
-    //
-    void vaDirectX12ShaderManager::SaveCacheInternal( ) const
-    {
-        vaTimerLogScope log( "Saving DirectX12 shader cache" );
-
-        // must already be locked by this point!
-        // std::unique_lock<mutex> cacheMutexLock( m_cacheMutex );
-        m_cacheMutex.assert_locked_by_caller();
-
-        wstring fullFileName = m_cacheFilePath;
-
-        wstring cacheDir;
-        vaFileTools::SplitPath( fullFileName, &cacheDir, nullptr, nullptr );
-        vaFileTools::EnsureDirectoryExists( cacheDir.c_str( ) );
-
-        vaFileStream outFile;
-        outFile.Open( fullFileName.c_str( ), FileCreationMode::Create );
-
-        outFile.WriteValue<int32>( 1 );                 // version;
-
-        outFile.WriteValue<int32>( (int32)m_cache.size( ) );    // number of entries
-
-        for( std::map<vaShaderCacheKey12, vaShaderCacheEntry12 *>::const_iterator it = m_cache.cbegin( ); it != m_cache.cend( ); ++it )
-        {
-            // Save key
-            ( *it ).first.Save( outFile );
-
-            // Save data
-            ( *it ).second->Save( outFile );
-        }
-
-        outFile.WriteValue<int32>( 0xFEEEFEEE );  // EOF;
-    }
-    //
-    void vaDirectX12ShaderManager::ClearCacheInternal( )
-    {
-        m_cacheMutex.assert_locked_by_caller();
-        for( std::map<vaShaderCacheKey12, vaShaderCacheEntry12 *>::iterator it = m_cache.begin( ); it != m_cache.end( ); ++it )
-        {
-            delete ( *it ).second;;
-        }
-        m_cache.clear( );
-    }
-    //
     void vaDirectX12ShaderManager::ClearCache( )
     {
-        std::unique_lock<mutex> cacheMutexLock( m_cacheMutex );
-        ClearCacheInternal();
+        if( m_cache != nullptr )
+            m_cache->Clear( );
     }
     //
-    shared_ptr<vaShaderDataDX12> vaDirectX12ShaderManager::FindInCache( vaShaderCacheKey12 & key, bool & foundButModified )
+    shared_ptr<vaShaderDataDX12> vaDirectX12ShaderManager::FindInCache( const vaShaderCacheKey & key, bool & foundButModified )
     {
-        std::unique_lock<mutex> cacheMutexLock( m_cacheMutex );
-
         foundButModified = false;
+        if( m_cache == nullptr )
+            return nullptr;
 
-        std::map<vaShaderCacheKey12, vaShaderCacheEntry12 *>::iterator it = m_cache.find( key );
-
-        if( it != m_cache.end( ) )
-        {
-            if( ( *it ).second->IsModified( ) )
-            {
-                foundButModified = true;
-
-                // Have to recompile...
-                delete ( *it ).second;
-                m_cache.erase( it );
-
-                return nullptr;
-            }
-
-            return ( *it ).second->GetCompiledShader( );
-        }
-        return nullptr;
-    }
-    //
-    void vaDirectX12ShaderManager::AddToCache( vaShaderCacheKey12 & key, const shared_ptr<vaShaderDataDX12> & shaderBlob, std::vector<vaShaderCacheEntry12::FileDependencyInfo> & dependencies )
-    {
-        std::unique_lock<mutex> cacheMutexLock( m_cacheMutex );
-
-        std::map<vaShaderCacheKey12, vaShaderCacheEntry12 *>::iterator it = m_cache.find( key );
-
-        if( it != m_cache.end( ) )
-        {
-            // Already in? can happen with parallel compilation I guess?
-            // well let's just not do anything then
-            return;
-            // delete ( *it ).second;
-            // m_cache.erase( it );
-        }
-
-        m_cache.insert( std::pair<vaShaderCacheKey12, vaShaderCacheEntry12 *>( key, new vaShaderCacheEntry12( shaderBlob, dependencies ) ) );
-    }
-    //
-    vaShaderCacheEntry12::FileDependencyInfo::FileDependencyInfo( const wstring & filePath )
-    {
-        wstring fullFileName = vaDirectX12ShaderManager::GetInstance( ).FindShaderFile( filePath );
-
-        if( fullFileName == L"" )
-        {
-            VA_WARN( L"Error trying to find shader file '%s'!", filePath.c_str() );
-
-            assert( false );
-            this->FilePath = L"";
-            this->ModifiedTimeDate = 0;
-        }
-        else
-        {
-            this->FilePath = filePath;
-
-            // struct _stat64 fileInfo;
-            // _wstat64( fullFileName.c_str( ), &fileInfo ); // check error code?
-            //this->ModifiedTimeDate = fileInfo.st_mtime;
-
-            // maybe add some CRC64 here too? that would require reading contents of every file and every dependency which would be costly! 
-            WIN32_FILE_ATTRIBUTE_DATA attrInfo;
-            ::GetFileAttributesEx( fullFileName.c_str( ), GetFileExInfoStandard, &attrInfo );
-            this->ModifiedTimeDate = ( ( (int64)attrInfo.ftLastWriteTime.dwHighDateTime ) << 32 ) | ( (int64)attrInfo.ftLastWriteTime.dwLowDateTime );
-        }
-    }
-    //
-    vaShaderCacheEntry12::FileDependencyInfo::FileDependencyInfo( const wstring & filePath, int64 modifiedTimeDate )
-    {
-        this->FilePath = filePath;
-        this->ModifiedTimeDate = modifiedTimeDate;
-    }
-    //
-    bool vaShaderCacheEntry12::FileDependencyInfo::IsModified( )
-    {
-        wstring fullFileName = vaDirectX12ShaderManager::GetInstance( ).FindShaderFile( this->FilePath.c_str( ) );
-
-        //vaLog::GetInstance( ).Add( LOG_COLORS_SHADERS, (L"vaShaderCacheEntry12::FileDependencyInfo::IsModified, file name %s", fullFileName.c_str() ) );
-
-        if( fullFileName == L"" )  // Can't find the file?
-        {
-            vaFileTools::EmbeddedFileData embeddedData = vaFileTools::EmbeddedFilesFind( vaStringTools::SimpleNarrow( wstring( L"shaders:\\" ) + this->FilePath ) );
-
-            if( !embeddedData.HasContents( ) )
-            {
-                //vaLog::GetInstance( ).Add( LOG_COLORS_SHADERS, L"        > embedded data has NO contents" );
-#ifdef STILL_LOAD_FROM_CACHE_IF_ORIGINAL_FILE_MISSING
-                return false;
-#else
-                VA_WARN( L"Error trying to find shader file '%s'!", this->FilePath.c_str( ) );
-                return true;
-#endif
-            }
-            else
-            {
-                //vaLog::GetInstance( ).Add( LOG_COLORS_SHADERS,  L"        > embedded data has contents" );
-                return this->ModifiedTimeDate != embeddedData.TimeStamp;
-            }
-        }
-
-        // struct _stat64 fileInfo;
-        // _wstat64( fullFileName.c_str( ), &fileInfo ); // check error code?
-        // return this->ModifiedTimeDate != fileInfo.st_mtime;
-
-        // maybe add some CRC64 here too? that would require reading contents of every file and every dependency which would be costly! 
-        WIN32_FILE_ATTRIBUTE_DATA attrInfo;
-        ::GetFileAttributesEx( fullFileName.c_str( ), GetFileExInfoStandard, &attrInfo );
-        bool ret = this->ModifiedTimeDate != ( ( ( (int64)attrInfo.ftLastWriteTime.dwHighDateTime ) << 32 ) | ( (int64)attrInfo.ftLastWriteTime.dwLowDateTime ) );
-
-        // if( ret )
-        // {
-        //     vaLog::GetInstance( ).Add( LOG_COLORS_SHADERS,  (const wchar_t*)((ret)?(L"   > shader file '%s' modified "):(L"   > shader file '%s' NOT modified ")), fullFileName.c_str() );
-        // }
-
-        return ret;
-    }
-    //
-    vaShaderCacheEntry12::vaShaderCacheEntry12( const shared_ptr<vaShaderDataDX12> & compiledShader, std::vector<vaShaderCacheEntry12::FileDependencyInfo> & dependencies )
-    {
-        m_compiledShader = compiledShader;
-        m_dependencies = dependencies;
-    }
-    //
-    vaShaderCacheEntry12::~vaShaderCacheEntry12( )
-    {
-    }
-    //
-    bool vaShaderCacheEntry12::IsModified( )
-    {
-        for( std::vector<vaShaderCacheEntry12::FileDependencyInfo>::iterator it = m_dependencies.begin( ); it != m_dependencies.end( ); ++it )
-        {
-            if( ( *it ).IsModified( ) )
-                return true;
-        }
-        return false;
-    }
-    //
-    void vaShaderCacheKey12::Save( vaStream & outStream ) const
-    {
-        outStream.WriteString( this->StringPart.c_str( ) );
-    }
-    //
-    void vaShaderCacheEntry12::FileDependencyInfo::Save( vaStream & outStream ) const
-    {
-        outStream.WriteString( this->FilePath.c_str( ) );
-        outStream.WriteValue<int64>( this->ModifiedTimeDate );
-    }
-    //
-    void vaShaderCacheEntry12::Save( vaStream & outStream ) const
-    {
-        outStream.WriteValue<int32>( ( int32 )this->m_dependencies.size( ) );       // number of dependencies
-
-        for( std::vector<vaShaderCacheEntry12::FileDependencyInfo>::const_iterator it = m_dependencies.cbegin( ); it != m_dependencies.cend( ); ++it )
-        {
-            ( *it ).Save( outStream );
-        }
-
-        int bufferSize = (int)m_compiledShader->GetBufferSize( );
+        shared_ptr<vaMemoryStream> data = m_cache->Find( key, foundButModified );
+        if( data == nullptr )
+            return nullptr;
 
-        outStream.WriteValue<int32>( bufferSize );
-        outStream.Write( m_compiledShader->GetBufferPointer( ), bufferSize );
-    }
-    //
-    bool vaShaderCacheKey12::Load( vaStream & inStream )
-    {
-        return inStream.ReadString( this->StringPart );
-    }
-    //
-    bool vaShaderCacheEntry12::FileDependencyInfo::Load( vaStream & inStream )
-    {
-        return inStream.ReadString( this->FilePath ) && inStream.ReadValue<int64>( this->ModifiedTimeDate );
+        shared_ptr<vaShaderDataDX12> shaderBlob = std::make_shared<vaShaderDataDX12>( (size_t)data->GetLength( ) );
+        memcpy( shaderBlob->GetBufferPointer( ), data->GetBuffer( ), (size_t)data->GetLength( ) );
+        return shaderBlob;
     }
     //
-    bool vaShaderCacheEntry12::Load( vaStream & inStream )
+    void vaDirectX12ShaderManager::AddToCache( const vaShaderCacheKey & key, const shared_ptr<vaShaderDataDX12> & shaderBlob, const std::vector<vaShaderCache::Dependency> & dependencies )
     {
-        int dependencyCount;
-        if( !inStream.ReadValue<int32>( dependencyCount ) || dependencyCount < 0 )
-            return false;
-
-        for( int i = 0; i < dependencyCount; i++ )
-        {
-            auto dependencyInfo = vaShaderCacheEntry12::FileDependencyInfo( );
-            if( !dependencyInfo.Load(inStream) )
-                return false;
-            m_dependencies.push_back( std::move(dependencyInfo) );
-        }
-
-        int bufferSize;
-        if( !inStream.ReadValue<int32>( bufferSize ) || bufferSize < 0 )
-            return false;
-
-        assert( m_compiledShader == nullptr );
-        m_compiledShader = std::make_shared<vaShaderDataDX12>( bufferSize );
-        
-        if( !inStream.Read( m_compiledShader->GetBufferPointer(), bufferSize ) )
-        {
-            m_compiledShader = nullptr;
-            return false;
-        }
-        return true;
+        if( m_cache != nullptr )
+            m_cache->Add( key, shaderBlob->GetBufferPointer( ), shaderBlob->GetBufferSize( ), dependencies );
     }
 }
 
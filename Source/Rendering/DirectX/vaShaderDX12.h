@@ -15,9 +15,6 @@
 
 namespace Vanilla
 {
-    struct vaShaderCacheKey12;
-    class vaShaderCacheEntry12;
-
     // This wraps the ID3DBlob/IDxcBlob into a vaFramePtr-castable smart ptr to avoid costly high-contention refcounting by the
     // refcounter in dxcompiler.dll (or the horrible horrible crashy thread-unsafe one in the old D3dcompiler.h:D3DCreateBlob).
     class vaShaderDataDX12 final: public ID3DBlob, public vaFramePtrTag//, public std::enable_shared_from_this<vaShaderDataDX12>
@@ -88,7 +85,7 @@ namespace Vanilla
         vaShader::State                 GetShader( vaFramePtr<vaShaderDataDX12> & outData, int64 & outUniqueContentsID );
         //
     protected:
-        virtual void                    CreateCacheKey( vaShaderCacheKey12 & outKey );
+        virtual void                    CreateCacheKey( vaShaderCacheKeyBuilder & outKey );
         //
     protected:
         //
@@ -178,61 +175,11 @@ namespace Vanilla
         virtual void                CreateShader( ) override;
         virtual void                DestroyShader( ) override;
 
-        virtual void                CreateCacheKey( vaShaderCacheKey12 & outKey );
+        virtual void                CreateCacheKey( vaShaderCacheKeyBuilder & outKey );
     };
 
 #pragma warning ( pop )
 
-    struct vaShaderCacheKey12
-    {
-        std::string                StringPart;
-
-        bool                       operator == ( const vaShaderCacheKey12 & cmp ) const { return this->StringPart == cmp.StringPart; }
-        bool                       operator < ( const vaShaderCacheKey12 & cmp ) const { return this->StringPart < cmp.StringPart; }
-        bool                       operator >( const vaShaderCacheKey12 & cmp ) const { return this->StringPart > cmp.StringPart; }
-
-        void                       Save( vaStream & outStream ) const;
-        bool                       Load( vaStream & inStream );
-    };
-
-    class vaShaderCacheEntry12
-    {
-    public:
-        struct FileDependencyInfo
-        {
-            std::wstring            FilePath;
-            int64                   ModifiedTimeDate;
-
-            FileDependencyInfo( ) : FilePath( L"" ), ModifiedTimeDate( 0 ) { }
-            FileDependencyInfo( const wstring & filePath );
-            FileDependencyInfo( const wstring & filePath, int64 modifiedTimeDate );
-
-            bool                    IsModified( );
-
-            void                    Save( vaStream & outStream ) const;
-            bool                    Load( vaStream & inStream );
-        };
-
-    private:
-
-        std::shared_ptr<vaShaderDataDX12>                       m_compiledShader;
-        std::vector<vaShaderCacheEntry12::FileDependencyInfo>   m_dependencies;
-
-    private:
-        explicit vaShaderCacheEntry12( const vaShaderCacheEntry12 & copy ) { copy; }
-    public:
-        vaShaderCacheEntry12( const std::shared_ptr<vaShaderDataDX12> & compiledShader, std::vector<vaShaderCacheEntry12::FileDependencyInfo> & dependencies );
-        explicit vaShaderCacheEntry12( ) { m_compiledShader = NULL; }
-        ~vaShaderCacheEntry12( );
-
-        bool                        IsModified( );
-        std::shared_ptr<vaShaderDataDX12>
-                                    GetCompiledShader( ) { return m_compiledShader; }
-
-        void                        Save( vaStream & outStream ) const;
-        bool                        Load( vaStream & inStream );
-    };
-
     // Singleton utility class for handling shaders
     class vaDirectX12ShaderManager : public vaShaderManager, public vaSingletonBase < vaDirectX12ShaderManager > // oooo I feel so dirty here but oh well
     {
@@ -242,17 +189,6 @@ namespace Vanilla
         friend class vaShaderDX12;
 
     private:
-        std::map<vaShaderCacheKey12, vaShaderCacheEntry12 *>    m_cache;
-        mutable mutex                                       m_cacheMutex;
-#ifdef VA_SHADER_CACHE_PERSISTENT_STORAGE_ENABLE
-        wstring                                             m_cacheFilePath;
-
-        // since cache loading from the disk happens only once, use this to ensure loading proc has grabbed m_cacheMutex - once it's unlocked we know it finished
-        std::atomic_bool                                    m_cacheLoadStarted = false;
-        std::mutex                                          m_cacheLoadStartedMutex;
-        std::condition_variable                             m_cacheLoadStartedCV;
-#endif
-
         shared_ptr<int>                                     m_objLifetimeToken;
 
     public:
@@ -260,19 +196,15 @@ namespace Vanilla
         ~vaDirectX12ShaderManager( );
 
     public:
-        shared_ptr<vaShaderDataDX12>FindInCache( vaShaderCacheKey12 & key, bool & foundButModified );
-        void                        AddToCache( vaShaderCacheKey12 & key, const shared_ptr<vaShaderDataDX12> & shaderBlob, std::vector<vaShaderCacheEntry12::FileDependencyInfo> & dependencies );
+        // m_cache (vaShaderCache) wrappers; no-ops if persistent storage is disabled
+        shared_ptr<vaShaderDataDX12>FindInCache( const vaShaderCacheKey & key, bool & foundButModified );
+        void                        AddToCache( const vaShaderCacheKey & key, const shared_ptr<vaShaderDataDX12> & shaderBlob, const std::vector<vaShaderCache::Dependency> & dependencies );
         void                        ClearCache( );
 
         // pushBack (searched last) or pushFront (searched first)
         virtual void                RegisterShaderSearchPath( const std::wstring & path, bool pushBack = true )     override;
         virtual wstring             FindShaderFile( const wstring & fileName )                                      override;
-        virtual wstring             GetCacheStoragePath( ) const override                                           { return m_cacheFilePath; }
-
-    private:
-        void                        ClearCacheInternal( );          // will not lock m_cacheMutex - has to be done before calling!!
-        void                        LoadCacheInternal( );           // will not lock m_cacheMutex - has to be done before calling!!
-        void                        SaveCacheInternal( ) const;     // will not lock m_cacheMutex - has to be done before calling!!
+        virtual wstring             GetCacheStoragePath( ) const override                                           { return ( m_cache != nullptr ) ? ( m_cache->GetDirectory( ) ) : ( L"" ); }
     };
 
     inline vaShader::State          vaShaderDX12::GetShader( vaFramePtr<vaShaderDataDX12> & outData, int64 & outUniqueContentsID )
@@ -0,0 +1,1178 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation 
+// 
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// XeGTAO is based on GTAO/GTSO "Jimenez et al. / Practical Real-Time Strategies for Accurate Indirect Occlusion", 
+// https://www.activision.com/cdn/research/Practical_Real_Time_Strategies_for_Accurate_Indirect_Occlusion_NEW%20VERSION_COLOR.pdf
+// 
+// Implementation:  Filip Strugar (filip.strugar@intel.com), Steve Mccalla <stephen.mccalla@intel.com>         (\_/)
+// Version:         (see XeGTAO.h)                                                                            (='.'=)
+// Details:         https://github.com/GameTechDev/XeGTAO                                                     (")_(")
+//
+// Version history: see XeGTAO.h
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "vaGTAOCPU.h"
+
+#include "Core/vaProfiler.h"
+
+#ifdef VA_TASKFLOW_INTEGRATION_ENABLED
+#include "IntegratedExternals/vaTaskflowIntegration.h"
+#endif
+
+#include <xmmintrin.h>
+#include <smmintrin.h>
+
+using namespace Vanilla;
+
+namespace
+{
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Minimal 4-wide SSE float type. Every operation here has a 'float' overload that does exactly the same IEEE operation
+    // so that the kernels below can be written once (templated on the lane type) and the scalar path can be used as a
+    // reference for the SIMD one.
+    struct vfloat4
+    {
+        __m128                  v;
+
+        vfloat4( )                                                      { }
+        vfloat4( __m128 _v )                                            : v( _v ) { }
+        vfloat4( float s )                                              : v( _mm_set1_ps( s ) ) { }
+    };
+    struct vmask4
+    {
+        __m128                  v;
+    };
+
+    inline vfloat4  operator + ( const vfloat4 & a, const vfloat4 & b )         { return _mm_add_ps( a.v, b.v ); }
+    inline vfloat4  operator - ( const vfloat4 & a, const vfloat4 & b )         { return _mm_sub_ps( a.v, b.v ); }
+    inline vfloat4  operator * ( const vfloat4 & a, const vfloat4 & b )         { return _mm_mul_ps( a.v, b.v ); }
+    inline vfloat4  operator / ( const vfloat4 & a, const vfloat4 & b )         { return _mm_div_ps( a.v, b.v ); }
+    inline vfloat4  operator - ( const vfloat4 & a )                            { return _mm_xor_ps( a.v, _mm_set1_ps( -0.0f ) ); }
+    inline vfloat4 &operator += ( vfloat4 & a, const vfloat4 & b )              { a.v = _mm_add_ps( a.v, b.v ); return a; }
+    inline vfloat4 &operator *= ( vfloat4 & a, const vfloat4 & b )              { a.v = _mm_mul_ps( a.v, b.v ); return a; }
+    inline vfloat4 &operator /= ( vfloat4 & a, const vfloat4 & b )              { a.v = _mm_div_ps( a.v, b.v ); return a; }
+    inline vmask4   operator <  ( const vfloat4 & a, const vfloat4 & b )        { return { _mm_cmplt_ps( a.v, b.v ) }; }
+    inline vmask4   operator >  ( const vfloat4 & a, const vfloat4 & b )        { return { _mm_cmpgt_ps( a.v, b.v ) }; }
+    inline vmask4   operator >= ( const vfloat4 & a, const vfloat4 & b )        { return { _mm_cmpge_ps( a.v, b.v ) }; }
+    inline vmask4   operator == ( const vfloat4 & a, const vfloat4 & b )        { return { _mm_cmpeq_ps( a.v, b.v ) }; }
+
+    inline vfloat4  Select( const vmask4 & m, const vfloat4 & a, const vfloat4 & b ) { return _mm_blendv_ps( b.v, a.v, m.v ); }
+    inline float    Select( bool m, float a, float b )                          { return (m)?(a):(b); }
+
+    inline vfloat4  Min( const vfloat4 & a, const vfloat4 & b )                 { return _mm_min_ps( a.v, b.v ); }
+    inline float    Min( float a, float b )                                     { return (a < b)?(a):(b); }     // same as _mm_min_ps
+    inline vfloat4  Max( const vfloat4 & a, const vfloat4 & b )                 { return _mm_max_ps( a.v, b.v ); }
+    inline float    Max( float a, float b )                                     { return (a > b)?(a):(b); }     // same as _mm_max_ps
+    inline vfloat4  Abs( const vfloat4 & a )                                    { return _mm_andnot_ps( _mm_set1_ps( -0.0f ), a.v ); }
+    inline float    Abs( float a )                                              { return std::fabs( a ); }
+    inline vfloat4  Sqrt( const vfloat4 & a )                                   { return _mm_sqrt_ps( a.v ); }
+    inline float    Sqrt( float a )                                             { return std::sqrt( a ); }
+    inline vfloat4  Floor( const vfloat4 & a )                                  { return _mm_floor_ps( a.v ); }
+    inline float    Floor( float a )                                            { return std::floor( a ); }
+    inline vfloat4  Round( const vfloat4 & a )                                  { return _mm_round_ps( a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC ); }
+    inline float    Round( float a )                                            { return std::nearbyint( a ); } // round half to even, same as HLSL round( )
+
+    inline uint32   AsUInt( float a )                                           { uint32 r; memcpy( &r, &a, sizeof( r ) ); return r; }
+    inline float    AsFloat( uint32 a )                                         { float r; memcpy( &r, &a, sizeof( r ) ); return r; }
+
+    // XeGTAO_FastSqrt
+    inline vfloat4  FastSqrt( const vfloat4 & x )                               { return _mm_castsi128_ps( _mm_add_epi32( _mm_set1_epi32( 0x1fbd1df5 ), _mm_srai_epi32( _mm_castps_si128( x.v ), 1 ) ) ); }
+    inline float    FastSqrt( float x )                                         { return AsFloat( (uint32)( 0x1fbd1df5 + ( (int32)AsUInt( x ) >> 1 ) ) ); }
+
+    // split a positive normal float into [0.5, 1) mantissa and exponent, like frexp
+    inline vfloat4  Frexp( const vfloat4 & x, vfloat4 & outExp )
+    {
+        __m128i bits = _mm_castps_si128( x.v );
+        outExp = _mm_cvtepi32_ps( _mm_sub_epi32( _mm_and_si128( _mm_srli_epi32( bits, 23 ), _mm_set1_epi32( 0xff ) ), _mm_set1_epi32( 126 ) ) );
+        return _mm_castsi128_ps( _mm_or_si128( _mm_and_si128( bits, _mm_set1_epi32( (int)0x807fffff ) ), _mm_set1_epi32( 0x3f000000 ) ) );
+    }
+    inline float    Frexp( float x, float & outExp )
+    {
+        uint32 bits = AsUInt( x );
+        outExp = (float)( (int32)( ( bits >> 23 ) & 0xff ) - 126 );
+        return AsFloat( ( bits & 0x807fffff ) | 0x3f000000 );
+    }
+    // 2^n for integer n in [-126, 127]
+    inline vfloat4  Exp2Int( const vfloat4 & n )                                { return _mm_castsi128_ps( _mm_slli_epi32( _mm_add_epi32( _mm_cvttps_epi32( n.v ), _mm_set1_epi32( 127 ) ), 23 ) ); }
+    inline float    Exp2Int( float n )                                          { return AsFloat( (uint32)( (int32)n + 127 ) << 23 ); }
+
+    template< typename F > struct Lanes;
+    template< > struct Lanes<float>
+    {
+        static const int        Count = 1;
+        static float            Load( const float * src )                       { return src[0]; }
+        static void             Store( const float & value, float * dst )       { dst[0] = value; }
+    };
+    template< > struct Lanes<vfloat4>
+    {
+        static const int        Count = 4;
+        static vfloat4          Load( const float * src )                       { return _mm_loadu_ps( src ); }
+        static void             Store( const vfloat4 & value, float * dst )     { _mm_storeu_ps( dst, value.v ); }
+    };
+
+    template< typename F >
+    struct V3
+    {
+        F   x, y, z;
+
+        V3( )                                                                   { }
+        V3( const F & _x, const F & _y, const F & _z ) : x( _x ), y( _y ), z( _z ) { }
+
+        friend V3   operator + ( const V3 & a, const V3 & b )                   { return V3( a.x + b.x, a.y + b.y, a.z + b.z ); }
+        friend V3   operator - ( const V3 & a, const V3 & b )                   { return V3( a.x - b.x, a.y - b.y, a.z - b.z ); }
+        friend V3   operator - ( const V3 & a )                                 { return V3( -a.x, -a.y, -a.z ); }
+        friend V3   operator * ( const V3 & a, const F & b )                    { return V3( a.x * b, a.y * b, a.z * b ); }
+        friend V3   operator * ( const F & a, const V3 & b )                    { return V3( a * b.x, a * b.y, a * b.z ); }
+        friend V3   operator / ( const V3 & a, const F & b )                    { return V3( a.x / b, a.y / b, a.z / b ); }
+        friend F    Dot( const V3 & a, const V3 & b )                           { return a.x * b.x + a.y * b.y + a.z * b.z; }
+        friend V3   Cross( const V3 & a, const V3 & b )                         { return V3( a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x ); }
+        friend F    Length( const V3 & a )                                      { return Sqrt( Dot( a, a ) ); }
+        friend V3   Normalize( const V3 & a )                                   { return a / Length( a ); }
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Per-Compute constants derived from GTAOConstants, same as the ones computed in-shader
+    struct PassConstants
+    {
+        XeGTAO::GTAOConstants   Consts;
+        int                     SliceCount;
+        int                     StepsPerSlice;
+        bool                    UseDefaultConstants;                // see XE_GTAO_USE_DEFAULT_CONSTANTS
+
+        // XeGTAO_MainPass
+        float                   EffectRadius;
+        float                   SampleDistributionPower;
+        float                   ThinOccluderCompensation;
+        float                   FalloffMul;
+        float                   FalloffAdd;
+        float                   MIPThresholdsSq[XE_GTAO_DEPTH_MIP_LEVELS];  // squared sample offset length (in pixels) from which the MIP is used
+
+        // XeGTAO_DepthMIPFilter
+        float                   MIPFilterFalloffMul;
+        float                   MIPFilterFalloffAdd;
+
+        PassConstants( const XeGTAO::GTAOConstants & consts, const XeGTAO::GTAOSettings & settings )
+        {
+            Consts = consts;
+
+            // same as vaGTAO CSGTAOLow/CSGTAOMedium/CSGTAOHigh/CSGTAOUltra
+            const int sliceCounts[]     = { 1, 2, 3, 9 };
+            const int stepsPerSlice[]   = { 2, 2, 3, 3 };
+            const int qualityLevel      = XeGTAO::clamp( settings.QualityLevel, 0, 3 );
+            SliceCount                  = sliceCounts[qualityLevel];
+            StepsPerSlice               = stepsPerSlice[qualityLevel];
+
+            // same as in vaGTAO::UpdateTexturesAndShaders
+            UseDefaultConstants =  ( settings.RadiusMultiplier         == XE_GTAO_DEFAULT_RADIUS_MULTIPLIER           )
+                                && ( settings.SampleDistributionPower  == XE_GTAO_DEFAULT_SAMPLE_DISTRIBUTION_POWER   )
+                                && ( settings.FalloffRange             == XE_GTAO_DEFAULT_FALLOFF_RANGE               )
+                                && ( settings.ThinOccluderCompensation == XE_GTAO_DEFAULT_THIN_OCCLUDER_COMPENSATION  )
+                                && ( settings.FinalValuePower          == XE_GTAO_DEFAULT_FINAL_VALUE_POWER           );
+
+            if( UseDefaultConstants )
+            {
+                EffectRadius                = consts.EffectRadius * XE_GTAO_DEFAULT_RADIUS_MULTIPLIER;
+                SampleDistributionPower     = XE_GTAO_DEFAULT_SAMPLE_DISTRIBUTION_POWER;
+                ThinOccluderCompensation    = XE_GTAO_DEFAULT_THIN_OCCLUDER_COMPENSATION;
+            }
+            else
+            {
+                EffectRadius                = consts.EffectRadius * consts.RadiusMultiplier;
+                SampleDistributionPower     = consts.SampleDistributionPower;
+                ThinOccluderCompensation    = consts.ThinOccluderCompensation;
+            }
+            const float falloffRange        = ( (UseDefaultConstants)?(XE_GTAO_DEFAULT_FALLOFF_RANGE):(consts.EffectFalloffRange) ) * EffectRadius;
+            const float falloffFrom         = EffectRadius * ( 1.0f - consts.EffectFalloffRange );
+            FalloffMul                      = -1.0f / falloffRange;
+            FalloffAdd                      = falloffFrom / falloffRange + 1.0f;
+
+            // Point MIP filter picks round( clamp( log2( sampleOffsetLength ) - DepthMIPSamplingOffset, 0, XE_GTAO_DEPTH_MIP_LEVELS ) ),
+            // which is the same as comparing squared length against 2^( 2 * ( mip - 0.5 + DepthMIPSamplingOffset ) ) - no log2 needed.
+            for( int mip = 0; mip < XE_GTAO_DEPTH_MIP_LEVELS; mip++ )
+                MIPThresholdsSq[mip] = (mip == 0)?(0.0f):((float)std::exp2( 2.0 * ( mip - 0.5 + consts.DepthMIPSamplingOffset ) ));
+
+            const float depthRangeScaleFactor   = 0.75f;
+            const float mipEffectRadius         = depthRangeScaleFactor * consts.EffectRadius * ( (UseDefaultConstants)?(XE_GTAO_DEFAULT_RADIUS_MULTIPLIER):(consts.RadiusMultiplier) );
+            const float mipFalloffRange         = ( (UseDefaultConstants)?(XE_GTAO_DEFAULT_FALLOFF_RANGE):(consts.EffectFalloffRange) ) * mipEffectRadius;
+            const float mipFalloffFrom          = mipEffectRadius * ( 1.0f - consts.EffectFalloffRange );
+            MIPFilterFalloffMul                 = -1.0f / mipFalloffRange;
+            MIPFilterFalloffAdd                 = mipFalloffFrom / mipFalloffRange + 1.0f;
+        }
+    };
+
+    struct DepthMIPs
+    {
+        float *                 Data;
+        const int *             Offsets;
+        const vaVector2i *      Sizes;
+    };
+
+    // XeGTAO::HilbertIndex for a 64x64 area - same as the vaGTAO Hilbert LUT texture
+    const uint16 * HilbertLUT( )
+    {
+        static const std::vector<uint16> lut = [ ]( )
+        {
+            std::vector<uint16> ret( XE_HILBERT_WIDTH * XE_HILBERT_WIDTH );
+            for( uint32 y = 0; y < XE_HILBERT_WIDTH; y++ )
+                for( uint32 x = 0; x < XE_HILBERT_WIDTH; x++ )
+                    ret[ y * XE_HILBERT_WIDTH + x ] = (uint16)XeGTAO::HilbertIndex( x, y );
+            return ret;
+        } ( );
+        return lut.data( );
+    }
+
+    // [0, 255] -> [0, 1] UNORM decode, as in XeGTAO_R8G8B8A8_UNORM_to_FLOAT4
+    const float * UNORM8LUT( )
+    {
+        static const std::vector<float> lut = [ ]( )
+        {
+            std::vector<float> ret( 256 );
+            for( int i = 0; i < 256; i++ )
+                ret[i] = (float)i / 255.0f;
+            return ret;
+        } ( );
+        return lut.data( );
+    }
+
+    // XeGTAO_UnpackEdges for all 256 packed values, 4 floats (LRTB) each
+    const float * UnpackedEdgesLUT( )
+    {
+        static const std::vector<float> lut = [ ]( )
+        {
+            std::vector<float> ret( 256 * 4 );
+            for( uint32 i = 0; i < 256; i++ )
+            {
+                ret[i * 4 + 0] = (float)( ( i >> 6 ) & 0x03 ) / 3.0f;
+                ret[i * 4 + 1] = (float)( ( i >> 4 ) & 0x03 ) / 3.0f;
+                ret[i * 4 + 2] = (float)( ( i >> 2 ) & 0x03 ) / 3.0f;
+                ret[i * 4 + 3] = (float)( ( i >> 0 ) & 0x03 ) / 3.0f;
+            }
+            return ret;
+        } ( );
+        return lut.data( );
+    }
+
+    inline uint32 FLOAT4_to_R8G8B8A8_UNORM( float x, float y, float z, float w )
+    {
+        return  ( (uint32)( Min( Max( x, 0.0f ), 1.0f ) * 255.0f + 0.5f )       ) |
+                ( (uint32)( Min( Max( y, 0.0f ), 1.0f ) * 255.0f + 0.5f ) << 8  ) |
+                ( (uint32)( Min( Max( z, 0.0f ), 1.0f ) * 255.0f + 0.5f ) << 16 ) |
+                ( (uint32)( Min( Max( w, 0.0f ), 1.0f ) * 255.0f + 0.5f ) << 24 );
+    }
+
+    inline uint32 FLOAT3_to_R11G11B10_UNORM( float x, float y, float z )
+    {
+        return  ( (uint32)( Min( Max( x, 0.0f ), 1.0f ) * 2047.0f + 0.5f )       ) |
+                ( (uint32)( Min( Max( y, 0.0f ), 1.0f ) * 2047.0f + 0.5f ) << 11 ) |
+                ( (uint32)( Min( Max( z, 0.0f ), 1.0f ) * 1023.0f + 0.5f ) << 22 );
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Ports of XeGTAO.hlsli functions; F is either 'float' (scalar reference path) or 'vfloat4' (SIMD path, 4 horizontally
+    // adjacent pixels at a time).
+    template< typename F >
+    struct XeGTAOKernels
+    {
+        static const int    c_lanes     = Lanes<F>::Count;
+
+        static F            Saturate( const F & x )                             { return Min( Max( x, F( 0.0f ) ), F( 1.0f ) ); }
+        static F            Lerp( const F & a, const F & b, const F & t )       { return a + t * ( b - a ); }
+        static F            Frac( const F & x )                                 { return x - Floor( x ); }
+        static F            Sign( const F & x )                                 { return Select( x > F( 0.0f ), F( 1.0f ), Select( x < F( 0.0f ), F( -1.0f ), F( 0.0f ) ) ); }
+
+        // Cody-Waite reduction to [-PI/4, PI/4] followed by minimax polynomials (from Cephes sinf/cosf); ~1e-7 abs error in the range used here
+        static void         SinCos( const F & x, F & outSin, F & outCos )
+        {
+            const F j   = Round( x * 0.63661977236758134308f );
+            const F r   = ( ( x - j * 1.5703125f ) - j * 4.837512969970703125e-4f ) - j * 7.54978995489188216e-8f;
+            const F q   = j - Floor( j * 0.25f ) * 4.0f;           // quadrant, [0, 3]
+            const F z   = r * r;
+            const F sr  = r + r * z * ( ( -1.9515295891e-4f * z + 8.3321608736e-3f ) * z - 1.6666654611e-1f );
+            const F cr  = ( 1.0f - 0.5f * z ) + z * z * ( ( 2.443315711809948e-5f * z - 1.388731625493765e-3f ) * z + 4.166664568298827e-2f );
+            const auto odd = Abs( q - 2.0f ) == F( 1.0f );
+            const F s   = Select( odd, cr, sr );
+            const F c   = Select( odd, sr, cr );
+            outSin      = Select( q >= F( 2.0f ), -s, s );
+            outCos      = Select( Abs( q - 1.5f ) < F( 1.0f ), -c, c );
+        }
+        static F            Sin( const F & x )                                  { F s, c; SinCos( x, s, c ); return s; }
+        static F            Cos( const F & x )                                  { F s, c; SinCos( x, s, c ); return c; }
+
+        // Cephes logf/exp2f based
+        static F            Log2( const F & x )
+        {
+            F e;
+            F m = Frexp( x, e );
+            const auto belowSqrtHalf = m < F( 0.707106781186547524f );
+            e   = Select( belowSqrtHalf, e - 1.0f, e );
+            m   = Select( belowSqrtHalf, m + m - 1.0f, m - 1.0f );
+            const F z = m * m;
+            F y = ( ( ( ( ( ( ( ( 7.0376836292e-2f * m - 1.1514610310e-1f ) * m + 1.1676998740e-1f ) * m - 1.2420140846e-1f ) * m + 1.4249322787e-1f ) * m - 1.6668057665e-1f ) * m + 2.0000714765e-1f ) * m - 2.4999993993e-1f ) * m + 3.3333331174e-1f ) * m * z;
+            y   = y - 0.5f * z;
+            return ( m + y ) * 1.44269504088896340736f + e;
+        }
+        static F            Exp2( const F & _x )
+        {
+            const F x   = Min( Max( _x, F( -126.0f ) ), F( 126.0f ) );
+            const F n   = Floor( x + 0.5f );
+            const F f   = x - n;
+            const F p   = ( ( ( ( ( 1.535336188319500e-4f * f + 1.339887440266574e-3f ) * f + 9.618437357674640e-3f ) * f + 5.550332471162809e-2f ) * f + 2.402264791363012e-1f ) * f + 6.931472028550421e-1f ) * f + 1.0f;
+            return p * Exp2Int( n );
+        }
+        // HLSL pow( x, y ) for x >= 0
+        static F            Pow( const F & x, const F & y )                     { return Select( x > F( 0.0f ), Exp2( y * Log2( Max( x, F( 1e-30f ) ) ) ), F( 0.0f ) ); }
+
+        // XeGTAO_FastACos
+        static F            FastACos( const F & inX )
+        {
+            const F x   = Abs( inX );
+            F res       = -0.156583f * x + 1.570796f;
+            res         = res * FastSqrt( 1.0f - x );
+            return Select( inX >= F( 0.0f ), res, 3.141593f - res );
+        }
+
+        // XeGTAO_ComputeViewspacePosition
+        static V3<F>        ComputeViewspacePosition( const PassConstants & pc, const F & screenPosX, const F & screenPosY, const F & viewspaceDepth )
+        {
+            return V3<F>( ( pc.Consts.NDCToViewMul.x * screenPosX + pc.Consts.NDCToViewAdd.x ) * viewspaceDepth,
+                          ( pc.Consts.NDCToViewMul.y * screenPosY + pc.Consts.NDCToViewAdd.y ) * viewspaceDepth, viewspaceDepth );
+        }
+
+        // XeGTAO_ScreenSpaceToViewSpaceDepth
+        static F            ScreenSpaceToViewSpaceDepth( const PassConstants & pc, const F & screenDepth )
+        {
+            return pc.Consts.DepthUnpackConsts.x / ( pc.Consts.DepthUnpackConsts.y - screenDepth );
+        }
+
+        // XeGTAO_ClampDepth - note: the shader uses '#ifdef XE_GTAO_USE_HALF_FLOAT_PRECISION', which is always defined, so the 65504 clamp applies to all paths
+        static F            ClampDepth( const F & depth )                       { return Min( Max( depth, F( 0.0f ) ), F( 65504.0f ) ); }
+
+        // XeGTAO_CalculateEdges
+        static void         CalculateEdges( const F & centerZ, const F & leftZ, const F & rightZ, const F & topZ, const F & bottomZ, F outEdgesLRTB[4] )
+        {
+            F edgesLRTB[4]  = { leftZ - centerZ, rightZ - centerZ, topZ - centerZ, bottomZ - centerZ };
+            const F slopeLR = ( edgesLRTB[1] - edgesLRTB[0] ) * 0.5f;
+            const F slopeTB = ( edgesLRTB[3] - edgesLRTB[2] ) * 0.5f;
+            const F edgesLRTBSlopeAdjusted[4] = { edgesLRTB[0] + slopeLR, edgesLRTB[1] - slopeLR, edgesLRTB[2] + slopeTB, edgesLRTB[3] - slopeTB };
+            for( int i = 0; i < 4; i++ )
+            {
+                edgesLRTB[i]        = Min( Abs( edgesLRTB[i] ), Abs( edgesLRTBSlopeAdjusted[i] ) );
+                outEdgesLRTB[i]     = Saturate( 1.25f - edgesLRTB[i] / ( centerZ * 0.011f ) );
+            }
+        }
+
+        // XeGTAO_PackEdges, except it returns the R8_UNORM stored value in [0, 255] instead of [0, 1]
+        static F            PackEdges( const F edgesLRTB[4] )
+        {
+            return Round( Saturate( edgesLRTB[0] ) * 2.9f ) * 64.0f + Round( Saturate( edgesLRTB[1] ) * 2.9f ) * 16.0f
+                 + Round( Saturate( edgesLRTB[2] ) * 2.9f ) * 4.0f  + Round( Saturate( edgesLRTB[3] ) * 2.9f );
+        }
+
+        // XeGTAO_DepthMIPFilter
+        static F            DepthMIPFilter( const PassConstants & pc, const F & depth0, const F & depth1, const F & depth2, const F & depth3 )
+        {
+            const F maxDepth    = Max( Max( depth0, depth1 ), Max( depth2, depth3 ) );
+            const F weight0     = Saturate( ( maxDepth - depth0 ) * pc.MIPFilterFalloffMul + pc.MIPFilterFalloffAdd );
+            const F weight1     = Saturate( ( maxDepth - depth1 ) * pc.MIPFilterFalloffMul + pc.MIPFilterFalloffAdd );
+            const F weight2     = Saturate( ( maxDepth - depth2 ) * pc.MIPFilterFalloffMul + pc.MIPFilterFalloffAdd );
+            const F weight3     = Saturate( ( maxDepth - depth3 ) * pc.MIPFilterFalloffMul + pc.MIPFilterFalloffAdd );
+            const F weightSum   = weight0 + weight1 + weight2 + weight3;
+            return ( weight0 * depth0 + weight1 * depth1 + weight2 * depth2 + weight3 * depth3 ) / weightSum;
+        }
+
+        // "mul( XeGTAO_RotFromToMatrix( from, to ), v )" for the from == {0, 0, -1} case used by the bent normals
+        static V3<F>        RotateFromNegZTo( const V3<F> & to, const V3<F> & v )
+        {
+            const V3<F> from( 0.0f, 0.0f, -1.0f );
+            const F e       = Dot( from, to );
+            const F f       = Abs( e );
+            const V3<F> c   = Cross( from, to );
+            const F h       = 1.0f / ( 1.0f + e );
+            const F hvx     = h * c.x;
+            const F hvz     = h * c.z;
+            const F hvxy    = hvx * c.y;
+            const F hvxz    = hvx * c.z;
+            const F hvyz    = hvz * c.y;
+
+            const V3<F> row0( e + hvx * c.x, hvxy - c.z, hvxz + c.y );
+            const V3<F> row1( hvxy + c.z, e + h * c.y * c.y, hvyz - c.x );
+            const V3<F> row2( hvxz - c.y, hvyz + c.x, e + hvz * c.z );
+
+            const auto identity = f > F( 0.9997f );
+            return V3<F>( Select( identity, v.x, Dot( row0, v ) ), Select( identity, v.y, Dot( row1, v ) ), Select( identity, v.z, Dot( row2, v ) ) );
+        }
+
+        // gather-free point-clamp 'SampleLevel' on the viewspace depth MIP chain
+        static F            SampleDepth( const PassConstants & pc, const DepthMIPs & depths, const F & u, const F & v, const F & offsetLengthSq )
+        {
+            F mip   = 0.0f;
+            F mipW  = (float)depths.Sizes[0].x;
+            F mipH  = (float)depths.Sizes[0].y;
+            for( int m = 1; m < XE_GTAO_DEPTH_MIP_LEVELS; m++ )
+            {
+                const auto useMIP = offsetLengthSq >= F( pc.MIPThresholdsSq[m] );
+                mip     = Select( useMIP, F( (float)m ), mip );
+                mipW    = Select( useMIP, F( (float)depths.Sizes[m].x ), mipW );
+                mipH    = Select( useMIP, F( (float)depths.Sizes[m].y ), mipH );
+            }
+            const F tx  = Min( Max( Floor( u * mipW ), F( 0.0f ) ), mipW - 1.0f );
+            const F ty  = Min( Max( Floor( v * mipH ), F( 0.0f ) ), mipH - 1.0f );
+
+            float mipA[c_lanes], txA[c_lanes], tyA[c_lanes], ret[c_lanes];
+            Lanes<F>::Store( mip, mipA ); Lanes<F>::Store( tx, txA ); Lanes<F>::Store( ty, tyA );
+            for( int i = 0; i < c_lanes; i++ )
+            {
+                const int m = (int)mipA[i];
+                ret[i] = depths.Data[ depths.Offsets[m] + (int)tyA[i] * depths.Sizes[m].x + (int)txA[i] ];
+            }
+            return Lanes<F>::Load( ret );
+        }
+
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // XeGTAO_ComputeViewspaceNormal + CSGenerateNormals packing
+        static void         GenerateNormals( const PassConstants & pc, const float * ndcDepth, int x, int y, int toX, uint32 * outNormals )
+        {
+            const int width = pc.Consts.ViewportSize.x; const int height = pc.Consts.ViewportSize.y;
+            float zC[c_lanes], zL[c_lanes], zR[c_lanes], zT[c_lanes], zB[c_lanes], px[c_lanes];
+            const float * rowC = ndcDepth + y * width;
+            const float * rowT = ndcDepth + std::max( y - 1, 0 ) * width;
+            const float * rowB = ndcDepth + std::min( y + 1, height - 1 ) * width;
+            for( int i = 0; i < c_lanes; i++ )
+            {
+                const int cx = std::min( x + i, width - 1 );
+                zC[i] = rowC[cx]; zT[i] = rowT[cx]; zB[i] = rowB[cx];
+                zL[i] = rowC[std::max( cx - 1, 0 )]; zR[i] = rowC[std::min( cx + 1, width - 1 )];
+                px[i] = (float)( x + i );
+            }
+
+            const F screenPosX  = ( Lanes<F>::Load( px ) + 0.5f ) * pc.Consts.ViewportPixelSize.x;
+            const F screenPosY  = ( (float)y + 0.5f ) * pc.Consts.ViewportPixelSize.y;
+
+            const F viewspaceZ  = ScreenSpaceToViewSpaceDepth( pc, Lanes<F>::Load( zC ) );
+            const F pixLZ       = ScreenSpaceToViewSpaceDepth( pc, Lanes<F>::Load( zL ) );
+            const F pixTZ       = ScreenSpaceToViewSpaceDepth( pc, Lanes<F>::Load( zT ) );
+            const F pixRZ       = ScreenSpaceToViewSpaceDepth( pc, Lanes<F>::Load( zR ) );
+            const F pixBZ       = ScreenSpaceToViewSpaceDepth( pc, Lanes<F>::Load( zB ) );
+
+            F edgesLRTB[4];
+            CalculateEdges( viewspaceZ, pixLZ, pixRZ, pixTZ, pixBZ, edgesLRTB );
+
+            const V3<F> pixCenterPos = ComputeViewspacePosition( pc, screenPosX, screenPosY, viewspaceZ );
+            V3<F> pixLPos = ComputeViewspacePosition( pc, screenPosX - pc.Consts.ViewportPixelSize.x, screenPosY, pixLZ );
+            V3<F> pixRPos = ComputeViewspacePosition( pc, screenPosX + pc.Consts.ViewportPixelSize.x, screenPosY, pixRZ );
+            V3<F> pixTPos = ComputeViewspacePosition( pc, screenPosX, screenPosY - pc.Consts.ViewportPixelSize.y, pixTZ );
+            V3<F> pixBPos = ComputeViewspacePosition( pc, screenPosX, screenPosY + pc.Consts.ViewportPixelSize.y, pixBZ );
+
+            // XeGTAO_CalculateNormal
+            const F acceptedNormals[4] = {  Saturate( edgesLRTB[0] * edgesLRTB[2] + 0.01f ), Saturate( edgesLRTB[2] * edgesLRTB[1] + 0.01f ),
+                                            Saturate( edgesLRTB[1] * edgesLRTB[3] + 0.01f ), Saturate( edgesLRTB[3] * edgesLRTB[0] + 0.01f ) };
+            pixLPos = Normalize( pixLPos - pixCenterPos );
+            pixRPos = Normalize( pixRPos - pixCenterPos );
+            pixTPos = Normalize( pixTPos - pixCenterPos );
+            pixBPos = Normalize( pixBPos - pixCenterPos );
+            V3<F> pixelNormal = acceptedNormals[0] * Cross( pixLPos, pixTPos ) + acceptedNormals[1] * Cross( pixTPos, pixRPos )
+                              + acceptedNormals[2] * Cross( pixRPos, pixBPos ) + acceptedNormals[3] * Cross( pixBPos, pixLPos );
+            pixelNormal = Normalize( pixelNormal );
+
+            float nx[c_lanes], ny[c_lanes], nz[c_lanes];
+            Lanes<F>::Store( pixelNormal.x * 0.5f + 0.5f, nx ); Lanes<F>::Store( pixelNormal.y * 0.5f + 0.5f, ny ); Lanes<F>::Store( pixelNormal.z * 0.5f + 0.5f, nz );
+            for( int i = 0; i < c_lanes && x + i < toX; i++ )
+                outNormals[ y * width + x + i ] = FLOAT3_to_R11G11B10_UNORM( nx[i], ny[i], nz[i] );
+        }
+
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // XeGTAO_PrefilterDepths16x16 for one thread group; the 'threads' of a row are processed c_lanes at a time for MIP 0
+        // and 1 with the groupshared scratch and the lower MIPs handled in scalar (same for both paths)
+        static void         PrefilterDepths16x16( const PassConstants & pc, const float * ndcDepth, const DepthMIPs & depths, int groupX, int groupY )
+        {
+            const int width = pc.Consts.ViewportSize.x; const int height = pc.Consts.ViewportSize.y;
+            float scratchDepths[8][8];
+
+            for( int gy = 0; gy < 8; gy++ )
+            {
+                const int baseY = groupY * 8 + gy;
+                const int pixY  = baseY * 2;
+                const float * row0 = ndcDepth + std::min( pixY + 0, height - 1 ) * width;
+                const float * row1 = ndcDepth + std::min( pixY + 1, height - 1 ) * width;
+                for( int gx = 0; gx < 8; gx += c_lanes )
+                {
+                    float raw[4][c_lanes];
+                    for( int i = 0; i < c_lanes; i++ )
+                    {
+                        const int pixX  = ( groupX * 8 + gx + i ) * 2;
+                        const int x0    = std::min( pixX + 0, width - 1 );
+                        const int x1    = std::min( pixX + 1, width - 1 );
+                        raw[0][i] = row0[x0]; raw[1][i] = row0[x1]; raw[2][i] = row1[x0]; raw[3][i] = row1[x1];
+                    }
+                    F depth[4];
+                    float depthA[4][c_lanes];
+                    for( int k = 0; k < 4; k++ )
+                    {
+                        depth[k] = ClampDepth( ScreenSpaceToViewSpaceDepth( pc, Lanes<F>::Load( raw[k] ) ) );
+                        Lanes<F>::Store( depth[k], depthA[k] );
+                    }
+                    const F dm1 = DepthMIPFilter( pc, depth[0], depth[1], depth[2], depth[3] );
+                    float dm1A[c_lanes];
+                    Lanes<F>::Store( dm1, dm1A );
+
+                    for( int i = 0; i < c_lanes; i++ )
+                    {
+                        const int baseX = groupX * 8 + gx + i;
+                        const int pixX  = baseX * 2;
+                        for( int k = 0; k < 4; k++ )
+                        {
+                            const int ox = pixX + ( k & 1 ), oy = pixY + ( k >> 1 );
+                            if( ox < depths.Sizes[0].x && oy < depths.Sizes[0].y )
+                                depths.Data[ depths.Offsets[0] + oy * depths.Sizes[0].x + ox ] = depthA[k][i];
+                        }
+                        if( baseX < depths.Sizes[1].x && baseY < depths.Sizes[1].y )
+                            depths.Data[ depths.Offsets[1] + baseY * depths.Sizes[1].x + baseX ] = dm1A[i];
+                        scratchDepths[gx + i][gy] = dm1A[i];
+                    }
+                }
+            }
+
+            // MIPs 2, 3 and 4, in-place in the scratch just like the shader
+            for( int mip = 2; mip < XE_GTAO_DEPTH_MIP_LEVELS; mip++ )
+            {
+                const int step = 1 << ( mip - 1 );  // 2, 4, 8
+                const int half = step / 2;
+                for( int gy = 0; gy < 8; gy += step )
+                    for( int gx = 0; gx < 8; gx += step )
+                    {
+                        const float dm = XeGTAOKernels<float>::DepthMIPFilter( pc, scratchDepths[gx][gy], scratchDepths[gx + half][gy], scratchDepths[gx][gy + half], scratchDepths[gx + half][gy + half] );
+                        const int mx = ( groupX * 8 + gx ) / step;
+                        const int my = ( groupY * 8 + gy ) / step;
+                        if( mx < depths.Sizes[mip].x && my < depths.Sizes[mip].y )
+                            depths.Data[ depths.Offsets[mip] + my * depths.Sizes[mip].x + mx ] = dm;
+                        scratchDepths[gx][gy] = dm;
+                    }
+            }
+        }
+
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // XeGTAO_MainPass (with SpatioTemporalNoise and LoadNormal from vaGTAO.hlsl)
+        template< bool BentNormals >
+        static void         MainPass( const PassConstants & pc, const DepthMIPs & depths, const uint32 * normals, int x, int y, int toX, uint8 * outEdges, uint32 * outAOTerm )
+        {
+            const int width = pc.Consts.ViewportSize.x; const int height = pc.Consts.ViewportSize.y;
+            const float * mip0  = depths.Data + depths.Offsets[0];
+            const float * rowC  = mip0 + y * width;
+            const float * rowT  = mip0 + std::max( y - 1, 0 ) * width;
+            const float * rowB  = mip0 + std::min( y + 1, height - 1 ) * width;
+            const uint16 * hilbertLUT = HilbertLUT( );
+
+            float zC[c_lanes], zL[c_lanes], zR[c_lanes], zT[c_lanes], zB[c_lanes], px[c_lanes];
+            float nx[c_lanes], ny[c_lanes], nz[c_lanes], noiseSliceA[c_lanes], noiseSampleA[c_lanes];
+            for( int i = 0; i < c_lanes; i++ )
+            {
+                const int cx = std::min( x + i, width - 1 );
+                zC[i] = rowC[cx]; zT[i] = rowT[cx]; zB[i] = rowB[cx];
+                zL[i] = rowC[std::max( cx - 1, 0 )]; zR[i] = rowC[std::min( cx + 1, width - 1 )];
+                px[i] = (float)( x + i );
+
+                // XeGTAO_R11G11B10_UNORM_to_FLOAT3
+                const uint32 packedNormal = normals[ y * width + cx ];
+                nx[i] = (float)( ( packedNormal       ) & 0x000007ff ) / 2047.0f;
+                ny[i] = (float)( ( packedNormal >> 11 ) & 0x000007ff ) / 2047.0f;
+                nz[i] = (float)( ( packedNormal >> 22 ) & 0x000003ff ) / 1023.0f;
+
+                // Hilbert curve driving R2 (see https://www.shadertoy.com/view/3tB3z3)
+                const uint32 index = hilbertLUT[ ( y % XE_HILBERT_WIDTH ) * XE_HILBERT_WIDTH + ( cx % XE_HILBERT_WIDTH ) ] + 288 * ( pc.Consts.NoiseIndex % 64 );
+                noiseSliceA[i]  = XeGTAOKernels<float>::Frac( 0.5f + (float)index * 0.75487766624669276005f );
+                noiseSampleA[i] = XeGTAOKernels<float>::Frac( 0.5f + (float)index * 0.5698402909980532659114f );
+            }
+
+            const F normalizedScreenPosX    = ( Lanes<F>::Load( px ) + 0.5f ) * pc.Consts.ViewportPixelSize.x;
+            const F normalizedScreenPosY    = ( (float)y + 0.5f ) * pc.Consts.ViewportPixelSize.y;
+
+            F viewspaceZ    = Lanes<F>::Load( zC );
+
+            F edgesLRTB[4];
+            CalculateEdges( viewspaceZ, Lanes<F>::Load( zL ), Lanes<F>::Load( zR ), Lanes<F>::Load( zT ), Lanes<F>::Load( zB ), edgesLRTB );
+            {
+                float packedEdges[c_lanes];
+                Lanes<F>::Store( PackEdges( edgesLRTB ), packedEdges );
+                for( int i = 0; i < c_lanes && x + i < toX; i++ )
+                    outEdges[ y * width + x + i ] = (uint8)packedEdges[i];
+            }
+
+            const V3<F> viewspaceNormal = Normalize( V3<F>( Lanes<F>::Load( nx ) * 2.0f - 1.0f, Lanes<F>::Load( ny ) * 2.0f - 1.0f, Lanes<F>::Load( nz ) * 2.0f - 1.0f ) );
+
+            // Move center pixel slightly towards camera to avoid imprecision artifacts due to depth buffer imprecision (XE_GTAO_FP32_DEPTHS value)
+            viewspaceZ = viewspaceZ * 0.99999f;
+
+            const V3<F> pixCenterPos    = ComputeViewspacePosition( pc, normalizedScreenPosX, normalizedScreenPosY, viewspaceZ );
+            const V3<F> viewVec         = Normalize( -pixCenterPos );
+
+            const F falloffMul          = pc.FalloffMul;
+            const F falloffAdd          = pc.FalloffAdd;
+            const bool simpleFalloff    = pc.UseDefaultConstants;       // XE_GTAO_USE_DEFAULT_CONSTANTS != 0 && XE_GTAO_DEFAULT_THIN_OBJECT_HEURISTIC == 0
+
+            F visibility                = 0.0f;
+            V3<F> bentNormal            = (BentNormals)?(V3<F>( 0.0f, 0.0f, 0.0f )):(viewspaceNormal);
+
+            const F noiseSlice          = Lanes<F>::Load( noiseSliceA );
+            const F noiseSample         = Lanes<F>::Load( noiseSampleA );
+
+            const float pixelTooCloseThreshold  = 1.3f;
+
+            const F pixelDirRBViewspaceSizeAtCenterZX = viewspaceZ * pc.Consts.NDCToViewMul_x_PixelSize.x;
+            const F screenspaceRadius   = pc.EffectRadius / pixelDirRBViewspaceSizeAtCenterZX;
+
+            // fade out for small screen radii
+            visibility += Saturate( ( 10.0f - screenspaceRadius ) / 100.0f ) * 0.5f;
+
+            const F minS                = pixelTooCloseThreshold / screenspaceRadius;
+
+            const float sliceCount      = (float)pc.SliceCount;
+            const float stepsPerSlice   = (float)pc.StepsPerSlice;
+
+            for( int sliceI = 0; sliceI < pc.SliceCount; sliceI++ )
+            {
+                const float slice   = (float)sliceI;
+                const F sliceK      = ( slice + noiseSlice ) / sliceCount;
+                const F phi         = sliceK * 3.1415926535897932384626433832795f;
+                F sinPhi, cosPhi;
+                SinCos( phi, sinPhi, cosPhi );
+                const F omegaX      = cosPhi * screenspaceRadius;
+                const F omegaY      = -sinPhi * screenspaceRadius;
+
+                const V3<F> directionVec( cosPhi, sinPhi, 0.0f );
+                const V3<F> orthoDirectionVec   = directionVec - ( Dot( directionVec, viewVec ) * viewVec );
+                const V3<F> axisVec             = Normalize( Cross( orthoDirectionVec, viewVec ) );
+                const V3<F> projectedNormalVec  = viewspaceNormal - axisVec * Dot( viewspaceNormal, axisVec );
+                const F signNorm                = Sign( Dot( orthoDirectionVec, projectedNormalVec ) );
+                F projectedNormalVecLength      = Length( projectedNormalVec );
+                const F cosNorm                 = Saturate( Dot( projectedNormalVec, viewVec ) / projectedNormalVecLength );
+                const F n                       = signNorm * FastACos( cosNorm );
+
+                const F lowHorizonCos0          = Cos( n + 1.5707963267948966192313216916398f );
+                const F lowHorizonCos1          = Cos( n - 1.5707963267948966192313216916398f );
+
+                F horizonCos0                   = lowHorizonCos0;
+                F horizonCos1                   = lowHorizonCos1;
+
+                for( int stepI = 0; stepI < pc.StepsPerSlice; stepI++ )
+                {
+                    const float step            = (float)stepI;
+                    const float stepBaseNoise   = ( slice + step * stepsPerSlice ) * 0.6180339887498948482f;
+                    const F stepNoise           = Frac( noiseSample + stepBaseNoise );
+
+                    F s                         = ( step + stepNoise ) / stepsPerSlice;
+                    s                           = Pow( s, pc.SampleDistributionPower );
+                    s                           += minS;
+
+                    F sampleOffsetX             = s * omegaX;
+                    F sampleOffsetY             = s * omegaY;
+                    const F sampleOffsetLengthSq= sampleOffsetX * sampleOffsetX + sampleOffsetY * sampleOffsetY;
+
+                    sampleOffsetX               = Round( sampleOffsetX ) * pc.Consts.ViewportPixelSize.x;
+                    sampleOffsetY               = Round( sampleOffsetY ) * pc.Consts.ViewportPixelSize.y;
+
+                    const F sampleScreenPos0X   = normalizedScreenPosX + sampleOffsetX;
+                    const F sampleScreenPos0Y   = normalizedScreenPosY + sampleOffsetY;
+                    const F SZ0                 = SampleDepth( pc, depths, sampleScreenPos0X, sampleScreenPos0Y, sampleOffsetLengthSq );
+                    const V3<F> samplePos0      = ComputeViewspacePosition( pc, sampleScreenPos0X, sampleScreenPos0Y, SZ0 );
+
+                    const F sampleScreenPos1X   = normalizedScreenPosX - sampleOffsetX;
+                    const F sampleScreenPos1Y   = normalizedScreenPosY - sampleOffsetY;
+                    const F SZ1                 = SampleDepth( pc, depths, sampleScreenPos1X, sampleScreenPos1Y, sampleOffsetLengthSq );
+                    const V3<F> samplePos1      = ComputeViewspacePosition( pc, sampleScreenPos1X, sampleScreenPos1Y, SZ1 );
+
+                    const V3<F> sampleDelta0    = samplePos0 - pixCenterPos;
+                    const V3<F> sampleDelta1    = samplePos1 - pixCenterPos;
+                    const F sampleDist0         = Length( sampleDelta0 );
+                    const F sampleDist1         = Length( sampleDelta1 );
+
+                    const V3<F> sampleHorizonVec0 = sampleDelta0 / sampleDist0;
+                    const V3<F> sampleHorizonVec1 = sampleDelta1 / sampleDist1;
+
+                    F weight0, weight1;
+                    if( simpleFalloff )
+                    {
+                        weight0                 = Saturate( sampleDist0 * falloffMul + falloffAdd );
+                        weight1                 = Saturate( sampleDist1 * falloffMul + falloffAdd );
+                    }
+                    else
+                    {
+                        const F falloffBase0    = Length( V3<F>( sampleDelta0.x, sampleDelta0.y, sampleDelta0.z * ( 1.0f + pc.ThinOccluderCompensation ) ) );
+                        const F falloffBase1    = Length( V3<F>( sampleDelta1.x, sampleDelta1.y, sampleDelta1.z * ( 1.0f + pc.ThinOccluderCompensation ) ) );
+                        weight0                 = Saturate( falloffBase0 * falloffMul + falloffAdd );
+                        weight1                 = Saturate( falloffBase1 * falloffMul + falloffAdd );
+                    }
+
+                    F shc0                      = Dot( sampleHorizonVec0, viewVec );
+                    F shc1                      = Dot( sampleHorizonVec1, viewVec );
+
+                    shc0                        = Lerp( lowHorizonCos0, shc0, weight0 );
+                    shc1                        = Lerp( lowHorizonCos1, shc1, weight1 );
+
+                    horizonCos0                 = Max( horizonCos0, shc0 );
+                    horizonCos1                 = Max( horizonCos1, shc1 );
+                }
+
+                projectedNormalVecLength        = Lerp( projectedNormalVecLength, 1.0f, 0.05f );
+
+                const F h0                      = -FastACos( horizonCos1 );
+                const F h1                      = FastACos( horizonCos0 );
+                F sinN, cosN;
+                SinCos( n, sinN, cosN );
+                const F iarc0                   = ( cosNorm + 2.0f * h0 * sinN - Cos( 2.0f * h0 - n ) ) / 4.0f;
+                const F iarc1                   = ( cosNorm + 2.0f * h1 * sinN - Cos( 2.0f * h1 - n ) ) / 4.0f;
+                const F localVisibility         = projectedNormalVecLength * ( iarc0 + iarc1 );
+                visibility                      += localVisibility;
+
+                if( BentNormals )
+                {
+                    F sinH0mN, cosH0mN, sin3H0mN, cos3H0mN, sinH1mN, cosH1mN, sin3H1mN, cos3H1mN, sinH0pN, cosH0pN, sinH1pN, cosH1pN;
+                    SinCos( h0 - n, sinH0mN, cosH0mN );
+                    SinCos( 3.0f * h0 - n, sin3H0mN, cos3H0mN );
+                    SinCos( h1 - n, sinH1mN, cosH1mN );
+                    SinCos( 3.0f * h1 - n, sin3H1mN, cos3H1mN );
+                    SinCos( h0 + n, sinH0pN, cosH0pN );
+                    SinCos( h1 + n, sinH1pN, cosH1pN );
+                    const F t0 = ( 6.0f * sinH0mN - sin3H0mN + 6.0f * sinH1mN - sin3H1mN + 16.0f * sinN - 3.0f * ( sinH0pN + sinH1pN ) ) / 12.0f;
+                    const F t1 = ( -cos3H0mN - cos3H1mN + 8.0f * cosN - 3.0f * ( cosH0pN + cosH1pN ) ) / 12.0f;
+                    V3<F> localBentNormal( directionVec.x * t0, directionVec.y * t0, -t1 );
+                    localBentNormal = RotateFromNegZTo( viewVec, localBentNormal ) * projectedNormalVecLength;
+                    bentNormal = bentNormal + localBentNormal;
+                }
+            }
+            visibility /= sliceCount;
+            visibility = Pow( visibility, pc.Consts.FinalValuePower );
+            visibility = Max( F( 0.03f ), visibility );
+
+            if( BentNormals )
+                bentNormal = Normalize( bentNormal );
+
+            // XeGTAO_OutputWorkingTerm
+            visibility = Saturate( visibility / XE_GTAO_OCCLUSION_TERM_SCALE );
+            StoreAOTerm<BentNormals>( visibility, bentNormal, x, y, toX, width, outAOTerm );
+        }
+
+        template< bool BentNormals >
+        static void         StoreAOTerm( const F & visibility, const V3<F> & bentNormal, int x, int y, int toX, int width, uint32 * outAOTerm )
+        {
+            float visA[c_lanes];
+            Lanes<F>::Store( visibility, visA );
+            if( BentNormals )
+            {
+                // XeGTAO_EncodeVisibilityBentNormal
+                float bx[c_lanes], by[c_lanes], bz[c_lanes];
+                Lanes<F>::Store( bentNormal.x * 0.5f + 0.5f, bx ); Lanes<F>::Store( bentNormal.y * 0.5f + 0.5f, by ); Lanes<F>::Store( bentNormal.z * 0.5f + 0.5f, bz );
+                for( int i = 0; i < c_lanes && x + i < toX; i++ )
+                    outAOTerm[ y * width + x + i ] = FLOAT4_to_R8G8B8A8_UNORM( bx[i], by[i], bz[i], visA[i] );
+            }
+            else
+            {
+                // R8_UINT UAV stores saturate
+                for( int i = 0; i < c_lanes && x + i < toX; i++ )
+                    outAOTerm[ y * width + x + i ] = std::min( 255u, (uint32)( visA[i] * 255.0f + 0.5f ) );
+            }
+        }
+
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // XeGTAO_Denoise; the shader does 2 horizontal pixels per thread using gathers, which boils down to plain clamped
+        // 3x3 neighbourhood loads
+        template< bool BentNormals >
+        static void         Denoise( const PassConstants & pc, const uint8 * edges, const uint32 * srcAOTerm, uint32 * dstAOTerm, bool finalApply, int x, int y, int toX )
+        {
+            const int width = pc.Consts.ViewportSize.x; const int height = pc.Consts.ViewportSize.y;
+            constexpr int aoComponents  = (BentNormals)?(4):(1);
+            const float * unorm8LUT     = UNORM8LUT( );
+            const float * edgesLUT      = UnpackedEdgesLUT( );
+
+            const float blurAmount      = (finalApply)?(pc.Consts.DenoiseBlurBeta):(pc.Consts.DenoiseBlurBeta / 5.0f);
+            const float diagWeight      = 0.85f * 0.5f;
+
+            const int rowT = std::max( y - 1, 0 ) * width;
+            const int rowC = y * width;
+            const int rowB = std::min( y + 1, height - 1 ) * width;
+
+            // neighbourhood: 0 - center, 1 - left, 2 - right, 3 - top, 4 - bottom, 5 - top left, 6 - top right, 7 - bottom left, 8 - bottom right
+            float edgesA[5][4][c_lanes];
+            float aoA[9][aoComponents][c_lanes];
+            for( int i = 0; i < c_lanes; i++ )
+            {
+                const int cx = std::min( x + i, width - 1 );
+                const int lx = std::max( cx - 1, 0 );
+                const int rx = std::min( cx + 1, width - 1 );
+                const int offsets[9] = { rowC + cx, rowC + lx, rowC + rx, rowT + cx, rowB + cx, rowT + lx, rowT + rx, rowB + lx, rowB + rx };
+                for( int k = 0; k < 5; k++ )
+                    for( int c = 0; c < 4; c++ )
+                        edgesA[k][c][i] = edgesLUT[ edges[offsets[k]] * 4 + c ];
+                for( int k = 0; k < 9; k++ )
+                {
+                    const uint32 packedValue = srcAOTerm[offsets[k]];
+                    if( BentNormals )
+                    {
+                        // XeGTAO_DecodeVisibilityBentNormal
+                        for( int c = 0; c < 3; c++ )
+                            aoA[k][c][i] = unorm8LUT[ ( packedValue >> ( c * 8 ) ) & 0xff ] * 2.0f - 1.0f;
+                        aoA[k][aoComponents-1][i] = unorm8LUT[ packedValue >> 24 ];
+                    }
+                    else
+                        aoA[k][0][i] = unorm8LUT[ std::min( packedValue, 255u ) ];
+                }
+            }
+
+            F edgesC_LRTB[4], edgesL_LRTB[4], edgesR_LRTB[4], edgesT_LRTB[4], edgesB_LRTB[4];
+            for( int c = 0; c < 4; c++ )
+            {
+                edgesC_LRTB[c] = Lanes<F>::Load( edgesA[0][c] );
+                edgesL_LRTB[c] = Lanes<F>::Load( edgesA[1][c] );
+                edgesR_LRTB[c] = Lanes<F>::Load( edgesA[2][c] );
+                edgesT_LRTB[c] = Lanes<F>::Load( edgesA[3][c] );
+                edgesB_LRTB[c] = Lanes<F>::Load( edgesA[4][c] );
+            }
+
+            // Edges aren't perfectly symmetrical: edge detection algorithm does not guarantee that a left edge on the right pixel will match the right edge on the left pixel
+            edgesC_LRTB[0] *= edgesL_LRTB[1];
+            edgesC_LRTB[1] *= edgesR_LRTB[0];
+            edgesC_LRTB[2] *= edgesT_LRTB[3];
+            edgesC_LRTB[3] *= edgesB_LRTB[2];
+
+            // this allows some small amount of AO leaking from neighbours if there are 3 or 4 edges; this reduces both spatial and temporal aliasing
+            const float leak_threshold = 2.5f; const float leak_strength = 0.5f;
+            const F edginess = ( Saturate( 4.0f - leak_threshold - ( edgesC_LRTB[0] + edgesC_LRTB[1] + edgesC_LRTB[2] + edgesC_LRTB[3] ) ) / ( 4.0f - leak_threshold ) ) * leak_strength;
+            for( int c = 0; c < 4; c++ )
+                edgesC_LRTB[c] = Saturate( edgesC_LRTB[c] + edginess );
+
+            const F weightTL = diagWeight * ( edgesC_LRTB[0] * edgesL_LRTB[2] + edgesC_LRTB[2] * edgesT_LRTB[0] );
+            const F weightTR = diagWeight * ( edgesC_LRTB[2] * edgesT_LRTB[1] + edgesC_LRTB[1] * edgesR_LRTB[2] );
+            const F weightBL = diagWeight * ( edgesC_LRTB[3] * edgesB_LRTB[0] + edgesC_LRTB[0] * edgesL_LRTB[3] );
+            const F weightBR = diagWeight * ( edgesC_LRTB[1] * edgesR_LRTB[3] + edgesC_LRTB[3] * edgesB_LRTB[1] );
+            const F weights[9] = { blurAmount, edgesC_LRTB[0], edgesC_LRTB[1], edgesC_LRTB[2], edgesC_LRTB[3], weightTL, weightTR, weightBL, weightBR };
+
+            // XeGTAO_AddSample
+            F sumWeight = weights[0];
+            F sum[aoComponents];
+            for( int c = 0; c < aoComponents; c++ )
+                sum[c] = Lanes<F>::Load( aoA[0][c] ) * sumWeight;
+            for( int k = 1; k < 9; k++ )
+            {
+                for( int c = 0; c < aoComponents; c++ )
+                    sum[c] += weights[k] * Lanes<F>::Load( aoA[k][c] );
+                sumWeight += weights[k];
+            }
+
+            // XeGTAO_Output
+            const float finalScale = (finalApply)?(XE_GTAO_OCCLUSION_TERM_SCALE):(1.0f);
+            if( BentNormals )
+            {
+                const F visibility      = ( sum[aoComponents-1] / sumWeight ) * finalScale;
+                const V3<F> bentNormal  = Normalize( V3<F>( sum[0] / sumWeight, sum[1 % aoComponents] / sumWeight, sum[2 % aoComponents] / sumWeight ) );
+                StoreAOTerm<BentNormals>( visibility, bentNormal, x, y, toX, width, dstAOTerm );
+            }
+            else
+            {
+                const F visibility      = ( sum[0] / sumWeight ) * finalScale;
+                StoreAOTerm<BentNormals>( visibility, V3<F>( 0.0f, 0.0f, 0.0f ), x, y, toX, width, dstAOTerm );
+            }
+        }
+    };
+
+    const int c_passGenerateNormals     = 0;
+    const int c_passPrefilterDepths     = 1;
+    const int c_passMainPass            = 2;
+    const int c_passDenoise             = 3;    // denoise pass N is c_passDenoise + N
+
+    inline int64 TimeInMicroseconds( )  { return (int64)( vaCore::TimeFromAppStart( ) * 1e6 ); }
+
+    inline void AtomicMin( std::atomic<int64> & target, int64 value )
+    {
+        int64 prev = target.load( std::memory_order_relaxed );
+        while( value < prev && !target.compare_exchange_weak( prev, value, std::memory_order_relaxed ) ) { }
+    }
+    inline void AtomicMax( std::atomic<int64> & target, int64 value )
+    {
+        int64 prev = target.load( std::memory_order_relaxed );
+        while( value > prev && !target.compare_exchange_weak( prev, value, std::memory_order_relaxed ) ) { }
+    }
+}
+
+vaGTAOCPU::vaGTAOCPU( )
+{
+    for( int mip = 0; mip < XE_GTAO_DEPTH_MIP_LEVELS; mip++ )
+    {
+        m_workingDepthsMIPOffsets[mip]  = 0;
+        m_workingDepthsMIPSizes[mip]    = { 0, 0 };
+    }
+    memset( &m_consts, 0, sizeof( m_consts ) );
+    for( int i = 0; i < _countof( m_passSpanBegin ); i++ )
+    {
+        m_passSpanBegin[i]  = 0;
+        m_passSpanEnd[i]    = 0;
+    }
+}
+
+vaGTAOCPU::~vaGTAOCPU( )
+{
+}
+
+void vaGTAOCPU::UpdateBuffers( int width, int height )
+{
+    if( m_size.x == width && m_size.y == height )
+        return;
+
+    m_size = { width, height };
+
+    // same as vaTexture::Create2D with XE_GTAO_DEPTH_MIP_LEVELS mips
+    int totalSize = 0;
+    for( int mip = 0; mip < XE_GTAO_DEPTH_MIP_LEVELS; mip++ )
+    {
+        m_workingDepthsMIPSizes[mip]    = { std::max( 1, width >> mip ), std::max( 1, height >> mip ) };
+        m_workingDepthsMIPOffsets[mip]  = totalSize;
+        totalSize += m_workingDepthsMIPSizes[mip].x * m_workingDepthsMIPSizes[mip].y;
+    }
+    m_workingDepths.resize( totalSize );
+
+    m_workingEdges.resize( (size_t)width * height );
+    m_workingAOTerm.resize( (size_t)width * height );
+    m_workingAOTermPong.resize( (size_t)width * height );
+}
+
+void vaGTAOCPU::GenerateNormalsBlock( const float * ndcDepth, int fromX, int fromY, int toX, int toY )
+{
+    const PassConstants pc( m_consts, m_settings );
+    for( int y = fromY; y < toY; y++ )
+        for( int x = fromX; x < toX; x += (m_useSIMD)?(4):(1) )
+        {
+            if( m_useSIMD )
+                XeGTAOKernels<vfloat4>::GenerateNormals( pc, ndcDepth, x, y, toX, m_workingNormals.data( ) );
+            else
+                XeGTAOKernels<float>::GenerateNormals( pc, ndcDepth, x, y, toX, m_workingNormals.data( ) );
+        }
+}
+
+void vaGTAOCPU::PrefilterDepthsBlock( const float * ndcDepth, int tileX, int tileY )
+{
+    const PassConstants pc( m_consts, m_settings );
+    const DepthMIPs depths = { m_workingDepths.data( ), m_workingDepthsMIPOffsets, m_workingDepthsMIPSizes };
+    if( m_useSIMD )
+        XeGTAOKernels<vfloat4>::PrefilterDepths16x16( pc, ndcDepth, depths, tileX, tileY );
+    else
+        XeGTAOKernels<float>::PrefilterDepths16x16( pc, ndcDepth, depths, tileX, tileY );
+}
+
+void vaGTAOCPU::MainPassBlock( const uint32 * normals, int fromX, int fromY, int toX, int toY )
+{
+    const PassConstants pc( m_consts, m_settings );
+    const DepthMIPs depths = { m_workingDepths.data( ), m_workingDepthsMIPOffsets, m_workingDepthsMIPSizes };
+    for( int y = fromY; y < toY; y++ )
+        for( int x = fromX; x < toX; x += (m_useSIMD)?(4):(1) )
+        {
+            if( m_useSIMD )
+            {
+                if( m_outputBentNormals )
+                    XeGTAOKernels<vfloat4>::MainPass<true>( pc, depths, normals, x, y, toX, m_workingEdges.data( ), m_workingAOTerm.data( ) );
+                else
+                    XeGTAOKernels<vfloat4>::MainPass<false>( pc, depths, normals, x, y, toX, m_workingEdges.data( ), m_workingAOTerm.data( ) );
+            }
+            else
+            {
+                if( m_outputBentNormals )
+                    XeGTAOKernels<float>::MainPass<true>( pc, depths, normals, x, y, toX, m_workingEdges.data( ), m_workingAOTerm.data( ) );
+                else
+                    XeGTAOKernels<float>::MainPass<false>( pc, depths, normals, x, y, toX, m_workingEdges.data( ), m_workingAOTerm.data( ) );
+            }
+        }
+}
+
+void vaGTAOCPU::DenoiseBlock( const uint32 * srcAOTerm, uint32 * dstAOTerm, bool finalApply, int fromX, int fromY, int toX, int toY )
+{
+    const PassConstants pc( m_consts, m_settings );
+    for( int y = fromY; y < toY; y++ )
+        for( int x = fromX; x < toX; x += (m_useSIMD)?(4):(1) )
+        {
+            if( m_useSIMD )
+            {
+                if( m_outputBentNormals )
+                    XeGTAOKernels<vfloat4>::Denoise<true>( pc, m_workingEdges.data( ), srcAOTerm, dstAOTerm, finalApply, x, y, toX );
+                else
+                    XeGTAOKernels<vfloat4>::Denoise<false>( pc, m_workingEdges.data( ), srcAOTerm, dstAOTerm, finalApply, x, y, toX );
+            }
+            else
+            {
+                if( m_outputBentNormals )
+                    XeGTAOKernels<float>::Denoise<true>( pc, m_workingEdges.data( ), srcAOTerm, dstAOTerm, finalApply, x, y, toX );
+                else
+                    XeGTAOKernels<float>::Denoise<false>( pc, m_workingEdges.data( ), srcAOTerm, dstAOTerm, finalApply, x, y, toX );
+            }
+        }
+}
+
+void vaGTAOCPU::ExecuteTile( int pass, int tileX, int tileY )
+{
+    const int64 startTime = TimeInMicroseconds( );
+
+    const int fromX = tileX * c_tileWidth;
+    const int fromY = tileY * c_tileHeight;
+    const int toX   = std::min( m_size.x, fromX + c_tileWidth );
+    const int toY   = std::min( m_size.y, fromY + c_tileHeight );
+
+    if( pass == c_passGenerateNormals )
+        GenerateNormalsBlock( m_currentNDCDepth, fromX, fromY, toX, toY );
+    else if( pass == c_passPrefilterDepths )
+    {
+        // prefilter thread group covers 16x16 pixels
+        for( int groupY = fromY / 16; groupY < ( toY + 15 ) / 16; groupY++ )
+            for( int groupX = fromX / 16; groupX < ( toX + 15 ) / 16; groupX++ )
+                PrefilterDepthsBlock( m_currentNDCDepth, groupX, groupY );
+    }
+    else if( pass == c_passMainPass )
+        MainPassBlock( m_currentNormals, fromX, fromY, toX, toY );
+    else
+    {
+        // ping-pong: main pass outputs into m_workingAOTerm, even denoise passes read from it and odd ones from m_workingAOTermPong; last one
+        // outputs into the external output
+        const int denoisePass       = pass - c_passDenoise;
+        const int denoisePassCount  = std::max( 1, m_settings.DenoisePasses );
+        const bool lastPass         = denoisePass == denoisePassCount - 1;
+        const uint32 * srcAOTerm    = ( denoisePass % 2 == 0 ) ? ( m_workingAOTerm.data( ) ) : ( m_workingAOTermPong.data( ) );
+        uint32 * dstAOTerm          = ( lastPass ) ? ( m_currentOutput ) : ( ( denoisePass % 2 == 0 ) ? ( m_workingAOTermPong.data( ) ) : ( m_workingAOTerm.data( ) ) );
+        DenoiseBlock( srcAOTerm, dstAOTerm, lastPass, fromX, fromY, toX, toY );
+    }
+
+    const int spanIndex = std::min( pass, c_passDenoise );
+    AtomicMin( m_passSpanBegin[spanIndex], startTime );
+    AtomicMax( m_passSpanEnd[spanIndex], TimeInMicroseconds( ) );
+}
+
+#ifdef VA_TASKFLOW_INTEGRATION_ENABLED
+void vaGTAOCPU::BuildTaskGraph( int denoisePasses, bool generateNormals )
+{
+    VA_TRACE_CPU_SCOPE( BuildTaskGraph );
+
+    m_taskGraph.clear( );
+    m_taskGraphSize             = m_size;
+    m_taskGraphDenoisePasses    = denoisePasses;
+    m_taskGraphGenerateNormals  = generateNormals;
+
+    const int tileCountX = ( m_size.x + c_tileWidth - 1 ) / c_tileWidth;
+    const int tileCountY = ( m_size.y + c_tileHeight - 1 ) / c_tileHeight;
+    auto tileIndex = [ tileCountX ]( int tileX, int tileY ) { return tileY * tileCountX + tileX; };
+
+    auto emplaceTiles = [ & ]( int pass, const char * name )
+    {
+        std::vector<tf::Task> tasks( (size_t)tileCountX * tileCountY );
+        for( int tileY = 0; tileY < tileCountY; tileY++ )
+            for( int tileX = 0; tileX < tileCountX; tileX++ )
+                tasks[tileIndex( tileX, tileY )] = m_taskGraph.emplace( [ this, pass, tileX, tileY ]( ) { ExecuteTile( pass, tileX, tileY ); } ).name( name );
+        return tasks;
+    };
+
+    // Normals are only read at the same pixel in the main pass so these can go tile-to-tile.
+    std::vector<tf::Task> normalsTasks;
+    if( generateNormals )
+        normalsTasks = emplaceTiles( c_passGenerateNormals, "GTAONormals" );
+
+    // Main pass samples depth MIPs up to the effect radius away which is unbounded in screen space, so this is the one full barrier
+    std::vector<tf::Task> prefilterTasks = emplaceTiles( c_passPrefilterDepths, "GTAOPrefilter" );
+    tf::Task depthMIPsReady = m_taskGraph.placeholder( ).name( "GTAODepthMIPsReady" );
+    for( tf::Task & task : prefilterTasks )
+        task.precede( depthMIPsReady );
+
+    std::vector<tf::Task> previousTasks = emplaceTiles( c_passMainPass, "GTAOMainPass" );
+    for( int i = 0; i < (int)previousTasks.size( ); i++ )
+    {
+        depthMIPsReady.precede( previousTasks[i] );
+        if( generateNormals )
+            normalsTasks[i].precede( previousTasks[i] );
+    }
+
+    // Each denoise tile reads a 1 pixel border (and edges from the main pass), so it depends on the 3x3 neighbourhood of tiles from
+    // the previous pass. This also protects ping-pong buffers: a tile only overwrites data that all its readers from the previous pass
+    // are already done with.
+    for( int denoisePass = 0; denoisePass < denoisePasses; denoisePass++ )
+    {
+        std::vector<tf::Task> denoiseTasks = emplaceTiles( c_passDenoise + denoisePass, "GTAODenoise" );
+        for( int tileY = 0; tileY < tileCountY; tileY++ )
+            for( int tileX = 0; tileX < tileCountX; tileX++ )
+                for( int ny = std::max( 0, tileY - 1 ); ny <= std::min( tileCountY - 1, tileY + 1 ); ny++ )
+                    for( int nx = std::max( 0, tileX - 1 ); nx <= std::min( tileCountX - 1, tileX + 1 ); nx++ )
+                        previousTasks[tileIndex( nx, ny )].precede( denoiseTasks[tileIndex( tileX, tileY )] );
+        previousTasks = std::move( denoiseTasks );
+    }
+}
+#else
+void vaGTAOCPU::BuildTaskGraph( int, bool )
+{
+    assert( false );
+}
+#endif
+
+bool vaGTAOCPU::Compute( const Inputs & inputs, bool outputBentNormals, std::vector<uint32> & outputAO )
+{
+    VA_TRACE_CPU_SCOPE( XeGTAOCPU );
+
+    if( inputs.Width <= 0 || inputs.Height <= 0 || inputs.NDCDepth == nullptr )
+    {
+        assert( false );
+        return false;
+    }
+
+    m_outputBentNormals = outputBentNormals;
+    UpdateBuffers( inputs.Width, inputs.Height );
+    outputAO.resize( (size_t)m_size.x * m_size.y );
+
+    XeGTAO::GTAOUpdateConstants( m_consts, m_size.x, m_size.y, m_settings, &inputs.ProjMatrix._11, true, inputs.FrameCounter );
+
+    m_lastTimings = Timings( );
+    for( int i = 0; i < _countof( m_passSpanBegin ); i++ )
+    {
+        m_passSpanBegin[i]  = std::numeric_limits<int64>::max( );
+        m_passSpanEnd[i]    = std::numeric_limits<int64>::min( );
+    }
+    const int64 startTime = TimeInMicroseconds( );
+
+    const bool generateNormals  = inputs.ViewspaceNormals == nullptr;
+    const int denoisePassCount  = std::max( 1, m_settings.DenoisePasses ); // even without denoising we have to run a single last pass to output correct term into the external output
+
+    if( generateNormals )
+        m_workingNormals.resize( (size_t)m_size.x * m_size.y );
+
+    m_currentNDCDepth   = inputs.NDCDepth;
+    m_currentNormals    = ( generateNormals ) ? ( m_workingNormals.data( ) ) : ( inputs.ViewspaceNormals );
+    m_currentOutput     = outputAO.data( );
+
+    bool done = false;
+#ifdef VA_TASKFLOW_INTEGRATION_ENABLED
+    if( m_multithreaded )
+    {
+        if( m_taskGraphSize.x != m_size.x || m_taskGraphSize.y != m_size.y || m_taskGraphDenoisePasses != denoisePassCount || m_taskGraphGenerateNormals != generateNormals )
+            BuildTaskGraph( denoisePassCount, generateNormals );
+
+        tf::Executor & executor = ( m_executor != nullptr ) ? ( *m_executor ) : ( vaTF::Executor( ) );
+        executor.run( m_taskGraph ).wait( );
+        done = true;
+    }
+#endif
+    if( !done )
+    {
+        // same work in the same tile order, one pass after another
+        const int tileCountX = ( m_size.x + c_tileWidth - 1 ) / c_tileWidth;
+        const int tileCountY = ( m_size.y + c_tileHeight - 1 ) / c_tileHeight;
+        for( int pass = ( generateNormals ) ? ( c_passGenerateNormals ) : ( c_passPrefilterDepths ); pass < c_passDenoise + denoisePassCount; pass++ )
+            for( int tileY = 0; tileY < tileCountY; tileY++ )
+                for( int tileX = 0; tileX < tileCountX; tileX++ )
+                    ExecuteTile( pass, tileX, tileY );
+    }
+
+    m_currentNDCDepth   = nullptr;
+    m_currentNormals    = nullptr;
+    m_currentOutput     = nullptr;
+
+    auto passTime = [ this ]( int pass ) { return ( m_passSpanEnd[pass] >= m_passSpanBegin[pass] ) ? ( ( m_passSpanEnd[pass] - m_passSpanBegin[pass] ) / 1000.0 ) : ( 0.0 ); };
+    m_lastTimings.GenerateNormals   = passTime( c_passGenerateNormals );
+    m_lastTimings.PrefilterDepths   = passTime( c_passPrefilterDepths );
+    m_lastTimings.MainPass          = passTime( c_passMainPass );
+    m_lastTimings.Denoise           = passTime( c_passDenoise );
+    m_lastTimings.Elapsed           = ( TimeInMicroseconds( ) - startTime ) / 1000.0;
+
+    return true;
+}
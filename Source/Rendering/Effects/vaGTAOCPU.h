@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation 
+// 
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// XeGTAO is based on GTAO/GTSO "Jimenez et al. / Practical Real-Time Strategies for Accurate Indirect Occlusion", 
+// https://www.activision.com/cdn/research/Practical_Real_Time_Strategies_for_Accurate_Indirect_Occlusion_NEW%20VERSION_COLOR.pdf
+// 
+// Implementation:  Filip Strugar (filip.strugar@intel.com), Steve Mccalla <stephen.mccalla@intel.com>         (\_/)
+// Version:         (see XeGTAO.h)                                                                            (='.'=)
+// Details:         https://github.com/GameTechDev/XeGTAO                                                     (")_(")
+//
+// Version history: see XeGTAO.h
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Core/vaCoreIncludes.h"
+#include "Core/vaGeometry.h"
+
+#include "Rendering/Shaders/XeGTAO.h"
+
+#ifdef VA_TASKFLOW_INTEGRATION_ENABLED
+#include "IntegratedExternals/vaTaskflowIntegration.h"
+#endif
+
+namespace Vanilla
+{
+    // CPU (headless, no render device required) port of the XeGTAO_PrefilterDepths16x16, XeGTAO_MainPass and XeGTAO_Denoise
+    // passes from XeGTAO.hlsli, for offline bakes and for validating settings changes on machines without a GPU.
+    //
+    // It mirrors the full precision shader path (XE_GTAO_FP32_DEPTHS with XE_GTAO_USE_HALF_FLOAT_PRECISION 0) and outputs
+    // the same packed formats as vaGTAO::Compute: R8_UINT visibility or R32_UINT XeGTAO_EncodeVisibilityBentNormal, and
+    // XeGTAO_PackEdges edges. The SIMD (SSE, 4 pixels at a time) and scalar paths share the same templated kernels and
+    // produce bitwise identical outputs; results vs the GPU differ only by the transcendental (sin/cos/pow) approximations.
+    //
+    // When multithreaded, the image is split into c_tileWidth x c_tileHeight tiles (groups of XE_GTAO_NUMTHREADS_X/Y thread
+    // groups, and of 16x16 prefilter thread groups) and all passes are scheduled as one taskflow graph, so main pass and
+    // denoise tiles run as soon as their neighbours are done. The only full-image barrier is between the depth prefilter
+    // and the main pass, since the main pass sampling footprint is only bounded by the effect radius.
+    class vaGTAOCPU
+    {
+    public:
+        struct Inputs
+        {
+            int                                     Width               = 0;
+            int                                     Height              = 0;
+            const float *                           NDCDepth            = nullptr;      // Width * Height, as stored in the depth buffer
+            const uint32 *                          ViewspaceNormals    = nullptr;      // optional Width * Height, R11G11B10_UNORM packed (same as the LoadNormal( ) in vaGTAO.hlsl); generated from depth if nullptr
+            vaMatrix4x4                             ProjMatrix          = vaMatrix4x4::Identity;
+            uint32                                  FrameCounter        = 0;            // same as in vaGTAO::UpdateConstants - use 0 if not using TAA
+        };
+
+        // All in milliseconds; per-pass times are from the first tile started to the last tile finished, so when pipelined
+        // they overlap and add up to more than Elapsed.
+        struct Timings
+        {
+            double                                  GenerateNormals     = 0.0;
+            double                                  PrefilterDepths     = 0.0;
+            double                                  MainPass            = 0.0;
+            double                                  Denoise             = 0.0;
+            double                                  Elapsed             = 0.0;
+        };
+
+        static const int                            c_tileWidth         = 8 * XE_GTAO_NUMTHREADS_X;     // must be a multiple of 16 (prefilter thread group footprint)
+        static const int                            c_tileHeight        = 4 * XE_GTAO_NUMTHREADS_Y;     // same as ^
+
+    protected:
+        XeGTAO::GTAOSettings                        m_settings;
+        bool                                        m_useSIMD                   = true;
+        bool                                        m_multithreaded             = true;
+        bool                                        m_outputBentNormals         = false;        // as given in the last Compute( ... ) call
+
+        vaVector2i                                  m_size                      = { 0, 0 };
+        XeGTAO::GTAOConstants                       m_consts;
+
+        // all XE_GTAO_DEPTH_MIP_LEVELS MIPs of the viewspace depth, one after another
+        std::vector<float>                          m_workingDepths;
+        int                                         m_workingDepthsMIPOffsets[XE_GTAO_DEPTH_MIP_LEVELS];
+        vaVector2i                                  m_workingDepthsMIPSizes[XE_GTAO_DEPTH_MIP_LEVELS];
+
+        std::vector<uint32>                         m_workingNormals;           // R11G11B10_UNORM, only used when normals are not provided
+        std::vector<uint8>                          m_workingEdges;             // XeGTAO_PackEdges( ) * 255
+        std::vector<uint32>                         m_workingAOTerm;            // AO alone (R8_UINT range) or AO+BentNormals (R8G8B8A8_UNORM packed)
+        std::vector<uint32>                         m_workingAOTermPong;        // same as ^, used for ping-ponging
+
+        Timings                                     m_lastTimings;
+
+        // per pass (GenerateNormals, PrefilterDepths, MainPass, Denoise) first tile start and last tile end, in microseconds
+        std::atomic<int64>                          m_passSpanBegin[4];
+        std::atomic<int64>                          m_passSpanEnd[4];
+
+        // valid during Compute( ... ) only
+        const float *                               m_currentNDCDepth           = nullptr;
+        const uint32 *                              m_currentNormals            = nullptr;
+        uint32 *                                    m_currentOutput             = nullptr;
+
+#ifdef VA_TASKFLOW_INTEGRATION_ENABLED
+        tf::Executor *                              m_executor                  = nullptr;      // nullptr means vaTF::Executor( )
+
+        // tile task graph, rebuilt only when the size or the pass setup change
+        tf::Taskflow                                m_taskGraph;
+        vaVector2i                                  m_taskGraphSize             = { 0, 0 };
+        int                                         m_taskGraphDenoisePasses    = -1;
+        bool                                        m_taskGraphGenerateNormals  = false;
+#endif
+
+    public:
+        vaGTAOCPU( );
+        ~vaGTAOCPU( );
+
+    public:
+        // Output is resized to Width * Height; with outputBentNormals == false the values are in the R8_UINT [0, 255] range.
+        bool                                        Compute( const Inputs & inputs, bool outputBentNormals, std::vector<uint32> & outputAO );
+
+        XeGTAO::GTAOSettings &                      Settings( )                                         { return m_settings; }
+        bool &                                      UseSIMD( )                                          { return m_useSIMD; }
+        bool &                                      Multithreaded( )                                    { return m_multithreaded; }
+#ifdef VA_TASKFLOW_INTEGRATION_ENABLED
+        // Use a different executor (for ex. for thread count scaling tests); nullptr to use the default vaTF::Executor( )
+        void                                        SetExecutor( tf::Executor * executor )              { m_executor = executor; }
+#endif
+
+        const Timings &                             LastTimings( ) const                                { return m_lastTimings; }
+        const vaVector2i &                          Size( ) const                                       { return m_size; }
+
+        // working data from the last Compute( ... ) call - viewspace depth MIPs, edges and (generated) normals
+        const float *                               WorkingDepthMIP( int mip ) const                    { assert( mip >= 0 && mip < XE_GTAO_DEPTH_MIP_LEVELS ); return m_workingDepths.data( ) + m_workingDepthsMIPOffsets[mip]; }
+        const vaVector2i &                          WorkingDepthMIPSize( int mip ) const                { assert( mip >= 0 && mip < XE_GTAO_DEPTH_MIP_LEVELS ); return m_workingDepthsMIPSizes[mip]; }
+        const std::vector<uint8> &                  WorkingEdges( ) const                               { return m_workingEdges; }
+        const std::vector<uint32> &                 WorkingNormals( ) const                             { return m_workingNormals; }
+
+    protected:
+        void                                        UpdateBuffers( int width, int height );
+
+        // Each of these process a block of the dispatch; these are thread safe as long as the blocks do not overlap.
+        void                                        GenerateNormalsBlock( const float * ndcDepth, int fromX, int fromY, int toX, int toY );
+        void                                        PrefilterDepthsBlock( const float * ndcDepth, int tileX, int tileY );      // one 16x16 tile (one XeGTAO_PrefilterDepths16x16 thread group)
+        void                                        MainPassBlock( const uint32 * normals, int fromX, int fromY, int toX, int toY );
+        void                                        DenoiseBlock( const uint32 * srcAOTerm, uint32 * dstAOTerm, bool finalApply, int fromX, int fromY, int toX, int toY );
+
+        // Runs pass 'pass' (0 - GenerateNormals, 1 - PrefilterDepths, 2 - MainPass, 3+ - Denoise) on one c_tileWidth x c_tileHeight tile
+        void                                        ExecuteTile( int pass, int tileX, int tileY );
+        void                                        BuildTaskGraph( int denoisePasses, bool generateNormals );
+    };
+
+}
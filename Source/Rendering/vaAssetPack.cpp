@@ -12,10 +12,14 @@
 
 #include "Rendering/vaRenderMesh.h"
 #include "Rendering/vaRenderMaterial.h"
+#include "Rendering/vaRenderMeshOptimizer.h"
 
 #include "Rendering/Misc/vaTextureReductionTestTool.h"
 
 #include "Core/System/vaCompressionStream.h"
+#include "Core/System/vaMemoryStream.h"
+
+#include "Core/Misc/vaXXHash.h"
 
 #include "Core/System/vaFileTools.h"
 
@@ -26,6 +30,8 @@
 
 #include "Rendering/vaTextureHelpers.h"
 
+#include <thread>
+
 using namespace Vanilla;
 
 string                  vaAssetPack::m_uiNameFilter                     = "";
@@ -357,7 +363,82 @@ void vaAssetPack::RemoveAll( bool lockMutex )
     m_assetMap.clear();
 }
 
-const int c_packFileVersion = 3;
+int vaAssetPack::OptimizeRenderMeshes( bool lockMutex )
+{
+    std::unique_lock<mutex> assetStorageMutexLock(m_assetStorageMutex, std::defer_lock );    if( lockMutex ) assetStorageMutexLock.lock(); else m_assetStorageMutex.assert_locked_by_caller();
+
+    std::vector<shared_ptr<vaRenderMesh>> renderMeshes;
+    for( const shared_ptr<vaAsset> & asset : m_assetList )
+    {
+        if( asset->Type != vaAssetType::RenderMesh )
+            continue;
+        shared_ptr<vaRenderMesh> renderMesh = vaAssetRenderMesh::SafeCast( asset )->GetRenderMesh( );
+        if( renderMesh != nullptr )
+            renderMeshes.push_back( renderMesh );
+    }
+    if( renderMeshes.size( ) == 0 )
+        return 0;
+
+    vaRenderMeshOptimizer::Stats stats = vaRenderMeshOptimizer::Optimize( renderMeshes, vaRenderMeshOptimizer::Settings( ) );
+    VA_LOG( "vaAssetPack '%s' optimized %s", m_name.c_str(), stats.ToString( ).c_str( ) );
+
+    SetDirty( );
+    return (int)renderMeshes.size( );
+}
+
+// version 4: chunked - a table of contents followed by one independently compressed chunk per asset
+const int c_packFileVersion = 4;
+
+namespace
+{
+    // Runs function( index ) for each index in [0, count) on the vaBackgroundTaskManager thread pool. The calling thread picks up
+    // work too so it makes progress even if the pool is busy, and it's safe to call from a (non-pooled) background task.
+    // Returns false if any of the calls returned false.
+    bool ParallelForOnBackgroundTasks( const string & name, int count, const std::function<bool( int index )> & function )
+    {
+        std::atomic_int nextIndex   = 0;
+        std::atomic_bool allOk      = true;
+        auto worker = [ & ]( )
+        {
+            for( int index = nextIndex++; index < count; index = nextIndex++ )
+                if( !function( index ) )
+                    allOk = false;
+        };
+
+        const int helperCount = std::min( count, (int)std::thread::hardware_concurrency( ) ) - 1;
+        std::vector<shared_ptr<vaBackgroundTaskManager::Task>> helpers;
+        for( int i = 0; i < helperCount; i++ )
+            helpers.push_back( vaBackgroundTaskManager::GetInstance( ).Spawn( name, vaBackgroundTaskManager::SpawnFlags::UseThreadPool, 
+                [ &worker ]( vaBackgroundTaskManager::TaskContext & ) { worker( ); return true; } ) );
+        worker( );
+        for( const auto & helper : helpers )
+            vaBackgroundTaskManager::GetInstance( ).WaitUntilFinished( helper );
+        return allOk;
+    }
+
+    bool CompressAPACKChunk( vaMemoryStream & uncompressed, vaMemoryStream & outCompressed )
+    {
+        vaCompressionStream compressor( false, &outCompressed );
+        return compressor.Write( uncompressed.GetBuffer( ), uncompressed.GetLength( ) );
+    }
+
+    bool DecompressAPACKChunk( const uint8 * compressed, const vaAssetPack::APACKChunkInfo & chunkInfo, vaMemoryStream & outUncompressed )
+    {
+        if( vaXXHash64::Compute( compressed, chunkInfo.CompressedSize ) != chunkInfo.Hash )
+        {
+            VA_LOG_ERROR( "vaAssetPack - checksum mismatch for chunk '%s', file is corrupt", chunkInfo.Name.c_str( ) );
+            return false;
+        }
+        vaMemoryStream compressedStream( (void*)compressed, chunkInfo.CompressedSize );
+        vaCompressionStream decompressor( true, &compressedStream );
+        if( !decompressor.Read( outUncompressed.GetBuffer( ), chunkInfo.UncompressedSize ) )
+        {
+            VA_LOG_ERROR( "vaAssetPack - unable to decompress chunk '%s'", chunkInfo.Name.c_str( ) );
+            return false;
+        }
+        return true;
+    }
+}
 
 bool vaAssetPack::IsBackgroundTaskActive( ) const
 {
@@ -401,51 +482,82 @@ bool vaAssetPack::SaveAPACK( const string & fileName, bool lockMutex )
 
     VERIFY_TRUE_RETURN_ON_FALSE( outStream.CanSeek( ) );
 
-    int64 posOfSize = outStream.GetPosition( );
-    VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<int64>( 0 ) );
-
-    VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<int32>( c_packFileVersion ) );
-
-    bool useWholeFileCompression = true;
-    VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<bool>( useWholeFileCompression ) );
-
-    // If compressing, have to write into memory buffer for later compression because seeking while
-    // writing directly to a compression stream is not supported, and it's used here.
-    vaMemoryStream memStream( (int64)0, (useWholeFileCompression)?( 16*1024 ): (0) );
-    vaStream & outStreamInner = (useWholeFileCompression)?( memStream ):( outStream );
-
-    VERIFY_TRUE_RETURN_ON_FALSE( outStreamInner.WriteValue<int32>( (int)m_assetMap.size() ) );
-
-    for( auto it = m_assetMap.begin( ); it != m_assetMap.end( ); it++ )
+    // serialize each asset into its own chunk; this touches asset data so it stays on this thread
+    const int chunkCount = (int)m_assetMap.size();
+    std::vector<APACKChunkInfo> toc( chunkCount );
+    std::vector<shared_ptr<vaMemoryStream>> uncompressedChunks( chunkCount );
+    std::vector<shared_ptr<vaMemoryStream>> compressedChunks( chunkCount );
+    int chunkIndex = 0;
+    for( auto it = m_assetMap.begin( ); it != m_assetMap.end( ); it++, chunkIndex++ )
     {
-        int64 posOfSubSize = outStreamInner.GetPosition( );
-        VERIFY_TRUE_RETURN_ON_FALSE( outStreamInner.WriteValue<int64>( 0 ) );
+        assert( vaStringTools::CompareNoCase( it->first, it->second->Name() ) == 0 );
+        toc[chunkIndex].Type = it->second->Type;
+        toc[chunkIndex].Name = it->first;
+
+        uncompressedChunks[chunkIndex] = std::make_shared<vaMemoryStream>( (int64)0, (int64)16*1024 );
+        vaMemoryStream & chunkStream = *uncompressedChunks[chunkIndex];
 
         // write type
-        VERIFY_TRUE_RETURN_ON_FALSE( outStreamInner.WriteValue<int32>( (int32)it->second->Type ) );
+        VERIFY_TRUE_RETURN_ON_FALSE( chunkStream.WriteValue<int32>( (int32)it->second->Type ) );
 
         // write name
-        VERIFY_TRUE_RETURN_ON_FALSE( outStreamInner.WriteString( it->first ) );
-        assert( vaStringTools::CompareNoCase( it->first, it->second->Name() ) == 0 );
+        VERIFY_TRUE_RETURN_ON_FALSE( chunkStream.WriteString( it->first ) );
 
         // write asset resource ID
-        VERIFY_TRUE_RETURN_ON_FALSE( outStreamInner.WriteValue<vaGUID>( it->second->GetResourceObjectUID() ) );
+        VERIFY_TRUE_RETURN_ON_FALSE( chunkStream.WriteValue<vaGUID>( it->second->GetResourceObjectUID() ) );
 
         // write asset
-        VERIFY_TRUE_RETURN_ON_FALSE( it->second->SaveAPACK( outStreamInner ) );
+        VERIFY_TRUE_RETURN_ON_FALSE( it->second->SaveAPACK( chunkStream ) );
 
-        int64 calculatedSubSize = outStreamInner.GetPosition() - posOfSubSize;
-        // auto aaaa = outStreamInner.GetPosition();
-        outStreamInner.Seek( posOfSubSize );
-        VERIFY_TRUE_RETURN_ON_FALSE( outStreamInner.WriteValue<int64>( calculatedSubSize ) );
-        outStreamInner.Seek( posOfSubSize + calculatedSubSize );
+        toc[chunkIndex].UncompressedSize = chunkStream.GetLength( );
     }
 
-    if( useWholeFileCompression )
+    // chunks are independent so they get compressed (and hashed) in parallel
+    bool compressOk = ParallelForOnBackgroundTasks( "vaAssetPack::SaveAPACK compression", chunkCount, [ & ]( int index )
     {
-        vaCompressionStream outCompressionStream( false, &outStream );
-        // just dump the whole buffer and we're done!
-        VERIFY_TRUE_RETURN_ON_FALSE( outCompressionStream.Write( memStream.GetBuffer(), memStream.GetLength() ) );
+        compressedChunks[index] = std::make_shared<vaMemoryStream>( (int64)0, uncompressedChunks[index]->GetLength( ) / 2 );
+        if( !CompressAPACKChunk( *uncompressedChunks[index], *compressedChunks[index] ) )
+            return false;
+        uncompressedChunks[index] = nullptr;
+        toc[index].CompressedSize   = compressedChunks[index]->GetLength( );
+        toc[index].Hash             = vaXXHash64::Compute( compressedChunks[index]->GetBuffer( ), toc[index].CompressedSize );
+        return true;
+    } );
+    if( !compressOk )
+    {
+        VA_LOG_ERROR( "vaAssetPack::SaveAPACK(%s) - error while compressing", fileName.c_str() );
+        m_apackStorage.Close();
+        return false;
+    }
+
+    int64 offset = 0;
+    for( APACKChunkInfo & chunkInfo : toc )
+    {
+        chunkInfo.Offset = offset;
+        offset += chunkInfo.CompressedSize;
+    }
+
+    int64 posOfSize = outStream.GetPosition( );
+    VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<int64>( 0 ) );
+
+    VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<int32>( c_packFileVersion ) );
+
+    // table of contents
+    VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<int32>( chunkCount ) );
+    for( const APACKChunkInfo & chunkInfo : toc )
+    {
+        VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<int32>( (int32)chunkInfo.Type ) );
+        VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteString( chunkInfo.Name ) );
+        VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<int64>( chunkInfo.Offset ) );
+        VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<int64>( chunkInfo.CompressedSize ) );
+        VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<int64>( chunkInfo.UncompressedSize ) );
+        VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<uint64>( chunkInfo.Hash ) );
+    }
+
+    // chunk data
+    for( const shared_ptr<vaMemoryStream> & compressedChunk : compressedChunks )
+    {
+        VERIFY_TRUE_RETURN_ON_FALSE( outStream.Write( compressedChunk->GetBuffer(), compressedChunk->GetLength() ) );
     }
 
     int64 calculatedSize = outStream.GetPosition( ) - posOfSize;
@@ -464,6 +576,66 @@ bool vaAssetPack::SaveAPACK( const string & fileName, bool lockMutex )
     return true;
 }
 
+shared_ptr<vaAsset> vaAssetPack::LoadAPACKAssetRecord( vaStream & inStream )
+{
+    m_assetStorageMutex.assert_locked_by_caller();
+
+    // read type
+    vaAssetType assetType;
+    if( !inStream.ReadValue<int32>( (int32&)assetType ) )
+    {
+        assert( false );
+        return nullptr;
+    }
+
+    // read name
+    string newAssetName;
+    if( !inStream.ReadString( newAssetName ) )
+    {
+        assert( false );
+        return nullptr;
+    }
+
+    string suitableName = FindSuitableAssetName( newAssetName, false );
+    if( suitableName != newAssetName )
+    {
+        VA_LOG_WARNING( "There's already an asset with the name '%s' or the name has disallowed characters - renaming the new one to '%s'", newAssetName.c_str(), suitableName.c_str() );
+        newAssetName = suitableName;
+    }
+    if( Find( newAssetName, false ) != nullptr )
+    {
+        VA_LOG_ERROR( "vaAssetPack::Load(): duplicated asset name, stopping loading." );
+        assert( false );
+        return nullptr;
+    }
+
+    shared_ptr<vaAsset> newAsset = nullptr;
+
+    switch( assetType )
+    {
+    case Vanilla::vaAssetType::Texture:
+        newAsset = shared_ptr<vaAsset>( vaAssetTexture::CreateAndLoadAPACK( *this, newAssetName, inStream ) );
+        break;
+    case Vanilla::vaAssetType::RenderMesh:
+        newAsset = shared_ptr<vaAsset>( vaAssetRenderMesh::CreateAndLoadAPACK( *this, newAssetName, inStream ) );
+        break;
+    case Vanilla::vaAssetType::RenderMaterial:
+        newAsset = shared_ptr<vaAsset>( vaAssetRenderMaterial::CreateAndLoadAPACK( *this, newAssetName, inStream ) );
+        break;
+    default:
+        break;
+    }
+
+    if( newAsset == nullptr )
+    {
+        VA_LOG_ERROR( "Error while loading an asset - see log file above for more info - aborting loading." );
+        return nullptr;
+    }
+
+    InsertAndTrackMe( newAsset, false );
+    return newAsset;
+}
+
 bool vaAssetPack::LoadAPACKInner( vaStream & inStream, std::vector< shared_ptr<vaAsset> > & loadedAssets, vaBackgroundTaskManager::TaskContext & taskContext )
 {
     m_assetStorageMutex.assert_locked_by_caller();
@@ -478,61 +650,147 @@ bool vaAssetPack::LoadAPACKInner( vaStream & inStream, std::vector< shared_ptr<v
         int64 subSize = 0;
         VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<int64>( subSize ) );
 
-        // read type
-        vaAssetType assetType;
-        VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<int32>( (int32&)assetType ) );
+        shared_ptr<vaAsset> newAsset = LoadAPACKAssetRecord( inStream );
+        if( newAsset == nullptr )
+            return false;
 
-        // read name
-        string newAssetName;
-        VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadString( newAssetName ) );
+        loadedAssets.push_back( newAsset );
+    }
+    return true;
+}
 
-        string suitableName = FindSuitableAssetName( newAssetName, false );
-        if( suitableName != newAssetName )
-        {
-            VA_LOG_WARNING( "There's already an asset with the name '%s' or the name has disallowed characters - renaming the new one to '%s'", newAssetName.c_str(), suitableName.c_str() );
-            newAssetName = suitableName;
-        }
-        if( Find( newAssetName, false ) != nullptr )
-        {
-            VA_LOG_ERROR( "vaAssetPack::Load(): duplicated asset name, stopping loading." );
-            assert( false );
-            return false;
-        }
+bool vaAssetPack::ReadAPACKTableOfContents( vaStream & inStream, std::vector<APACKChunkInfo> & outTOC )
+{
+    int32 chunkCount = 0;
+    VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<int32>( chunkCount ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( chunkCount >= 0 );
 
-        shared_ptr<vaAsset> newAsset = nullptr;
+    outTOC.resize( chunkCount );
+    int64 expectedOffset = 0;
+    for( APACKChunkInfo & chunkInfo : outTOC )
+    {
+        VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<int32>( (int32&)chunkInfo.Type ) );
+        VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadString( chunkInfo.Name ) );
+        VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<int64>( chunkInfo.Offset ) );
+        VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<int64>( chunkInfo.CompressedSize ) );
+        VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<int64>( chunkInfo.UncompressedSize ) );
+        VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<uint64>( chunkInfo.Hash ) );
 
-        switch( assetType )
-        {
-        case Vanilla::vaAssetType::Texture:
-            newAsset = shared_ptr<vaAsset>( vaAssetTexture::CreateAndLoadAPACK( *this, newAssetName, inStream ) );
-            break;
-        case Vanilla::vaAssetType::RenderMesh:
-            newAsset = shared_ptr<vaAsset>( vaAssetRenderMesh::CreateAndLoadAPACK( *this, newAssetName, inStream ) );
-            break;
-        case Vanilla::vaAssetType::RenderMaterial:
-            newAsset = shared_ptr<vaAsset>( vaAssetRenderMaterial::CreateAndLoadAPACK( *this, newAssetName, inStream ) );
-            break;
-        default:
-            break;
-        }
+        // chunks are stored back to back in TOC order
+        VERIFY_TRUE_RETURN_ON_FALSE( chunkInfo.Offset == expectedOffset && chunkInfo.CompressedSize > 0 && chunkInfo.UncompressedSize >= 0 );
+        expectedOffset += chunkInfo.CompressedSize;
+    }
+    return true;
+}
+
+bool vaAssetPack::ReadAPACKTableOfContents( const string & fileName, std::vector<APACKChunkInfo> & outTOC )
+{
+    vaFileStream inStream;
+    if( !inStream.Open( fileName, FileCreationMode::Open, FileAccessMode::Read ) )
+    {
+        VA_LOG_ERROR( "vaAssetPack::ReadAPACKTableOfContents(%s) - unable to open file for reading", fileName.c_str() );
+        return false;
+    }
+
+    int64 size = 0;
+    VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<int64>( size ) );
+
+    int32 fileVersion = 0;
+    VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<int32>( fileVersion ) );
+    if( fileVersion < 4 || fileVersion > c_packFileVersion )
+    {
+        VA_LOG_ERROR( "vaAssetPack::ReadAPACKTableOfContents(%s) - file version %d has no table of contents or is not supported", fileName.c_str(), fileVersion );
+        return false;
+    }
 
+    return ReadAPACKTableOfContents( inStream, outTOC );
+}
+
+bool vaAssetPack::LoadAPACKChunked( vaStream & inStream, std::vector< shared_ptr<vaAsset> > & loadedAssets, vaBackgroundTaskManager::TaskContext & taskContext )
+{
+    m_assetStorageMutex.assert_locked_by_caller();
+
+    std::vector<APACKChunkInfo> toc;
+    VERIFY_TRUE_RETURN_ON_FALSE( ReadAPACKTableOfContents( inStream, toc ) );
+    if( toc.size() == 0 )
+        return true;
+
+    // one sequential read for the whole data section
+    const int64 dataSize = toc.back().Offset + toc.back().CompressedSize;
+    std::vector<uint8> data( dataSize );
+    VERIFY_TRUE_RETURN_ON_FALSE( inStream.Read( data.data(), dataSize ) );
+
+    // verify & decompress all chunks in parallel...
+    std::vector<shared_ptr<vaMemoryStream>> chunks( toc.size() );
+    bool decompressOk = ParallelForOnBackgroundTasks( vaStringTools::Format( "Decompressing '%s.apack'", m_name.c_str() ), (int)toc.size(), [ & ]( int index )
+    {
+        chunks[index] = std::make_shared<vaMemoryStream>( toc[index].UncompressedSize, (int64)0 );
+        return DecompressAPACKChunk( data.data() + toc[index].Offset, toc[index], *chunks[index] );
+    } );
+    if( !decompressOk )
+        return false;
+    data.clear();
+    data.shrink_to_fit();
+
+    // ...and then create assets from them in order (asset creation is not thread safe)
+    for( size_t i = 0; i < toc.size(); i++ )
+    {
+        taskContext.Progress = float(i) / float(toc.size());
+
+        shared_ptr<vaAsset> newAsset = LoadAPACKAssetRecord( *chunks[i] );
         if( newAsset == nullptr )
-        {
-            VA_LOG_ERROR( "Error while loading an asset - see log file above for more info - aborting loading." );
             return false;
-        }
-        else
-        {
-            VERIFY_TRUE_RETURN_ON_FALSE( newAsset != nullptr );
+        chunks[i] = nullptr;
 
-            InsertAndTrackMe( newAsset, false );
-
-            loadedAssets.push_back( newAsset );
-        }
+        loadedAssets.push_back( newAsset );
     }
     return true;
 }
 
+shared_ptr<vaAsset> vaAssetPack::LoadAPACKAsset( const string & fileName, const string & assetName, bool lockMutex )
+{
+    // uses its own file stream, m_apackStorage could be busy with a background load
+    vaFileStream inStream;
+    if( !inStream.Open( fileName, FileCreationMode::Open, FileAccessMode::Read ) )
+    {
+        VA_LOG_ERROR( "vaAssetPack::LoadAPACKAsset(%s) - unable to open file for reading", fileName.c_str() );
+        return nullptr;
+    }
+
+    int64 size = 0; int32 fileVersion = 0;
+    std::vector<APACKChunkInfo> toc;
+    if( !inStream.ReadValue<int64>( size ) || !inStream.ReadValue<int32>( fileVersion ) || fileVersion < 4 || fileVersion > c_packFileVersion || !ReadAPACKTableOfContents( inStream, toc ) )
+    {
+        VA_LOG_ERROR( "vaAssetPack::LoadAPACKAsset(%s) - not a chunked .apack file or unsupported version", fileName.c_str() );
+        return nullptr;
+    }
+    const int64 dataStart = inStream.GetPosition( );
+
+    auto it = std::find_if( toc.begin(), toc.end(), [ &assetName ]( const APACKChunkInfo & chunkInfo ) { return vaStringTools::CompareNoCase( chunkInfo.Name, assetName ) == 0; } );
+    if( it == toc.end() )
+    {
+        VA_LOG_ERROR( "vaAssetPack::LoadAPACKAsset(%s) - asset '%s' not found", fileName.c_str(), assetName.c_str() );
+        return nullptr;
+    }
+
+    // vaStream::Seek can't fail (seeking past the end is allowed) so check that the chunk is in the file and that the seek got there
+    const int64 chunkStart = dataStart + it->Offset;
+    if( chunkStart + it->CompressedSize > inStream.GetLength( ) )
+    {
+        VA_LOG_ERROR( "vaAssetPack::LoadAPACKAsset(%s) - asset '%s' data is past the end of the file", fileName.c_str(), assetName.c_str() );
+        return nullptr;
+    }
+    std::vector<uint8> compressed( it->CompressedSize );
+    inStream.Seek( chunkStart );
+    vaMemoryStream chunk( it->UncompressedSize, (int64)0 );
+    if( inStream.GetPosition( ) != chunkStart || !inStream.Read( compressed.data(), it->CompressedSize ) || !DecompressAPACKChunk( compressed.data(), *it, chunk ) )
+        return nullptr;
+    inStream.Close( );
+
+    std::unique_lock<mutex> assetStorageMutexLock(m_assetStorageMutex, std::defer_lock );    if( lockMutex ) assetStorageMutexLock.lock(); else m_assetStorageMutex.assert_locked_by_caller();
+    return LoadAPACKAssetRecord( chunk );
+}
+
 bool vaAssetPack::LoadAPACK( const string & fileName, bool async, bool lockMutex )
 {
     WaitUntilIOTaskFinished( );
@@ -555,14 +813,14 @@ bool vaAssetPack::LoadAPACK( const string & fileName, bool async, bool lockMutex
 
     int32 fileVersion = 0;
     VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<int32>( fileVersion ) );
-    if( fileVersion < 1 || fileVersion > 3 )
+    if( fileVersion < 1 || fileVersion > c_packFileVersion )
     {
         VA_LOG_ERROR( "vaAssetPack::Load(): unsupported file version" );
         return false;
     }
 
     bool useWholeFileCompression = false;
-    if( fileVersion >= 3 )
+    if( fileVersion == 3 )
     {
         VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<bool>( useWholeFileCompression ) );
     }
@@ -573,7 +831,7 @@ bool vaAssetPack::LoadAPACK( const string & fileName, bool async, bool lockMutex
     // apackStorageLock.unlock();
 
     // async stuff here. 
-    auto loadingLambda = [this, &inStream, useWholeFileCompression]( vaBackgroundTaskManager::TaskContext & context ) 
+    auto loadingLambda = [this, &inStream, useWholeFileCompression, fileVersion]( vaBackgroundTaskManager::TaskContext & context ) 
     {
         std::vector< shared_ptr<vaAsset> > loadedAssets;
 
@@ -581,7 +839,11 @@ bool vaAssetPack::LoadAPACK( const string & fileName, bool async, bool lockMutex
         std::unique_lock<mutex> assetStorageMutexLock(m_assetStorageMutex);
 
         bool success;
-        if( useWholeFileCompression )
+        if( fileVersion >= 4 )
+        {
+            success = LoadAPACKChunked( inStream, loadedAssets, context );
+        }
+        else if( useWholeFileCompression )
         {
             vaCompressionStream decompressor( true, &inStream );
             success = LoadAPACKInner( decompressor, loadedAssets, context );
@@ -1650,6 +1912,22 @@ void vaAssetPack::UIPanelTick( vaApplicationBase & application )
                 }
             }
 
+            if( ImGui::Button( "Optimize render meshes", { -1, 0 } ) )
+                OptimizeRenderMeshes( false );
+            if( ImGui::IsItemHovered( ) )
+                ImGui::SetTooltip( "Vertex cache, overdraw and vertex fetch optimization for all meshes (and their LODs)" );
+
+            if( ImGui::Button( "Precompile material shaders", { -1, 0 } ) )
+            {
+                // the asset storage mutex is held here for the whole UI so the task has to wait for it (lockMutex true); the edit UI is
+                // disabled until it's done, same as when loading
+                assert( m_ioTask == nullptr || vaBackgroundTaskManager::GetInstance( ).IsFinished( m_ioTask ) );
+                m_ioTask = vaBackgroundTaskManager::GetInstance( ).Spawn( vaStringTools::Format( "Precompiling '%s' material shaders", m_name.c_str( ) ), vaBackgroundTaskManager::SpawnFlags::ShowInUI, 
+                    [this]( vaBackgroundTaskManager::TaskContext & context ) { GetRenderDevice( ).GetMaterialManager( ).PrecompileShaders( *this, true, &context ); return true; } );
+            }
+            if( ImGui::IsItemHovered( ) )
+                ImGui::SetTooltip( "Compile all shader permutations used by materials into the shader cache now instead of on first use (in the background)" );
+
             ImGui::Separator();
 
             if( ImGui::CollapsingHeader( "Import asset from unpacked storage", ImGuiTreeNodeFlags_Framed /*| ImGuiTreeNodeFlags_DefaultOpen*/ ) )
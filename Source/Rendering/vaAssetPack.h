@@ -229,12 +229,36 @@ namespace Vanilla
         void                                                Remove( const shared_ptr<vaAsset> & asset, bool lockMutex );
         void                                                Remove( vaAsset * asset, bool lockMutex );
         void                                                RemoveAll( bool lockMutex );
+
+        // Vertex cache, overdraw and vertex fetch optimization (vaRenderMeshOptimizer) of all render meshes in the pack, in one
+        // concurrent batch; logs ACMR/ATVR before and after. Returns the number of meshes processed.
+        int                                                 OptimizeRenderMeshes( bool lockMutex );
         
         vaRenderDevice &                                    GetRenderDevice( );
 
         bool                                                IsDirty( ) const                            { return *m_dirty; }
         void                                                SetDirty( )                                 { *m_dirty = true; }
 
+    public:
+        // Table of contents entry of a chunked .apack file (pack version 4+): every asset is stored as its own independently
+        // compressed chunk so that it can be located, checksummed and decompressed without reading the rest of the file.
+        struct APACKChunkInfo
+        {
+            vaAssetType                                     Type                = vaAssetType::MaxVal;
+            string                                          Name;
+            int64                                           Offset              = 0;    // relative to the start of the chunk data
+            int64                                           CompressedSize      = 0;
+            int64                                           UncompressedSize    = 0;
+            uint64                                          Hash                = 0;    // vaXXHash64 of the compressed chunk
+        };
+
+        // Reads only the header and the table of contents; fails on pre-chunked (version 1-3) files.
+        static bool                                         ReadAPACKTableOfContents( const string & fileName, std::vector<APACKChunkInfo> & outTOC );
+
+        // Loads a single asset by name from a chunked .apack file, reading and decompressing only its chunk; the asset is added
+        // to this pack (renamed if there's a name clash) and returned, or nullptr on failure.
+        shared_ptr<vaAsset>                                 LoadAPACKAsset( const string & fileName, const string & assetName, bool lockMutex );
+
     public:
         shared_ptr<vaAssetTexture>                          Add( const shared_ptr<vaTexture> & texture, const string & name, bool lockMutex );
         shared_ptr<vaAssetRenderMesh>                       Add( const shared_ptr<vaRenderMesh> & mesh, const string & name, bool lockMutex );
@@ -269,6 +293,10 @@ namespace Vanilla
         void                                                InsertAndTrackMe( shared_ptr<vaAsset> newAsset, bool lockMutex );
 
         bool                                                LoadAPACKInner( vaStream & inStream, std::vector< shared_ptr<vaAsset> > & loadedAssets, vaBackgroundTaskManager::TaskContext & taskContext );
+        bool                                                LoadAPACKChunked( vaStream & inStream, std::vector< shared_ptr<vaAsset> > & loadedAssets, vaBackgroundTaskManager::TaskContext & taskContext );
+        // reads one asset record (type, name, resource UID, asset data) - the contents of a chunk, or of a version 1-3 entry
+        shared_ptr<vaAsset>                                 LoadAPACKAssetRecord( vaStream & inStream );
+        static bool                                         ReadAPACKTableOfContents( vaStream & inStream, std::vector<APACKChunkInfo> & outTOC );
 
         void                                                UpdateStorageLocation( const string & newStorage, StorageMode newStorageMode, bool removePrevious );
 
@@ -0,0 +1,217 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation 
+// 
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "vaFrustumCulling.h"
+
+#include <immintrin.h>
+
+using namespace Vanilla;
+
+namespace
+{
+#ifdef __AVX__
+    typedef __m256  vfloat;
+    inline vfloat   VLoad( const float * p )                                { return _mm256_loadu_ps( p ); }
+    inline vfloat   VSet1( float s )                                        { return _mm256_set1_ps( s ); }
+    inline vfloat   VAdd( vfloat a, vfloat b )                              { return _mm256_add_ps( a, b ); }
+    inline vfloat   VMul( vfloat a, vfloat b )                              { return _mm256_mul_ps( a, b ); }
+    inline vfloat   VOr( vfloat a, vfloat b )                               { return _mm256_or_ps( a, b ); }
+    inline vfloat   VNeg( vfloat a )                                        { return _mm256_xor_ps( a, _mm256_set1_ps( -0.0f ) ); }
+    inline vfloat   VLess( vfloat a, vfloat b )                             { return _mm256_cmp_ps( a, b, _CMP_LT_OQ ); }
+    inline vfloat   VZero( )                                                { return _mm256_setzero_ps( ); }
+    inline uint32   VMoveMask( vfloat a )                                   { return (uint32)_mm256_movemask_ps( a ); }
+#else
+    typedef __m128  vfloat;
+    inline vfloat   VLoad( const float * p )                                { return _mm_loadu_ps( p ); }
+    inline vfloat   VSet1( float s )                                        { return _mm_set1_ps( s ); }
+    inline vfloat   VAdd( vfloat a, vfloat b )                              { return _mm_add_ps( a, b ); }
+    inline vfloat   VMul( vfloat a, vfloat b )                              { return _mm_mul_ps( a, b ); }
+    inline vfloat   VOr( vfloat a, vfloat b )                               { return _mm_or_ps( a, b ); }
+    inline vfloat   VNeg( vfloat a )                                        { return _mm_xor_ps( a, _mm_set1_ps( -0.0f ) ); }
+    inline vfloat   VLess( vfloat a, vfloat b )                             { return _mm_cmplt_ps( a, b ); }
+    inline vfloat   VZero( )                                                { return _mm_setzero_ps( ); }
+    inline uint32   VMoveMask( vfloat a )                                   { return (uint32)_mm_movemask_ps( a ); }
+#endif
+
+    const uint32 c_fullMask = ( 1u << vaFrustumCulling::c_BatchWidth ) - 1;
+
+    // one batch (c_BatchWidth instances) of bounds, loaded once and tested against any number of planes
+    struct BatchBounds
+    {
+        vfloat      SX, SY, SZ, NegRadius;
+        vfloat      BX, BY, BZ, HX, HY, HZ;
+
+        BatchBounds( const vaCullingBoundsSoA & bounds, uint32 base, bool testBoxes )
+        {
+            SX          = VLoad( bounds.SphereX + base );
+            SY          = VLoad( bounds.SphereY + base );
+            SZ          = VLoad( bounds.SphereZ + base );
+            NegRadius   = VNeg( VLoad( bounds.SphereRadius + base ) );
+            if( testBoxes )
+            {
+                BX = VLoad( bounds.BoxX + base );       BY = VLoad( bounds.BoxY + base );       BZ = VLoad( bounds.BoxZ + base );
+                HX = VLoad( bounds.BoxHalfX + base );   HY = VLoad( bounds.BoxHalfY + base );   HZ = VLoad( bounds.BoxHalfZ + base );
+            }
+            else
+                BX = BY = BZ = HX = HY = HZ = VZero( );
+        }
+    };
+
+    // Returns the mask of lanes that are fully behind at least one of the planes: spheres first, then, unless all are already
+    // out, the boxes.
+    inline uint32 OutsideMask( const BatchBounds & batch, const vaCullingViewSet::PreparedPlane * planes, int planeCount, bool testBoxes )
+    {
+        vfloat outside = VZero( );
+        for( int p = 0; p < planeCount; p++ )
+        {
+            const vaCullingViewSet::PreparedPlane & plane = planes[p];
+            const vfloat dist = VAdd( VAdd( VAdd( VMul( VLoad( plane.A ), batch.SX ), VMul( VLoad( plane.B ), batch.SY ) ), VMul( VLoad( plane.C ), batch.SZ ) ), VLoad( plane.D ) );
+            outside = VOr( outside, VLess( dist, batch.NegRadius ) );
+        }
+        if( testBoxes && VMoveMask( outside ) != c_fullMask )
+        {
+            for( int p = 0; p < planeCount; p++ )
+            {
+                const vaCullingViewSet::PreparedPlane & plane = planes[p];
+                const vfloat dist       = VAdd( VAdd( VAdd( VMul( VLoad( plane.A ), batch.BX ), VMul( VLoad( plane.B ), batch.BY ) ), VMul( VLoad( plane.C ), batch.BZ ) ), VLoad( plane.D ) );
+                const vfloat projected  = VAdd( VAdd( VMul( VLoad( plane.AbsA ), batch.HX ), VMul( VLoad( plane.AbsB ), batch.HY ) ), VMul( VLoad( plane.AbsC ), batch.HZ ) );
+                outside = VOr( outside, VLess( dist, VNeg( projected ) ) );
+            }
+        }
+        return VMoveMask( outside );
+    }
+
+    inline uint32 ValidLaneMask( uint32 count, uint32 base )
+    {
+        return ( count - base < vaFrustumCulling::c_BatchWidth ) ? ( ( 1u << ( count - base ) ) - 1 ) : ( c_fullMask );
+    }
+
+    inline void PreparePlane( vaCullingViewSet::PreparedPlane & outPlane, const vaPlane & plane )
+    {
+        for( int i = 0; i < 8; i++ )
+        {
+            outPlane.A[i]       = plane.a;              outPlane.B[i]       = plane.b;              outPlane.C[i]       = plane.c;          outPlane.D[i] = plane.d;
+            outPlane.AbsA[i]    = std::abs( plane.a );  outPlane.AbsB[i]    = std::abs( plane.b );  outPlane.AbsC[i]    = std::abs( plane.c );
+        }
+    }
+}
+
+int vaCullingViewSet::AddView( const vaPlane * planes, int planeCount )
+{
+    assert( planes != nullptr || planeCount == 0 );
+    assert( planeCount <= vaFrustumCulling::c_MaxPlanes );
+    if( ViewCount( ) >= vaFrustumCulling::c_MaxViews )
+    {
+        assert( false );
+        return -1;
+    }
+    for( int p = 0; p < planeCount; p++ )
+    {
+        m_planes.emplace_back( );
+        PreparePlane( m_planes.back( ), planes[p] );
+    }
+    m_viewPlaneStart.push_back( (int)m_planes.size( ) );
+    return ViewCount( ) - 1;
+}
+
+uint32 vaFrustumCulling::Cull( const vaCullingBoundsSoA & bounds, const vaPlane * planes, int planeCount, bool testBoxes, uint32 * outVisibleIndices )
+{
+    assert( planes != nullptr || planeCount == 0 );
+
+    if( planeCount == 0 )
+    {
+        for( uint32 i = 0; i < bounds.Count; i++ )
+            outVisibleIndices[i] = i;
+        return bounds.Count;
+    }
+
+    assert( planeCount <= c_MaxPlanes );
+    planeCount = std::min( planeCount, c_MaxPlanes );
+    vaCullingViewSet::PreparedPlane preparedPlanes[c_MaxPlanes];
+    for( int p = 0; p < planeCount; p++ )
+        PreparePlane( preparedPlanes[p], planes[p] );
+
+    uint32 visibleCount = 0;
+    for( uint32 base = 0; base < bounds.Count; base += c_BatchWidth )
+    {
+        uint32 visibleMask = ~OutsideMask( BatchBounds( bounds, base, testBoxes ), preparedPlanes, planeCount, testBoxes ) & ValidLaneMask( bounds.Count, base );
+        while( visibleMask != 0 )
+        {
+            unsigned long lane;
+            _BitScanForward( &lane, visibleMask );
+            visibleMask &= visibleMask - 1;
+            outVisibleIndices[visibleCount++] = base + lane;
+        }
+    }
+    return visibleCount;
+}
+
+uint32 vaFrustumCulling::CullReference( const vaCullingBoundsSoA & bounds, const vaPlane * planes, int planeCount, bool testBoxes, uint32 * outVisibleIndices )
+{
+    uint32 visibleCount = 0;
+    for( uint32 i = 0; i < bounds.Count; i++ )
+    {
+        bool outside = false;
+        for( int p = 0; p < planeCount && !outside; p++ )
+        {
+            const vaPlane & plane = planes[p];
+            const float sphereDist = plane.a * bounds.SphereX[i] + plane.b * bounds.SphereY[i] + plane.c * bounds.SphereZ[i] + plane.d;
+            outside |= sphereDist < -bounds.SphereRadius[i];
+            if( testBoxes )
+            {
+                const float boxDist     = plane.a * bounds.BoxX[i] + plane.b * bounds.BoxY[i] + plane.c * bounds.BoxZ[i] + plane.d;
+                const float projected   = std::abs( plane.a ) * bounds.BoxHalfX[i] + std::abs( plane.b ) * bounds.BoxHalfY[i] + std::abs( plane.c ) * bounds.BoxHalfZ[i];
+                outside |= boxDist < -projected;
+            }
+        }
+        if( !outside )
+            outVisibleIndices[visibleCount++] = i;
+    }
+    return visibleCount;
+}
+
+void vaFrustumCulling::CullMultiView( const vaCullingBoundsSoA & bounds, const vaCullingViewSet & views, bool testBoxes, uint64 * outViewMasks )
+{
+    const int viewCount = views.ViewCount( );
+    for( uint32 base = 0; base < bounds.Count; base += c_BatchWidth )
+    {
+        const uint32 validMask = ValidLaneMask( bounds.Count, base );
+        const BatchBounds batch( bounds, base, testBoxes );
+
+        uint64 laneMasks[c_BatchWidth] = { };
+        for( int view = 0; view < viewCount; view++ )
+        {
+            uint32 visibleMask = ~OutsideMask( batch, views.ViewPlanes( view ), views.ViewPlaneCount( view ), testBoxes ) & validMask;
+            while( visibleMask != 0 )
+            {
+                unsigned long lane;
+                _BitScanForward( &lane, visibleMask );
+                visibleMask &= visibleMask - 1;
+                laneMasks[lane] |= 1ull << view;
+            }
+        }
+        for( uint32 lane = 0; lane < c_BatchWidth && ( validMask & ( 1u << lane ) ) != 0; lane++ )
+            outViewMasks[base + lane] = laneMasks[lane];
+    }
+}
+
+uint32 vaFrustumCulling::ExtractVisible( const uint64 * viewMasks, uint32 count, int viewIndex, uint32 * outVisibleIndices )
+{
+    assert( viewIndex >= 0 && viewIndex < c_MaxViews );
+    const uint64 viewBit = 1ull << viewIndex;
+    uint32 visibleCount = 0;
+    for( uint32 i = 0; i < count; i++ )
+    {
+        // branchless - always write, only advance if visible
+        outVisibleIndices[visibleCount] = i;
+        visibleCount += ( viewMasks[i] & viewBit ) ? ( 1 ) : ( 0 );
+    }
+    return visibleCount;
+}
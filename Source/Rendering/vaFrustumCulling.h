@@ -0,0 +1,131 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation 
+// 
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Core/vaCoreIncludes.h"
+
+namespace Vanilla
+{
+    // Non-owning structure-of-arrays view of instance bounds (bounding spheres and AABBs stored as center + half-size, which is
+    // what the plane test wants), for batched culling with vaFrustumCulling. Arrays must be readable (but not necessarily valid)
+    // up to Count rounded up to vaFrustumCulling::c_BatchWidth.
+    struct vaCullingBoundsSoA
+    {
+        const float *                       SphereX         = nullptr;
+        const float *                       SphereY         = nullptr;
+        const float *                       SphereZ         = nullptr;
+        const float *                       SphereRadius    = nullptr;
+        const float *                       BoxX            = nullptr;
+        const float *                       BoxY            = nullptr;
+        const float *                       BoxZ            = nullptr;
+        const float *                       BoxHalfX        = nullptr;
+        const float *                       BoxHalfY        = nullptr;
+        const float *                       BoxHalfZ        = nullptr;
+        uint32                              Count           = 0;
+    };
+
+    // Fixed capacity storage for vaCullingBoundsSoA; filled in lock-step with whatever the bounds belong to (for ex. the
+    // vaSceneRenderInstanceProcessor::SceneItem batch, from Scene::WorldBounds).
+    template< uint32 Capacity >
+    struct vaCullingBoundsStorage
+    {
+        static constexpr uint32             c_PaddedCapacity    = ( Capacity + 7 ) & ~7u;
+
+        alignas( 32 ) float                 SphereX[c_PaddedCapacity];
+        alignas( 32 ) float                 SphereY[c_PaddedCapacity];
+        alignas( 32 ) float                 SphereZ[c_PaddedCapacity];
+        alignas( 32 ) float                 SphereRadius[c_PaddedCapacity];
+        alignas( 32 ) float                 BoxX[c_PaddedCapacity];
+        alignas( 32 ) float                 BoxY[c_PaddedCapacity];
+        alignas( 32 ) float                 BoxZ[c_PaddedCapacity];
+        alignas( 32 ) float                 BoxHalfX[c_PaddedCapacity];
+        alignas( 32 ) float                 BoxHalfY[c_PaddedCapacity];
+        alignas( 32 ) float                 BoxHalfZ[c_PaddedCapacity];
+        uint32                              Count               = 0;
+
+        void                                Clear( )                    { Count = 0; }
+
+        // Degenerate (never updated or empty) bounds are stored so that they always get culled.
+        void                                Append( const vaBoundingSphere & bs, const vaBoundingBox & aabb )
+        {
+            assert( Count < Capacity );
+            const uint32 i = Count++;
+            if( bs.Radius < 0 || aabb.Size.x < 0 )
+            {
+                SphereX[i] = SphereY[i] = SphereZ[i] = 0.0f;    SphereRadius[i] = -std::numeric_limits<float>::infinity();
+                BoxX[i] = BoxY[i] = BoxZ[i] = 0.0f;             BoxHalfX[i] = BoxHalfY[i] = BoxHalfZ[i] = -std::numeric_limits<float>::infinity();
+                return;
+            }
+            SphereX[i]  = bs.Center.x;                          SphereY[i]  = bs.Center.y;                          SphereZ[i]  = bs.Center.z;      SphereRadius[i] = bs.Radius;
+            BoxHalfX[i] = aabb.Size.x * 0.5f;                   BoxHalfY[i] = aabb.Size.y * 0.5f;                   BoxHalfZ[i] = aabb.Size.z * 0.5f;
+            BoxX[i]     = aabb.Min.x + BoxHalfX[i];             BoxY[i]     = aabb.Min.y + BoxHalfY[i];             BoxZ[i]     = aabb.Min.z + BoxHalfZ[i];
+        }
+
+        vaCullingBoundsSoA                  SoA( ) const                { return { SphereX, SphereY, SphereZ, SphereRadius, BoxX, BoxY, BoxZ, BoxHalfX, BoxHalfY, BoxHalfZ, Count }; }
+    };
+
+    // Planes of a set of views (up to vaFrustumCulling::c_MaxViews), pre-broadcast for the SIMD kernel so that it can be set up
+    // once per frame and used for every vaFrustumCulling::CullMultiView batch.
+    class vaCullingViewSet
+    {
+    public:
+        struct alignas( 32 ) PreparedPlane
+        {
+            float                           A[8], B[8], C[8], D[8];
+            float                           AbsA[8], AbsB[8], AbsC[8];
+        };
+
+    private:
+        std::vector<PreparedPlane>          m_planes;
+        std::vector<int>                    m_viewPlaneStart    = { 0 };    // planes of view N are [m_viewPlaneStart[N], m_viewPlaneStart[N+1])
+
+    public:
+        void                                Clear( )                    { m_planes.clear( ); m_viewPlaneStart = { 0 }; }
+        // returns the view index (its bit in CullMultiView masks) or -1 if there are already c_MaxViews views
+        int                                 AddView( const vaPlane * planes, int planeCount );
+        int                                 ViewCount( ) const          { return (int)m_viewPlaneStart.size( ) - 1; }
+
+        const PreparedPlane *               ViewPlanes( int viewIndex ) const       { return m_planes.data( ) + m_viewPlaneStart[viewIndex]; }
+        int                                 ViewPlaneCount( int viewIndex ) const   { return m_viewPlaneStart[viewIndex+1] - m_viewPlaneStart[viewIndex]; }
+    };
+
+    // Batched SIMD frustum culling (8-wide with AVX, 4-wide SSE otherwise) shared by all views - main camera, shadow map faces
+    // and IBL probes. A sphere or box is culled if it is fully behind any of the planes (same convention as
+    // vaBoundingSphere::IntersectFrustum); with testBoxes the AABB is tested too, using the center/half-size projection which
+    // is exact for each plane.
+    class vaFrustumCulling
+    {
+    public:
+#ifdef __AVX__
+        static constexpr uint32             c_BatchWidth        = 8;
+#else
+        static constexpr uint32             c_BatchWidth        = 4;
+#endif
+        static constexpr int                c_MaxPlanes         = 8;
+        static constexpr int                c_MaxViews          = 64;
+
+    public:
+        // Writes indices of all bounds not culled into outVisibleIndices (must have room for bounds.Count) and returns their count.
+        static uint32                       Cull( const vaCullingBoundsSoA & bounds, const vaPlane * planes, int planeCount, bool testBoxes, uint32 * outVisibleIndices );
+
+        // Scalar version of the above, same math - for reference and validation.
+        static uint32                       CullReference( const vaCullingBoundsSoA & bounds, const vaPlane * planes, int planeCount, bool testBoxes, uint32 * outVisibleIndices );
+
+        // Single pass over the bounds for all views at once - each instance is loaded once and tested against every view - writing
+        // per instance a bitmask of the views it's visible in (bit N for view N of the set). Used to fill all views' lists from
+        // one selection pass instead of every view culling the whole scene on its own.
+        static void                         CullMultiView( const vaCullingBoundsSoA & bounds, const vaCullingViewSet & views, bool testBoxes, uint64 * outViewMasks );
+
+        // Scatter of the CullMultiView output: indices of all instances visible in the given view.
+        static uint32                       ExtractVisible( const uint64 * viewMasks, uint32 count, int viewIndex, uint32 * outVisibleIndices );
+    };
+
+}
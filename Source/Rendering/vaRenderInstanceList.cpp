@@ -17,6 +17,8 @@
 
 #include "vaRenderBuffers.h"
 
+#include "Core/Misc/vaRadixSort.h"
+
 #include <future>
 
 //#undef VA_TASKFLOW_INTEGRATION_ENABLED
@@ -30,9 +32,12 @@ namespace Vanilla
     class vaRenderInstanceListSorterInstance
     {
     private:
+        // below this the whole sort runs as a single task - splitting into chunks costs more than it saves
+        static constexpr uint32             c_parallelSortMinCount  = 16384;
+        static constexpr uint32             c_parallelSortChunkSize = 8192;
 
-        std::vector<pair<int, float>>            m_sortDistances;          // first is a sort group - items first get sorted by it and then by distance
-        std::vector<int>                         m_sortedIndices;
+        vaRadixSort                         m_radixSort;                // keys are built by MakeSortKey, values are list indices
+        vaRenderInstanceList::SortIndices   m_sortedIndices;
 
         vaRenderInstanceList::SortSettings     m_settings;
         vaRenderInstanceList &                 m_parent;
@@ -50,7 +55,7 @@ namespace Vanilla
 
         bool                                Initialize( const vaRenderInstanceList::SortSettings & sortSettings, int sessionID );
         bool                                Start( );
-        int                                 Finish( const std::vector<int> * & sortedIndices );
+        int                                 Finish( const vaRenderInstanceList::SortIndices * & sortedIndices );
 
         void                                Reset( )                
         {
@@ -63,8 +68,8 @@ namespace Vanilla
 #endif
             m_finished = false;
             m_sessionID = -1; 
-            m_sortedIndices.clear(); 
-            m_sortDistances.clear(); 
+            m_sortedIndices = vaRenderInstanceList::SortIndices( );   // (drops the storage so it can't outlive the frame arena ring)
+            m_radixSort.Begin( 0, 1 );
             m_settings = vaRenderInstanceList::SortSettings(); 
         }
     };
@@ -73,6 +78,43 @@ namespace Vanilla
 
 using namespace Vanilla;
 
+// Packs everything the list gets sorted by into one 64-bit key so that a radix sort can be used and so that the order is fully
+// determined by the key (ties fall back to list order as the sort is stable):
+//  [63..48]    sort group: 0 for everything but decals, which go after, ordered by their DecalSortOrder
+//  [47..0]     distance (31 bits) then material (17 bits); for sort group 0 the other way around if SortSettings::SortByMaterial
+//              is set - decals always stay in distance order as they blend over each other
+// Non-negative float bits compare the same as the floats so the distance needs no conversion; back to front just flips them.
+uint64 vaRenderInstanceList::MakeSortKey( bool isDecal, int decalSortOrder, float distanceFromRef, int materialGlobalIndex, const SortSettings & settings )
+{
+    uint64 sortGroup = 0;
+    // special decal case - they get rendered with opaque but go after all non-decal stuff has rendered regardless of FrontToBack/BackToFront sort order 
+    if( isDecal )
+        sortGroup = (uint64)( vaMath::Clamp( decalSortOrder, -32767, 32767 ) + 32768 );
+
+    const float distance = ( distanceFromRef > 0.0f ) ? ( distanceFromRef ) : ( 0.0f );   // (also takes care of NaNs)
+    uint32 distanceBits;
+    memcpy( &distanceBits, &distance, sizeof( distanceBits ) );
+    if( !settings.FrontToBack )
+        distanceBits = 0x7FFFFFFF - distanceBits;
+
+    const uint64 material = (uint64)( materialGlobalIndex + 1 ) & 0x1FFFF;
+
+    if( settings.SortByMaterial && sortGroup == 0 )
+        return ( sortGroup << 48 ) | ( material << 31 ) | (uint64)distanceBits;
+    else
+        return ( sortGroup << 48 ) | ( (uint64)distanceBits << 17 ) | material;
+}
+
+namespace
+{
+    inline uint64 MakeSortKey( const vaRenderInstance & item, const vaRenderInstanceList::SortSettings & settings )
+    {
+        assert( item.Material != nullptr );    // not allowed anymore
+        const int decalSortOrder = ( item.Flags.IsDecal ) ? ( item.Material->GetMaterialSettings( ).DecalSortOrder ) : ( 0 );
+        return vaRenderInstanceList::MakeSortKey( item.Flags.IsDecal != 0, decalSortOrder, item.DistanceFromRef, item.Material->GetGlobalIndex( ), settings );
+    }
+}
+
 bool vaRenderInstanceListSorterInstance::Initialize( const vaRenderInstanceList::SortSettings& sortSettings, int sessionID )
 {
     assert( vaThreading::IsMainThread( ) );
@@ -98,62 +140,80 @@ bool vaRenderInstanceListSorterInstance::Start(  )
 #endif
 
     // data sizes!
-    m_sortDistances.resize( drawList.second );
-    m_sortedIndices.resize( drawList.second );
-
-    auto sortComp = [ This = this ] ( int ia, int ib ) -> bool
-    {
-        // first sort by special type
-        if( This->m_sortDistances[ia].first != This->m_sortDistances[ib].first )
-            return This->m_sortDistances[ia].first < This->m_sortDistances[ib].first;
-        else // then by distance
-            return ( This->m_settings.FrontToBack ) ? ( This->m_sortDistances[ia].second < This->m_sortDistances[ib].second ) : ( This->m_sortDistances[ia].second > This->m_sortDistances[ib].second );
-    };
+    const uint32 count = drawList.second;
+#ifdef VA_TASKFLOW_INTEGRATION_ENABLED
+    const int chunkCount = ( count < c_parallelSortMinCount ) ? ( 1 ) : ( std::max( 1, std::min( vaTF::ThreadCount( ), (int)( count / c_parallelSortChunkSize ) ) ) );
+#else
+    const int chunkCount = 1;
+#endif
+    m_radixSort.Begin( count, chunkCount );
+    m_sortedIndices.resize( count );
 
-    auto sortCallback = [ drawList, renderInstances = m_parent.GetGlobalInstanceArray(), &sortedIndices = m_sortedIndices, &sortDistances = m_sortDistances, &settings = m_settings]( )
+    auto prepareCallback = [ drawList, renderInstances = m_parent.GetGlobalInstanceArray(), &radixSort = m_radixSort, &settings = m_settings]( int chunk )
     {
-#ifndef VA_TASKFLOW_INTEGRATION_ENABLED
-        VA_TRACE_CPU_SCOPE( RenderSelectionSort_Prepare );
-#endif
-        for( uint32 i = 0; i < drawList.second; i++ )
+        uint64 * keys   = radixSort.Keys( );
+        uint32 * values = radixSort.Values( );
+        const auto [begin, end] = radixSort.ChunkRange( chunk );
+        for( uint32 i = begin; i < end; i++ )
         {
-            // auto & itemLocal    = drawList.first[i];
             auto & itemGlobal   = renderInstances[drawList.first[i].InstanceIndex];
-
-            assert( itemGlobal.Material != nullptr );    // not allowed anymore
-
-            int sortGroup = 0;
-
-            // special decal case - they get rendered with opaque but go after all non-decal stuff has rendered regardless of FrontToBack/BackToFront sort order 
-            if( itemGlobal.Flags.IsDecal )
-                sortGroup = vaMath::Clamp( itemGlobal.Material->GetMaterialSettings( ).DecalSortOrder, -65536, 65536 ) + 100000;
-            //else if( settings.SortByVRSType )
-            //    sortGroup = (int)item.Properties.ShadingRate;
-            //assert( itemA.Transform == itemLocal.Transform );
-
-            //sortDistances[i] = { sortGroup, ( vaVector3::TransformCoord( itemGlobal.Mesh->GetAABB( ).Center( ), itemGlobal.Transform ) - settings.ReferencePoint ).Length( ) };
-            sortDistances[i] = { sortGroup, itemGlobal.DistanceFromRef };
-            sortedIndices[i] = i;
+            keys[i]     = MakeSortKey( itemGlobal, settings );
+            values[i]   = i;
         }
     };
 
+    auto finishCallback = [ &radixSort = m_radixSort, &sortedIndices = m_sortedIndices ]( )
+    {
+        const uint32 * values = radixSort.SortedValues( );
+        for( uint32 i = 0; i < radixSort.Count( ); i++ )
+            sortedIndices[i] = (int)values[i];
+    };
+
 #ifdef VA_TASKFLOW_INTEGRATION_ENABLED
-    tf::Task prepareTask = m_sortTaskFlow.emplace( sortCallback ).name( "RenderSelectionSortPrepare" );
-    tf::Task sortTask = m_sortTaskFlow.sort(  m_sortedIndices.begin( ), m_sortedIndices.end( ), std::move(sortComp) ).name( "RenderSelectionSort" );
-    prepareTask.precede(sortTask);
+    if( chunkCount == 1 )
+    {
+        m_sortTaskFlow.emplace( [ prepareCallback, finishCallback, &radixSort = m_radixSort ]( )
+        {
+            prepareCallback( 0 );
+            radixSort.SortSerial( );
+            finishCallback( );
+        } ).name( "RenderSelectionSort" );
+    }
+    else
+    {
+        // prepare -> for each pass: histograms -> prefix sum -> scatter -> ... -> copy out; chunks within a step run in parallel
+        auto [prepareStart, prepareEnd] = vaTF::parallel_for_emplace( m_sortTaskFlow, 0, chunkCount, prepareCallback, 1, "RenderSelectionSortPrepare" );
+        tf::Task previous = prepareEnd;
+        for( int pass = 0; pass < vaRadixSort::c_PassCount; pass++ )
+        {
+            auto [histogramStart, histogramEnd] = vaTF::parallel_for_emplace( m_sortTaskFlow, 0, chunkCount, [ &radixSort = m_radixSort, pass ]( int chunk ) { radixSort.Histogram( pass, chunk ); }, 1, "RenderSelectionSortHistogram" );
+            tf::Task prefixSum = m_sortTaskFlow.emplace( [ &radixSort = m_radixSort, pass ]( ) { radixSort.PrefixSum( pass ); } ).name( "RenderSelectionSortPrefixSum" );
+            auto [scatterStart, scatterEnd] = vaTF::parallel_for_emplace( m_sortTaskFlow, 0, chunkCount, [ &radixSort = m_radixSort, pass ]( int chunk ) { radixSort.Scatter( pass, chunk ); }, 1, "RenderSelectionSortScatter" );
+            previous.precede( histogramStart );
+            histogramEnd.precede( prefixSum );
+            prefixSum.precede( scatterStart );
+            previous = scatterEnd;
+        }
+        tf::Task finishTask = m_sortTaskFlow.emplace( finishCallback ).name( "RenderSelectionSortFinish" );
+        previous.precede( finishTask );
+    }
     m_sortFuture = vaTF::Executor().run( m_sortTaskFlow );
 #else
-    sortCallback( );
+    {
+        VA_TRACE_CPU_SCOPE( RenderSelectionSort_Prepare );
+        prepareCallback( 0 );
+    }
     {
         VA_TRACE_CPU_SCOPE( RenderSelectionSort_Sort );
-        std::sort( sortedIndices.begin( ), sortedIndices.end( ), sortComp );
+        m_radixSort.SortSerial( );
+        finishCallback( );
     }
 #endif
 
     return true;
 }
 
-int vaRenderInstanceListSorterInstance::Finish( const std::vector<int> * & sortedIndices )
+int vaRenderInstanceListSorterInstance::Finish( const vaRenderInstanceList::SortIndices * & sortedIndices )
 {
     assert( vaThreading::IsMainThread( ) );
     assert( m_sessionID != -1 );    // invalid sorting setup - please fix
@@ -167,7 +227,7 @@ int vaRenderInstanceListSorterInstance::Finish( const std::vector<int> * & sorte
 #endif
         m_finished = true;
     }
-    assert( m_sortedIndices.size( ) == m_sortDistances.size( ) ); // some kind of serious bug - please fix
+    assert( m_sortedIndices.size( ) == m_radixSort.Count( ) ); // some kind of serious bug - please fix
    
     sortedIndices = &m_sortedIndices;
 
@@ -285,7 +345,7 @@ vaRenderInstanceList::SortHandle vaRenderInstanceList::ScheduleSort( const SortS
     return (vaRenderInstanceList::SortHandle)((int64(m_instanceID) << 32) | (m_activeSorters.size()-1));
 }
 
-const std::vector<int> * vaRenderInstanceList::GetSortIndices( SortHandle sortHandle ) const
+const vaRenderInstanceList::SortIndices * vaRenderInstanceList::GetSortIndices( SortHandle sortHandle ) const
 {
     VA_TRACE_CPU_SCOPE( GetSortIndices );
     assert( vaThreading::IsMainThread( ) );
@@ -306,7 +366,7 @@ const std::vector<int> * vaRenderInstanceList::GetSortIndices( SortHandle sortHa
         return nullptr;
     }
     shared_ptr<vaRenderInstanceListSorterInstance> sortInstance = m_activeSorters[sortInstanceIndex];
-    const std::vector<int> * sortedIndices = nullptr;
+    const SortIndices * sortedIndices = nullptr;
     if( sortInstance->Finish( sortedIndices ) != m_resetCounter )
     {
         // mismatch in ID - this sort handle is probably outdated
@@ -334,13 +394,16 @@ vaRenderInstanceList::FilterSettings vaRenderInstanceList::FilterSettings::Shado
 
 vaRenderInstanceList::FilterSettings vaRenderInstanceList::FilterSettings::EnvironmentProbeCull( const Scene::IBLProbe & probeData )
 {
-    FilterSettings ret;
-
-    probeData;
-    // make a frustum cube based on
-    // probeData.Position
-    // probeData.ClipFar
+    return CubeCull( probeData.Position, probeData.ClipFar );
+}
 
+vaRenderInstanceList::FilterSettings vaRenderInstanceList::FilterSettings::CubeCull( const vaVector3 & center, float halfSize )
+{
+    FilterSettings ret;
+    ret.FrustumPlanes = {
+        vaPlane(  1.0f,  0.0f,  0.0f, halfSize - center.x ), vaPlane( -1.0f,  0.0f,  0.0f, halfSize + center.x ),
+        vaPlane(  0.0f,  1.0f,  0.0f, halfSize - center.y ), vaPlane(  0.0f, -1.0f,  0.0f, halfSize + center.y ),
+        vaPlane(  0.0f,  0.0f,  1.0f, halfSize - center.z ), vaPlane(  0.0f,  0.0f, -1.0f, halfSize + center.z ) };
     return ret;
 }
 
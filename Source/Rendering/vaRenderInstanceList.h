@@ -22,6 +22,10 @@
 // 
 // #include "Rendering/Shaders/vaSharedTypes.h"
 
+// Keep the per-frame item list and sort indices in vaFrameArena memory (per-thread, recycled every c_FramesInFlight frames)
+// instead of each list holding on to its own heap buffers; list contents are only valid from StopCollecting to Reset anyway.
+#define VA_RENDER_INSTANCE_LIST_USE_FRAME_ARENA
+
 namespace Vanilla
 {
     namespace Scene
@@ -74,6 +78,15 @@ namespace Vanilla
             vaShadingRate                   ShadingRate;        // vaShadingRate::ShadingRate1X1;        // per-draw-call shading rate
         };
 
+#ifdef VA_RENDER_INSTANCE_LIST_USE_FRAME_ARENA
+        template< typename Type >
+        using TransientAllocator            = vaFrameAllocator<Type>;
+#else
+        template< typename Type >
+        using TransientAllocator            = std::allocator<Type>;
+#endif
+        typedef std::vector<int, TransientAllocator<int>>  SortIndices;
+
         // contains culling and sorting information that should be honored when filling up the vaRenderInstanceList
         struct FilterSettings
         {
@@ -87,6 +100,8 @@ namespace Vanilla
             static FilterSettings           FrustumCull( const vaCameraBase & camera );
             static FilterSettings           ShadowmapCull( const vaShadowmap & shadowmap );
             static FilterSettings           EnvironmentProbeCull( const Scene::IBLProbe & probeData );
+            // axis aligned cube around center - the union of all 6 faces of a cubemap view with the given far plane distance
+            static FilterSettings           CubeCull( const vaVector3 & center, float halfSize );
         };
 
         struct SortSettings
@@ -96,6 +111,7 @@ namespace Vanilla
             vaVector3                       ReferencePoint          = vaVector3( std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity() );
             bool                            SortByDistanceToPoint   = false;        // useful for cubemaps and etc; probably not fully correct for transparencies? (would need sorting by distance to the plane?)
             bool                            FrontToBack             = true;         // front to back for opaque/depth pre-pass, back to front for transparencies is usual
+            bool                            SortByMaterial          = false;        // material first, then distance - fewer state changes; makes sense for opaque after a depth pre-pass has already done the occlusion
 
             //bool                            SortByVRSType           = false;        // this will force sorting by shading rate first
 
@@ -103,13 +119,17 @@ namespace Vanilla
             inline bool operator != ( const SortSettings & other ) const    { return !(*this==other); }
 
             //static SortSettings             Standard( bool sortByVRSType ) { SortSettings ret; ret.SortByVRSType = sortByVRSType; return ret; }
-            static SortSettings             Standard( const vaVector3 & referencePoint, bool frontToBack/*, bool sortByVRSType*/ ) { SortSettings ret; ret.SortByDistanceToPoint = true; ret.ReferencePoint = referencePoint; ret.FrontToBack = frontToBack; /*ret.SortByVRSType = sortByVRSType;*/ return ret; }
-            static SortSettings             Standard( const vaCameraBase & camera, bool frontToBack/*, bool sortByVRSType*/ ) { SortSettings ret; ret.SortByDistanceToPoint = true; ret.ReferencePoint = camera.GetPosition(); ret.FrontToBack = frontToBack; /*ret.SortByVRSType = sortByVRSType;*/ return ret; }
+            static SortSettings             Standard( const vaVector3 & referencePoint, bool frontToBack, bool sortByMaterial = false/*, bool sortByVRSType*/ ) { SortSettings ret; ret.SortByDistanceToPoint = true; ret.ReferencePoint = referencePoint; ret.FrontToBack = frontToBack; ret.SortByMaterial = sortByMaterial; /*ret.SortByVRSType = sortByVRSType;*/ return ret; }
+            static SortSettings             Standard( const vaCameraBase & camera, bool frontToBack, bool sortByMaterial = false/*, bool sortByVRSType*/ ) { SortSettings ret; ret.SortByDistanceToPoint = true; ret.ReferencePoint = camera.GetPosition(); ret.FrontToBack = frontToBack; ret.SortByMaterial = sortByMaterial; /*ret.SortByVRSType = sortByVRSType;*/ return ret; }
         };
 
         typedef uint64 SortHandle;
         static const SortHandle             EmptySortHandle         = uint64(-1L);
 
+        // The 64-bit radix sort key the sorters order items by (stable, so ties keep list order); materialGlobalIndex is
+        // vaRenderMaterial::GetGlobalIndex, decalSortOrder is only used if isDecal. Public for tools and benchmarks.
+        static uint64                       MakeSortKey( bool isDecal, int decalSortOrder, float distanceFromRef, int materialGlobalIndex, const SortSettings & settings );
+
     private:
         static int                          s_instanceCounter;
         const int                           m_instanceID;
@@ -118,8 +138,8 @@ namespace Vanilla
         bool                                m_ready                 = false;            // ready to start
         atomic_bool                         m_started               = false;            // started, ready to collect data
 
-        unique_ptr<vaAppendConsumeList< Item >>         
-                                            m_list                  = std::make_unique<vaAppendConsumeList< Item >>();
+        typedef vaAppendConsumeList< Item, 128, 384, TransientAllocator<Item> >  ItemList;
+        unique_ptr<ItemList>                m_list                  = std::make_unique<ItemList>();
 
         // valid from StartCollecting to Reset
         shared_ptr<vaRenderInstanceStorage> m_instanceStorage;
@@ -169,7 +189,7 @@ namespace Vanilla
         std::pair<const Item*, size_t>      GetItems( ) const                           { if( m_ready ) return { nullptr, 0 }; assert( !m_started ); return m_list->GetItemsUnsafe( ); };
         vaDrawResultFlags                   ResultFlags( ) const                        { assert( !m_started ); return (vaDrawResultFlags)m_selectResults.load(); }
         // Return the sorted array of indices (wait on sort finish if needed)
-        const std::vector<int> *            GetSortIndices( SortHandle sortHandle ) const;
+        const SortIndices *                 GetSortIndices( SortHandle sortHandle ) const;
         const vaRenderInstance *            GetGlobalInstanceArray( ) const             { return m_instanceArray; }
         const shared_ptr<vaRenderBuffer> &  GetGlobalInstanceRenderBuffer( ) const;
     };
@@ -25,6 +25,8 @@
 
 #include "Core/vaUI.h"
 
+#include "IntegratedExternals/vaTaskflowIntegration.h"
+
 using namespace Vanilla;
 
 //vaRenderMeshManager & renderMeshManager, const vaGUID & uid
@@ -1297,6 +1299,24 @@ bool vaRenderMaterial::Update( )
     return true;
 }
 
+bool vaRenderMaterial::GetShaderPermutation( bool & outAlphaTest, string & outClass, ShaderSettings & outShaderSettings, std::vector< pair< string, string > > & outShaderMacros )
+{
+    std::unique_lock uniqueLock( m_mutex );
+
+    // UpdateShaderMacros only sets m_shadersDirty if macros changed - don't lose the pending recreate
+    const bool shadersDirty = m_shadersDirty;
+    UpdateShaderMacros( );
+    m_shadersDirty |= shadersDirty;
+    if( m_shaderMacrosDirty )
+        return false;
+
+    outAlphaTest        = IsAlphaTested( );
+    outClass            = m_class;
+    outShaderSettings   = m_shaderSettings;
+    outShaderMacros     = m_shaderMacros;
+    return true;
+}
+
 void vaRenderMaterial::GetShaderState_VS_Standard( vaShader::State & outState, string & outErrorString )
 {
     if( !Update() )     { outState = vaShader::State::Uncooked; outErrorString = "Material shader cache not (yet) created"; assert( false ); }
@@ -1909,6 +1929,11 @@ shared_ptr<vaRenderMaterial> vaRenderMaterialManager::CreateRenderMaterial( cons
 void vaRenderMaterialManager::UIPanelTick( vaApplicationBase & )
 {
 #ifdef VA_IMGUI_INTEGRATION_ENABLED
+    {
+        RuntimeShaderCounters counters = GetRuntimeShaderCounters( );
+        ImGui::Text( "Shader sets created on first use: %lld (%lld not in the shader cache)", (long long)counters.ShaderSetsCreated, (long long)counters.ShaderSetsMissing );
+    }
+
     static int selected = 0;
     ImGui::BeginChild( "left pane", ImVec2( 150, 0 ), true );
     for( int i = 0; i < 7; i++ )
@@ -1937,8 +1962,7 @@ void vaRenderMaterialManager::UIPanelTick( vaApplicationBase & )
 #endif
 }
 
-shared_ptr<vaRenderMaterialCachedShaders>
-vaRenderMaterialManager::FindOrCreateShaders( bool alphaTest, string materialClass, const vaRenderMaterial::ShaderSettings & _shaderSettings, const std::vector< pair< string, string > > & _shaderMacros )
+vaRenderMaterial::ShaderSettings vaRenderMaterialManager::ResolveShaderSettings( const string & materialClass, const vaRenderMaterial::ShaderSettings & _shaderSettings ) const
 {
     vaRenderMaterial::ShaderSettings shaderSettings;
     if( materialClass != "" )
@@ -1956,6 +1980,60 @@ vaRenderMaterialManager::FindOrCreateShaders( bool alphaTest, string materialCla
     }
     else
         shaderSettings = _shaderSettings; // old path
+    return shaderSettings;
+}
+
+void vaRenderMaterialManager::EnumerateShaders( bool alphaTest, const vaRenderMaterial::ShaderSettings & shaderSettings, const std::vector< pair< string, string > > & shaderMacros,
+    const std::function<void( vaRenderMaterialCachedShaders::Slot slot, const string & filePath, const string & entryPoint, const std::vector< pair< string, string > > & macros )> & callback ) const
+{
+    using Slot = vaRenderMaterialCachedShaders::Slot;
+
+    if( shaderSettings.VS_Standard.first != "" && shaderSettings.VS_Standard.second != "" )
+        callback( Slot::VS_Standard, shaderSettings.VS_Standard.first, shaderSettings.VS_Standard.second, shaderMacros );
+//    else
+//        vaCore::Warning( "Material has no vertex shader!" );
+
+    {
+        string gsFile = shaderSettings.GS_Standard.first;
+        string gsEntry = shaderSettings.GS_Standard.second;
+        if( m_globalGSOverrideEnabled )
+        {
+            gsFile = shaderSettings.VS_Standard.first;
+            gsEntry = "GS_Standard";
+        }
+        if( gsFile != "" && gsEntry != "" )
+            callback( Slot::GS_Standard, gsFile, gsEntry, shaderMacros );
+    }
+
+    if( alphaTest ) 
+    {
+        if( shaderSettings.PS_DepthOnly.first != "" && shaderSettings.PS_DepthOnly.second != "" )
+            callback( Slot::PS_DepthOnly, shaderSettings.PS_DepthOnly.first, shaderSettings.PS_DepthOnly.second, shaderMacros );
+        else
+            VA_ERROR( "Material has no depth only pixel shader but alpha test is used!" );
+    }
+    if( shaderSettings.PS_Forward.first != "" && shaderSettings.PS_Forward.second != "" )
+        callback( Slot::PS_Forward, shaderSettings.PS_Forward.first, shaderSettings.PS_Forward.second, shaderMacros );
+//    else
+//        vaCore::Warning( "Material has no pixel shader!" );
+//    if( shaderSettings.PS_Deferred.first != "" && shaderSettings.PS_Deferred.second != "" )
+//        callback( Slot::PS_Deferred, shaderSettings.PS_Deferred.first, shaderSettings.PS_Deferred.second, shaderMacros );
+    if( shaderSettings.PS_RichPrepass.first != "" && shaderSettings.PS_RichPrepass.second != "" )
+        callback( Slot::PS_RichPrepass, shaderSettings.PS_RichPrepass.first, shaderSettings.PS_RichPrepass.second, shaderMacros );
+
+    // ***RAYTRACING ONLY SHADERS BELOW***
+    if( shaderSettings.CAL_LibraryFile != "" )
+    {
+        std::vector< pair< string, string > > raytracingMacros = shaderMacros;
+        raytracingMacros.push_back( std::pair<string, string>( "VA_RAYTRACING",   "" ) );
+        callback( Slot::CAL_Library, shaderSettings.CAL_LibraryFile, "", raytracingMacros );
+    }
+}
+
+shared_ptr<vaRenderMaterialCachedShaders>
+vaRenderMaterialManager::FindOrCreateShaders( bool alphaTest, string materialClass, const vaRenderMaterial::ShaderSettings & _shaderSettings, const std::vector< pair< string, string > > & _shaderMacros )
+{
+    const vaRenderMaterial::ShaderSettings shaderSettings = ResolveShaderSettings( materialClass, _shaderSettings );
 
     vaRenderMaterialCachedShaders::Key cacheKey( alphaTest, shaderSettings, _shaderMacros );
 
@@ -1985,61 +2063,46 @@ vaRenderMaterialManager::FindOrCreateShaders( bool alphaTest, string materialCla
         shared_ptr<vaRenderMaterialCachedShaders> newShaders( new vaRenderMaterialCachedShaders( GetRenderDevice() ) );
 
         // This unique ID is there in only for the case of a special extra shader uint32-based define that uniquely (at runtime) describes
-        // the shader. 
-        uint32 uniqueID = (cacheKey.Hash & 0xFFFF);
-        while( !m_cachedShadersUniqueIDs.insert( uniqueID ).second )
-            uniqueID++;
+        // the shader. Precompiled sets get the ID they were precompiled with (unless taken), others avoid those.
+        uint32 uniqueID;
+        auto precompiled = m_precompiledShaderIDs.find( cacheKey );
+        if( precompiled != m_precompiledShaderIDs.end() && m_cachedShadersUniqueIDs.insert( precompiled->second ).second )
+            uniqueID = precompiled->second;
+        else
+        {
+            uniqueID = (cacheKey.Hash.Value[0] & 0xFFFF);
+            while( m_precompiledShaderIDSet.find( uniqueID ) != m_precompiledShaderIDSet.end() || !m_cachedShadersUniqueIDs.insert( uniqueID ).second )
+                uniqueID++;
+        }
         cacheKey.UniqueID = uniqueID;
         newShaders->UniqueID = uniqueID;
         newShaders->UniqueIDString = vaStringTools::Format( "%d", uniqueID );
+
+        m_runtimeShaderSetsCreated++;
+        m_runtimeShaderSetsPending.push_back( newShaders );
         
         // Enable additional macros
         m_scratchShaderMacrosStorage = _shaderMacros;
-        std::vector< pair< string, string > > & shaderMacros = m_scratchShaderMacrosStorage;
         m_scratchShaderMacrosStorage.push_back( std::pair<string, string>( "VA_RM_SHADER_ID",   newShaders->UniqueIDString ) );
 
         // vertex input layout is here!
         std::vector<vaVertexInputElementDesc> inputElements = vaRenderMesh::GetStandardInputLayout( );
 
-        if( shaderSettings.VS_Standard.first != "" && shaderSettings.VS_Standard.second != "" )
-            newShaders->VS_Standard->CompileVSAndILFromFile( shaderSettings.VS_Standard.first, shaderSettings.VS_Standard.second.c_str( ), inputElements, shaderMacros, false );
-//        else
-//            vaCore::Warning( "Material has no vertex shader!" );
-
+        EnumerateShaders( alphaTest, shaderSettings, m_scratchShaderMacrosStorage, [&]( vaRenderMaterialCachedShaders::Slot slot, const string & filePath, const string & entryPoint, const std::vector< pair< string, string > > & macros )
         {
-            string gsFile = shaderSettings.GS_Standard.first;
-            string gsEntry = shaderSettings.GS_Standard.second;
-            if( m_globalGSOverrideEnabled )
+            switch( slot )
             {
-                gsFile = shaderSettings.VS_Standard.first;
-                gsEntry = "GS_Standard";
+            case vaRenderMaterialCachedShaders::Slot::VS_Standard:      newShaders->VS_Standard->CompileVSAndILFromFile( filePath, entryPoint, inputElements, macros, false ); break;
+            case vaRenderMaterialCachedShaders::Slot::GS_Standard:      newShaders->GS_Standard->CompileFromFile( filePath, entryPoint, macros, false ); break;
+            case vaRenderMaterialCachedShaders::Slot::PS_DepthOnly:     newShaders->PS_DepthOnly->CompileFromFile( filePath, entryPoint, macros, false ); break;
+            case vaRenderMaterialCachedShaders::Slot::PS_Forward:       newShaders->PS_Forward->CompileFromFile( filePath, entryPoint, macros, false ); break;
+            case vaRenderMaterialCachedShaders::Slot::PS_RichPrepass:   newShaders->PS_RichPrepass->CompileFromFile( filePath, entryPoint, macros, false ); break;
+            case vaRenderMaterialCachedShaders::Slot::CAL_Library:      newShaders->CAL_Library->CompileFromFile( filePath, entryPoint, macros, false ); break;
+            default: assert( false ); break;
             }
-            if( gsFile != "" && gsEntry != "" )
-                newShaders->GS_Standard->CompileFromFile( gsFile, gsEntry.c_str( ), shaderMacros, false );
-        }
-
-        if( alphaTest ) 
-        {
-            if( shaderSettings.PS_DepthOnly.first != "" && shaderSettings.PS_DepthOnly.second != "" )
-                newShaders->PS_DepthOnly->CompileFromFile( shaderSettings.PS_DepthOnly.first, shaderSettings.PS_DepthOnly.second.c_str( ), shaderMacros, false );
-            else
-                VA_ERROR( "Material has no depth only pixel shader but alpha test is used!" );
-        }
-        else
+        } );
+        if( !alphaTest ) 
             newShaders->PS_DepthOnly->Clear( true );
-        if( shaderSettings.PS_Forward.first != "" && shaderSettings.PS_Forward.second != "" )
-            newShaders->PS_Forward->CompileFromFile( shaderSettings.PS_Forward.first, shaderSettings.PS_Forward.second.c_str( ), shaderMacros, false );
-//        else
-//            vaCore::Warning( "Material has no pixel shader!" );
-//        if( shaderSettings.PS_Deferred.first != "" && shaderSettings.PS_Deferred.second != "" )
-//            newShaders->PS_Deferred->CompileFromFile( shaderSettings.PS_Deferred.first, shaderSettings.PS_Deferred.second.c_str( ), shaderMacros, false );
-        if( shaderSettings.PS_RichPrepass.first != "" && shaderSettings.PS_RichPrepass.second != "" )
-            newShaders->PS_RichPrepass->CompileFromFile( shaderSettings.PS_RichPrepass.first, shaderSettings.PS_RichPrepass.second.c_str( ), shaderMacros, false );
-
-        // ***RAYTRACING ONLY SHADERS BELOW***
-        shaderMacros.push_back( std::pair<string, string>( "VA_RAYTRACING",   "" ) );
-        if( shaderSettings.CAL_LibraryFile != "" )
-            newShaders->CAL_Library->CompileFromFile( shaderSettings.CAL_LibraryFile, "", shaderMacros, false );
         
         // finally, add to cache
         m_cachedShaders.insert( std::make_pair( cacheKey, newShaders ) );
@@ -2066,6 +2129,150 @@ vaRenderMaterialManager::FindOrCreateShaders( bool alphaTest, string materialCla
     }
 }
 
+vaRenderMaterialManager::PrecompileStatistics vaRenderMaterialManager::PrecompileShaders( vaAssetPack & assetPack, bool lockMutex, vaBackgroundTaskManager::TaskContext * taskContext )
+{
+    VA_TRACE_CPU_SCOPE( RenderMaterialPrecompileShaders );
+    using Slot = vaRenderMaterialCachedShaders::Slot;
+
+    PrecompileStatistics stats;
+    const double startTime = vaCore::TimeFromAppStart( );
+
+    // 1.) collect unique shader sets from all materials (shader macros depend on material inputs so have to be up to date)
+    std::vector< pair< vaRenderMaterialCachedShaders::Key, vaRenderMaterial::ShaderSettings > > shaderSets;
+    std::vector< std::vector< pair< string, string > > > shaderSetMacros;
+    std::vector< bool > shaderSetAlphaTest;
+    {
+        std::unordered_set< vaRenderMaterialCachedShaders::Key, vaRenderMaterialCachedShaders::Key > uniqueKeys;
+        std::vector<shared_ptr<vaAsset>> materialAssets = assetPack.Find( []( vaAsset & asset ) { return asset.Type == vaAssetType::RenderMaterial; }, lockMutex );
+        for( const shared_ptr<vaAsset> & asset : materialAssets )
+        {
+            shared_ptr<vaRenderMaterial> material = vaAssetRenderMaterial::SafeCast( asset )->GetRenderMaterial( );
+            if( material == nullptr )
+                continue;
+            stats.Materials++;
+
+            bool alphaTest; string materialClass; vaRenderMaterial::ShaderSettings materialShaderSettings; std::vector< pair< string, string > > shaderMacros;
+            if( !material->GetShaderPermutation( alphaTest, materialClass, materialShaderSettings, shaderMacros ) )
+            {
+                stats.MaterialsNotReady++;
+                continue;
+            }
+            const vaRenderMaterial::ShaderSettings shaderSettings = ResolveShaderSettings( materialClass, materialShaderSettings );
+            vaRenderMaterialCachedShaders::Key key( alphaTest, shaderSettings, shaderMacros );
+            if( !uniqueKeys.insert( key ).second )
+                continue;
+            shaderSets.push_back( std::make_pair( key, shaderSettings ) );
+            shaderSetMacros.push_back( std::move( shaderMacros ) );
+            shaderSetAlphaTest.push_back( alphaTest );
+        }
+    }
+
+    // 2.) pick VA_RM_SHADER_ID-s the same way FindOrCreateShaders does, skipping sets already compiled or precompiled
+    struct Job
+    {
+        Slot                                    Type;
+        string                                  FilePath;
+        string                                  EntryPoint;
+        std::vector< pair< string, string > >   Macros;
+    };
+    std::vector<Job> jobs;
+    uint32 generation;
+    {
+        std::unique_lock lock( m_cachedShadersMutex );
+        generation = m_cachedShadersGeneration.load( );
+        for( int i = 0; i < (int)shaderSets.size( ); i++ )
+        {
+            const vaRenderMaterialCachedShaders::Key & key = shaderSets[i].first;
+            if( m_precompiledShaderIDs.find( key ) != m_precompiledShaderIDs.end( ) )
+                continue;
+            auto existing = m_cachedShaders.find( key );
+            if( existing != m_cachedShaders.end( ) && existing->second.lock( ) != nullptr )
+            {
+                m_precompiledShaderIDs.insert( std::make_pair( key, existing->first.UniqueID ) );
+                m_precompiledShaderIDSet.insert( existing->first.UniqueID );
+                continue;
+            }
+            uint32 uniqueID = (key.Hash.Value[0] & 0xFFFF);
+            while( m_precompiledShaderIDSet.find( uniqueID ) != m_precompiledShaderIDSet.end( ) || m_cachedShadersUniqueIDs.find( uniqueID ) != m_cachedShadersUniqueIDs.end( ) )
+                uniqueID++;
+            m_precompiledShaderIDs.insert( std::make_pair( key, uniqueID ) );
+            m_precompiledShaderIDSet.insert( uniqueID );
+            stats.ShaderSets++;
+
+            std::vector< pair< string, string > > & shaderMacros = shaderSetMacros[i];
+            shaderMacros.push_back( std::pair<string, string>( "VA_RM_SHADER_ID",   vaStringTools::Format( "%d", uniqueID ) ) );
+            EnumerateShaders( shaderSetAlphaTest[i], shaderSets[i].second, shaderMacros, [&]( Slot slot, const string & filePath, const string & entryPoint, const std::vector< pair< string, string > > & macros )
+            {
+                jobs.push_back( { slot, filePath, entryPoint, macros } );
+            } );
+        }
+    }
+    stats.Permutations = (int)jobs.size( );
+
+    // 3.) compile; the shader objects are only needed to get the blobs into the vaShaderCache
+    if( GetRenderDevice( ).GetShaderManager( ).GetCache( ) == nullptr )
+        VA_WARN( "vaRenderMaterialManager::PrecompileShaders - shader cache is disabled, precompiled shaders will not be kept" );
+    std::vector< shared_ptr<vaShader> > shaders( jobs.size( ) );
+    const std::vector<vaVertexInputElementDesc> inputElements = vaRenderMesh::GetStandardInputLayout( );
+    std::atomic_int finishedJobs = 0;
+    vaTF::parallel_for( 0, (int)jobs.size( ), [&]( int index )
+    {
+        if( ( taskContext != nullptr && taskContext->ForceStop ) || m_cachedShadersGeneration.load( std::memory_order_relaxed ) != generation )
+            return;
+        const Job & job = jobs[index];
+        vaRenderDevice & device = GetRenderDevice( );
+        switch( job.Type )
+        {
+        case Slot::VS_Standard:     shaders[index] = vaVertexShader::CreateVSAndILFromFile( device, job.FilePath, job.EntryPoint, inputElements, job.Macros, true ); break;
+        case Slot::GS_Standard:     shaders[index] = vaShader::CreateFromFile<vaGeometryShader>( device, job.FilePath, job.EntryPoint, job.Macros, true ); break;
+        case Slot::PS_DepthOnly:
+        case Slot::PS_Forward:
+        case Slot::PS_RichPrepass:  shaders[index] = vaPixelShader::CreateFromFile( device, job.FilePath, job.EntryPoint, job.Macros, true ); break;
+        case Slot::CAL_Library:     shaders[index] = vaShaderLibrary::CreateFromFile( device, job.FilePath, job.EntryPoint, job.Macros, true ); break;
+        default: assert( false ); break;
+        }
+        if( taskContext != nullptr )
+            taskContext->Progress = (float)( ++finishedJobs ) / (float)jobs.size( );
+    }, 1, "PrecompileShaders" ).wait( );
+
+    const bool stopped = taskContext != nullptr && taskContext->ForceStop;
+    if( !stopped && m_cachedShadersGeneration.load( ) != generation )
+    {
+        VA_LOG( "Material shader caches were reset while precompiling - starting over" );
+        shaders.clear( );
+        return PrecompileShaders( assetPack, lockMutex, taskContext );
+    }
+    for( const shared_ptr<vaShader> & shader : shaders )
+    {
+        if( shader == nullptr && stopped )
+            continue;
+        vaShader::State state = vaShader::State::Empty; string errorString;
+        if( shader != nullptr )
+            shader->GetState( state, errorString );
+        if( shader == nullptr || state != vaShader::State::Cooked )
+            stats.Failed++;
+        else if( shader->IsLoadedFromCache( ) )
+            stats.AlreadyCached++;
+        else
+            stats.Compiled++;
+    }
+    shaders.clear( );
+
+    stats.Time = vaCore::TimeFromAppStart( ) - startTime;
+    VA_LOG( "Precompiled material shaders%s: %d materials (%d not ready), %d shader sets, %d permutations, %d already cached, %d compiled, %d failed, %.2fs",
+        ( stopped ) ? ( " (stopped)" ) : ( "" ), stats.Materials, stats.MaterialsNotReady, stats.ShaderSets, stats.Permutations, stats.AlreadyCached, stats.Compiled, stats.Failed, stats.Time );
+    return stats;
+}
+
+vaRenderMaterialManager::RuntimeShaderCounters vaRenderMaterialManager::GetRuntimeShaderCounters( )
+{
+    std::shared_lock lock( m_cachedShadersMutex );
+    RuntimeShaderCounters counters;
+    counters.ShaderSetsCreated  = m_runtimeShaderSetsCreated;
+    counters.ShaderSetsMissing  = m_runtimeShaderSetsMissing;
+    return counters;
+}
+
 void vaRenderMaterialManager::ResetCaches( )
 {
     {
@@ -2073,8 +2280,14 @@ void vaRenderMaterialManager::ResetCaches( )
         for( int i : m_materials.PackedArray() )
             m_materials.At(i)->SetShadersDirty();
     }
+    // PrecompileShaders can be running in the background
+    std::unique_lock lock( m_cachedShadersMutex );
+    m_cachedShadersGeneration++;
     m_cachedShaders.clear();
     m_cachedShadersUniqueIDs.clear();
+    // precompiled with the old macros
+    m_precompiledShaderIDs.clear();
+    m_precompiledShaderIDSet.clear();
 }
 
 void vaRenderMaterialManager::SetGlobalShaderMacros( const std::vector< pair< string, string > > & globalShaderMacros ) 
@@ -2112,6 +2325,37 @@ void vaRenderMaterialManager::SetGlobalGSOverride( bool enabled )
 
 void vaRenderMaterialManager::UpdateAndSetToGlobals( vaRenderDeviceContext & renderContext, vaShaderItemGlobals & shaderItemGlobals, const vaDrawAttributes * drawAttributes )
 {   
+    std::unique_lock lock( m_cachedShadersMutex );
+
+    // count shader sets that had to be compiled on first use, once their shaders are done
+    for( int i = (int)m_runtimeShaderSetsPending.size( ) - 1; i >= 0; i-- )
+    {
+        shared_ptr<vaRenderMaterialCachedShaders> shaderSet = m_runtimeShaderSetsPending[i].lock( );
+        bool done = true, compiled = false;
+        if( shaderSet != nullptr )
+        {
+            const shared_ptr<vaShader> shaders[] = { shaderSet->VS_Standard.get( ), shaderSet->GS_Standard.get( ), shaderSet->PS_DepthOnly.get( ), shaderSet->PS_Forward.get( ), shaderSet->PS_RichPrepass.get( ), shaderSet->CAL_Library.get( ) };
+            for( const shared_ptr<vaShader> & shader : shaders )
+            {
+                vaShader::State state; string errorString;
+                shader->GetState( state, errorString );
+                if( state == vaShader::State::Uncooked && errorString == "" )
+                    done = false;   // still compiling
+                else if( state == vaShader::State::Cooked && !shader->IsLoadedFromCache( ) )
+                    compiled = true;
+            }
+            if( !done )
+                continue;
+            if( compiled )
+            {
+                m_runtimeShaderSetsMissing++;
+                VA_WARN( "Material shader set %d (%s) was not in the shader cache, compiled on first use", shaderSet->UniqueID, shaderSet->PS_Forward->GetEntryPoint( ).c_str( ) );
+            }
+        }
+        m_runtimeShaderSetsPending[i] = m_runtimeShaderSetsPending.back( );
+        m_runtimeShaderSetsPending.pop_back( );
+    }
+
     // slowly clear shader cache
     assert( m_cachedShaders.size() == m_cachedShadersUniqueIDs.size() );
     if( m_cachedShaders.size() > 0 )
@@ -87,6 +87,7 @@ namespace Vanilla
     // };
 
     struct vaRenderMaterialCachedShaders;
+    class vaAssetPack;
 
     class vaRenderMaterial : public vaAssetResource, public vaRenderingModule
     {
@@ -380,6 +381,10 @@ namespace Vanilla
 
         bool                                            IsDirty( ) const                                                { return m_inputsDirty || m_shaderMacrosDirty || m_shadersDirty || (m_delayedInputsSetDirty != std::numeric_limits<double>::max()); }
 
+        // Everything vaRenderMaterialManager::FindOrCreateShaders gets from this material (updates shader macros first); returns false if
+        // they can't be updated yet (inputs still loading). Locks m_mutex so it can be used from any thread.
+        bool                                            GetShaderPermutation( bool & outAlphaTest, string & outClass, ShaderSettings & outShaderSettings, std::vector< pair< string, string > > & outShaderMacros );
+
         vaRenderMaterialManager &                       GetManager( ) const                                             { return m_renderMaterialManager; }
         //int                                             GetListIndex( ) const                                           { return m_trackee.GetIndex( ); }
 
@@ -501,46 +506,50 @@ namespace Vanilla
     {
         struct Key
         {
-            uint64                      Hash        = 0;
-            string                      String      ;
+            vaShaderCacheKey            Hash;
             uint32                      UniqueID    = 0;        // see vaRenderMaterialCachedShaders::UniqueID
 
             Key()                       {}
 
-            bool                        operator == ( const Key & cmp ) const   { return this->String == cmp.String; }
-            //bool                        operator >( const Key & cmp ) const     { return this->String > cmp.AStringPart; }
-            //bool                        operator < ( const Key & cmp ) const    { return this->String < cmp.AStringPart; }
+            bool                        operator == ( const Key & cmp ) const   { return this->Hash == cmp.Hash; }
 
             // alphaTest is part of the key because it determines whether PS_DepthOnly is needed at all; all other shader parameters are contained in shaderMacros
             Key( bool alphaTest, const vaRenderMaterial::ShaderSettings & shaderSettings, const std::vector< pair< string, string > > & shaderMacros )
             {
-                //WStringPart = fileName;
-                String = "";
-                String += "&" + shaderSettings.VS_Standard.first       + "&" + shaderSettings.VS_Standard.second;
-                String += "&" + shaderSettings.PS_DepthOnly.first      + "&" + shaderSettings.PS_DepthOnly.second;
-                String += "&" + shaderSettings.PS_Forward.first        + "&" + shaderSettings.PS_Forward.second;
-                // String += "&" + shaderSettings.PS_Deferred.first       + "&" + shaderSettings.PS_Deferred.second;
-                String += "&" + shaderSettings.PS_RichPrepass.first   + "&" + shaderSettings.PS_RichPrepass.second;
-                String += "&" + shaderSettings.GS_Standard.first       + "&" + shaderSettings.GS_Standard.second;
+                vaShaderCacheKeyBuilder builder;
+                builder.AddString( shaderSettings.VS_Standard.first );      builder.AddString( shaderSettings.VS_Standard.second );
+                builder.AddString( shaderSettings.PS_DepthOnly.first );     builder.AddString( shaderSettings.PS_DepthOnly.second );
+                builder.AddString( shaderSettings.PS_Forward.first );       builder.AddString( shaderSettings.PS_Forward.second );
+                // builder.AddString( shaderSettings.PS_Deferred.first );      builder.AddString( shaderSettings.PS_Deferred.second );
+                builder.AddString( shaderSettings.PS_RichPrepass.first );   builder.AddString( shaderSettings.PS_RichPrepass.second );
+                builder.AddString( shaderSettings.GS_Standard.first );      builder.AddString( shaderSettings.GS_Standard.second );
                 
-                String += "&" + shaderSettings.CAL_LibraryFile;
-                //String += "&" + shaderSettings.CAL_HitTestEntry + "&" + shaderSettings.CAL_ShadeEntry;
+                builder.AddString( shaderSettings.CAL_LibraryFile );
+                //builder.AddString( shaderSettings.CAL_HitTestEntry );     builder.AddString( shaderSettings.CAL_ShadeEntry );
 
-                String += ((alphaTest)?("a&"):("b&"));
-                for( int i = 0; i < shaderMacros.size(); i++ )
-                    String += shaderMacros[i].first + "&" + shaderMacros[i].second + "&";
+                builder.AddValue( alphaTest );
+                builder.AddMacros( shaderMacros );
 
-                Hash = vaXXHash64::Compute( String.data(), sizeof(String[0])*String.size(), 0 );
+                Hash = builder.Finalize( );
             }
 
             std::size_t operator () ( const vaRenderMaterialCachedShaders::Key & key ) const
             {
-                // see vaGraphicsPSODescDX12::FillKey and vaComputePSODescDX12::FillKey - hash is in the first 64 bits of the buffer :)
-
-                return key.Hash;
+                return (std::size_t)key.Hash.Value[0];
             }
         };
 
+        // one for each of the shaders below
+        enum class Slot : int32
+        {
+            VS_Standard,
+            GS_Standard,
+            PS_DepthOnly,
+            PS_Forward,
+            PS_RichPrepass,
+            CAL_Library,
+        };
+
         vaRenderMaterialCachedShaders( vaRenderDevice & device ) : VS_Standard( device ), GS_Standard( device ), PS_DepthOnly( device ), PS_Forward( device ), /*PS_Deferred( device ),*/ PS_RichPrepass( device ), CAL_Library( device ) { }
 
         vaAutoRMI<vaVertexShader>           VS_Standard;
@@ -589,6 +598,18 @@ namespace Vanilla
         std::shared_mutex                               m_cachedShadersMutex;
         std::vector< weak_ptr<vaRenderMaterialCachedShaders> >
                                                         m_cachedShadersTable;
+        // VA_RM_SHADER_ID picked for each precompiled shader set - FindOrCreateShaders reuses it so the shader cache keys match; IDs
+        // are also kept in a set so that other shader sets don't take them
+        std::unordered_map< vaRenderMaterialCachedShaders::Key, uint32, vaRenderMaterialCachedShaders::Key >
+                                                        m_precompiledShaderIDs;
+        std::unordered_set< uint32 >                    m_precompiledShaderIDSet;
+        // incremented by ResetCaches so that a PrecompileShaders running in the background knows its jobs are stale
+        std::atomic<uint32>                             m_cachedShadersGeneration           = 0;
+        int64                                           m_runtimeShaderSetsCreated          = 0;
+        int64                                           m_runtimeShaderSetsMissing          = 0;
+        // created by FindOrCreateShaders but still compiling - checked for vaShaderCache misses once done
+        std::vector< weak_ptr<vaRenderMaterialCachedShaders> >
+                                                        m_runtimeShaderSetsPending;
         std::vector< pair< string, string > >           m_scratchShaderMacrosStorage;
 
         std::vector< pair< string, string > >           m_globalShaderMacros;
@@ -618,6 +639,14 @@ namespace Vanilla
 
         void                                            ResetCaches( );
 
+        // resolves material class into actual shader files / entry points
+        vaRenderMaterial::ShaderSettings                ResolveShaderSettings( const string & materialClass, const vaRenderMaterial::ShaderSettings & shaderSettings ) const;
+
+        // Calls the callback for each shader of a vaRenderMaterialCachedShaders set - used both for creating and for precompiling
+        // them so that the two can't diverge; shaderMacros have to contain VA_RM_SHADER_ID already
+        void                                            EnumerateShaders( bool alphaTest, const vaRenderMaterial::ShaderSettings & shaderSettings, const std::vector< pair< string, string > > & shaderMacros,
+                                                            const std::function<void( vaRenderMaterialCachedShaders::Slot slot, const string & filePath, const string & entryPoint, const std::vector< pair< string, string > > & macros )> & callback ) const;
+
     public:
         // Make sure you've locked mutex when accessing this: std::shared_lock managerLock( renderMaterialManager.Mutex() );
         const vaSparseArray< vaRenderMaterial * > &     Materials( ) const                                      { return m_materials; }
@@ -656,6 +685,36 @@ namespace Vanilla
         // alphaTest is part of the key because it determines whether PS_DepthOnly is needed at all; all other shader parameters are contained in shaderMacros
         shared_ptr<vaRenderMaterialCachedShaders>       FindOrCreateShaders( bool alphaTest, string materialClass, const vaRenderMaterial::ShaderSettings & shaderSettings, const std::vector< pair< string, string > > & shaderMacros );
 
+    public:
+        struct PrecompileStatistics
+        {
+            int                                         Materials               = 0;
+            int                                         MaterialsNotReady       = 0;    // inputs still loading so shader macros unknown - skipped
+            int                                         ShaderSets              = 0;    // unique vaRenderMaterialCachedShaders::Key-s (materials share them)
+            int                                         Permutations            = 0;    // shaders in all of these sets; all get compiled (every set has its own VA_RM_SHADER_ID so they can't be shared)
+            int                                         AlreadyCached           = 0;    // found in the vaShaderCache
+            int                                         Compiled                = 0;
+            int                                         Failed                  = 0;
+            double                                      Time                    = 0.0;  // seconds
+        };
+
+        // Shader sets created on first use and how many of them weren't precompiled (each one is a potential hitch): 'missing' are
+        // the ones with any shader that had to be compiled instead of being loaded from the vaShaderCache - so it covers shaders
+        // precompiled in earlier runs too; counted once the set's shaders are done compiling
+        struct RuntimeShaderCounters
+        {
+            int64                                       ShaderSetsCreated       = 0;
+            int64                                       ShaderSetsMissing       = 0;
+        };
+
+        // Compiles (or finds in the vaShaderCache) every shader used by render materials in the asset pack, in parallel on vaTF worker
+        // threads, so they're cached before the materials are first drawn. Shader sets that were already created or precompiled are
+        // skipped. Blocks until done; can be called from any thread. If run as a vaBackgroundTaskManager task, pass its context for
+        // progress and to stop early on ForceStop (shaders not started by then are skipped). If the caches get reset while it runs
+        // (global shader macros changed), remaining shaders are skipped and it starts over.
+        PrecompileStatistics                            PrecompileShaders( vaAssetPack & assetPack, bool lockMutex, vaBackgroundTaskManager::TaskContext * taskContext = nullptr );
+        RuntimeShaderCounters                           GetRuntimeShaderCounters( );
+
     protected:
         virtual string                                  UIPanelGetDisplayName( ) const override { return "Materials"; } //vaStringTools::Format( "vaRenderMaterialManager (%d meshes)", m_renderMaterials.size( ) ); }
         virtual void                                    UIPanelTick( vaApplicationBase & application ) override;
@@ -30,11 +30,97 @@
 
 #include "Rendering/vaAssetPack.h"
 
+#include "Rendering/vaRenderMeshLODBuilder.h"
+#include "Rendering/vaRenderMeshOptimizer.h"
+
 using namespace Vanilla;
 
 //vaRenderMeshManager & renderMeshManager, const vaGUID & uid
 
-const int c_renderMeshFileVersion = 4;
+const int c_renderMeshFileVersion = 5;     // 5 - meshopt encoded geometry (see SaveGeometryAPACK); unpacked format same as 4
+
+namespace
+{
+    enum GeometryStorageFlags : uint32
+    {
+        GSF_QuantizedAttributes = ( 1 << 0 ),   // vertices stored as QuantizedVertex
+        GSF_RawIndices          = ( 1 << 1 ),   // index count not a multiple of 3 so can't use the index codec
+    };
+
+    // on-disk only
+    struct QuantizedVertex
+    {
+        vaVector3   Position;
+        uint32      Color;
+        int16       Normal[3];                  // snorm16
+        uint16      NormalW;                    // half
+        uint16      TexCoord0[2];               // half
+        uint16      TexCoord1[2];               // half
+    };
+    static_assert( sizeof( QuantizedVertex ) == 32, "meshopt vertex codec needs a multiple of 4 bytes" );
+
+    float HalfToFloat( uint16 h )
+    {
+        const uint32 sign       = ( h & 0x8000u ) << 16;
+        const uint32 exponent   = ( h >> 10 ) & 0x1Fu;
+        const uint32 mantissa   = h & 0x3FFu;
+        uint32 bits;
+        if( exponent == 0 )
+        {
+            // zero or denormal - value is mantissa * 2^-24
+            float value = (float)mantissa * ( 1.0f / 16777216.0f );
+            return ( sign != 0 ) ? ( -value ) : ( value );
+        }
+        else if( exponent == 31 )
+            bits = sign | 0x7F800000u | ( mantissa << 13 );
+        else
+            bits = sign | ( ( exponent + 112 ) << 23 ) | ( mantissa << 13 );
+        float ret; memcpy( &ret, &bits, sizeof( ret ) );
+        return ret;
+    }
+
+    QuantizedVertex Quantize( const vaRenderMesh::StandardVertex & vertex )
+    {
+        QuantizedVertex ret;
+        ret.Position        = vertex.Position;
+        ret.Color           = vertex.Color;
+        for( int i = 0; i < 3; i++ )
+            ret.Normal[i]   = (int16)meshopt_quantizeSnorm( vaMath::Clamp( (&vertex.Normal.x)[i], -1.0f, 1.0f ), 16 );
+        ret.NormalW         = meshopt_quantizeHalf( vertex.Normal.w );
+        ret.TexCoord0[0]    = meshopt_quantizeHalf( vertex.TexCoord0.x );
+        ret.TexCoord0[1]    = meshopt_quantizeHalf( vertex.TexCoord0.y );
+        ret.TexCoord1[0]    = meshopt_quantizeHalf( vertex.TexCoord1.x );
+        ret.TexCoord1[1]    = meshopt_quantizeHalf( vertex.TexCoord1.y );
+        return ret;
+    }
+
+    vaRenderMesh::StandardVertex Dequantize( const QuantizedVertex & vertex )
+    {
+        vaRenderMesh::StandardVertex ret;
+        ret.Position        = vertex.Position;
+        ret.Color           = vertex.Color;
+        ret.Normal          = vaVector4( vertex.Normal[0] / 32767.0f, vertex.Normal[1] / 32767.0f, vertex.Normal[2] / 32767.0f, HalfToFloat( vertex.NormalW ) );
+        ret.TexCoord0       = vaVector2( HalfToFloat( vertex.TexCoord0[0] ), HalfToFloat( vertex.TexCoord0[1] ) );
+        ret.TexCoord1       = vaVector2( HalfToFloat( vertex.TexCoord1[0] ), HalfToFloat( vertex.TexCoord1[1] ) );
+        return ret;
+    }
+
+    bool WriteEncoded( vaStream & outStream, const std::vector<unsigned char> & buffer, size_t size )
+    {
+        VERIFY_TRUE_RETURN_ON_FALSE( size > 0 && size < INT_MAX );
+        VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<int32>( (int32)size ) );
+        return outStream.Write( buffer.data( ), (int64)size );
+    }
+
+    bool ReadEncoded( vaStream & inStream, std::vector<unsigned char> & buffer )
+    {
+        int32 size = 0;
+        VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<int32>( size ) );
+        VERIFY_TRUE_RETURN_ON_FALSE( size > 0 );
+        buffer.resize( size );
+        return inStream.Read( buffer.data( ), size );
+    }
+}
 
 
 vaRenderMesh::vaRenderMesh( const vaRenderingModuleParams & params ) 
@@ -258,6 +344,8 @@ void vaRenderMesh::MergeSimilarVerts( int lodFrom, int lodCount, float distanceT
 
     MeshReset( );
 
+    vaVertexWeldIndex weldIndex( distanceThreshold, srcVertices.size( ) );
+
     assert( lodFrom == 0 );
     assert( lodCount == 0 );
     if( lodCount == 0 )
@@ -274,7 +362,7 @@ void vaRenderMesh::MergeSimilarVerts( int lodFrom, int lodCount, float distanceT
             const vaRenderMesh::StandardVertex b = srcVertices[srcIndices[i + 1]];
             const vaRenderMesh::StandardVertex c = srcVertices[srcIndices[i + 2]];
 
-            MeshAddTriangleMergeDuplicates( a, b, c, closeEnough, -1 );
+            MeshAddTriangleMergeDuplicates( a, b, c, weldIndex, closeEnough );
         }
     }
 
@@ -371,6 +459,8 @@ void vaRenderMesh::TNTesselate( )
 
     int newTriangles = 0;
 
+    vaVertexWeldIndex weldIndex( 0.0f, origVertices.size( ) * 2 );
+
     struct PnPatch
     {
         vaVector3 b210;
@@ -487,10 +577,10 @@ void vaRenderMesh::TNTesselate( )
         StandardVertex e = evaluateVertex( a, b, c, coeffs, 0.5f, 0.5f, 0.0f );
         StandardVertex f = evaluateVertex( a, b, c, coeffs, 0.0f, 0.5f, 0.5f );
 
-        vaTriangleMeshTools::AddTriangle_MergeDuplicates( newVertices, newIndices, a, d, f, StandardVertex::IsDuplicate, 0 );
-        vaTriangleMeshTools::AddTriangle_MergeDuplicates( newVertices, newIndices, d, e, f, StandardVertex::IsDuplicate, 0 );
-        vaTriangleMeshTools::AddTriangle_MergeDuplicates( newVertices, newIndices, d, b, e, StandardVertex::IsDuplicate, 0 );
-        vaTriangleMeshTools::AddTriangle_MergeDuplicates( newVertices, newIndices, e, c, f, StandardVertex::IsDuplicate, 0 );
+        vaTriangleMeshTools::AddTriangle_MergeDuplicates( newVertices, newIndices, a, d, f, weldIndex, StandardVertex::IsDuplicate );
+        vaTriangleMeshTools::AddTriangle_MergeDuplicates( newVertices, newIndices, d, e, f, weldIndex, StandardVertex::IsDuplicate );
+        vaTriangleMeshTools::AddTriangle_MergeDuplicates( newVertices, newIndices, d, b, e, weldIndex, StandardVertex::IsDuplicate );
+        vaTriangleMeshTools::AddTriangle_MergeDuplicates( newVertices, newIndices, e, c, f, weldIndex, StandardVertex::IsDuplicate );
         newTriangles += 4;
     }
 
@@ -552,76 +642,14 @@ void vaRenderMesh::RebuildLODs( float maxRelativePosError, float normalRebuildMe
     if( m_LODParts.size() == 0 )
         return;
 
-    auto & vertices = Vertices();
-    auto & indices  = Indices();
-
-    ClearLODs();
-
-    //
-    const float stepTriReduce       = 0.25f;    // how many triangles to attempt to drop every step
-    const float stepTriReduceMin    = vaMath::Lerp( stepTriReduce, 1.0f, 0.7f );     // stop if failed to drop below this for next step
-    const float stepRangeIncrease   = 1.0f / stepTriReduce;
-    const float maxError            = m_boundingBox.Size.Length() * maxRelativePosError;
-    const int stopTriCount          = 64;  // doesn't make sense to go lower - we're going to be heavily CPU bound so it doesn't save anything
-
-    // transition starting point - just a guess <shrug>
-    m_LODParts[0].SwapToNextDistance = 1.0f / std::sqrtf(stepTriReduce);
-
-    std::vector<StandardVertex> srcVertices = vertices;
-    std::vector<uint32>         srcIndices  = indices;
-
-    int currentLOD = 1;
-    do
-    {
-        LODPart & prevLOD = m_LODParts[currentLOD - 1];
-        size_t targetCount              = (size_t)(srcIndices.size() * stepTriReduce);
-        size_t targetCountAcceptable    = (size_t)(srcIndices.size() * stepTriReduceMin);
-
-        std::vector<uint32> lod( srcIndices.size() );
-        lod.resize( meshopt_simplify( &lod[0], &srcIndices[0], srcIndices.size(),
-            &srcVertices[0].Position.x, srcVertices.size( ), sizeof( StandardVertex ), targetCount, maxError ) );
-
-        // exit conditions
-        if( lod.size() > targetCountAcceptable || lod.size() < stopTriCount*3 )
-            break;
-
-        LODPart nextLOD;
-        nextLOD.IndexStart          = (int)indices.size();
-        nextLOD.SwapToNextDistance  = prevLOD.SwapToNextDistance * std::sqrtf(stepRangeIncrease);
-        int startVertex             = (int)vertices.size();
-        for( int i = 0; i < (int)lod.size(); i += 3 )
-        {
-            const StandardVertex a = srcVertices[lod[i+0]];
-            const StandardVertex b = srcVertices[lod[i+1]];
-            const StandardVertex c = srcVertices[lod[i+2]];
-
-            int lookBackRange = std::min( 1024, ((int)vertices.size()-startVertex) );
-            MeshAddTriangleMergeDuplicates( a, b, c, vaRenderMesh::StandardVertex::IsDuplicate, lookBackRange );
-        }
-        nextLOD.IndexCount = (int)indices.size() - nextLOD.IndexStart;
-        assert( nextLOD.IndexCount > 0 );
-
-        srcVertices.resize( vertices.size() - startVertex );
-        srcIndices.resize( nextLOD.IndexCount );
-        for( int i = 0; i < srcVertices.size(); i++ )
-            srcVertices[i] = vertices[startVertex+i];
-        for( int i = 0; i < srcIndices.size( ); i++ )
-        {
-            srcIndices[i] = indices[nextLOD.IndexStart+i] - startVertex;
-            assert( srcIndices[i] >= 0 && srcIndices[i] < srcVertices.size() );
-        }
-
-        m_LODParts.push_back( nextLOD );
-
-        RebuildNormals( currentLOD, 1, normalRebuildMergeSharedMaxAngle );
-
-        currentLOD++;
-    } while( true );
+    vaRenderMeshLODBuilder::Settings settings;
+    settings.MaxRelativePosError                = maxRelativePosError;
+    settings.NormalRebuildMergeSharedMaxAngle   = normalRebuildMergeSharedMaxAngle;
 
-    assert( m_LODParts.size( ) <= LODPart::MaxLODParts );
-
-    MeshSetGPUDataDirty( );
-    UpdateAABB( );
+    vaRenderMeshLODBuilder::Mesh mesh;
+    vaRenderMeshLODBuilder::Extract( *this, mesh );
+    vaRenderMeshLODBuilder::Build( mesh, settings );
+    vaRenderMeshLODBuilder::Apply( std::move( mesh ), *this );
 }
 
 float vaRenderMesh::FindLOD( float LODRangeFactor )
@@ -760,8 +788,7 @@ bool vaRenderMesh::SaveAPACK( vaStream & outStream )
 {
     VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<int32>( c_renderMeshFileVersion ) );
     VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<int32>( (int32)m_frontFaceWinding ) );
-    VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValueVector<uint32>( Indices() ) );
-    VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValueVector<StandardVertex>( Vertices() ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( SaveGeometryAPACK( outStream, Vertices(), Indices(), m_storageQuantizeAttributes ) );
     VERIFY_TRUE_RETURN_ON_FALSE( SaveUIDObjectUID( outStream, vaUIDObjectRegistrar::Find<vaRenderMaterial>( m_materialID ) ) );
     VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValueVector<LODPart>( m_LODParts ) );
     VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<vaBoundingBox>( m_boundingBox ) );
@@ -794,11 +821,19 @@ bool vaRenderMesh::LoadAPACK( vaStream & inStream )
         vaTriangleMeshTools::CalculateBounds( Vertices( ), aabb, m_boundingSphere );
         // assert( aabb == m_boundingBox );
     }
-    else if( fileVersion == 4 )
+    else if( fileVersion == 4 || fileVersion == 5 )
     {
         VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<int32>( (int32&)m_frontFaceWinding ) );
-        VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValueVector<uint32>( Indices( ) ) );
-        VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValueVector<StandardVertex>( Vertices( ) ) );
+        if( fileVersion == 4 )
+        {
+            VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValueVector<uint32>( Indices( ) ) );
+            VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValueVector<StandardVertex>( Vertices( ) ) );
+            m_storageQuantizeAttributes = false;
+        }
+        else
+        {
+            VERIFY_TRUE_RETURN_ON_FALSE( LoadGeometryAPACK( inStream, Vertices( ), Indices( ), &m_storageQuantizeAttributes ) );
+        }
         VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<vaGUID>( m_materialID ) ); 
 #ifdef VA_RENDER_MATERIAL_USE_CACHED_FP
         m_materialCachedFP.store( vaFramePtr<vaRenderMaterial>{} );
@@ -821,6 +856,93 @@ bool vaRenderMesh::LoadAPACK( vaStream & inStream )
     return true;
 }
 
+bool vaRenderMesh::SaveGeometryAPACK( vaStream & outStream, const std::vector<StandardVertex> & vertices, const std::vector<uint32> & indices, bool quantizeAttributes )
+{
+    uint32 flags = 0;
+    if( quantizeAttributes )
+        flags |= GSF_QuantizedAttributes;
+    if( indices.size( ) % 3 != 0 )
+        flags |= GSF_RawIndices;
+
+    VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<uint32>( flags ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<int32>( (int32)vertices.size( ) ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( outStream.WriteValue<int32>( (int32)indices.size( ) ) );
+
+    std::vector<unsigned char> buffer;
+    if( vertices.size( ) > 0 )
+    {
+        if( quantizeAttributes )
+        {
+            std::vector<QuantizedVertex> quantized( vertices.size( ) );
+            for( size_t i = 0; i < vertices.size( ); i++ )
+                quantized[i] = Quantize( vertices[i] );
+            buffer.resize( meshopt_encodeVertexBufferBound( quantized.size( ), sizeof( QuantizedVertex ) ) );
+            VERIFY_TRUE_RETURN_ON_FALSE( WriteEncoded( outStream, buffer, meshopt_encodeVertexBuffer( buffer.data( ), buffer.size( ), quantized.data( ), quantized.size( ), sizeof( QuantizedVertex ) ) ) );
+        }
+        else
+        {
+            buffer.resize( meshopt_encodeVertexBufferBound( vertices.size( ), sizeof( StandardVertex ) ) );
+            VERIFY_TRUE_RETURN_ON_FALSE( WriteEncoded( outStream, buffer, meshopt_encodeVertexBuffer( buffer.data( ), buffer.size( ), vertices.data( ), vertices.size( ), sizeof( StandardVertex ) ) ) );
+        }
+    }
+    if( indices.size( ) > 0 )
+    {
+        if( ( flags & GSF_RawIndices ) != 0 )
+            VERIFY_TRUE_RETURN_ON_FALSE( outStream.Write( indices.data( ), (int64)( indices.size( ) * sizeof( uint32 ) ) ) );
+        else
+        {
+            buffer.resize( meshopt_encodeIndexBufferBound( indices.size( ), vertices.size( ) ) );
+            VERIFY_TRUE_RETURN_ON_FALSE( WriteEncoded( outStream, buffer, meshopt_encodeIndexBuffer( buffer.data( ), buffer.size( ), indices.data( ), indices.size( ) ) ) );
+        }
+    }
+    return true;
+}
+
+bool vaRenderMesh::LoadGeometryAPACK( vaStream & inStream, std::vector<StandardVertex> & outVertices, std::vector<uint32> & outIndices, bool * outQuantizedAttributes )
+{
+    uint32 flags = 0; int32 vertexCount = 0; int32 indexCount = 0;
+    VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<uint32>( flags ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<int32>( vertexCount ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( inStream.ReadValue<int32>( indexCount ) );
+    VERIFY_TRUE_RETURN_ON_FALSE( vertexCount >= 0 && indexCount >= 0 );
+
+    const bool quantized = ( flags & GSF_QuantizedAttributes ) != 0;
+    if( outQuantizedAttributes != nullptr )
+        *outQuantizedAttributes = quantized;
+
+    std::vector<unsigned char> buffer;
+    outVertices.resize( vertexCount );
+    if( vertexCount > 0 )
+    {
+        VERIFY_TRUE_RETURN_ON_FALSE( ReadEncoded( inStream, buffer ) );
+        if( quantized )
+        {
+            std::vector<QuantizedVertex> quantizedVertices( vertexCount );
+            VERIFY_TRUE_RETURN_ON_FALSE( meshopt_decodeVertexBuffer( quantizedVertices.data( ), vertexCount, sizeof( QuantizedVertex ), buffer.data( ), buffer.size( ) ) == 0 );
+            for( int32 i = 0; i < vertexCount; i++ )
+                outVertices[i] = Dequantize( quantizedVertices[i] );
+        }
+        else
+            VERIFY_TRUE_RETURN_ON_FALSE( meshopt_decodeVertexBuffer( outVertices.data( ), vertexCount, sizeof( StandardVertex ), buffer.data( ), buffer.size( ) ) == 0 );
+    }
+
+    outIndices.resize( indexCount );
+    if( indexCount > 0 )
+    {
+        if( ( flags & GSF_RawIndices ) != 0 )
+            VERIFY_TRUE_RETURN_ON_FALSE( inStream.Read( outIndices.data( ), (int64)indexCount * sizeof( uint32 ) ) );
+        else
+        {
+            VERIFY_TRUE_RETURN_ON_FALSE( ReadEncoded( inStream, buffer ) );
+            VERIFY_TRUE_RETURN_ON_FALSE( meshopt_decodeIndexBuffer( outIndices.data( ), indexCount, sizeof( uint32 ), buffer.data( ), buffer.size( ) ) == 0 );
+        }
+        // the decoder is safe for untrusted input but can produce out of range indices
+        for( uint32 index : outIndices )
+            VERIFY_TRUE_RETURN_ON_FALSE( index < (uint32)vertexCount );
+    }
+    return true;
+}
+
 bool vaRenderMesh::LODPart::Serialize( vaXMLSerializer & serializer )
 {
     VERIFY_TRUE_RETURN_ON_FALSE( serializer.Serialize<int32>( "IndexStart", IndexStart ) );
@@ -834,7 +956,7 @@ bool vaRenderMesh::SerializeUnpacked( vaXMLSerializer & serializer, const string
     assetFolder;
     int32 fileVersion = c_renderMeshFileVersion;
     VERIFY_TRUE_RETURN_ON_FALSE( serializer.Serialize<int32>( "FileVersion", fileVersion ) );
-    VERIFY_TRUE_RETURN_ON_FALSE( fileVersion == c_renderMeshFileVersion );
+    VERIFY_TRUE_RETURN_ON_FALSE( fileVersion >= 4 && fileVersion <= c_renderMeshFileVersion );   // 4 and 5 only differ in APACK geometry storage
 
 
     VERIFY_TRUE_RETURN_ON_FALSE( serializer.Serialize<int32>( "FrontFaceWinding", reinterpret_cast<int32&>(m_frontFaceWinding) ) );
@@ -894,6 +1016,9 @@ bool vaRenderMesh::SerializeUnpacked( vaXMLSerializer & serializer, const string
     VERIFY_TRUE_RETURN_ON_FALSE( serializer.Serialize<float>( "LODDistanceOffsetAdd", m_LODDistanceOffsetAdd ) );
     VERIFY_TRUE_RETURN_ON_FALSE( serializer.Serialize<float>( "LODDistanceOffsetMul", m_LODDistanceOffsetMul ) );
 
+    // only affects APACK geometry storage (see SaveGeometryAPACK) but it's a user setting so it has to survive the unpacked round trip too
+    VERIFY_TRUE_RETURN_ON_FALSE( serializer.Serialize<bool>( "StorageQuantizeAttributes", m_storageQuantizeAttributes, false ) );
+
     assert( m_LODParts.size( ) <= LODPart::MaxLODParts );
     if( m_LODParts.size() > LODPart::MaxLODParts )
         m_LODParts.resize(LODPart::MaxLODParts);
@@ -1274,6 +1399,23 @@ bool vaRenderMesh::UIPropertiesDraw( vaApplicationBase & application )
                 ClearLODs( );
                 hadChanges = true;
             }
+
+            if( ImGui::Checkbox( "Quantize normals and UVs in storage", &m_storageQuantizeAttributes ) )
+                hadChanges = true;
+            if( ImGui::IsItemHovered( ) )
+                ImGui::SetTooltip( "Lossy: normals to 16bit snorm and UVs to 16bit float when saving to .apack" );
+
+            if( ImGui::Button( "Optimize for rendering" ) )
+            {
+                vaRenderMeshOptimizer::Mesh mesh;
+                vaRenderMeshOptimizer::Extract( *this, mesh );
+                vaRenderMeshOptimizer::Stats stats = vaRenderMeshOptimizer::Optimize( mesh, vaRenderMeshOptimizer::Settings( ) );
+                vaRenderMeshLODBuilder::Apply( std::move( mesh ), *this );
+                VA_LOG( "vaRenderMesh optimize: %s", stats.ToString( ).c_str( ) );
+                hadChanges = true;
+            }
+            if( ImGui::IsItemHovered( ) )
+                ImGui::SetTooltip( "Vertex cache, overdraw and vertex fetch optimization for all LODs" );
         }
 
         ImGui::Separator();
@@ -1492,7 +1634,7 @@ vaDrawResultFlags vaRenderMeshManager::Draw( vaRenderDeviceContext & renderConte
     {
         std::pair< const vaRenderInstanceList::Item *, size_t > List;
         const vaRenderInstance *                    GlobalList;
-        const std::vector< int > *                  SortIndices;
+        const vaRenderInstanceList::SortIndices *   SortIndices;
         vaDrawAttributes                            DrawAttributes;
         std::vector<PerWorkerData> &                WorkerDataArray;
         //GlobalCustomizerType &                      GlobalCustomizer;
@@ -136,6 +136,8 @@ namespace Vanilla
         float                                           m_LODDistanceOffsetAdd      = 0.0f;
         float                                           m_LODDistanceOffsetMul      = 1.0f;
 
+        bool                                            m_storageQuantizeAttributes = false;    // see SaveGeometryAPACK
+
         vaBoundingBox                                   m_boundingBox;              // local bounding box around the mesh (includes all LODs)
         vaBoundingSphere                                m_boundingSphere;           // same as ^ :)
 
@@ -144,6 +146,7 @@ namespace Vanilla
 
     protected:
         friend class vaRenderMeshManager;
+        friend class vaRenderMeshLODBuilder;
         vaRenderMesh( const vaRenderingModuleParams & params );
     public:
         virtual ~vaRenderMesh( );
@@ -203,6 +206,17 @@ namespace Vanilla
         bool                                            LoadAPACK( vaStream & inStream ) override;
         bool                                            SerializeUnpacked( vaXMLSerializer & serializer, const string & assetFolder ) override;
 
+        // Quantize normals (snorm16) and UVs (half float) when saving to APACK - lossy, roughly 30% smaller vertex streams
+        bool                                            GetStorageQuantizeAttributes( ) const               { return m_storageQuantizeAttributes; }
+        void                                            SetStorageQuantizeAttributes( bool quantize )       { m_storageQuantizeAttributes = quantize; }
+
+        // APACK geometry streams: vertices and indices encoded with meshoptimizer's vertex and index codecs (which work best on
+        // vertex cache/fetch optimized data, see vaRenderMeshOptimizer), optionally with quantized attributes. The output is 
+        // also much more compressible by the APACK whole-file compression than raw data. Note: the index codec can rotate 
+        // vertex order within a triangle (winding is preserved).
+        static bool                                     SaveGeometryAPACK( vaStream & outStream, const std::vector<StandardVertex> & vertices, const std::vector<uint32> & indices, bool quantizeAttributes );
+        static bool                                     LoadGeometryAPACK( vaStream & inStream, std::vector<StandardVertex> & outVertices, std::vector<uint32> & outIndices, bool * outQuantizedAttributes = nullptr );
+
         //virtual void                                    ReconnectDependencies( );
         virtual void                                    RegisterUsedAssetPacks( std::function<void( const vaAssetPack & )> registerFunction ) override;
         void                                            EnumerateUsedAssets( const std::function<void(vaAsset * asset)> & callback );
@@ -253,6 +267,9 @@ namespace Vanilla
         // don't forget to "std::unique_lock lock( m_mutex ); m_gpuDataDirty = true;"!
         template< typename CompareCallableType >
         inline void                                     MeshAddTriangleMergeDuplicates( const StandardVertex & v0, const StandardVertex & v1, const StandardVertex & v2, CompareCallableType && isDuplicate, int searchBackRange = -1 );
+        // same as above but searches using (and adds new vertices to) weldIndex - see vaVertexWeldIndex
+        template< typename CompareCallableType >
+        inline void                                     MeshAddTriangleMergeDuplicates( const StandardVertex & v0, const StandardVertex & v1, const StandardVertex & v2, vaVertexWeldIndex & weldIndex, CompareCallableType && isDuplicate );
         //
         // TEMP TEMP TEMP
         virtual void                                    UpdateGPURTData( vaRenderDeviceContext & renderContext ) { renderContext; assert( false ); };
@@ -413,4 +430,11 @@ namespace Vanilla
         // m_gpuDataDirty = true;
     }
 
+    template< typename CompareCallableType >
+    inline void vaRenderMesh::MeshAddTriangleMergeDuplicates( const StandardVertex & v0, const StandardVertex & v1, const StandardVertex & v2, vaVertexWeldIndex & weldIndex, CompareCallableType && isDuplicate )
+    {
+        assert( GetRenderDevice( ).IsRenderThread( ) );
+        vaTriangleMeshTools::AddTriangle_MergeDuplicates( Vertices( ), Indices( ), v0, v1, v2, weldIndex, isDuplicate );
+    }
+
 }
\ No newline at end of file
@@ -0,0 +1,173 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation 
+// 
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "vaRenderMeshLODBuilder.h"
+
+#include "IntegratedExternals/vaMeshoptimizerIntegration.h"
+
+using namespace Vanilla;
+
+namespace
+{
+    const float     c_stepTriReduce         = 0.25f;                                        // how many triangles to attempt to drop every step
+    const float     c_stepTriReduceMin      = vaMath::Lerp( c_stepTriReduce, 1.0f, 0.7f );  // stop if failed to drop below this for next step
+    const float     c_stepRangeIncrease     = 1.0f / c_stepTriReduce;
+    const int       c_stopTriCount          = 64;                                           // doesn't make sense to go lower - we're going to be heavily CPU bound so it doesn't save anything
+}
+
+void vaRenderMeshLODBuilder::Build( Mesh & mesh, const Settings & settings )
+{
+    VA_TRACE_CPU_SCOPE( LODBuilderMesh );
+
+    std::vector<StandardVertex> & vertices  = mesh.Vertices;
+    std::vector<uint32> &         indices   = mesh.Indices;
+
+    mesh.LODParts.clear( );
+    // transition starting point - just a guess <shrug>
+    mesh.LODParts.push_back( LODPart( 0, (int)indices.size( ), 1.0f / std::sqrtf( c_stepTriReduce ) ) );
+    if( vertices.size( ) == 0 || indices.size( ) == 0 )
+        return;
+
+    const float maxError = vaTriangleMeshTools::CalculateBounds( vertices ).Size.Length( ) * settings.MaxRelativePosError;
+
+    // previous LOD, with local (0-based) indices
+    std::vector<StandardVertex> srcVertices = vertices;
+    std::vector<uint32>         srcIndices  = indices;
+
+    std::vector<uint32>         lod;
+    std::vector<uint32>         remap;
+    std::vector<vaVector3>      positions;
+    std::vector<vaVector3>      normals;
+    while( mesh.LODParts.size( ) < LODPart::MaxLODParts )
+    {
+        const size_t targetCount            = (size_t)( srcIndices.size( ) * c_stepTriReduce );
+        const size_t targetCountAcceptable  = (size_t)( srcIndices.size( ) * c_stepTriReduceMin );
+
+        lod.resize( srcIndices.size( ) );
+        lod.resize( meshopt_simplify( lod.data( ), srcIndices.data( ), srcIndices.size( ), &srcVertices[0].Position.x, srcVertices.size( ), 
+            sizeof( StandardVertex ), targetCount, maxError ) );
+
+        // exit conditions
+        if( lod.size( ) > targetCountAcceptable || lod.size( ) < c_stopTriCount * 3 )
+            break;
+
+        // compact: only vertices referenced by the new LOD, in the order of first use, with identical vertices merged
+        remap.resize( srcVertices.size( ) );
+        const size_t lodVertexCount = meshopt_generateVertexRemap( remap.data( ), lod.data( ), lod.size( ), srcVertices.data( ), srcVertices.size( ), sizeof( StandardVertex ) );
+        std::vector<StandardVertex> lodVertices( lodVertexCount );
+        meshopt_remapVertexBuffer( lodVertices.data( ), srcVertices.data( ), srcVertices.size( ), sizeof( StandardVertex ), remap.data( ) );
+        meshopt_remapIndexBuffer( lod.data( ), lod.data( ), lod.size( ), remap.data( ) );
+
+        // rebuild normals for the new LOD only
+        positions.resize( lodVertexCount );
+        normals.resize( lodVertexCount );
+        for( size_t i = 0; i < lodVertexCount; i++ )
+            positions[i] = lodVertices[i].Position;
+        vaTriangleMeshTools::GenerateNormals( normals, positions, lod, mesh.FrontFaceWinding, 0, -1, true, settings.NormalRebuildMergeSharedMaxAngle );
+
+        // append, with the rebuilt normals; lodVertices keep the source ones as the next LOD is compacted from them (otherwise 
+        // rebuilt normals would decide which vertices get merged)
+        const uint32 startVertex = (uint32)vertices.size( );
+        LODPart nextLOD;
+        nextLOD.IndexStart          = (int)indices.size( );
+        nextLOD.IndexCount          = (int)lod.size( );
+        nextLOD.SwapToNextDistance  = mesh.LODParts.back( ).SwapToNextDistance * std::sqrtf( c_stepRangeIncrease );
+        vertices.insert( vertices.end( ), lodVertices.begin( ), lodVertices.end( ) );
+        for( size_t i = 0; i < lodVertexCount; i++ )
+            vertices[startVertex + i].Normal.AsVec3( ) = normals[i];
+        for( uint32 index : lod )
+            indices.push_back( index + startVertex );
+        mesh.LODParts.push_back( nextLOD );
+
+        srcVertices.swap( lodVertices );
+        srcIndices.swap( lod );
+    }
+
+    assert( mesh.LODParts.size( ) <= LODPart::MaxLODParts );
+}
+
+vaRenderMeshLODBuilder::Stats vaRenderMeshLODBuilder::Build( std::vector<Mesh> & meshes, const Settings & settings, tf::Executor * executor )
+{
+    VA_TRACE_CPU_SCOPE( LODBuilder );
+
+    const double startTime = vaCore::TimeFromAppStart( );
+
+#ifdef VA_TASKFLOW_INTEGRATION_ENABLED
+    tf::Executor & actualExecutor = ( executor != nullptr ) ? ( *executor ) : ( vaTF::Executor( ) );
+    if( meshes.size( ) > 1 && actualExecutor.this_worker_id( ) == -1 )
+    {
+        // largest first so the long ones don't end up at the tail
+        std::vector<int> order( meshes.size( ) );
+        for( int i = 0; i < (int)order.size( ); i++ )
+            order[i] = i;
+        std::sort( order.begin( ), order.end( ), [ &meshes ]( int a, int b ) { return meshes[a].Indices.size( ) > meshes[b].Indices.size( ); } );
+
+        tf::Taskflow taskflow( "LODBuilder" );
+        for( int meshIndex : order )
+            taskflow.emplace( [ &meshes, &settings, meshIndex ]( ) { Build( meshes[meshIndex], settings ); } ).name( "LODBuilderMesh" );
+        actualExecutor.run( taskflow ).wait( );
+    }
+    else
+#else
+    executor; // unreferenced
+#endif
+    {
+        for( Mesh & mesh : meshes )
+            Build( mesh, settings );
+    }
+
+    Stats stats;
+    stats.ElapsedTime = vaCore::TimeFromAppStart( ) - startTime;
+    for( const Mesh & mesh : meshes )
+    {
+        stats.MeshCount++;
+        stats.LODCount += std::max( 0, (int)mesh.LODParts.size( ) - 1 );
+        stats.InputTriangles += ( mesh.LODParts.size( ) > 0 ) ? ( mesh.LODParts[0].IndexCount / 3 ) : ( 0 );
+        for( size_t i = 1; i < mesh.LODParts.size( ); i++ )
+            stats.OutputTriangles += mesh.LODParts[i].IndexCount / 3;
+    }
+    return stats;
+}
+
+void vaRenderMeshLODBuilder::Extract( vaRenderMesh & renderMesh, Mesh & outMesh )
+{
+    if( renderMesh.GetLODParts( ).size( ) > 0 )
+        renderMesh.ClearLODs( );
+
+    outMesh.Vertices            = renderMesh.Vertices( );
+    outMesh.Indices             = renderMesh.Indices( );
+    outMesh.FrontFaceWinding    = renderMesh.GetFrontFaceWindingOrder( );
+    outMesh.LODParts.clear( );
+}
+
+void vaRenderMeshLODBuilder::Apply( Mesh && mesh, vaRenderMesh & renderMesh )
+{
+    renderMesh.Vertices( )      = std::move( mesh.Vertices );
+    renderMesh.Indices( )       = std::move( mesh.Indices );
+    renderMesh.m_LODParts       = std::move( mesh.LODParts );
+    assert( renderMesh.m_LODParts.size( ) <= LODPart::MaxLODParts );
+
+    renderMesh.MeshSetGPUDataDirty( );
+    renderMesh.UpdateAABB( );
+}
+
+vaRenderMeshLODBuilder::Stats vaRenderMeshLODBuilder::Rebuild( const std::vector<shared_ptr<vaRenderMesh>> & renderMeshes, const Settings & settings, tf::Executor * executor )
+{
+    std::vector<Mesh> meshes( renderMeshes.size( ) );
+    for( size_t i = 0; i < renderMeshes.size( ); i++ )
+        Extract( *renderMeshes[i], meshes[i] );
+
+    Stats stats = Build( meshes, settings, executor );
+
+    for( size_t i = 0; i < renderMeshes.size( ); i++ )
+        Apply( std::move( meshes[i] ), *renderMeshes[i] );
+
+    return stats;
+}
@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation 
+// 
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Core/vaCoreIncludes.h"
+
+#include "vaRenderMesh.h"
+
+#ifdef VA_TASKFLOW_INTEGRATION_ENABLED
+#include "IntegratedExternals/vaTaskflowIntegration.h"
+#else
+namespace tf { class Executor; }
+#endif
+
+namespace Vanilla
+{
+    // Builds vaRenderMesh LOD chains (meshopt_simplify based, used by vaRenderMesh::RebuildLODs) for many meshes concurrently on 
+    // the task system. Works on plain vertex/index arrays so it needs no render device or render thread - Extract and Apply 
+    // are the only parts that touch vaRenderMesh - and can be used from headless tools or the asset importer's background thread.
+    //
+    // Each LOD is simplified from the previous one and its vertices are compacted with a meshopt vertex remap table (which 
+    // also merges identical vertices), then normals are rebuilt for it. The output matches the old per-mesh RebuildLODs path 
+    // (see the LODBuilder benchmark) with one exception: the remap compares vertices bitwise while StandardVertex::IsDuplicate 
+    // compares floats, so vertices that differ only in +0/-0 are no longer merged (and NaN ones now are).
+    class vaRenderMeshLODBuilder
+    {
+    public:
+        typedef vaRenderMesh::StandardVertex            StandardVertex;
+        typedef vaRenderMesh::LODPart                   LODPart;
+
+        struct Settings
+        {
+            float                                       MaxRelativePosError                 = 0.0007f;  // relative to the bounding box diagonal
+            float                                       NormalRebuildMergeSharedMaxAngle    = 0.0f;     // in radians, see vaTriangleMeshTools::GenerateNormals
+        };
+
+        // On input Vertices/Indices are LOD0; on output the generated LODs are appended and LODParts describes them all.
+        struct Mesh
+        {
+            std::vector<StandardVertex>                 Vertices;
+            std::vector<uint32>                         Indices;
+            vaWindingOrder                              FrontFaceWinding                    = vaWindingOrder::CounterClockwise;
+            std::vector<LODPart>                        LODParts;
+        };
+
+        struct Stats
+        {
+            int                                         MeshCount                           = 0;
+            int                                         LODCount                            = 0;        // generated, not including LOD0s
+            int64                                       InputTriangles                      = 0;        // LOD0 triangles
+            int64                                       OutputTriangles                     = 0;        // generated triangles
+            double                                      ElapsedTime                         = 0.0;      // in seconds
+
+            double                                      TrianglesPerSecond( ) const         { return ( ElapsedTime > 0.0 ) ? ( (double)InputTriangles / ElapsedTime ) : ( 0.0 ); }
+        };
+
+    public:
+        // Single mesh, on the calling thread
+        static void                                     Build( Mesh & mesh, const Settings & settings );
+
+        // One task per mesh on 'executor' (vaTF::Executor( ) if nullptr); blocks until all done. Runs serially if called from 
+        // one of the executor's own workers to avoid blocking it.
+        static Stats                                    Build( std::vector<Mesh> & meshes, const Settings & settings, tf::Executor * executor = nullptr );
+
+        // Drops existing LODs from renderMesh (vaRenderMesh::ClearLODs) and copies LOD0 into outMesh
+        static void                                     Extract( vaRenderMesh & renderMesh, Mesh & outMesh );
+        // Moves built mesh data into renderMesh
+        static void                                     Apply( Mesh && mesh, vaRenderMesh & renderMesh );
+
+        // Extract, Build and Apply for a batch of render meshes (same render thread requirements as vaRenderMesh::RebuildLODs)
+        static Stats                                    Rebuild( const std::vector<shared_ptr<vaRenderMesh>> & renderMeshes, const Settings & settings, tf::Executor * executor = nullptr );
+    };
+}
@@ -0,0 +1,178 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation 
+// 
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "vaRenderMeshOptimizer.h"
+
+#include "IntegratedExternals/vaMeshoptimizerIntegration.h"
+
+using namespace Vanilla;
+
+namespace
+{
+    const unsigned int  c_analyzeCacheSize  = 16;   // typical post-transform cache size used for ACMR/ATVR reporting
+}
+
+vaRenderMeshOptimizer::Statistics & vaRenderMeshOptimizer::Statistics::operator += ( const Statistics & other )
+{
+    Triangles           += other.Triangles;
+    Vertices            += other.Vertices;
+    VerticesTransformed += other.VerticesTransformed;
+    BytesFetched        += other.BytesFetched;
+    BytesReferenced     += other.BytesReferenced;
+    return *this;
+}
+
+string vaRenderMeshOptimizer::Stats::ToString( ) const
+{
+    return vaStringTools::Format( "%d meshes, %d LODs, %lld triangles: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, overfetch %.3f -> %.3f in %.2fs (%.2f Mtris/s)", 
+        MeshCount, LODCount, Before.Triangles, Before.ACMR( ), After.ACMR( ), Before.ATVR( ), After.ATVR( ), Before.Overfetch( ), After.Overfetch( ), 
+        ElapsedTime, TrianglesPerSecond( ) / 1e6 );
+}
+
+vaRenderMeshOptimizer::Statistics vaRenderMeshOptimizer::Analyze( const Mesh & mesh )
+{
+    Statistics stats;
+    const size_t vertexCount = mesh.Vertices.size( );
+    std::vector<int> lastSeenInLOD( vertexCount, -1 );
+    for( int lod = 0; lod < (int)mesh.LODParts.size( ); lod++ )
+    {
+        const LODPart & part = mesh.LODParts[lod];
+        if( part.IndexCount == 0 )
+            continue;
+        const uint32 * indices = mesh.Indices.data( ) + part.IndexStart;
+
+        const meshopt_VertexCacheStatistics cacheStats = meshopt_analyzeVertexCache( indices, part.IndexCount, vertexCount, c_analyzeCacheSize, 0, 0 );
+        const meshopt_VertexFetchStatistics fetchStats = meshopt_analyzeVertexFetch( indices, part.IndexCount, vertexCount, sizeof( StandardVertex ) );
+
+        int64 uniqueVertices = 0;
+        for( int i = 0; i < part.IndexCount; i++ )
+            if( lastSeenInLOD[indices[i]] != lod )
+            {
+                lastSeenInLOD[indices[i]] = lod;
+                uniqueVertices++;
+            }
+
+        stats.Triangles             += part.IndexCount / 3;
+        stats.Vertices              += uniqueVertices;
+        stats.VerticesTransformed   += cacheStats.vertices_transformed;
+        stats.BytesFetched          += fetchStats.bytes_fetched;
+        stats.BytesReferenced       += uniqueVertices * (int64)sizeof( StandardVertex );
+    }
+    return stats;
+}
+
+vaRenderMeshOptimizer::Stats vaRenderMeshOptimizer::Optimize( Mesh & mesh, const Settings & settings )
+{
+    VA_TRACE_CPU_SCOPE( RenderMeshOptimize );
+
+    Stats stats;
+    stats.MeshCount = 1;
+    stats.LODCount  = (int)mesh.LODParts.size( );
+    stats.Before    = Analyze( mesh );
+
+    const double startTime = vaCore::TimeFromAppStart( );
+
+    std::vector<StandardVertex> & vertices  = mesh.Vertices;
+    std::vector<uint32> &         indices   = mesh.Indices;
+    if( vertices.size( ) > 0 && indices.size( ) > 0 )
+    {
+        std::vector<uint32> scratch;
+        for( const LODPart & part : mesh.LODParts )
+        {
+            if( part.IndexCount == 0 )
+                continue;
+            uint32 * partIndices = indices.data( ) + part.IndexStart;
+            scratch.resize( part.IndexCount );
+
+            if( settings.OptimizeVertexCache )
+            {
+                meshopt_optimizeVertexCache( scratch.data( ), partIndices, part.IndexCount, vertices.size( ) );
+                std::copy( scratch.begin( ), scratch.end( ), partIndices );
+            }
+            // expects vertex cache optimized input, works on triangle clusters so that it doesn't undo it
+            if( settings.OptimizeOverdraw )
+            {
+                meshopt_optimizeOverdraw( scratch.data( ), partIndices, part.IndexCount, &vertices[0].Position.x, vertices.size( ), sizeof( StandardVertex ), settings.OverdrawThreshold );
+                std::copy( scratch.begin( ), scratch.end( ), partIndices );
+            }
+        }
+
+        // whole index buffer at once - LOD parts are in order so each one's vertices end up contiguous (if they didn't share any before)
+        if( settings.OptimizeVertexFetch )
+        {
+            std::vector<StandardVertex> fetchOptimized( vertices.size( ) );
+            fetchOptimized.resize( meshopt_optimizeVertexFetch( fetchOptimized.data( ), indices.data( ), indices.size( ), vertices.data( ), vertices.size( ), sizeof( StandardVertex ) ) );
+            vertices.swap( fetchOptimized );
+        }
+    }
+
+    stats.ElapsedTime   = vaCore::TimeFromAppStart( ) - startTime;
+    stats.After         = Analyze( mesh );
+    return stats;
+}
+
+vaRenderMeshOptimizer::Stats vaRenderMeshOptimizer::Optimize( std::vector<Mesh> & meshes, const Settings & settings, tf::Executor * executor )
+{
+    VA_TRACE_CPU_SCOPE( RenderMeshOptimizeBatch );
+
+    const double startTime = vaCore::TimeFromAppStart( );
+
+    std::vector<Stats> meshStats( meshes.size( ) );
+#ifdef VA_TASKFLOW_INTEGRATION_ENABLED
+    tf::Executor & actualExecutor = ( executor != nullptr ) ? ( *executor ) : ( vaTF::Executor( ) );
+    if( meshes.size( ) > 1 && actualExecutor.this_worker_id( ) == -1 )
+    {
+        tf::Taskflow taskflow( "RenderMeshOptimize" );
+        for( int meshIndex = 0; meshIndex < (int)meshes.size( ); meshIndex++ )
+            taskflow.emplace( [ &meshes, &meshStats, &settings, meshIndex ]( ) { meshStats[meshIndex] = Optimize( meshes[meshIndex], settings ); } ).name( "RenderMeshOptimizeMesh" );
+        actualExecutor.run( taskflow ).wait( );
+    }
+    else
+#else
+    executor; // unreferenced
+#endif
+    {
+        for( size_t i = 0; i < meshes.size( ); i++ )
+            meshStats[i] = Optimize( meshes[i], settings );
+    }
+
+    Stats stats;
+    for( const Stats & oneMesh : meshStats )
+    {
+        stats.MeshCount += oneMesh.MeshCount;
+        stats.LODCount  += oneMesh.LODCount;
+        stats.Before    += oneMesh.Before;
+        stats.After     += oneMesh.After;
+    }
+    stats.ElapsedTime = vaCore::TimeFromAppStart( ) - startTime;
+    return stats;
+}
+
+void vaRenderMeshOptimizer::Extract( const vaRenderMesh & renderMesh, Mesh & outMesh )
+{
+    outMesh.Vertices            = renderMesh.Vertices( );
+    outMesh.Indices             = renderMesh.Indices( );
+    outMesh.FrontFaceWinding    = renderMesh.GetFrontFaceWindingOrder( );
+    outMesh.LODParts            = renderMesh.GetLODParts( );
+}
+
+vaRenderMeshOptimizer::Stats vaRenderMeshOptimizer::Optimize( const std::vector<shared_ptr<vaRenderMesh>> & renderMeshes, const Settings & settings, tf::Executor * executor )
+{
+    std::vector<Mesh> meshes( renderMeshes.size( ) );
+    for( size_t i = 0; i < renderMeshes.size( ); i++ )
+        Extract( *renderMeshes[i], meshes[i] );
+
+    Stats stats = Optimize( meshes, settings, executor );
+
+    for( size_t i = 0; i < renderMeshes.size( ); i++ )
+        vaRenderMeshLODBuilder::Apply( std::move( meshes[i] ), *renderMeshes[i] );
+
+    return stats;
+}
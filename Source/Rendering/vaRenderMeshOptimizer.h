@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation 
+// 
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Core/vaCoreIncludes.h"
+
+#include "vaRenderMeshLODBuilder.h"
+
+namespace Vanilla
+{
+    // Reorders vaRenderMesh triangles and vertices for rendering efficiency using meshoptimizer: vertex cache, then overdraw 
+    // (both per LOD part, so LOD ranges stay valid), then vertex fetch (vertices in order of first use - LODs laid out after 
+    // each other keep their vertices in their own contiguous ranges; unreferenced vertices are dropped). 
+    // Works on the same plain data as vaRenderMeshLODBuilder so it's usable headlessly and from the asset importer's thread.
+    class vaRenderMeshOptimizer
+    {
+    public:
+        typedef vaRenderMeshLODBuilder::Mesh            Mesh;
+        typedef vaRenderMeshLODBuilder::StandardVertex  StandardVertex;
+        typedef vaRenderMeshLODBuilder::LODPart         LODPart;
+
+        struct Settings
+        {
+            bool                                        OptimizeVertexCache             = true;
+            bool                                        OptimizeOverdraw                = true;
+            float                                       OverdrawThreshold               = 1.05f;    // max allowed ACMR increase when reordering for overdraw, see meshopt_optimizeOverdraw
+            bool                                        OptimizeVertexFetch             = true;
+        };
+
+        // Summed over all LOD parts of one or more meshes
+        struct Statistics
+        {
+            int64                                       Triangles                       = 0;
+            int64                                       Vertices                        = 0;        // unique vertices referenced (per LOD part)
+            int64                                       VerticesTransformed             = 0;        // simulated post-transform cache misses
+            int64                                       BytesFetched                    = 0;        // simulated vertex fetch
+            int64                                       BytesReferenced                 = 0;
+
+            // average cache miss ratio: transformed vertices / triangle count; best case 0.5, worst case 3.0
+            double                                      ACMR( ) const                   { return ( Triangles > 0 ) ? ( (double)VerticesTransformed / (double)Triangles ) : ( 0.0 ); }
+            // average transformed vertex ratio: transformed vertices / vertex count; best case 1.0
+            double                                      ATVR( ) const                   { return ( Vertices > 0 ) ? ( (double)VerticesTransformed / (double)Vertices ) : ( 0.0 ); }
+            // fetched bytes / referenced vertex bytes; best case 1.0
+            double                                      Overfetch( ) const              { return ( BytesReferenced > 0 ) ? ( (double)BytesFetched / (double)BytesReferenced ) : ( 0.0 ); }
+
+            Statistics &                                operator += ( const Statistics & other );
+        };
+
+        struct Stats
+        {
+            int                                         MeshCount                       = 0;
+            int                                         LODCount                        = 0;        // all LOD parts, including LOD0s
+            Statistics                                  Before;
+            Statistics                                  After;
+            double                                      ElapsedTime                     = 0.0;      // in seconds, not including Analyze
+
+            double                                      TrianglesPerSecond( ) const     { return ( ElapsedTime > 0.0 ) ? ( (double)Before.Triangles / ElapsedTime ) : ( 0.0 ); }
+            string                                      ToString( ) const;
+        };
+
+    public:
+        static Statistics                               Analyze( const Mesh & mesh );
+
+        // Single mesh, on the calling thread
+        static Stats                                    Optimize( Mesh & mesh, const Settings & settings );
+
+        // One task per mesh on 'executor' (vaTF::Executor( ) if nullptr); same rules as vaRenderMeshLODBuilder::Build
+        static Stats                                    Optimize( std::vector<Mesh> & meshes, const Settings & settings, tf::Executor * executor = nullptr );
+
+        // Copies renderMesh data, including existing LODs, into outMesh (use vaRenderMeshLODBuilder::Apply to put it back)
+        static void                                     Extract( const vaRenderMesh & renderMesh, Mesh & outMesh );
+
+        // Extract, Optimize and Apply for a batch of render meshes (same render thread requirements as vaRenderMesh::RebuildLODs)
+        static Stats                                    Optimize( const std::vector<shared_ptr<vaRenderMesh>> & renderMeshes, const Settings & settings, tf::Executor * executor = nullptr );
+    };
+}
@@ -576,10 +576,7 @@ shared_ptr<vaCubeShadowmap> vaShadowmap::CreatePoint( vaRenderDevice & device, v
 
 void vaCubeShadowmap::SetToRenderSelectionFilter( vaRenderInstanceList::FilterSettings & filter ) const
 {
-    filter;
-    // make a frustum cube based on
-    // Position
-    // ClipFar
+    filter = vaRenderInstanceList::FilterSettings::CubeCull( m_lightCenter, m_lightRange );
 }
 
 vaDrawResultFlags vaCubeShadowmap::Draw( vaRenderDeviceContext & renderContext, vaRenderInstanceList & renderSelection )
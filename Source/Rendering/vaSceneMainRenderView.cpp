@@ -319,7 +319,7 @@ void vaSceneMainRenderView::PreRenderTick( float deltaTime )
         m_sortDepthPrepass  = m_selectionOpaque.ScheduleSort(       vaRenderInstanceList::SortSettings::Standard( *m_camera, true/*, false*/ ) );
 
     // if( sceneRenderer->GeneralSettings( ).SortOpaque ) <- we now always sort opaque due to decals, sorry
-        m_sortOpaque        = m_selectionOpaque.ScheduleSort(       vaRenderInstanceList::SortSettings::Standard( *m_camera, false/*, true*/ ) );
+        m_sortOpaque        = m_selectionOpaque.ScheduleSort(       vaRenderInstanceList::SortSettings::Standard( *m_camera, false, sceneRenderer->GeneralSettings( ).DepthPrepass/*, true*/ ) );
 
     m_sortTransparent   = m_selectionTransparent.ScheduleSort(  vaRenderInstanceList::SortSettings::Standard( *m_camera, false/*, false*/ ) );
 
@@ -329,10 +329,16 @@ void vaSceneMainRenderView::PreRenderTick( float deltaTime )
     // after this, ProcessInstanceBatch will get called and then, after all is processed, PreRenderTickParallelFinished gets called
 }
 
+bool vaSceneMainRenderView::GetInstanceBatchFilter( vaRenderInstanceList::FilterSettings & outFilter )
+{
+    outFilter = vaRenderInstanceList::FilterSettings::FrustumCull( *m_camera );
+    return true;
+}
+
 // this gets called from worker threads to provide chunks for processing!
-void vaSceneMainRenderView::ProcessInstanceBatch( vaScene & scene, vaSceneRenderInstanceProcessor::SceneItem * items, uint32 itemCount, uint32 baseInstanceIndex )
+void vaSceneMainRenderView::ProcessInstanceBatch( vaScene & scene, vaSceneRenderInstanceProcessor::SceneItem * items, const uint32 * visibleIndices, uint32 visibleCount, uint32 baseInstanceIndex )
 {
-    vaSceneRenderViewBase::ProcessInstanceBatchCommon( scene.Registry(), items, itemCount,  &m_selectionOpaque, &m_selectionTransparent, vaRenderInstanceList::FilterSettings::FrustumCull( *m_camera ), m_selectionFilter, baseInstanceIndex );
+    vaSceneRenderViewBase::ProcessInstanceBatchCommon( scene.Registry(), items, visibleIndices, visibleCount, &m_selectionOpaque, &m_selectionTransparent, m_selectionFilter, baseInstanceIndex );
 }
 
 vaDrawResultFlags vaSceneMainRenderView::PreRenderTickParallelFinished( )
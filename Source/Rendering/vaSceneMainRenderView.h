@@ -194,7 +194,8 @@ namespace Vanilla
         virtual void                        RenderTick( float deltaTime, vaRenderDeviceContext & renderContext, vaDrawResultFlags & currentDrawResults ) override;
 
         // this gets called from worker threads to provide chunks for processing!
-        virtual void                        ProcessInstanceBatch( vaScene & scene, vaSceneRenderInstanceProcessor::SceneItem * items, uint32 itemCount, uint32 baseInstanceIndex ) override;
+        virtual bool                        GetInstanceBatchFilter( vaRenderInstanceList::FilterSettings & outFilter ) override;
+        virtual void                        ProcessInstanceBatch( vaScene & scene, vaSceneRenderInstanceProcessor::SceneItem * items, const uint32 * visibleIndices, uint32 visibleCount, uint32 baseInstanceIndex ) override;
 
         virtual bool                        RequiresRaytracing( ) const override;
     };
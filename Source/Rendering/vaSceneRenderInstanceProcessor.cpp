@@ -94,6 +94,9 @@ void vaSceneRenderInstanceProcessor::SelectionProc( MainWorkNode & workNode, uin
     vaSceneRenderInstanceProcessor::SceneItem localList[c_ConcurrentChuckMaxItemCount];
     int localCount = 0;
 
+    // SoA copy of WorldBounds for the items in localList (same order), used by all views for batched frustum culling
+    vaCullingBoundsStorage<c_ConcurrentChuckMaxItemCount> localBounds;
+
     entt::registry & registry = workNode.Scene.Registry();
     entt::basic_view< entt::entity, entt::exclude_t<>, const Scene::WorldBounds> & registryView = workNode.BoundsView;
     const auto & cregistry = std::as_const( registry ); 
@@ -178,6 +181,7 @@ void vaSceneRenderInstanceProcessor::SelectionProc( MainWorkNode & workNode, uin
                 showAsSelected      |= renderMaterial->GetUIShowSelectedAppTickIndex( ) >= workNode.ApplicationTickIndex;
 
                 localList[localCount++] = { entity, renderMesh, renderMaterial,  dist, meshLOD, false, isDecal, showAsSelected };
+                localBounds.Append( worldBounds.BS, worldBounds.AABB );
             }
         }
     }
@@ -188,7 +192,7 @@ void vaSceneRenderInstanceProcessor::SelectionProc( MainWorkNode & workNode, uin
     uint32 baseInstanceIndex = workNode.InstanceCounter.fetch_add( localCount );
     assert( baseInstanceIndex < workNode.MaxInstances );
 
-    m_sceneRenderer.ProcessInstanceBatch( localList, localCount, baseInstanceIndex );
+    m_sceneRenderer.ProcessInstanceBatch( localList, localCount, localBounds.SoA( ), baseInstanceIndex );
 
     for( int i = 0; i < localCount; i++ )
     {
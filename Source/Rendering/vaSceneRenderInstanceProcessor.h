@@ -18,6 +18,8 @@
 
 #include "Rendering/vaRendering.h"
 
+#include "Rendering/vaFrustumCulling.h"
+
 namespace Vanilla
 {
     class vaRenderMesh;
@@ -43,20 +43,19 @@
 
 using namespace Vanilla;
 
-void vaSceneRenderViewBase::ProcessInstanceBatchCommon( entt::registry & registry, vaSceneRenderInstanceProcessor::SceneItem * items, uint32 itemCount, vaRenderInstanceList * opaqueList, vaRenderInstanceList * transparentList, const vaRenderInstanceList::FilterSettings & filter, const vaSceneSelectionFilterType & customFilter, uint32 baseInstanceIndex )
+void vaSceneRenderViewBase::ProcessInstanceBatchCommon( entt::registry & registry, vaSceneRenderInstanceProcessor::SceneItem * items, const uint32 * visibleIndices, uint32 visibleCount, vaRenderInstanceList * opaqueList, vaRenderInstanceList * transparentList, const vaSceneSelectionFilterType & customFilter, uint32 baseInstanceIndex )
 {
     baseInstanceIndex;
 
-    if( itemCount == 0 )
+    if( visibleCount == 0 )
         return;
 
     const auto & cregistry = std::as_const( registry );
 
-    const vaPlane* frustumPlanes = filter.FrustumPlanes.data( );
-    const int       frustumPlaneCount = (int)filter.FrustumPlanes.size( );
-
-    for( uint32 i = 0; i < itemCount; i++ )
+    // frustum culling was already done for all views at once in vaSceneRenderer::ProcessInstanceBatch
+    for( uint32 visibleIndex = 0; visibleIndex < visibleCount; visibleIndex++ )
     {
+        const uint32 i = visibleIndices[visibleIndex];
         entt::entity entity = items[i].Entity;
 
         if( !cregistry.valid(entity) || !cregistry.any_of<Scene::WorldBounds>(entity) )
@@ -70,13 +69,6 @@ void vaSceneRenderViewBase::ProcessInstanceBatchCommon( entt::registry & registr
         vaFramePtr<vaRenderMesh> & renderMesh           = items[i].Mesh;
         vaFramePtr<vaRenderMaterial> & renderMaterial   = items[i].Material;
 
-        // todo - do this: http://bitsquid.blogspot.com/2016/10/the-implementation-of-frustum-culling.html
-
-        // if it doesn't pass the frustum test, cull it here
-        //if( worldBounds.AABB.IntersectFrustum( frustumPlanes, frustumPlaneCount ) == vaIntersectType::Outside )
-        if( worldBounds.BS.IntersectFrustum( frustumPlanes, frustumPlaneCount ) == vaIntersectType::Outside )
-            continue;
-
         const Scene::TransformWorld & worldTransform = cregistry.get<Scene::TransformWorld>( entity );
 
         int baseShadingRate = 0;
@@ -144,13 +136,22 @@ void vaPointShadowRV::PreRenderTick( float deltaTime )
     // after this, ProcessInstanceBatch will get called and then, after all is processed, PreRenderTickParallelFinished gets called
 }
 
+bool vaPointShadowRV::GetInstanceBatchFilter( vaRenderInstanceList::FilterSettings & outFilter )
+{
+    if( m_shadowmap == nullptr )
+        return false;
+
+    outFilter = vaRenderInstanceList::FilterSettings::ShadowmapCull( *m_shadowmap );
+    return true;
+}
+
 // this gets called from worker threads to provide chunks for processing!
-void vaPointShadowRV::ProcessInstanceBatch( vaScene& scene, vaSceneRenderInstanceProcessor::SceneItem* items, uint32 itemCount, uint32 baseInstanceIndex )
+void vaPointShadowRV::ProcessInstanceBatch( vaScene& scene, vaSceneRenderInstanceProcessor::SceneItem* items, const uint32 * visibleIndices, uint32 visibleCount, uint32 baseInstanceIndex )
 {
     if( m_shadowmap == nullptr )
         return;
 
-    vaSceneRenderViewBase::ProcessInstanceBatchCommon( scene.Registry( ), items, itemCount, &m_selectionOpaque, nullptr, vaRenderInstanceList::FilterSettings::ShadowmapCull( *m_shadowmap ), m_selectionFilter, baseInstanceIndex );
+    vaSceneRenderViewBase::ProcessInstanceBatchCommon( scene.Registry( ), items, visibleIndices, visibleCount, &m_selectionOpaque, nullptr, m_selectionFilter, baseInstanceIndex );
 }
 
 vaDrawResultFlags vaPointShadowRV::PreRenderTickParallelFinished( )
@@ -237,7 +238,7 @@ void vaLightProbeRV::PreRenderTick( float deltaTime )
             m_sortDepthPrepass = m_selectionOpaque.ScheduleSort( vaRenderInstanceList::SortSettings::Standard( probePos, true/*, false*/ ) );
 
         //if( sceneRenderer->GeneralSettings( ).SortOpaque ) <- we now always sort opaque due to decals, sorry
-            m_sortOpaque = m_selectionOpaque.ScheduleSort( vaRenderInstanceList::SortSettings::Standard( probePos, false/*, true*/ ) );
+            m_sortOpaque = m_selectionOpaque.ScheduleSort( vaRenderInstanceList::SortSettings::Standard( probePos, false, sceneRenderer->GeneralSettings( ).DepthPrepass/*, true*/ ) );
 
         m_sortTransparent = m_selectionTransparent.ScheduleSort( vaRenderInstanceList::SortSettings::Standard( probePos, false/*, false*/ ) );
 
@@ -254,15 +255,24 @@ void vaLightProbeRV::PreRenderTick( float deltaTime )
     }
 }
 
+bool vaLightProbeRV::GetInstanceBatchFilter( vaRenderInstanceList::FilterSettings & outFilter )
+{
+    if( m_probe == nullptr || !m_probeData.Enabled || m_probeData.ImportFilePath != "" )
+        return false;
+
+    outFilter = vaRenderInstanceList::FilterSettings::EnvironmentProbeCull( m_probeData );
+    return true;
+}
+
 // this gets called from worker threads to provide chunks for processing!
-void vaLightProbeRV::ProcessInstanceBatch( vaScene & scene, vaSceneRenderInstanceProcessor::SceneItem * items, uint32 itemCount, uint32 baseInstanceIndex )
+void vaLightProbeRV::ProcessInstanceBatch( vaScene & scene, vaSceneRenderInstanceProcessor::SceneItem * items, const uint32 * visibleIndices, uint32 visibleCount, uint32 baseInstanceIndex )
 {
     if( m_probe == nullptr || !m_probeData.Enabled )    // all good, nothing to do
         return;
 
     if( m_probeData.ImportFilePath == "" )
     {
-        vaSceneRenderViewBase::ProcessInstanceBatchCommon( scene.Registry( ), items, itemCount, &m_selectionOpaque, &m_selectionTransparent, vaRenderInstanceList::FilterSettings::EnvironmentProbeCull( m_probeData ), m_selectionFilter, baseInstanceIndex );
+        vaSceneRenderViewBase::ProcessInstanceBatchCommon( scene.Registry( ), items, visibleIndices, visibleCount, &m_selectionOpaque, &m_selectionTransparent, m_selectionFilter, baseInstanceIndex );
     }
 }
 
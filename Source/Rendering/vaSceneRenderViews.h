@@ -74,12 +74,16 @@ namespace Vanilla
 
         // this gets called from worker threads to provide chunks for processing!
         virtual void                    PrepareInstanceBatchProcessing( const shared_ptr<vaRenderInstanceStorage> & instanceStorage )                                                   { instanceStorage; }
-        virtual void                    ProcessInstanceBatch( vaScene & scene, vaSceneRenderInstanceProcessor::SceneItem * sceneItems, uint32 itemCount, uint32 baseInstanceIndex )     { scene; sceneItems; itemCount; assert( false ); baseInstanceIndex; }
+        // return false if the view takes no instances this frame; otherwise outFilter is used for the view's culling in the shared, 
+        // multi-view, selection pass (see vaSceneRenderer::ProcessInstanceBatch) - called once per frame after PreRenderTick
+        virtual bool                    GetInstanceBatchFilter( vaRenderInstanceList::FilterSettings & outFilter )                                                                      { outFilter; return false; }
+        // sceneItems[visibleIndices[0..visibleCount)] are the items that passed this view's culling
+        virtual void                    ProcessInstanceBatch( vaScene & scene, vaSceneRenderInstanceProcessor::SceneItem * sceneItems, const uint32 * visibleIndices, uint32 visibleCount, uint32 baseInstanceIndex )     { scene; sceneItems; visibleIndices; visibleCount; assert( false ); baseInstanceIndex; }
 
         virtual bool                    RequiresRaytracing( ) const                                                                 { return false; }
 
     protected:
-        static void                     ProcessInstanceBatchCommon( entt::registry & registry, vaSceneRenderInstanceProcessor::SceneItem * items, uint32 itemCount, vaRenderInstanceList * opaqueList, vaRenderInstanceList * transparentList, const vaRenderInstanceList::FilterSettings & filter, const vaSceneSelectionFilterType & customFilter, uint32 baseInstanceIndex );
+        static void                     ProcessInstanceBatchCommon( entt::registry & registry, vaSceneRenderInstanceProcessor::SceneItem * items, const uint32 * visibleIndices, uint32 visibleCount, vaRenderInstanceList * opaqueList, vaRenderInstanceList * transparentList, const vaSceneSelectionFilterType & customFilter, uint32 baseInstanceIndex );
     };
 
     class vaPointShadowRV : public vaSceneRenderViewBase
@@ -104,7 +108,8 @@ namespace Vanilla
         virtual void                        RenderTick( float deltaTime, vaRenderDeviceContext & renderContext, vaDrawResultFlags & currentDrawResults ) override;
 
         // this gets called from worker threads to provide chunks for processing!
-        virtual void                        ProcessInstanceBatch( vaScene & scene, vaSceneRenderInstanceProcessor::SceneItem * items, uint32 itemCount, uint32 baseInstanceIndex ) override;
+        virtual bool                        GetInstanceBatchFilter( vaRenderInstanceList::FilterSettings & outFilter ) override;
+        virtual void                        ProcessInstanceBatch( vaScene & scene, vaSceneRenderInstanceProcessor::SceneItem * items, const uint32 * visibleIndices, uint32 visibleCount, uint32 baseInstanceIndex ) override;
     };
 
     class vaLightProbeRV : public vaSceneRenderViewBase
@@ -133,7 +138,8 @@ namespace Vanilla
         virtual void                        RenderTick( float deltaTime, vaRenderDeviceContext & renderContext, vaDrawResultFlags & currentDrawResults ) override;
 
         // this gets called from worker threads to provide chunks for processing!
-        virtual void                        ProcessInstanceBatch( vaScene & scene, vaSceneRenderInstanceProcessor::SceneItem * items, uint32 itemCount, uint32 baseInstanceIndex ) override;
+        virtual bool                        GetInstanceBatchFilter( vaRenderInstanceList::FilterSettings & outFilter ) override;
+        virtual void                        ProcessInstanceBatch( vaScene & scene, vaSceneRenderInstanceProcessor::SceneItem * items, const uint32 * visibleIndices, uint32 visibleCount, uint32 baseInstanceIndex ) override;
     };
 
 }
@@ -256,25 +256,43 @@ void vaSceneRenderer::PrepareInstanceBatchProcessing( uint32 maxInstances )
     assert( m_scene != nullptr );
     if( m_raytracer != nullptr )
         m_raytracer->PrepareInstanceBatchProcessing( m_instanceStorage );
+
+    m_batchViews.clear( );
+    m_batchCullingViews.Clear( );
     for( int i = 0; i < (int)m_allViews.size( ); i++ )
     {
         auto view = m_allViews[i].lock( );
-        if( view != nullptr )
-            view->PrepareInstanceBatchProcessing( m_instanceStorage );
+        if( view == nullptr )
+            continue;
+        view->PrepareInstanceBatchProcessing( m_instanceStorage );
+
+        vaRenderInstanceList::FilterSettings filter;
+        if( view->GetInstanceBatchFilter( filter ) && m_batchCullingViews.AddView( filter.FrustumPlanes.data( ), (int)filter.FrustumPlanes.size( ) ) != -1 )
+            m_batchViews.push_back( view );
     }
 }
 
-void vaSceneRenderer::ProcessInstanceBatch( vaSceneRenderInstanceProcessor::SceneItem * items, uint32 itemCount, uint32 baseInstanceIndex )
+void vaSceneRenderer::ProcessInstanceBatch( vaSceneRenderInstanceProcessor::SceneItem * items, uint32 itemCount, const vaCullingBoundsSoA & itemBounds, uint32 baseInstanceIndex )
 {
     VA_TRACE_CPU_SCOPE( ProcessInstanceBatch );
     assert( m_scene != nullptr );
     if( m_raytracer != nullptr )
         m_raytracer->ProcessInstanceBatch( *m_scene, items, itemCount, baseInstanceIndex );
-    for( int i = 0; i < (int)m_allViews.size( ); i++ )
+
+    if( m_batchViews.size( ) == 0 )
+        return;
+
+    // read the batch's bounds once for all views, then scatter into each view
+    assert( itemBounds.Count == itemCount && itemCount <= vaSceneRenderInstanceProcessor::c_ConcurrentChuckMaxItemCount );
+    uint64 viewMasks[vaSceneRenderInstanceProcessor::c_ConcurrentChuckMaxItemCount];
+    vaFrustumCulling::CullMultiView( itemBounds, m_batchCullingViews, true, viewMasks );
+
+    uint32 visibleIndices[vaSceneRenderInstanceProcessor::c_ConcurrentChuckMaxItemCount];
+    for( int i = 0; i < (int)m_batchViews.size( ); i++ )
     {
-        auto view = m_allViews[i].lock( );
-        if( view != nullptr )
-            view->ProcessInstanceBatch( *m_scene, items, itemCount, baseInstanceIndex );
+        const uint32 visibleCount = vaFrustumCulling::ExtractVisible( viewMasks, itemCount, i, visibleIndices );
+        if( visibleCount > 0 )
+            m_batchViews[i]->ProcessInstanceBatch( *m_scene, items, visibleIndices, visibleCount, baseInstanceIndex );
     }
 }
 
@@ -297,6 +315,7 @@ vaDrawResultFlags vaSceneRenderer::RenderTick( float deltaTime, int64 applicatio
     m_scene->Async().WaitAsyncComplete( "renderlists_done_marker" );
 
     m_sceneTickDrawResults |= m_instanceProcessor.ResultFlags();
+    m_batchViews.clear( );
 
     for( int i = 0; i < (int)m_allViews.size( ); i++ )
     {
@@ -53,6 +53,12 @@ namespace Vanilla
 
         shared_ptr<vaSceneRaytracing>           m_raytracer;
 
+        // views taking instances in the current frame's selection and their culling planes (same order); set up in 
+        // PrepareInstanceBatchProcessing, used from worker threads in ProcessInstanceBatch
+        std::vector< shared_ptr< vaSceneRenderViewBase > >
+                                                m_batchViews;
+        vaCullingViewSet                        m_batchCullingViews;
+
 
 //        // this means there's no pending updates to shadows or IBLs - mostly needed for image comparisons / EnforceDeterminism option
 //        bool                                m_shadowsStable     = false;
@@ -141,7 +147,8 @@ namespace Vanilla
         friend class vaSceneRenderInstanceProcessor;
         // this gets called from worker threads to provide chunks for processing! First one call to PreProcessInstanceBatch to prepare receiving buffers (if any) and then ProcessInstanceBatch per batch
         void                                PrepareInstanceBatchProcessing( uint32 maxInstances );
-        void                                ProcessInstanceBatch( vaSceneRenderInstanceProcessor::SceneItem * items, uint32 itemCount, uint32 baseInstanceIndex );
+        // All views are culled in one pass (vaFrustumCulling::CullMultiView) and each gets its visible subset of the batch
+        void                                ProcessInstanceBatch( vaSceneRenderInstanceProcessor::SceneItem * items, uint32 itemCount, const vaCullingBoundsSoA & itemBounds, uint32 baseInstanceIndex );
 
     protected:
         virtual void                        UIPanelTick( vaApplicationBase & application ) override;
@@ -13,6 +13,7 @@
 #include "Rendering/vaRenderDevice.h"
 
 #include "Core/System/vaFileTools.h"
+#include "Core/System/vaFileStream.h"
 
 using namespace Vanilla;
 
@@ -212,6 +213,11 @@ void vaShader::ReloadAll( )
 
     {
         std::unique_lock<mutex> shaderListLock( GetAllShaderListMutex( ) );
+
+        // shader files were probably edited - cache has to look at their contents again
+        if( GetAllShaderList( ).size( ) > 0 && GetAllShaderList( )[0]->GetRenderDevice( ).GetShaderManager( ).GetCache( ) != nullptr )
+            GetAllShaderList( )[0]->GetRenderDevice( ).GetShaderManager( ).GetCache( )->ResetDependencyHashes( );
+
 #ifndef VA_SHADER_BACKGROUND_COMPILATION_ENABLE
         int totalLoaded = (int)GetAllShaderList( ).size( );
         int totalLoadedFromCache = 0;
@@ -294,6 +300,391 @@ vaShaderManager::~vaShaderManager( )
 #endif
 }
 
+string vaShaderCacheKey::ToString( ) const
+{
+    return vaStringTools::Format( "%016llx%016llx", (unsigned long long)Value[0], (unsigned long long)Value[1] );
+}
+
+namespace
+{
+    const int32         c_shaderCacheIndexVersion   = 1;
+    const uint32        c_shaderCacheIndexEOF       = 0xFEEEFEEE;
+}
+
+vaShaderCache::vaShaderCache( const wstring & directory, const DependencyHashFunction & dependencyHash, uint64 sizeLimit )
+    : m_directory( ( directory.size( ) > 0 && directory.back( ) != L'\\' && directory.back( ) != L'/' ) ? ( directory + L"\\" ) : ( directory ) ),
+    m_sizeLimit( sizeLimit ), m_dependencyHash( dependencyHash )
+{
+    assert( m_directory != L"" && m_dependencyHash );
+    vaFileTools::EnsureDirectoryExists( m_directory );
+}
+
+vaShaderCache::~vaShaderCache( )
+{
+    if( m_indexDirty )
+        SaveIndex( );
+}
+
+bool vaShaderCache::LoadIndex( )
+{
+    VA_TRACE_CPU_SCOPE( ShaderCacheLoadIndex );
+    std::unique_lock<mutex> lock( m_mutex );
+
+    m_keys.clear( );
+    m_blobs.clear( );
+    m_totalSize     = 0;
+    m_useCounter    = 0;
+    m_indexDirty    = false;
+
+    bool loaded = false;
+    vaFileStream inFile;
+    if( vaFileTools::FileExists( IndexPath( ) ) && inFile.Open( IndexPath( ), FileCreationMode::Open, FileAccessMode::Read ) )
+    {
+        auto readIndex = [&]( ) -> bool
+        {
+            int32 version = -1;
+            if( !inFile.ReadValue<int32>( version ) || version != c_shaderCacheIndexVersion )
+                return false;
+            int32 blobCount = 0;
+            if( !inFile.ReadValue<uint64>( m_useCounter ) || !inFile.ReadValue<int32>( blobCount ) || blobCount < 0 )
+                return false;
+            m_blobs.reserve( blobCount );
+            for( int32 i = 0; i < blobCount; i++ )
+            {
+                vaShaderCacheKey blobKey; BlobEntry blob;
+                if( !inFile.ReadValue<uint64>( blobKey.Value[0] ) || !inFile.ReadValue<uint64>( blobKey.Value[1] ) || !inFile.ReadValue<uint64>( blob.Size )
+                    || !inFile.ReadValue<uint64>( blob.DataHash ) || !inFile.ReadValue<uint64>( blob.LastUse ) )
+                    return false;
+                m_totalSize += blob.Size;
+                m_blobs.insert( std::make_pair( blobKey, blob ) );
+            }
+            int32 pathCount = 0;
+            if( !inFile.ReadValue<int32>( pathCount ) || pathCount < 0 )
+                return false;
+            std::vector<wstring> paths( pathCount );
+            for( wstring & path : paths )
+                if( !inFile.ReadString( path ) )
+                    return false;
+            int32 keyCount = 0;
+            if( !inFile.ReadValue<int32>( keyCount ) || keyCount < 0 )
+                return false;
+            m_keys.reserve( keyCount );
+            for( int32 i = 0; i < keyCount; i++ )
+            {
+                vaShaderCacheKey key; KeyEntry entry; int32 dependencyCount = 0;
+                if( !inFile.ReadValue<uint64>( key.Value[0] ) || !inFile.ReadValue<uint64>( key.Value[1] ) || !inFile.ReadValue<uint64>( entry.BlobKey.Value[0] )
+                    || !inFile.ReadValue<uint64>( entry.BlobKey.Value[1] ) || !inFile.ReadValue<int32>( dependencyCount ) || dependencyCount < 0 )
+                    return false;
+                entry.Dependencies.resize( dependencyCount );
+                for( Dependency & dependency : entry.Dependencies )
+                {
+                    int32 pathIndex = -1;
+                    if( !inFile.ReadValue<int32>( pathIndex ) || pathIndex < 0 || pathIndex >= pathCount || !inFile.ReadValue<uint64>( dependency.ContentHash ) )
+                        return false;
+                    dependency.FilePath = paths[pathIndex];
+                }
+                m_keys.insert( std::make_pair( key, std::move( entry ) ) );
+            }
+            uint32 terminator = 0;
+            return inFile.ReadValue<uint32>( terminator ) && terminator == c_shaderCacheIndexEOF;
+        };
+        loaded = readIndex( );
+        inFile.Close( );
+        if( !loaded )
+        {
+            VA_WARN( L"Error while reading shader cache index '%s', starting from scratch!", IndexPath( ).c_str( ) );
+            m_keys.clear( );
+            m_blobs.clear( );
+            m_totalSize     = 0;
+            m_useCounter    = 0;
+        }
+    }
+
+    // blobs that never made it into the index (crash, damaged index) would otherwise just take space forever
+    for( const wstring & filePath : vaFileTools::FindFiles( m_directory, L"*.blob", false ) )
+    {
+        wstring fileName;
+        vaFileTools::SplitPath( filePath, nullptr, &fileName, nullptr );
+        vaShaderCacheKey blobKey;
+        if( fileName.size( ) != 32 || swscanf_s( fileName.c_str( ), L"%16llx%16llx", &blobKey.Value[0], &blobKey.Value[1] ) != 2 || m_blobs.find( blobKey ) == m_blobs.end( ) )
+            vaFileTools::DeleteFile( filePath );
+    }
+    return loaded;
+}
+
+bool vaShaderCache::SaveIndex( )
+{
+    VA_TRACE_CPU_SCOPE( ShaderCacheSaveIndex );
+    std::unique_lock<mutex> lock( m_mutex );
+
+    // written next to the old one and then swapped in, so a crash while saving can't damage it
+    const wstring tempPath = IndexPath( ) + L".tmp";
+    vaFileStream outFile;
+    if( !outFile.Open( tempPath, FileCreationMode::Create, FileAccessMode::Write ) )
+    {
+        VA_WARN( L"Unable to write shader cache index '%s'", tempPath.c_str( ) );
+        return false;
+    }
+
+    outFile.WriteValue<int32>( c_shaderCacheIndexVersion );
+    outFile.WriteValue<uint64>( m_useCounter );
+    outFile.WriteValue<int32>( (int32)m_blobs.size( ) );
+    for( const auto & it : m_blobs )
+    {
+        outFile.WriteValue<uint64>( it.first.Value[0] );
+        outFile.WriteValue<uint64>( it.first.Value[1] );
+        outFile.WriteValue<uint64>( it.second.Size );
+        outFile.WriteValue<uint64>( it.second.DataHash );
+        outFile.WriteValue<uint64>( it.second.LastUse );
+    }
+    // keys whose blob got evicted don't need to be remembered; dependency paths are mostly the same few headers so they're
+    // stored once, in a table
+    int32 keyCount = 0;
+    std::unordered_map<wstring, int32> pathIndices;
+    std::vector<const wstring *> paths;
+    for( const auto & it : m_keys )
+    {
+        if( m_blobs.find( it.second.BlobKey ) == m_blobs.end( ) )
+            continue;
+        keyCount++;
+        for( const Dependency & dependency : it.second.Dependencies )
+            if( pathIndices.insert( std::make_pair( dependency.FilePath, (int32)paths.size( ) ) ).second )
+                paths.push_back( &dependency.FilePath );
+    }
+    outFile.WriteValue<int32>( (int32)paths.size( ) );
+    for( const wstring * path : paths )
+        outFile.WriteString( *path );
+    outFile.WriteValue<int32>( keyCount );
+    for( const auto & it : m_keys )
+    {
+        if( m_blobs.find( it.second.BlobKey ) == m_blobs.end( ) )
+            continue;
+        outFile.WriteValue<uint64>( it.first.Value[0] );
+        outFile.WriteValue<uint64>( it.first.Value[1] );
+        outFile.WriteValue<uint64>( it.second.BlobKey.Value[0] );
+        outFile.WriteValue<uint64>( it.second.BlobKey.Value[1] );
+        outFile.WriteValue<int32>( (int32)it.second.Dependencies.size( ) );
+        for( const Dependency & dependency : it.second.Dependencies )
+        {
+            outFile.WriteValue<int32>( pathIndices[dependency.FilePath] );
+            outFile.WriteValue<uint64>( dependency.ContentHash );
+        }
+    }
+    outFile.WriteValue<uint32>( c_shaderCacheIndexEOF );
+    outFile.Close( );
+
+    vaFileTools::DeleteFile( IndexPath( ) );
+    if( !vaFileTools::MoveFile( tempPath, IndexPath( ) ) )
+    {
+        VA_WARN( L"Unable to write shader cache index '%s'", IndexPath( ).c_str( ) );
+        return false;
+    }
+    m_indexDirty = false;
+    return true;
+}
+
+vaShaderCacheKey vaShaderCache::ComputeBlobKey( const vaShaderCacheKey & key, const std::vector<Dependency> & dependencies )
+{
+    vaShaderCacheKeyBuilder builder;
+    builder.AddKey( key );
+    builder.AddValue( (int32)dependencies.size( ) );
+    for( const Dependency & dependency : dependencies )
+    {
+        builder.AddString( dependency.FilePath );
+        builder.AddValue( dependency.ContentHash );
+    }
+    return builder.Finalize( );
+}
+
+bool vaShaderCache::CurrentContentHash( const wstring & filePath, uint64 & outContentHash )
+{
+    {
+        std::unique_lock<mutex> lock( m_dependencyHashesMutex );
+        auto it = m_dependencyHashes.find( filePath );
+        if( it != m_dependencyHashes.end( ) )
+        {
+            outContentHash = it->second;
+            return true;
+        }
+    }
+    // (outside of the lock - reading and hashing the file is the slow part; two threads doing the same file get the same result)
+    if( !m_dependencyHash( filePath, outContentHash ) )
+        return false;
+    std::unique_lock<mutex> lock( m_dependencyHashesMutex );
+    m_dependencyHashes.insert( std::make_pair( filePath, outContentHash ) );
+    return true;
+}
+
+shared_ptr<vaMemoryStream> vaShaderCache::Find( const vaShaderCacheKey & key, bool & foundButModified )
+{
+    VA_TRACE_CPU_SCOPE( ShaderCacheFind );
+    foundButModified = false;
+
+    std::vector<Dependency> dependencies;
+    vaShaderCacheKey lastBlobKey;
+    {
+        std::unique_lock<mutex> lock( m_mutex );
+        m_statistics.Lookups++;
+        auto it = m_keys.find( key );
+        if( it == m_keys.end( ) )
+            return nullptr;
+        dependencies    = it->second.Dependencies;
+        lastBlobKey     = it->second.BlobKey;
+    }
+
+    for( Dependency & dependency : dependencies )
+        if( !CurrentContentHash( dependency.FilePath, dependency.ContentHash ) )
+        {
+            VA_WARN( L"Error trying to find shader file '%s'!", dependency.FilePath.c_str( ) );
+            std::unique_lock<mutex> lock( m_mutex );
+            m_statistics.Modified++;
+            foundButModified = true;
+            return nullptr;
+        }
+    const vaShaderCacheKey blobKey = ComputeBlobKey( key, dependencies );
+
+    BlobEntry blob;
+    {
+        std::unique_lock<mutex> lock( m_mutex );
+        auto it = m_blobs.find( blobKey );
+        if( it == m_blobs.end( ) )
+        {
+            // same dependency contents as last time means the blob got evicted - that's just a miss
+            foundButModified = blobKey != lastBlobKey;
+            m_statistics.Modified += ( foundButModified ) ? ( 1 ) : ( 0 );
+            return nullptr;
+        }
+        it->second.LastUse = ++m_useCounter;
+        m_indexDirty = true;
+        blob = it->second;
+        if( blobKey != lastBlobKey )
+        {
+            // dependencies went back to an earlier state
+            KeyEntry & keyEntry     = m_keys[key];
+            keyEntry.BlobKey        = blobKey;
+            keyEntry.Dependencies   = dependencies;
+        }
+    }
+
+    shared_ptr<vaMemoryStream> data = vaFileTools::LoadMemoryStream( BlobPath( blobKey ) );
+    if( data == nullptr || (uint64)data->GetLength( ) != blob.Size || vaXXHash64::Compute( data->GetBuffer( ), data->GetLength( ) ) != blob.DataHash )
+    {
+        VA_WARN( L"Shader cache file '%s' missing or damaged, removing", BlobPath( blobKey ).c_str( ) );
+        std::unique_lock<mutex> lock( m_mutex );
+        RemoveBlobInternal( blobKey );
+        return nullptr;
+    }
+
+    std::unique_lock<mutex> lock( m_mutex );
+    m_statistics.Hits++;
+    m_statistics.BlobBytesRead += data->GetLength( );
+    return data;
+}
+
+void vaShaderCache::Add( const vaShaderCacheKey & key, const void * data, size_t dataSize, const std::vector<Dependency> & dependencies )
+{
+    VA_TRACE_CPU_SCOPE( ShaderCacheAdd );
+    const vaShaderCacheKey blobKey = ComputeBlobKey( key, dependencies );
+
+    // these are the contents that were just compiled so they're the current ones
+    {
+        std::unique_lock<mutex> lock( m_dependencyHashesMutex );
+        for( const Dependency & dependency : dependencies )
+            m_dependencyHashes[dependency.FilePath] = dependency.ContentHash;
+    }
+
+    // the file is written under the lock: this only happens after a compile, which is way slower anyway, and it keeps two
+    // threads compiling the same shader from writing the same file
+    std::unique_lock<mutex> lock( m_mutex );
+    KeyEntry & keyEntry     = m_keys[key];
+    keyEntry.BlobKey        = blobKey;
+    keyEntry.Dependencies   = dependencies;
+    m_indexDirty            = true;
+
+    auto it = m_blobs.find( blobKey );
+    if( it != m_blobs.end( ) )
+    {
+        it->second.LastUse = ++m_useCounter;
+        return;
+    }
+
+    const wstring blobPath = BlobPath( blobKey );
+    const wstring tempPath = blobPath + L".tmp";
+    {
+        vaFileStream outFile;
+        if( !outFile.Open( tempPath, FileCreationMode::Create, FileAccessMode::Write ) || !outFile.Write( data, (int64)dataSize ) )
+        {
+            VA_WARN( L"Unable to write shader cache file '%s'", tempPath.c_str( ) );
+            return;
+        }
+    }
+    vaFileTools::DeleteFile( blobPath );
+    if( !vaFileTools::MoveFile( tempPath, blobPath ) )
+    {
+        VA_WARN( L"Unable to write shader cache file '%s'", blobPath.c_str( ) );
+        vaFileTools::DeleteFile( tempPath );
+        return;
+    }
+
+    BlobEntry blob;
+    blob.Size       = dataSize;
+    blob.DataHash   = vaXXHash64::Compute( data, (int64)dataSize );
+    blob.LastUse    = ++m_useCounter;
+    m_blobs.insert( std::make_pair( blobKey, blob ) );
+    m_totalSize += dataSize;
+
+    EvictInternal( );
+}
+
+void vaShaderCache::RemoveBlobInternal( const vaShaderCacheKey & blobKey )
+{
+    m_mutex.assert_locked_by_caller( );
+    auto it = m_blobs.find( blobKey );
+    if( it == m_blobs.end( ) )
+        return;
+    m_totalSize -= it->second.Size;
+    m_blobs.erase( it );
+    m_indexDirty = true;
+    vaFileTools::DeleteFile( BlobPath( blobKey ) );
+}
+
+void vaShaderCache::EvictInternal( )
+{
+    m_mutex.assert_locked_by_caller( );
+    if( m_totalSize <= m_sizeLimit )
+        return;
+
+    // evict down to 3/4 of the limit so that this doesn't happen (and sort) on every Add once the cache is full
+    std::vector<std::pair<uint64, vaShaderCacheKey>> byLastUse;
+    byLastUse.reserve( m_blobs.size( ) );
+    for( const auto & it : m_blobs )
+        byLastUse.push_back( std::make_pair( it.second.LastUse, it.first ) );
+    std::sort( byLastUse.begin( ), byLastUse.end( ) );
+    const uint64 target = m_sizeLimit / 4 * 3;
+    for( size_t i = 0; i < byLastUse.size( ) && m_totalSize > target; i++ )
+    {
+        RemoveBlobInternal( byLastUse[i].second );
+        m_statistics.Evictions++;
+    }
+}
+
+void vaShaderCache::ResetDependencyHashes( )
+{
+    std::unique_lock<mutex> lock( m_dependencyHashesMutex );
+    m_dependencyHashes.clear( );
+}
+
+void vaShaderCache::Clear( )
+{
+    std::unique_lock<mutex> lock( m_mutex );
+    for( const auto & it : m_blobs )
+        vaFileTools::DeleteFile( BlobPath( it.first ) );
+    m_blobs.clear( );
+    m_keys.clear( );
+    m_totalSize     = 0;
+    m_indexDirty    = true;
+}
+
 shared_ptr<vaVertexShader> vaVertexShader::CreateVSAndILFromFile( vaRenderDevice & renderDevice, const string & filePath, const string & entryPoint, const std::vector<vaVertexInputElementDesc> & inputLayoutElements, const vaShaderMacroContaner & macros, bool forceImmediateCompile ) 
 { 
     shared_ptr<vaVertexShader> ret = renderDevice.CreateModule<vaVertexShader>( );
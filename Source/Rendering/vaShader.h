@@ -13,6 +13,7 @@
 #include "Core/vaCoreIncludes.h"
 
 #include "Core/Misc/vaResourceFormats.h"
+#include "Core/System/vaMemoryStream.h"
 
 #include "Rendering/Shaders/vaSharedTypes.h"
 
@@ -346,6 +347,151 @@ namespace Vanilla
        static shared_ptr<vaVertexShader> CreateVSAndILFromBuffer( vaRenderDevice & renderDevice, const string & shaderCode, const string & entryPoint, const std::vector<vaVertexInputElementDesc> & inputLayoutElements, const vaShaderMacroContaner & macros, bool forceImmediateCompile );
     };
 
+    // 128-bit key made of two 64-bit xxhash-es (different seeds) over everything that goes into a shader compile; platform
+    // neutral and cheap to compare and hash, also used (as hex) for shader cache file names
+    struct vaShaderCacheKey
+    {
+        uint64                          Value[2]    = { 0, 0 };
+
+        bool                            operator == ( const vaShaderCacheKey & other ) const    { return Value[0] == other.Value[0] && Value[1] == other.Value[1]; }
+        bool                            operator != ( const vaShaderCacheKey & other ) const    { return !( *this == other ); }
+        bool                            operator <  ( const vaShaderCacheKey & other ) const    { return ( Value[0] != other.Value[0] ) ? ( Value[0] < other.Value[0] ) : ( Value[1] < other.Value[1] ); }
+
+        // for std::unordered_map - the first half already is a good hash
+        std::size_t                     operator () ( const vaShaderCacheKey & key ) const      { return (std::size_t)key.Value[0]; }
+
+        // 32 hex digits
+        string                          ToString( ) const;
+    };
+
+    // Strings are added length-prefixed so "ab"+"c" and "a"+"bc" give different keys
+    class vaShaderCacheKeyBuilder
+    {
+        vaXXHash64                      m_hashA;
+        vaXXHash64                      m_hashB;
+
+    public:
+        vaShaderCacheKeyBuilder( ) : m_hashA( 0x9E3779B97F4A7C15ull ), m_hashB( 0xC2B2AE3D27D4EB4Full ) { }
+
+        void                            AddString( const string & str )                     { m_hashA.AddString( str ); m_hashB.AddString( str ); }
+        void                            AddString( const wstring & str )                    { m_hashA.AddString( str ); m_hashB.AddString( str ); }
+        template< class ValueType >
+        void                            AddValue( ValueType val )                           { m_hashA.AddValue( val ); m_hashB.AddValue( val ); }
+        void                            AddKey( const vaShaderCacheKey & key )              { AddValue( key.Value[0] ); AddValue( key.Value[1] ); }
+        void                            AddMacros( const vaShaderMacroContaner & macros )
+        {
+            AddValue( (int32)macros.size( ) );
+            for( const auto & macro : macros )
+            {
+                AddString( macro.first );
+                AddString( macro.second );
+            }
+        }
+
+        vaShaderCacheKey                Finalize( ) const                                   { vaShaderCacheKey ret; ret.Value[0] = m_hashA.Digest( ); ret.Value[1] = m_hashB.Digest( ); return ret; }
+    };
+
+    // Platform-neutral persistent storage for compiled shaders: a directory with one file per compiled shader ("blob") and an
+    // index file, which is the only thing read at startup - blobs are read on lookup.
+    //  * lookups are by a vaShaderCacheKey over the compile inputs (shader file, entry point, shader model, macros, ...)
+    //  * blobs are content addressed: their key (and file name) also covers all dependencies (the shader file and everything
+    //    it includes) with hashes of their contents; a lookup hashes the current contents of the dependencies last seen for
+    //    the key and hits if there's a blob for exactly that - also after a change was reverted
+    //  * dependency contents are hashed once per file and remembered until ResetDependencyHashes (shader reload)
+    //  * least recently used blobs get deleted once the total size goes over the limit
+    // Thread safe.
+    class vaShaderCache
+    {
+    public:
+        struct Dependency
+        {
+            wstring                     FilePath;
+            uint64                      ContentHash     = 0;    // vaXXHash64 of the contents
+        };
+
+        // Returns false if the file can't be found; provided by the backend as it knows where shader files come from (search
+        // paths, embedded storage)
+        typedef std::function< bool( const wstring & filePath, uint64 & outContentHash ) >   DependencyHashFunction;
+
+        struct Statistics
+        {
+            int64                       Lookups         = 0;
+            int64                       Hits            = 0;
+            int64                       Modified        = 0;    // key known but dependencies changed since
+            int64                       Evictions       = 0;
+            int64                       BlobBytesRead   = 0;
+        };
+
+        static constexpr uint64         c_defaultSizeLimit  = 256ull * 1024 * 1024;
+
+    private:
+        // dependencies last seen for a key, with the blob they gave (just to tell a modified dependency from an evicted blob)
+        struct KeyEntry
+        {
+            vaShaderCacheKey            BlobKey;
+            std::vector<Dependency>     Dependencies;
+        };
+        struct BlobEntry
+        {
+            uint64                      Size            = 0;
+            uint64                      DataHash        = 0;    // catches damaged files
+            uint64                      LastUse         = 0;    // m_useCounter at the time; persistent so LRU works across runs
+        };
+
+        const wstring                   m_directory;
+        const uint64                    m_sizeLimit;
+        const DependencyHashFunction    m_dependencyHash;
+
+        mutable mutex                   m_mutex;
+        std::unordered_map<vaShaderCacheKey, KeyEntry, vaShaderCacheKey>
+                                        m_keys;
+        std::unordered_map<vaShaderCacheKey, BlobEntry, vaShaderCacheKey>
+                                        m_blobs;
+        uint64                          m_totalSize         = 0;
+        uint64                          m_useCounter        = 0;
+        bool                            m_indexDirty        = false;
+        Statistics                      m_statistics;
+
+        mutex                           m_dependencyHashesMutex;
+        std::unordered_map<wstring, uint64>
+                                        m_dependencyHashes;
+
+    public:
+        // directory gets created if needed
+        vaShaderCache( const wstring & directory, const DependencyHashFunction & dependencyHash, uint64 sizeLimit = c_defaultSizeLimit );
+        // saves the index if anything changed
+        ~vaShaderCache( );
+
+        // Reads the index (not the blobs) and deletes blob files that aren't in it; returns false and starts empty if there's
+        // no index or it's damaged or of a different version
+        bool                            LoadIndex( );
+        bool                            SaveIndex( );
+
+        // Returns nullptr if not in cache; foundButModified is set if the key is known but some dependency changed since
+        shared_ptr<vaMemoryStream>      Find( const vaShaderCacheKey & key, bool & foundButModified );
+        // The blob file is written right away; dependency hashes have to be of the contents that were compiled
+        void                            Add( const vaShaderCacheKey & key, const void * data, size_t dataSize, const std::vector<Dependency> & dependencies );
+
+        // Call when shader files might have changed (before recompiling everything)
+        void                            ResetDependencyHashes( );
+        // Removes all entries and their files
+        void                            Clear( );
+
+        const wstring &                 GetDirectory( ) const                               { return m_directory; }
+        uint64                          GetSizeLimit( ) const                               { return m_sizeLimit; }
+        uint64                          GetTotalSize( ) const                               { std::unique_lock<mutex> lock( m_mutex ); return m_totalSize; }
+        int                             GetBlobCount( ) const                               { std::unique_lock<mutex> lock( m_mutex ); return (int)m_blobs.size( ); }
+        Statistics                      GetStatistics( ) const                              { std::unique_lock<mutex> lock( m_mutex ); return m_statistics; }
+
+    private:
+        wstring                         BlobPath( const vaShaderCacheKey & blobKey ) const  { return m_directory + vaStringTools::SimpleWiden( blobKey.ToString( ) ) + L".blob"; }
+        wstring                         IndexPath( ) const                                  { return m_directory + L"index"; }
+        static vaShaderCacheKey         ComputeBlobKey( const vaShaderCacheKey & key, const std::vector<Dependency> & dependencies );
+        bool                            CurrentContentHash( const wstring & filePath, uint64 & outContentHash );
+        void                            RemoveBlobInternal( const vaShaderCacheKey & blobKey );     // m_mutex has to be locked
+        void                            EvictInternal( );                                           // m_mutex has to be locked
+    };
+
     // Singleton utility class for handling shaders
     class vaShaderManager : public vaRenderingModule
     {
@@ -368,6 +514,7 @@ namespace Vanilla
         std::deque<wstring>                                 m_searchPaths;
         Settings                                            m_settings;
         shared_ptr<vaBackgroundTaskManager::Task>           m_backgroundShaderCompilationProgressIndicator;
+        shared_ptr<vaShaderCache>                           m_cache;            // created by the backend; nullptr if persistent storage is disabled
 
     protected:
         vaShaderManager( vaRenderDevice & device );
@@ -379,6 +526,7 @@ namespace Vanilla
         virtual wstring     FindShaderFile( const wstring & fileName )                                      = 0;
 
         virtual wstring     GetCacheStoragePath( ) const                                                    = 0;
+        vaShaderCache *     GetCache( ) const                                                               { return m_cache.get( ); }
 
         Settings &          Settings( ) { return m_settings; }
     };
@@ -327,7 +327,8 @@ void vaStandardShapes::CreateDodecahedron( std::vector<vaVector3> & outVertices,
 // ------------------------------------------------------------------------------------------------
 static void TessellateSphere( std::vector<vaVector3> & outVertices, std::vector<uint32> & outIndices, const std::vector<vaVector3> & inVertices, const std::vector<uint32> & inIndices, bool shareVertices )
 {
-    int baseOutVertex = (int)outVertices.size();
+    // only vertices added here are considered for merging
+    vaVertexWeldIndex weldIndex( 0.0f, ( shareVertices ) ? ( inVertices.size( ) * 4 ) : ( 0 ) );
 
     for( size_t i = 0; i < inIndices.size(); i += 3 )
     {
@@ -341,11 +342,10 @@ static void TessellateSphere( std::vector<vaVector3> & outVertices, std::vector<
 
         if( shareVertices )
         {
-            // very inefficient way but couldn't think of anything better: feel free to improve!
-            vaTriangleMeshTools::AddTriangle_MergeSamePositionVertices( outVertices, outIndices, v1, v2, v3, baseOutVertex );
-            vaTriangleMeshTools::AddTriangle_MergeSamePositionVertices( outVertices, outIndices, a, v1, v3,  baseOutVertex );
-            vaTriangleMeshTools::AddTriangle_MergeSamePositionVertices( outVertices, outIndices, b, v2, v1,  baseOutVertex );
-            vaTriangleMeshTools::AddTriangle_MergeSamePositionVertices( outVertices, outIndices, c, v3, v2,  baseOutVertex );
+            vaTriangleMeshTools::AddTriangle_MergeSamePositionVertices( outVertices, outIndices, v1, v2, v3, weldIndex );
+            vaTriangleMeshTools::AddTriangle_MergeSamePositionVertices( outVertices, outIndices, a, v1, v3,  weldIndex );
+            vaTriangleMeshTools::AddTriangle_MergeSamePositionVertices( outVertices, outIndices, b, v2, v1,  weldIndex );
+            vaTriangleMeshTools::AddTriangle_MergeSamePositionVertices( outVertices, outIndices, c, v3, v2,  weldIndex );
         }
         else
         {
@@ -369,12 +369,6 @@ void vaStandardShapes::CreateSphere( std::vector<vaVector3> & outVertices, std::
     std::vector<vaVector3> * dstVertices    = &temp1Vertices;
     std::vector<uint32>    * dstIndices     = &temp1Indices;
 
-    if( shareVertices && ( tessellationLevel > 5 ) )
-    {
-        assert( false );
-        // this code is not really suitable for high tessellation levels when shareVertices is true; please look into optimizing TessellateSphere to avoid/optimize current incredibly slow O(N^2) search
-    }
-
     // Construct an icosahedron to start with 
     CreateIcosahedron( *srcVertices, *srcIndices, shareVertices );
 
@@ -18,6 +18,161 @@
 
 namespace Vanilla
 {
+    // Spatial hash over vertex positions for welding (merging duplicate or similar vertices) in O(1) average per query, 
+    // instead of the linear search done by vaTriangleMeshTools::FindOrAdd.
+    // With epsilon == 0 positions are hashed exactly (+0 and -0 are treated as the same) so only vertices with the same 
+    // position are candidates; otherwise positions go into a uniform grid with 2*epsilon sized cells and all vertices within 
+    // [position-epsilon, position+epsilon] (per component, inclusive) are candidates. The actual 'is it a duplicate' decision
+    // is always left to the caller's predicate, so the epsilon only needs to be at least as large as what the predicate accepts.
+    class vaVertexWeldIndex
+    {
+        struct Cell
+        {
+            int32                   X, Y, Z;
+            int                     Head;           // first entry in this cell's chain, -1 if the cell is empty
+        };
+        struct Entry
+        {
+            int                     Index;
+            int                     Next;
+        };
+
+        float                       m_epsilon       = 0.0f;
+        float                       m_invCellSize   = 0.0f;
+        std::vector<Cell>           m_cells;        // open addressing with linear probing, power of 2 size, at most half full
+        std::vector<Entry>          m_entries;
+        int                         m_usedCellCount = 0;
+
+    public:
+        vaVertexWeldIndex( float epsilon = 0.0f, size_t expectedCount = 0 )        { Reset( epsilon, expectedCount ); }
+
+        void                        Reset( float epsilon, size_t expectedCount = 0 )
+        {
+            assert( epsilon >= 0.0f );
+            m_epsilon       = epsilon;
+            m_invCellSize   = ( epsilon > 0.0f ) ? ( 0.5f / epsilon ) : ( 0.0f );
+            size_t cellCount = 64;
+            while( cellCount < expectedCount * 2 )
+                cellCount *= 2;
+            m_cells.assign( cellCount, Cell{ 0, 0, 0, -1 } );
+            m_entries.clear( );
+            m_entries.reserve( expectedCount );
+            m_usedCellCount = 0;
+        }
+
+        float                       Epsilon( ) const                                { return m_epsilon; }
+        size_t                      Count( ) const                                  { return m_entries.size( ); }
+
+        void                        Insert( const vaVector3 & position, int index )
+        {
+            if( ( m_usedCellCount + 1 ) * 2 > (int)m_cells.size( ) )
+                Grow( );
+
+            int32 x, y, z;
+            CellCoords( position, x, y, z );
+            Cell & cell = m_cells[FindCell( m_cells, x, y, z )];
+            if( cell.Head == -1 )
+            {
+                cell.X = x; cell.Y = y; cell.Z = z;
+                m_usedCellCount++;
+            }
+            m_entries.push_back( { index, cell.Head } );
+            cell.Head = (int)m_entries.size( ) - 1;
+        }
+
+        // Returns the first candidate index for which predicate( index ) returns true, or -1 if none. Candidates from the 
+        // same cell are visited from the most recently inserted (same as FindOrAdd's backwards search).
+        template< typename PredicateType >
+        int                         Find( const vaVector3 & position, PredicateType && predicate ) const
+        {
+            if( m_epsilon == 0.0f )
+            {
+                int32 x, y, z;
+                CellCoords( position, x, y, z );
+                return FindInCell( x, y, z, predicate );
+            }
+
+            int32 x0, y0, z0, x1, y1, z1;
+            CellCoords( position - vaVector3( m_epsilon, m_epsilon, m_epsilon ), x0, y0, z0 );
+            CellCoords( position + vaVector3( m_epsilon, m_epsilon, m_epsilon ), x1, y1, z1 );
+            for( int64 z = z0; z <= z1; z++ )
+                for( int64 y = y0; y <= y1; y++ )
+                    for( int64 x = x0; x <= x1; x++ )
+                    {
+                        int index = FindInCell( (int32)x, (int32)y, (int32)z, predicate );
+                        if( index != -1 )
+                            return index;
+                    }
+            return -1;
+        }
+
+    private:
+        static int32                GridCoord( float value, float invCellSize )
+        {
+            const float cell = std::floor( value * invCellSize );
+            if( cell > -2e9f && cell < 2e9f )
+                return (int32)cell;
+            return ( cell > 0.0f ) ? ( INT32_MAX ) : ( INT32_MIN );     // out of range, infinities and NaNs
+        }
+
+        static int32                ExactCoord( float value )
+        {
+            if( value == 0.0f )
+                return 0;
+            int32 bits;
+            memcpy( &bits, &value, sizeof( bits ) );
+            return bits;
+        }
+
+        void                        CellCoords( const vaVector3 & position, int32 & x, int32 & y, int32 & z ) const
+        {
+            if( m_epsilon == 0.0f )
+            {
+                x = ExactCoord( position.x ); y = ExactCoord( position.y ); z = ExactCoord( position.z );
+            }
+            else
+            {
+                x = GridCoord( position.x, m_invCellSize ); y = GridCoord( position.y, m_invCellSize ); z = GridCoord( position.z, m_invCellSize );
+            }
+        }
+
+        static size_t               HashCell( int32 x, int32 y, int32 z )
+        {
+            uint64 hash = (uint64)(uint32)x * 0x9E3779B97F4A7C15ull;
+            hash ^= (uint64)(uint32)y * 0xC2B2AE3D27D4EB4Full;
+            hash ^= (uint64)(uint32)z * 0x165667B19E3779F9ull;
+            return (size_t)( hash ^ ( hash >> 29 ) );
+        }
+
+        // returns either the matching cell or the empty one where it would go
+        static size_t               FindCell( const std::vector<Cell> & cells, int32 x, int32 y, int32 z )
+        {
+            const size_t mask = cells.size( ) - 1;
+            size_t i = HashCell( x, y, z ) & mask;
+            while( cells[i].Head != -1 && ( cells[i].X != x || cells[i].Y != y || cells[i].Z != z ) )
+                i = ( i + 1 ) & mask;
+            return i;
+        }
+
+        template< typename PredicateType >
+        int                         FindInCell( int32 x, int32 y, int32 z, PredicateType & predicate ) const
+        {
+            for( int entry = m_cells[FindCell( m_cells, x, y, z )].Head; entry != -1; entry = m_entries[entry].Next )
+                if( predicate( m_entries[entry].Index ) )
+                    return m_entries[entry].Index;
+            return -1;
+        }
+
+        void                        Grow( )
+        {
+            std::vector<Cell> newCells( m_cells.size( ) * 2, Cell{ 0, 0, 0, -1 } );
+            for( const Cell & cell : m_cells )
+                if( cell.Head != -1 )
+                    newCells[FindCell( newCells, cell.X, cell.Y, cell.Z )] = cell;
+            m_cells.swap( newCells );
+        }
+    };
+
     class vaTriangleMeshTools
     {
         vaTriangleMeshTools( ) { }
@@ -59,6 +214,32 @@ namespace Vanilla
             return (int)( vertices.size( ) ) - 1;
         }
 
+        static inline const vaVector3 & VertexPosition( const vaVector3 & vert )                         { return vert; }
+        template< typename VertexType >
+        static inline const vaVector3 & VertexPosition( const VertexType & vert )                        { return vert.Position; }
+
+        // Same as the above two but O(1) instead of O(searchBackRange): the search is done using (and new vertices added to)
+        // weldIndex, which is expected to contain all vertices to consider and have epsilon large enough for isDuplicate.
+        template< typename VertexType >
+        static inline int FindOrAdd( std::vector<VertexType> & vertices, const VertexType & vert, vaVertexWeldIndex & weldIndex )
+        {
+            return FindOrAdd( vertices, vert, weldIndex, [ ]( const VertexType & left, const VertexType & right ) { return left == right; } );
+        }
+
+        template< typename VertexType, typename CompareCallableType >
+        static inline int FindOrAdd( std::vector<VertexType> & vertices, const VertexType & vert, vaVertexWeldIndex & weldIndex, CompareCallableType && isDuplicate )
+        {
+            const vaVector3 & position = VertexPosition( vert );
+            int index = weldIndex.Find( position, [ & ]( int candidate ) { return isDuplicate( vertices[candidate], vert ); } );
+            if( index != -1 )
+                return index;
+
+            vertices.push_back( vert );
+            index = (int)( vertices.size( ) ) - 1;
+            weldIndex.Insert( position, index );
+            return index;
+        }
+
         static inline void AddTriangle( std::vector<uint32> & outIndices, int a, int b, int c )
         {
             assert( ( a >= 0 ) && ( b >= 0 ) && ( c >= 0 ) );
@@ -97,6 +278,26 @@ namespace Vanilla
             AddTriangle( outIndices, i0, i1, i2 );
         }
 
+        template< typename VertexType >
+        static inline void AddTriangle_MergeSamePositionVertices( std::vector<VertexType> & outVertices, std::vector<uint32> & outIndices, const VertexType & v0, const VertexType & v1, const VertexType & v2, vaVertexWeldIndex & weldIndex )
+        {
+            int i0 = FindOrAdd( outVertices, v0, weldIndex );
+            int i1 = FindOrAdd( outVertices, v1, weldIndex );
+            int i2 = FindOrAdd( outVertices, v2, weldIndex );
+
+            AddTriangle( outIndices, i0, i1, i2 );
+        }
+
+        template< typename VertexType, typename CompareCallableType >
+        static inline void AddTriangle_MergeDuplicates( std::vector<VertexType> & outVertices, std::vector<uint32> & outIndices, const VertexType & v0, const VertexType & v1, const VertexType & v2, vaVertexWeldIndex & weldIndex, CompareCallableType && isDuplicate )
+        {
+            int i0 = FindOrAdd( outVertices, v0, weldIndex, isDuplicate );
+            int i1 = FindOrAdd( outVertices, v1, weldIndex, isDuplicate );
+            int i2 = FindOrAdd( outVertices, v2, weldIndex, isDuplicate );
+
+            AddTriangle( outIndices, i0, i1, i2 );
+        }
+
         // This adds quad triangles in strip order ( (0, 0), (1, 0), (0, 1), (1, 1) ) - so swap the last two if doing clockwise/counterclockwise
         // (this is a bit inconsistent with AddPentagon below)
         static inline void AddQuad( std::vector<uint32> & outIndices, int i0, int i1, int i2, int i3 )
@@ -201,13 +402,16 @@ namespace Vanilla
                 float dotThreshold = std::cosf( mergeSharedMaxAngle );
                 std::vector<vaVector3> mergeVals;
                 mergeVals.resize( vertexCount, {0,0,0} );
+                vaVertexWeldIndex weldIndex( 0.0f, vertexCount );
                 for( int i = 0; i < vertexCount; i++ )
-                    for( int j = i+1; j < vertexCount; j++ )
+                {
+                    // visit all previous vertices with the same position (predicate never 'finds' so it sees them all)
+                    weldIndex.Find( vertices[i], [&]( int j )
                     {
                         const vaVector3 & pi = vertices[i];
                         const vaVector3 & pj = vertices[j];
                         if( pi != pj )
-                            continue;
+                            return false;
                         const vaVector3 & ni = outNormals[i];
                         const vaVector3 & nj = outNormals[j];
                         if( vaVector3::Dot( ni.Normalized(), nj.Normalized() ) > dotThreshold )
@@ -215,7 +419,10 @@ namespace Vanilla
                             mergeVals[i] += nj;
                             mergeVals[j] += ni;
                         }
-                    }
+                        return false;
+                    } );
+                    weldIndex.Insert( vertices[i], i );
+                }
 
                 for( int i = 0; i < vertexCount; i++ )
                     outNormals[i] += mergeVals[i];
@@ -236,17 +443,21 @@ namespace Vanilla
         {
             std::vector<vaVector3> normalsCopy( inOutNormals );
             assert( inOutNormals.size() == vertices.size() );
+            vaVertexWeldIndex weldIndex( epsilon, vertices.size( ) );
             for( int i = 0; i < (int)vertices.size( ); i++ )
-                for( int j = i+1; j < (int)vertices.size( ); j++ )
+            {
+                // visit all previous vertices within epsilon (predicate never 'finds' so it sees them all)
+                weldIndex.Find( vertices[i], [&]( int j )
                 {
-                    // if( i == j )
-                    //     continue;
                     if( vaVector3::NearEqual( vertices[i], vertices[j], epsilon ) )
                     {
                         inOutNormals[i] += normalsCopy[j];
                         inOutNormals[j] += normalsCopy[i];
                     }
-                }
+                    return false;
+                } );
+                weldIndex.Insert( vertices[i], i );
+            }
             for( int i = 0; i < (int)vertices.size( ); i++ )
                 inOutNormals[i] = inOutNormals[i].Normalized();
         }
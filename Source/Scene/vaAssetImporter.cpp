@@ -14,6 +14,8 @@
 #include "Core/System/vaFileTools.h"
 
 #include "Rendering/vaRenderMesh.h"
+#include "Rendering/vaRenderMeshLODBuilder.h"
+#include "Rendering/vaRenderMeshOptimizer.h"
 #include "Rendering/vaRenderMaterial.h"
 #include "Rendering/vaDebugCanvas.h"
 
@@ -63,6 +65,65 @@ bool vaAssetImporter::LoadFileContents( const string & path, ImporterContext & i
     return false;
 }
 
+bool vaAssetImporter::PostProcessMeshes( const std::vector<shared_ptr<vaRenderMesh>> & meshes, ImporterContext & importerContext )
+{
+    const ImporterSettings & importerSettings = importerContext.Settings;
+    if( meshes.size( ) == 0 || !( importerSettings.GenerateLODs || importerSettings.OptimizeMeshes ) )
+        return true;
+
+    std::vector<vaRenderMeshLODBuilder::Mesh> lodMeshes( meshes.size( ) );
+
+    // render meshes are owned by the render thread
+    if( !importerContext.AsyncInvokeAtBeginFrame( [ & ]( vaRenderDevice &, ImporterContext & )
+    {
+        for( size_t i = 0; i < meshes.size( ); i++ )
+        {
+            if( importerSettings.GenerateLODs )
+                vaRenderMeshLODBuilder::Extract( *meshes[i], lodMeshes[i] );
+            else
+                vaRenderMeshOptimizer::Extract( *meshes[i], lodMeshes[i] );
+        }
+        return true;
+    } ) )
+        return false;
+
+    if( importerSettings.GenerateLODs )
+    {
+        vaRenderMeshLODBuilder::Settings settings;
+        settings.MaxRelativePosError                = importerSettings.LODMaxRelativePosError;
+        settings.NormalRebuildMergeSharedMaxAngle   = importerSettings.LODNormalMergeSharedMaxAngle / 180.0f * VA_PIf;
+
+        vaRenderMeshLODBuilder::Stats stats = vaRenderMeshLODBuilder::Build( lodMeshes, settings );
+
+        string logLine = vaStringTools::Format( "Generated %d LODs for %d meshes (%lld -> %lld triangles) in %.2fs, %.2f Mtris/s", 
+            stats.LODCount, stats.MeshCount, stats.InputTriangles, stats.OutputTriangles, stats.ElapsedTime, stats.TrianglesPerSecond( ) / 1e6 );
+        importerContext.AddLog( logLine + "\n" );
+        VA_LOG( "vaAssetImporter - %s", logLine.c_str( ) );
+    }
+
+    if( importerContext.IsAborted( ) )
+        return false;
+
+    if( importerSettings.OptimizeMeshes )
+    {
+        vaRenderMeshOptimizer::Stats stats = vaRenderMeshOptimizer::Optimize( lodMeshes, vaRenderMeshOptimizer::Settings( ) );
+
+        string logLine = "Optimized " + stats.ToString( );
+        importerContext.AddLog( logLine + "\n" );
+        VA_LOG( "vaAssetImporter - %s", logLine.c_str( ) );
+    }
+
+    if( importerContext.IsAborted( ) )
+        return false;
+
+    return importerContext.AsyncInvokeAtBeginFrame( [ & ]( vaRenderDevice &, ImporterContext & )
+    {
+        for( size_t i = 0; i < meshes.size( ); i++ )
+            vaRenderMeshLODBuilder::Apply( std::move( lodMeshes[i] ), *meshes[i] );
+        return true;
+    } );
+}
+
 vaAssetImporter::ImporterContext::~ImporterContext( )
 {
     if( AssetPack != nullptr )
@@ -159,6 +220,19 @@ void vaAssetImporter::UIPanelTick( vaApplicationBase & application )
         ImGui::Separator( );
         ImGui::Checkbox( "Textures: GenerateMIPs", &m_settings.TextureGenerateMIPs );
         ImGui::Separator( );
+        ImGui::Checkbox( "Meshes: Generate LODs", &m_settings.GenerateLODs );
+        if( m_settings.GenerateLODs )
+        {
+            VA_GENERIC_RAII_SCOPE( ImGui::Indent( );, ImGui::Unindent( ); );
+            ImGui::InputFloat( "Max relative position error", &m_settings.LODMaxRelativePosError, 0.0001f, 0.001f, "%.5f" );
+            m_settings.LODMaxRelativePosError = vaMath::Clamp( m_settings.LODMaxRelativePosError, 0.0f, 1.0f );
+            ImGui::InputFloat( "Normal merge max angle", &m_settings.LODNormalMergeSharedMaxAngle, 1.0f, 10.0f, "%.1f" );
+            m_settings.LODNormalMergeSharedMaxAngle = vaMath::Clamp( m_settings.LODNormalMergeSharedMaxAngle, 0.0f, 180.0f );
+        }
+        ImGui::Checkbox( "Meshes: Optimize for rendering", &m_settings.OptimizeMeshes );
+        if( ImGui::IsItemHovered( ) )
+            ImGui::SetTooltip( "Vertex cache, overdraw and vertex fetch optimization (per LOD)" );
+        ImGui::Separator( );
         ImGui::InputText( "AssetNamePrefix", &m_settings.AssetNamePrefix );
         //ImGui::Checkbox( "Regenerate tangents/bitangents",      &m_uiContext.ImportingRegenerateTangents );
         ImGui::Separator( );
@@ -40,6 +40,11 @@ namespace Vanilla
             bool                        AIOptimizeGraph                     = false;        // aiProcess_OptimizeGraph
             bool                        AIFLipUVs                           = false;        // aiProcess_FlipUVs
 
+            bool                        GenerateLODs                        = false;        // see vaRenderMeshLODBuilder
+            float                       LODMaxRelativePosError              = 0.0007f;      // relative to the mesh bounding box diagonal
+            float                       LODNormalMergeSharedMaxAngle        = 0.0f;         // in degrees
+            bool                        OptimizeMeshes                      = false;        // vertex cache, overdraw and vertex fetch, see vaRenderMeshOptimizer
+
             bool                        EnableLogInfo                       = true;
             bool                        EnableLogWarning                    = true;
             bool                        EnableLogError                      = true;
@@ -154,6 +159,11 @@ namespace Vanilla
     public:
         static bool                                         LoadFileContents( const string & path, ImporterContext & parameters );
 
+        // Generates LODs (vaRenderMeshLODBuilder) and/or optimizes (vaRenderMeshOptimizer) all meshes at once, as enabled in 
+        // ImporterSettings - called by the importers from the import (background) thread, with only the mesh data copies going 
+        // through the render thread.
+        static bool                                         PostProcessMeshes( const std::vector<shared_ptr<vaRenderMesh>> & meshes, ImporterContext & importerContext );
+
     };
 
 
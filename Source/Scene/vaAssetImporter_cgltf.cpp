@@ -1024,6 +1024,15 @@ static bool ProcessScene( const cgltf_data * loadedScene, LoadingTempStorage & t
     if( importerContext.IsAborted( ) )
         return false;
 
+    {
+        std::vector<shared_ptr<vaRenderMesh>> renderMeshes;
+        for( const auto & loadedMesh : tempStorage.LoadedMeshes )
+            if( loadedMesh.Mesh != nullptr && loadedMesh.Mesh->GetRenderMesh( ) != nullptr )
+                renderMeshes.push_back( loadedMesh.Mesh->GetRenderMesh( ) );
+        if( !vaAssetImporter::PostProcessMeshes( renderMeshes, importerContext ) )
+            return false;
+    }
+
     // this must happen in the main thread
     if (!importerContext.AsyncInvokeAtBeginFrame([&](vaRenderDevice&, vaAssetImporter::ImporterContext& importerContext)
     {
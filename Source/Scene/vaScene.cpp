@@ -59,6 +59,8 @@ namespace Vanilla
     struct TransformsUpdateWorkNode : vaSceneAsync::WorkNode
     {
         vaScene &               Scene;
+        bool                    UseHierarchy        = false;    // vaSceneTransformHierarchy path, latched at pass 0
+        uint32                  HierarchyBegin      = 0;        // flat index of the first item of the current depth's dirty range
 
         TransformsUpdateWorkNode( const string & name, vaScene & scene, const std::vector<string> & predecessors, const std::vector<string> & successors ) : Scene( scene ),
             vaSceneAsync::WorkNode( name, predecessors, successors, Scene::AccessPermissions::ExportPairLists<
@@ -76,8 +78,10 @@ namespace Vanilla
                 if( !Scene.m_listDirtyTransforms.IsConsuming( ) )
                     Scene.m_listDirtyTransforms.StartConsuming( );
 
-                for( uint32 depth = 0; depth < Scene::Relationship::c_MaxDepthLevels; depth++ )
-                    Scene.m_listHierarchyDirtyTransforms[depth].StartAppending( );
+                UseHierarchy = Scene.m_useTransformHierarchy;
+                if( !UseHierarchy )
+                    for( uint32 depth = 0; depth < Scene::Relationship::c_MaxDepthLevels; depth++ )
+                        Scene.m_listHierarchyDirtyTransforms[depth].StartAppending( );
 
                 return { (uint32)Scene.m_listDirtyTransforms.Count(), VA_GOOD_PARALLEL_FOR_CHUNK_SIZE * 4 };
             }
@@ -87,10 +91,25 @@ namespace Vanilla
 
                 // that's it, we're done
                 if( depth == Scene::Relationship::c_MaxDepthLevels )
+                {
+                    if( UseHierarchy )
+                        Scene.m_transformHierarchy.EndUpdate( );
                     return {0,0};
+                }
 
                 assert( depth >= 0 && depth < Scene::Relationship::c_MaxDepthLevels );
 
+                if( UseHierarchy )
+                {
+                    // new entities or changed relationships found in pass 0 (or first use) - rebuild, which marks everything dirty
+                    if( depth == 0 && Scene.m_transformHierarchy.NeedsRebuild( ) )
+                        Scene.m_transformHierarchy.Rebuild( Scene.CRegistry( ) );
+
+                    const auto range = Scene.m_transformHierarchy.DirtyRange( depth );
+                    HierarchyBegin = range.first;
+                    return { range.second - range.first, VA_GOOD_PARALLEL_FOR_CHUNK_SIZE * 2 };
+                }
+
                 // Switch hierarchy transform dirty tag containers into 'readable'
                 Scene.m_listHierarchyDirtyTransforms[depth].StartConsuming( );
 
@@ -103,7 +122,16 @@ namespace Vanilla
         // Asynchronous wide processing; items run in chunks to minimize various overheads
         virtual void                    ExecuteWide( const uint32 pass, const uint32 itemBegin, const uint32 itemEnd, vaSceneAsync::ConcurrencyContext & ) override
         {
-            if( pass == 0 )
+            if( pass == 0 && UseHierarchy )
+            {
+                // copy dirty locals into the flat storage; if any of them doesn't fit the current structure it gets rebuilt in pass 1
+                vaSceneTransformHierarchy::DirtyRanges ranges;
+                for( uint32 index = itemBegin; index < itemEnd; index++ )
+                    if( !Scene.m_transformHierarchy.MarkDirty( Scene.CRegistry( ), Scene.m_listDirtyTransforms[index], ranges ) )
+                        break;
+                Scene.m_transformHierarchy.MergeDirtyRanges( ranges );
+            }
+            else if( pass == 0 )
             {   
                 // continue from Narrow pass 0, we categorizes transform-dirty entities to hierarchy-depth-based buckets
                 for( uint32 index = itemBegin; index < itemEnd; index++ )
@@ -116,6 +144,11 @@ namespace Vanilla
                     Scene.m_listHierarchyDirtyTransforms[depth].Append( entity );
                 }
             }
+            else if( UseHierarchy )
+            {
+                // one depth level of the flat storage; the previous level is done
+                Scene.m_transformHierarchy.Update( Scene.Registry(), HierarchyBegin + itemBegin, HierarchyBegin + itemEnd, Scene.m_listDirtyBounds );
+            }
             else
             {
                 // continue from Narrow pass 1+, update transforms in layers
@@ -364,6 +397,13 @@ vaScene::vaScene( const string & name, const vaGUID & UID )
     m_registry.on_construct<Scene::TransformWorld>( ).connect< &Scene::AutoEmplaceDestroyPreviousTransformWorld >( );
     m_registry.on_destroy<Scene::TransformWorld>( ).connect< &Scene::AutoEmplaceDestroyPreviousTransformWorld >( );
     //
+    // flat transform hierarchy caches these so it has to get rebuilt (new entities and re-parenting are caught by MarkDirty)
+    m_registry.on_destroy<Scene::TransformWorld>( ).connect<&vaScene::OnTransformHierarchyChange>( this );
+    m_registry.on_construct<Scene::TransformLocalIsWorldTag>( ).connect<&vaScene::OnTransformHierarchyChange>( this );
+    m_registry.on_destroy<Scene::TransformLocalIsWorldTag>( ).connect<&vaScene::OnTransformHierarchyChange>( this );
+    m_registry.on_construct<Scene::WorldBounds>( ).connect<&vaScene::OnTransformHierarchyChange>( this );
+    m_registry.on_destroy<Scene::WorldBounds>( ).connect<&vaScene::OnTransformHierarchyChange>( this );
+    //
     ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     
 #ifdef _DEBUG
@@ -449,6 +489,12 @@ vaScene::~vaScene( )
     // remove all entities
     ClearAll();
 
+    m_registry.on_destroy<Scene::TransformWorld>( ).disconnect<&vaScene::OnTransformHierarchyChange>( this );
+    m_registry.on_construct<Scene::TransformLocalIsWorldTag>( ).disconnect<&vaScene::OnTransformHierarchyChange>( this );
+    m_registry.on_destroy<Scene::TransformLocalIsWorldTag>( ).disconnect<&vaScene::OnTransformHierarchyChange>( this );
+    m_registry.on_construct<Scene::WorldBounds>( ).disconnect<&vaScene::OnTransformHierarchyChange>( this );
+    m_registry.on_destroy<Scene::WorldBounds>( ).disconnect<&vaScene::OnTransformHierarchyChange>( this );
+
     // m_registry.unset<Scene::RuntimeIDContext>( );
 
     s_instanceCount--;
@@ -541,6 +587,16 @@ void vaScene::SetTransformDirtyRecursive( entt::entity entity )
     Scene::SetTransformDirtyRecursive( m_registry, entity );
 }
 
+void vaScene::SetUseTransformHierarchy( bool enable )
+{
+    assert( vaThreading::IsMainThread( ) && m_registry.ctx<Scene::AccessPermissions>().GetState( ) != Scene::AccessPermissions::State::Concurrent );
+    if( m_useTransformHierarchy == enable )
+        return;
+    m_useTransformHierarchy = enable;
+    // not kept up to date while disabled
+    m_transformHierarchy.Clear( );
+}
+
 void vaScene::UnparentChildren( entt::entity parent )
 {
     assert( vaThreading::IsMainThread( ) && m_registry.ctx<Scene::AccessPermissions>().GetState( ) != Scene::AccessPermissions::State::Concurrent );
@@ -625,6 +681,28 @@ bool vaScene::LoadJSON( const string & filePath )
     return ret;
 }
 
+bool vaScene::SaveBinary( const string & filePath )
+{
+    Scene::DestroyTagged( m_registry ); // <- don't save any of the about to be destroyed ones
+    bool ret = Scene::BinarySave( m_registry, filePath );
+    if( ret )
+        VA_LOG_SUCCESS( "Scene file saved to %s", filePath.c_str() );
+    else
+        VA_LOG_ERROR( "Unable to save scene file to %s", filePath.c_str() );
+    return ret;
+}
+
+bool vaScene::LoadBinary( const string & filePath )
+{
+    ClearAll();
+    bool ret = Scene::BinaryLoad( m_registry, filePath );
+    if( ret )
+        VA_LOG_SUCCESS( "Scene loaded from %s", filePath.c_str() );
+    else
+        VA_LOG_ERROR( "Unable to load scene file from %s", filePath.c_str() );
+    return ret;
+}
+
 void vaScene::UIPanelTick( vaApplicationBase& application )
 {
     assert( vaThreading::IsMainThread( ) && m_registry.ctx<Scene::AccessPermissions>().GetState( ) != Scene::AccessPermissions::State::Concurrent );
@@ -689,6 +767,12 @@ void vaScene::UIPanelTick( vaApplicationBase& application )
 
         if( ImGui::Button( "Dump systems graph", {-1, 0} ) )
             m_async.ScheduleGraphDump( );
+
+        bool useTransformHierarchy = m_useTransformHierarchy;
+        if( ImGui::Checkbox( "Flat transform hierarchy", &useTransformHierarchy ) )
+            SetUseTransformHierarchy( useTransformHierarchy );
+        if( ImGui::IsItemHovered( ) )
+            ImGui::SetTooltip( "Update world transforms from a depth-sorted flat copy of the hierarchy (vaSceneTransformHierarchy)\ninstead of per-entity registry lookups" );
         
         if( m_uiMarker == vaMatrix4x4::Degenerate ) 
             ImGui::Text( "UI marker not set" );
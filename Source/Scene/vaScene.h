@@ -24,6 +24,7 @@
 #include "vaSceneComponents.h"
 
 #include "vaSceneAsync.h"
+#include "vaSceneTransformHierarchy.h"
 
 #ifdef VA_TASKFLOW_INTEGRATION_ENABLED
 #include "IntegratedExternals/vaTaskflowIntegration.h"
@@ -131,6 +132,10 @@ namespace Vanilla
         // specialized for traversing dirty transform hierarchy - 32k total for 16 levels when unused, grows with used storage (no shrink to fit yet!)
         vaAppendConsumeList<entt::entity>           m_listHierarchyDirtyTransforms[Scene::Relationship::c_MaxDepthLevels];
         // 
+        // optional flat, depth-sorted transform storage used by TransformsUpdate instead of per-entity registry lookups
+        vaSceneTransformHierarchy                   m_transformHierarchy;
+        bool                                        m_useTransformHierarchy             = false;
+        // 
         //////////////////////////////////////////////////////////////////////////
 
         //////////////////////////////////////////////////////////////////////////
@@ -189,6 +194,9 @@ namespace Vanilla
         bool                                        SaveJSON( const string & filePath );
         bool                                        LoadJSON( const string & filePath );
         string                                      LastJSONFilePath( )                                 { return m_storagePath; }
+        // Scene::BinarySave/BinaryLoad format - much faster to load; doesn't change LastJSONFilePath
+        bool                                        SaveBinary( const string & filePath );
+        bool                                        LoadBinary( const string & filePath );
 
         int64                                       GetLastApplicationTickIndex( ) const                { return m_lastApplicationTickIndex; }
         double                                      GetTime( ) const                                    { return m_time; }
@@ -224,6 +232,9 @@ namespace Vanilla
         // Transforms
         // const vaMatrix4x4 *                         GetTransformWorld( )
         void                                        SetTransformDirtyRecursive( entt::entity entity );
+        // Switches TransformsUpdate between per-entity Scene::UpdateTransforms and vaSceneTransformHierarchy; results are the same.
+        void                                        SetUseTransformHierarchy( bool enable );
+        bool                                        GetUseTransformHierarchy( ) const                   { return m_useTransformHierarchy; }
 
     public:
         // Parent/child relationships
@@ -239,6 +250,7 @@ namespace Vanilla
         void                                        OnDisallowedOperation( entt::registry &, entt::entity );
         void                                        OnRelationshipEmplace( entt::registry &, entt::entity );
         void                                        OnTransformDirtyFlagEmplace( entt::registry & registry, entt::entity );
+        void                                        OnTransformHierarchyChange( entt::registry & registry, entt::entity );
 
     protected:
         virtual string                              UIPanelGetDisplayName( ) const override { return Name(); }
@@ -282,4 +294,10 @@ namespace Vanilla
         // TODO: handle this with Component states
         // assert( m_canEmplaceTransformDirtyFlag );    // you're doing something that's not allowed
     }
+
+    inline void vaScene::OnTransformHierarchyChange( entt::registry & registry, entt::entity )
+    {
+        assert( &registry == &m_registry ); registry;
+        m_transformHierarchy.Invalidate( );
+    }
 }
@@ -178,7 +178,7 @@ void vaSceneAsync::Begin( float deltaTime, int64 applicationTickIndex )
             m_tracerContext = vaTracer::CreateVirtualThreadContext( tracerName, false, false );
     }
 
-    m_tracerContext->OnBegin( m_tracerContext->MapName("BeginEndScope"), (int)(applicationTickIndex&0x8FFFFFFF) );
+    m_tracerContext->OnBegin( "BeginEndScope", (int)(applicationTickIndex&0x8FFFFFFF) );
 
     m_isAsync = true;
     m_currentDeltaTime            = deltaTime;
@@ -312,7 +312,7 @@ void vaSceneAsync::Begin( float deltaTime, int64 applicationTickIndex )
 
     // run through the graph for the prologue
     {
-        m_tracerContext->OnBegin( m_tracerContext->MapName("Prologue") );
+        m_tracerContext->OnBegin( "Prologue" );
         int totalProloguesDone; 
         do 
         {
@@ -351,7 +351,7 @@ void vaSceneAsync::Begin( float deltaTime, int64 applicationTickIndex )
                 break;
             }
         } while ( true );
-        m_tracerContext->OnEnd( m_tracerContext->MapName("Prologue") );
+        m_tracerContext->OnEnd( "Prologue" );
     }
 
     // Async part starts so enable threaded registry use validation
@@ -364,7 +364,7 @@ void vaSceneAsync::Begin( float deltaTime, int64 applicationTickIndex )
 #ifdef VA_SCENE_ASYNC_FORCE_SINGLETHREADED
     // run through the graph for the async stuff (but single-threaded)
     {
-        m_tracerContext->OnBegin( m_tracerContext->MapName("SingleThreadedAsync") );
+        m_tracerContext->OnBegin( "SingleThreadedAsync" );
         int totalAsyncDone; 
         do 
         {
@@ -433,10 +433,10 @@ void vaSceneAsync::Begin( float deltaTime, int64 applicationTickIndex )
                 break;
             }
         } while ( true );
-        m_tracerContext->OnEnd( m_tracerContext->MapName("SingleThreadedAsync") );
+        m_tracerContext->OnEnd( "SingleThreadedAsync" );
     }
 #else
-    m_tracerContext->OnBegin( m_tracerContext->MapName("Async") );
+    m_tracerContext->OnBegin( "Async" );
     assert( m_masterFlow.empty( ) );
     assert( !m_masterFlowFuture.valid() );  // i.e. empty
 
@@ -576,7 +576,7 @@ void vaSceneAsync::End( )
         node->FinishedBarrierFuture = std::future<void>();
     }
 
-    m_tracerContext->OnEnd( m_tracerContext->MapName("Async") );
+    m_tracerContext->OnEnd( "Async" );
 #endif
 
     // update tracing stuff
@@ -585,6 +585,15 @@ void vaSceneAsync::End( )
         assert( lockTry.owns_lock() ); // all async work should have been finished by now so this is an indication of a serious failure
         // we need these sorted by beginnings for correct ordering later
         std::sort( m_tracerAsyncEntries.begin(), m_tracerAsyncEntries.end(), []( const vaTracer::Entry & a, const vaTracer::Entry & b) -> bool { return a.Beginning < b.Beginning; } );
+        // per node totals (a node can have many entries when single threaded)
+        m_lastNodeTimes.clear( );
+        for( const vaTracer::Entry & entry : m_tracerAsyncEntries )
+        {
+            auto it = std::find_if( m_lastNodeTimes.begin( ), m_lastNodeTimes.end( ), [&entry]( const std::pair<string, float> & item ) { return item.first == entry.Name; } );
+            if( it == m_lastNodeTimes.end( ) )
+                it = m_lastNodeTimes.insert( m_lastNodeTimes.end( ), { entry.Name, 0.0f } );
+            it->second += (float)( ( entry.End - entry.Beginning ) * 1000.0 );
+        }
         // dump all at once
         m_tracerContext->BatchAddSingleLevelEntries( m_tracerAsyncEntries.data(), (int)m_tracerAsyncEntries.size() );
         m_tracerAsyncEntries.clear();
@@ -594,7 +603,7 @@ void vaSceneAsync::End( )
     Scene::AccessPermissions & accessPermissions = m_scene.Registry().ctx<Scene::AccessPermissions>( );
     accessPermissions.SetState( Scene::AccessPermissions::State::Serialized );
 
-    m_tracerContext->OnBegin( m_tracerContext->MapName("Epilogue") );
+    m_tracerContext->OnBegin( "Epilogue" );
     {
 
         // run through the graph for the epilogue
@@ -637,7 +646,7 @@ void vaSceneAsync::End( )
             }
         } while ( true );
     }
-    m_tracerContext->OnEnd( m_tracerContext->MapName("Epilogue") );
+    m_tracerContext->OnEnd( "Epilogue" );
 
     if( m_graphDumpScheduled )
     {
@@ -666,7 +675,7 @@ void vaSceneAsync::End( )
 
     m_graphNodesActive.clear();
 
-    m_tracerContext->OnEnd( m_tracerContext->MapName("BeginEndScope") );
+    m_tracerContext->OnEnd( "BeginEndScope" );
 }
 
 string vaSceneAsync::DumpDOTGraph( )
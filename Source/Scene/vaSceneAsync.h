@@ -148,6 +148,9 @@ namespace Vanilla
         std::shared_mutex               m_tracerAsyncEntriesMutex;
         std::vector<vaTracer::Entry>    m_tracerAsyncEntries;
 
+        // async (narrow + wide) wall time of each node during the last Begin/End, in milliseconds
+        std::vector<std::pair<string, float>>   m_lastNodeTimes;
+
 #ifndef VA_SCENE_ASYNC_FORCE_SINGLETHREADED
         tf::Taskflow                    m_masterFlow;
         tf::Future<void>                m_masterFlowFuture;
@@ -174,6 +177,9 @@ namespace Vanilla
 
         void                    ScheduleGraphDump( )            { m_graphDumpScheduled = true; }
 
+        // per node times of the last Begin/End (in order of first execution); only valid outside of Begin/End
+        const std::vector<std::pair<string, float>> & LastNodeTimes( ) const    { assert( !m_isAsync ); return m_lastNodeTimes; }
+
     private:
         int                     FindActiveNodeIndex( const string & name );
         string                  DumpDOTGraph( );
@@ -0,0 +1,914 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Core/vaCoreIncludes.h"
+#include "vaSceneComponents.h"
+#include "vaSceneSystems.h"
+
+#include "Core/vaSerializer.h"
+#include "Core/vaProfiler.h"
+#include "Core/System/vaFileTools.h"
+
+using namespace Vanilla;
+
+// Binary scene format ('.vaSceneBin'): the same content as JSONSave/JSONLoad - entity names, UIDs, hierarchy and whatever
+// each component writes through its Serialize - but laid out for loading straight from a memory mapped file:
+//
+//  Header
+//  string table        uint32 offsets[StringCount+1], then the characters (no terminators); names, object keys, string values
+//  GUID table          vaGUID[GUIDCount]; entity UIDs and all string values that are GUIDs in vaGUID::ToString form
+//  entity table        EntityRecord[EntityCount], depth-first in the same order as JSONSave writes them (parents always
+//                      before their children, children in order), ROOT trees first and UNROOT after
+//  component blocks    one per component type: BlockHeader, uint32 entities[Count], uint32 offsets[Count+1] (into data),
+//                      then the data - every component's serialized tree encoded with EncodeValue
+//
+// Sections are 8 byte aligned. Components keep using their vaSerializer reflection so nothing needs to know about this
+// format; on load, every type's components get bulk-emplaced for all entities from its block before being deserialized.
+// BinaryFromJSON/BinaryToJSON convert between the two without going through a registry, so they don't drop components that
+// aren't registered; converting a JSONSave output to binary and back gives the same JSON tree (BinaryToJSON writes the keys
+// sorted, like vaSerializer::Dump, while the streaming JSONSave writes them in serialization order).
+namespace
+{
+    const uint32            c_binaryMagic                   = 0x42534156;     // 'VASB'
+    const uint32            c_binaryVersion                 = 1;
+    const uint32            c_none                          = 0xFFFFFFFF;
+    const int               c_maxValueDepth                 = 128;
+
+    struct BinaryHeader
+    {
+        uint32              Magic;
+        uint32              Version;
+        uint32              EntityCount;
+        uint32              BlockCount;
+        uint32              StringCount;
+        uint32              GUIDCount;
+        uint32              SceneName;                      // string index or c_none
+        uint32              Reserved;
+        uint64              StringTableOffset;
+        uint64              GUIDTableOffset;
+        uint64              EntityTableOffset;
+        uint64              BlockTableOffset;
+        uint64              FileSize;
+    };
+
+    enum EntityFlags : uint32
+    {
+        EF_HasRelationship                                  = ( 1 << 0 ),   // has "[ChildEntities]" in JSON
+        EF_Unrooted                                         = ( 1 << 1 ),   // top level entity from the UNROOT list
+    };
+
+    struct EntityRecord
+    {
+        uint32              Name;                           // string index or c_none
+        uint32              UID;                            // GUID index or c_none
+        uint32              Parent;                         // entity index or c_none
+        uint32              Flags;                          // EntityFlags
+    };
+
+    struct BlockHeader
+    {
+        uint32              TypeName;                       // string index
+        uint32              Count;
+        uint64              DataSize;
+    };
+
+    enum class ValueTag : uint8
+    {
+        Null,
+        False,
+        True,
+        Int,                // zigzag varint
+        UInt,               // varint
+        Float,              // a double that's exactly representable as a float, stored as one
+        Double,
+        String,             // varint string index
+        GUID,               // varint GUID index
+        Array,              // varint count, values
+        Object,             // varint count, [varint key string index, value] pairs
+        FloatArray,         // varint count, floats; array of only Float-s (vectors, matrices, colors...)
+    };
+
+    static_assert( sizeof( vaGUID ) == 16 );
+    static_assert( sizeof( BinaryHeader ) % 8 == 0 && sizeof( EntityRecord ) % 8 == 0 && sizeof( BlockHeader ) % 8 == 0 );
+
+    // only the exact vaGUID::ToString form (lowercase) so that formatting it back gives the same string
+    bool ParseGUIDString( const string & text, vaGUID & outGUID )
+    {
+        if( text.size( ) != 36 )
+            return false;
+        byte bytes[16];
+        int byteCount = 0;
+        for( size_t i = 0; i < text.size( ); )
+        {
+            if( i == 8 || i == 13 || i == 18 || i == 23 )
+            {
+                if( text[i] != '-' )
+                    return false;
+                i++;
+                continue;
+            }
+            int nibbles[2];
+            for( int n = 0; n < 2; n++, i++ )
+            {
+                const char c = text[i];
+                if( c >= '0' && c <= '9' )
+                    nibbles[n] = c - '0';
+                else if( c >= 'a' && c <= 'f' )
+                    nibbles[n] = c - 'a' + 10;
+                else
+                    return false;
+            }
+            bytes[byteCount++] = (byte)( ( nibbles[0] << 4 ) | nibbles[1] );
+        }
+        assert( byteCount == 16 );
+        outGUID.Data1 = ( (uint32)bytes[0] << 24 ) | ( (uint32)bytes[1] << 16 ) | ( (uint32)bytes[2] << 8 ) | bytes[3];
+        outGUID.Data2 = (unsigned short)( ( bytes[4] << 8 ) | bytes[5] );
+        outGUID.Data3 = (unsigned short)( ( bytes[6] << 8 ) | bytes[7] );
+        for( int i = 0; i < 8; i++ )
+            outGUID.Data4[i] = bytes[8 + i];
+        return true;
+    }
+
+    // doubles that convert to float and back unchanged
+    bool IsExactFloat( double value )
+    {
+        return !( std::abs( value ) > FLT_MAX ) && (double)(float)value == value;
+    }
+
+    string FormatGUIDString( const vaGUID & guid )
+    {
+        char buffer[40];
+        snprintf( buffer, sizeof( buffer ), "%08x-%04x-%04x-%02x%02x-%02x%02x%02x%02x%02x%02x", (uint32)guid.Data1, (uint32)guid.Data2, (uint32)guid.Data3,
+            guid.Data4[0], guid.Data4[1], guid.Data4[2], guid.Data4[3], guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7] );
+        return buffer;
+    }
+
+    template< typename ValueType >
+    void Append( std::vector<byte> & out, const ValueType & value )
+    {
+        const byte * bytes = reinterpret_cast<const byte *>( &value );
+        out.insert( out.end( ), bytes, bytes + sizeof( ValueType ) );
+    }
+
+    void AppendBytes( std::vector<byte> & out, const void * data, size_t size )
+    {
+        const byte * bytes = static_cast<const byte *>( data );
+        out.insert( out.end( ), bytes, bytes + size );
+    }
+
+    void AppendVarUInt( std::vector<byte> & out, uint64 value )
+    {
+        while( value >= 0x80 )
+        {
+            out.push_back( (byte)( value | 0x80 ) );
+            value >>= 7;
+        }
+        out.push_back( (byte)value );
+    }
+
+    void PadTo8( std::vector<byte> & out )
+    {
+        out.resize( ( out.size( ) + 7 ) & ~(size_t)7, 0 );
+    }
+
+    // strings and GUIDs, deduplicated, in order of first use
+    class SceneBinaryTables
+    {
+        std::vector<string>                                 m_strings;
+        std::unordered_map<string, uint32>                  m_stringMap;
+        std::vector<vaGUID>                                 m_GUIDs;
+        std::unordered_map<vaGUID, uint32, vaGUIDHasher>    m_GUIDMap;
+
+    public:
+        uint32                          String( const string & text )
+        {
+            auto it = m_stringMap.find( text );
+            if( it != m_stringMap.end( ) )
+                return it->second;
+            const uint32 index = (uint32)m_strings.size( );
+            m_strings.push_back( text );
+            m_stringMap.emplace( text, index );
+            return index;
+        }
+        uint32                          GUID( const vaGUID & guid )
+        {
+            auto it = m_GUIDMap.find( guid );
+            if( it != m_GUIDMap.end( ) )
+                return it->second;
+            const uint32 index = (uint32)m_GUIDs.size( );
+            m_GUIDs.push_back( guid );
+            m_GUIDMap.emplace( guid, index );
+            return index;
+        }
+        const std::vector<string> &     Strings( ) const        { return m_strings; }
+        const std::vector<vaGUID> &     GUIDs( ) const          { return m_GUIDs; }
+    };
+
+    bool EncodeValue( const nlohmann::json & value, SceneBinaryTables & tables, std::vector<byte> & out )
+    {
+        switch( value.type( ) )
+        {
+        case( nlohmann::json::value_t::null ):              out.push_back( (byte)ValueTag::Null ); return true;
+        case( nlohmann::json::value_t::boolean ):           out.push_back( (byte)( ( value.get<bool>( ) ) ? ( ValueTag::True ) : ( ValueTag::False ) ) ); return true;
+        case( nlohmann::json::value_t::number_integer ):
+        {
+            const int64 number = value.get<int64>( );
+            out.push_back( (byte)ValueTag::Int );
+            AppendVarUInt( out, ( (uint64)number << 1 ) ^ (uint64)( number >> 63 ) );
+            return true;
+        }
+        case( nlohmann::json::value_t::number_unsigned ):
+            out.push_back( (byte)ValueTag::UInt );
+            AppendVarUInt( out, value.get<uint64>( ) );
+            return true;
+        case( nlohmann::json::value_t::number_float ):
+        {
+            const double number = value.get<double>( );
+            if( IsExactFloat( number ) )
+            {
+                out.push_back( (byte)ValueTag::Float );
+                Append( out, (float)number );
+            }
+            else
+            {
+                out.push_back( (byte)ValueTag::Double );
+                Append( out, number );
+            }
+            return true;
+        }
+        case( nlohmann::json::value_t::string ):
+        {
+            const string & text = value.get_ref<const string &>( );
+            vaGUID guid;
+            if( ParseGUIDString( text, guid ) )
+            {
+                out.push_back( (byte)ValueTag::GUID );
+                AppendVarUInt( out, tables.GUID( guid ) );
+            }
+            else
+            {
+                out.push_back( (byte)ValueTag::String );
+                AppendVarUInt( out, tables.String( text ) );
+            }
+            return true;
+        }
+        case( nlohmann::json::value_t::array ):
+        {
+            const bool allFloats = !value.empty( ) && std::all_of( value.begin( ), value.end( ), [ ]( const nlohmann::json & item )
+                { return item.is_number_float( ) && IsExactFloat( item.get<double>( ) ); } );
+            out.push_back( (byte)( ( allFloats ) ? ( ValueTag::FloatArray ) : ( ValueTag::Array ) ) );
+            AppendVarUInt( out, value.size( ) );
+            for( const nlohmann::json & item : value )
+            {
+                if( allFloats )
+                    Append( out, (float)item.get<double>( ) );
+                else if( !EncodeValue( item, tables, out ) )
+                    return false;
+            }
+            return true;
+        }
+        case( nlohmann::json::value_t::object ):
+            out.push_back( (byte)ValueTag::Object );
+            AppendVarUInt( out, value.size( ) );
+            for( auto it = value.begin( ); it != value.end( ); it++ )
+            {
+                AppendVarUInt( out, tables.String( it.key( ) ) );
+                if( !EncodeValue( it.value( ), tables, out ) )
+                    return false;
+            }
+            return true;
+        default:
+            // binary/discarded - never produced by vaSerializer
+            return false;
+        }
+    }
+
+    // Builds the file in memory; entities have to be added depth-first (parents before children)
+    class SceneBinaryWriter
+    {
+        struct Block
+        {
+            uint32                      TypeName;
+            std::vector<uint32>         Entities;
+            std::vector<uint32>         Offsets;
+            std::vector<byte>           Data;
+        };
+
+        SceneBinaryTables               m_tables;
+        std::vector<EntityRecord>       m_entities;
+        std::vector<Block>              m_blocks;
+        std::unordered_map<string, size_t>
+                                        m_blockMap;
+
+    public:
+        uint32                          AddEntity( const string * name, const vaGUID * uid, uint32 parent, uint32 flags )
+        {
+            assert( parent == c_none || parent < m_entities.size( ) );
+            EntityRecord record;
+            record.Name     = ( name != nullptr ) ? ( m_tables.String( *name ) ) : ( c_none );
+            record.UID      = ( uid != nullptr ) ? ( m_tables.GUID( *uid ) ) : ( c_none );
+            record.Parent   = parent;
+            record.Flags    = flags;
+            m_entities.push_back( record );
+            return (uint32)m_entities.size( ) - 1;
+        }
+
+        bool                            AddComponent( uint32 entity, const string & typeName, const nlohmann::json & value )
+        {
+            auto it = m_blockMap.find( typeName );
+            if( it == m_blockMap.end( ) )
+            {
+                it = m_blockMap.emplace( typeName, m_blocks.size( ) ).first;
+                m_blocks.emplace_back( );
+                m_blocks.back( ).TypeName = m_tables.String( typeName );
+                m_blocks.back( ).Offsets.push_back( 0 );
+            }
+            Block & block = m_blocks[it->second];
+            block.Entities.push_back( entity );
+            if( !EncodeValue( value, m_tables, block.Data ) || block.Data.size( ) > 0xFFFFFFFFull )
+                return false;
+            block.Offsets.push_back( (uint32)block.Data.size( ) );
+            return true;
+        }
+
+        bool                            Write( const string * sceneName, const string & filePath )
+        {
+            BinaryHeader header = { };
+            header.Magic        = c_binaryMagic;
+            header.Version      = c_binaryVersion;
+            header.SceneName    = ( sceneName != nullptr ) ? ( m_tables.String( *sceneName ) ) : ( c_none );
+
+            std::vector<byte> image;
+            image.resize( sizeof( BinaryHeader ) );
+
+            const std::vector<string> & strings = m_tables.Strings( );
+            header.StringCount          = (uint32)strings.size( );
+            header.StringTableOffset    = image.size( );
+            uint64 characterCount = 0;
+            Append( image, (uint32)0 );
+            for( const string & text : strings )
+            {
+                characterCount += text.size( );
+                if( characterCount > 0xFFFFFFFFull )
+                    return false;
+                Append( image, (uint32)characterCount );
+            }
+            for( const string & text : strings )
+                AppendBytes( image, text.data( ), text.size( ) );
+            PadTo8( image );
+
+            header.GUIDCount            = (uint32)m_tables.GUIDs( ).size( );
+            header.GUIDTableOffset      = image.size( );
+            AppendBytes( image, m_tables.GUIDs( ).data( ), m_tables.GUIDs( ).size( ) * sizeof( vaGUID ) );
+            PadTo8( image );
+
+            header.EntityCount          = (uint32)m_entities.size( );
+            header.EntityTableOffset    = image.size( );
+            AppendBytes( image, m_entities.data( ), m_entities.size( ) * sizeof( EntityRecord ) );
+
+            header.BlockCount           = (uint32)m_blocks.size( );
+            header.BlockTableOffset     = image.size( );
+            for( const Block & block : m_blocks )
+            {
+                BlockHeader blockHeader;
+                blockHeader.TypeName    = block.TypeName;
+                blockHeader.Count       = (uint32)block.Entities.size( );
+                blockHeader.DataSize    = block.Data.size( );
+                Append( image, blockHeader );
+                AppendBytes( image, block.Entities.data( ), block.Entities.size( ) * sizeof( uint32 ) );
+                AppendBytes( image, block.Offsets.data( ), block.Offsets.size( ) * sizeof( uint32 ) );
+                AppendBytes( image, block.Data.data( ), block.Data.size( ) );
+                PadTo8( image );
+            }
+
+            header.FileSize = image.size( );
+            memcpy( image.data( ), &header, sizeof( header ) );
+            return vaFileTools::WriteBuffer( filePath, image.data( ), image.size( ) );
+        }
+    };
+
+    // Bounds checked view of a file image (memory mapped); Open validates everything that's used for indexing so that a
+    // corrupted file fails to load instead of crashing
+    class SceneBinaryView
+    {
+    public:
+        struct Block
+        {
+            uint32                      TypeName;
+            uint32                      Count;
+            const uint32 *              Entities;
+            const uint32 *              Offsets;
+            const byte *                Data;
+        };
+
+    private:
+        const BinaryHeader *            m_header        = nullptr;
+        std::vector<string>             m_strings;
+        const vaGUID *                  m_GUIDs         = nullptr;
+        const EntityRecord *            m_entities      = nullptr;
+        std::vector<Block>              m_blocks;
+
+    public:
+        bool                            Open( const byte * data, int64 size )
+        {
+            if( data == nullptr || size < (int64)sizeof( BinaryHeader ) )
+                return false;
+            m_header = reinterpret_cast<const BinaryHeader *>( data );
+            const BinaryHeader & header = *m_header;
+            if( header.Magic != c_binaryMagic || header.Version != c_binaryVersion || header.FileSize != (uint64)size )
+                return false;
+
+            auto sectionFits = [size]( uint64 sectionOffset, uint64 sectionBytes ) { return ( sectionOffset % 8 ) == 0 && sectionOffset <= (uint64)size && sectionBytes <= (uint64)size - sectionOffset; };
+
+            // strings
+            const uint64 offsetsBytes = ( (uint64)header.StringCount + 1 ) * sizeof( uint32 );
+            if( !sectionFits( header.StringTableOffset, offsetsBytes ) )
+                return false;
+            const uint32 * stringOffsets = reinterpret_cast<const uint32 *>( data + header.StringTableOffset );
+            const char * characters = reinterpret_cast<const char *>( data + header.StringTableOffset + offsetsBytes );
+            if( stringOffsets[0] != 0 || !sectionFits( header.StringTableOffset, offsetsBytes + stringOffsets[header.StringCount] ) )
+                return false;
+            m_strings.resize( header.StringCount );
+            for( uint32 i = 0; i < header.StringCount; i++ )
+            {
+                if( stringOffsets[i + 1] < stringOffsets[i] || stringOffsets[i + 1] > stringOffsets[header.StringCount] )
+                    return false;
+                m_strings[i].assign( characters + stringOffsets[i], stringOffsets[i + 1] - stringOffsets[i] );
+            }
+            if( header.SceneName != c_none && header.SceneName >= header.StringCount )
+                return false;
+
+            // GUIDs
+            if( !sectionFits( header.GUIDTableOffset, (uint64)header.GUIDCount * sizeof( vaGUID ) ) )
+                return false;
+            m_GUIDs = reinterpret_cast<const vaGUID *>( data + header.GUIDTableOffset );
+
+            // entities
+            if( !sectionFits( header.EntityTableOffset, (uint64)header.EntityCount * sizeof( EntityRecord ) ) )
+                return false;
+            m_entities = reinterpret_cast<const EntityRecord *>( data + header.EntityTableOffset );
+            for( uint32 i = 0; i < header.EntityCount; i++ )
+            {
+                const EntityRecord & record = m_entities[i];
+                if( ( record.Name != c_none && record.Name >= header.StringCount ) || ( record.UID != c_none && record.UID >= header.GUIDCount ) )
+                    return false;
+                // depth-first: parents are always before children, and only entities with relationship can have them
+                if( record.Parent != c_none && ( record.Parent >= i || ( m_entities[record.Parent].Flags & EF_HasRelationship ) == 0 ) )
+                    return false;
+            }
+
+            // component blocks
+            uint64 offset = header.BlockTableOffset;
+            m_blocks.resize( header.BlockCount );
+            for( uint32 b = 0; b < header.BlockCount; b++ )
+            {
+                if( !sectionFits( offset, sizeof( BlockHeader ) ) )
+                    return false;
+                const BlockHeader & blockHeader = *reinterpret_cast<const BlockHeader *>( data + offset );
+                const uint64 tablesBytes = ( (uint64)blockHeader.Count * 2 + 1 ) * sizeof( uint32 );
+                if( blockHeader.TypeName >= header.StringCount || !sectionFits( offset, sizeof( BlockHeader ) + tablesBytes + blockHeader.DataSize ) )
+                    return false;
+                Block & block   = m_blocks[b];
+                block.TypeName  = blockHeader.TypeName;
+                block.Count     = blockHeader.Count;
+                block.Entities  = reinterpret_cast<const uint32 *>( data + offset + sizeof( BlockHeader ) );
+                block.Offsets   = block.Entities + block.Count;
+                block.Data      = data + offset + sizeof( BlockHeader ) + tablesBytes;
+                if( block.Offsets[0] != 0 || block.Offsets[block.Count] != blockHeader.DataSize )
+                    return false;
+                for( uint32 i = 0; i < block.Count; i++ )
+                    if( block.Entities[i] >= header.EntityCount || block.Offsets[i + 1] < block.Offsets[i] )
+                        return false;
+                offset += ( sizeof( BlockHeader ) + tablesBytes + blockHeader.DataSize + 7 ) & ~(uint64)7;
+            }
+            return true;
+        }
+
+        uint32                          EntityCount( ) const                { return m_header->EntityCount; }
+        const EntityRecord &            Entity( uint32 index ) const        { return m_entities[index]; }
+        const string &                  String( uint32 index ) const        { return m_strings[index]; }
+        const vaGUID &                  GUID( uint32 index ) const          { return m_GUIDs[index]; }
+        const string *                  SceneName( ) const                  { return ( m_header->SceneName != c_none ) ? ( &m_strings[m_header->SceneName] ) : ( nullptr ); }
+        const std::vector<Block> &      Blocks( ) const                     { return m_blocks; }
+
+        bool                            DecodeComponent( const Block & block, uint32 row, nlohmann::json & outValue ) const
+        {
+            const byte * position = block.Data + block.Offsets[row];
+            const byte * end = block.Data + block.Offsets[row + 1];
+            return DecodeValue( position, end, outValue, 0 ) && position == end;
+        }
+
+    private:
+        static bool                     ReadVarUInt( const byte * & position, const byte * end, uint64 & outValue )
+        {
+            outValue = 0;
+            for( int shift = 0; shift < 64; shift += 7 )
+            {
+                if( position >= end )
+                    return false;
+                const byte part = *position++;
+                outValue |= (uint64)( part & 0x7F ) << shift;
+                if( ( part & 0x80 ) == 0 )
+                    return true;
+            }
+            return false;
+        }
+
+        template< typename ValueType >
+        static bool                     Read( const byte * & position, const byte * end, ValueType & outValue )
+        {
+            if( (size_t)( end - position ) < sizeof( ValueType ) )
+                return false;
+            memcpy( &outValue, position, sizeof( ValueType ) );
+            position += sizeof( ValueType );
+            return true;
+        }
+
+        bool                            DecodeValue( const byte * & position, const byte * end, nlohmann::json & outValue, int depth ) const
+        {
+            if( position >= end || depth > c_maxValueDepth )
+                return false;
+            const ValueTag tag = (ValueTag)*position++;
+            uint64 number;
+            switch( tag )
+            {
+            case( ValueTag::Null ):     outValue = nullptr; return true;
+            case( ValueTag::False ):    outValue = false; return true;
+            case( ValueTag::True ):     outValue = true; return true;
+            case( ValueTag::Int ):
+                if( !ReadVarUInt( position, end, number ) )
+                    return false;
+                outValue = (int64)( number >> 1 ) ^ -(int64)( number & 1 );
+                return true;
+            case( ValueTag::UInt ):
+                if( !ReadVarUInt( position, end, number ) )
+                    return false;
+                outValue = number;
+                return true;
+            case( ValueTag::Float ):
+            {
+                float value;
+                if( !Read( position, end, value ) )
+                    return false;
+                outValue = (double)value;
+                return true;
+            }
+            case( ValueTag::Double ):
+            {
+                double value;
+                if( !Read( position, end, value ) )
+                    return false;
+                outValue = value;
+                return true;
+            }
+            case( ValueTag::String ):
+                if( !ReadVarUInt( position, end, number ) || number >= m_strings.size( ) )
+                    return false;
+                outValue = m_strings[(size_t)number];
+                return true;
+            case( ValueTag::GUID ):
+                if( !ReadVarUInt( position, end, number ) || number >= m_header->GUIDCount )
+                    return false;
+                outValue = FormatGUIDString( m_GUIDs[(size_t)number] );
+                return true;
+            case( ValueTag::FloatArray ):
+            {
+                if( !ReadVarUInt( position, end, number ) || number > (uint64)( end - position ) / sizeof( float ) )
+                    return false;
+                outValue = nlohmann::json::array( );
+                auto & items = outValue.get_ref<nlohmann::json::array_t &>( );
+                items.reserve( (size_t)number );
+                for( uint64 i = 0; i < number; i++ )
+                {
+                    float value;
+                    Read( position, end, value );
+                    items.emplace_back( (double)value );
+                }
+                return true;
+            }
+            case( ValueTag::Array ):
+            {
+                // every item takes at least a byte
+                if( !ReadVarUInt( position, end, number ) || number > (uint64)( end - position ) )
+                    return false;
+                outValue = nlohmann::json::array( );
+                auto & items = outValue.get_ref<nlohmann::json::array_t &>( );
+                items.resize( (size_t)number );
+                for( nlohmann::json & item : items )
+                    if( !DecodeValue( position, end, item, depth + 1 ) )
+                        return false;
+                return true;
+            }
+            case( ValueTag::Object ):
+            {
+                if( !ReadVarUInt( position, end, number ) || number > (uint64)( end - position ) )
+                    return false;
+                outValue = nlohmann::json::object( );
+                for( uint64 i = 0; i < number; i++ )
+                {
+                    uint64 key;
+                    if( !ReadVarUInt( position, end, key ) || key >= m_strings.size( ) )
+                        return false;
+                    if( !DecodeValue( position, end, outValue[m_strings[(size_t)key]], depth + 1 ) )
+                        return false;
+                }
+                return true;
+            }
+            default:
+                return false;
+            }
+        }
+    };
+
+    bool WriteEntityRecursive( SceneBinaryWriter & writer, entt::registry & registry, Scene::SerializeArgs & args, entt::entity entity, uint32 parent, uint32 flags )
+    {
+        const Scene::Name * name = registry.try_get<Scene::Name>( entity );
+        const Scene::UID * uid = registry.try_get<Scene::UID>( entity );
+        const bool hasRelationship = registry.any_of<Scene::Relationship>( entity );
+        if( hasRelationship )
+            flags |= EF_HasRelationship;
+        const uint32 index = writer.AddEntity( static_cast<const string *>( name ), static_cast<const vaGUID *>( uid ), parent, flags );
+
+        const int componentTypeCount = Scene::Components::TypeCount( );
+        for( int i = 0; i < componentTypeCount; i++ )
+        {
+            if( Scene::Components::HasSerialize( i ) && Scene::Components::Has( i, registry, entity ) )
+            {
+                vaSerializer node = vaSerializer::OpenWrite( );
+                if( !Scene::Components::Serialize( i, registry, entity, args, node ) || !writer.AddComponent( index, Scene::Components::TypeName( i ), node.DOM( ) ) )
+                    { assert( false ); return false; }
+            }
+        }
+
+        // same as EntitySerializeHelper
+        if( hasRelationship && !registry.any_of<Scene::SerializationSkipChildrenTag>( entity ) )
+        {
+            std::vector<entt::entity> children;
+            Scene::VisitChildren( registry, entity, [&]( entt::entity child ) { if( !registry.any_of<Scene::SerializationSkipTag>( child ) ) children.push_back( child ); } );
+            std::reverse( children.begin( ), children.end( ) ); // reverse because children get added in reverse so this preserves the original order
+            for( entt::entity child : children )
+                if( !WriteEntityRecursive( writer, registry, args, child, index, 0 ) )
+                    return false;
+        }
+        return true;
+    }
+
+    bool ConvertJSONEntityRecursive( SceneBinaryWriter & writer, const nlohmann::json & node, uint32 parent, uint32 flags )
+    {
+        if( !node.is_object( ) )
+            return false;
+
+        const string * name = nullptr;
+        auto nameIt = node.find( "Name" );
+        if( nameIt != node.end( ) )
+        {
+            if( !nameIt->is_string( ) )
+                return false;
+            name = &nameIt->get_ref<const string &>( );
+        }
+        vaGUID uid;
+        auto uidIt = node.find( "UID" );
+        if( uidIt != node.end( ) && ( !uidIt->is_string( ) || !ParseGUIDString( uidIt->get_ref<const string &>( ), uid ) ) )
+            return false;
+        auto childrenIt = node.find( "[ChildEntities]" );
+        if( childrenIt != node.end( ) )
+        {
+            // vaSerializer writes empty vectors as null
+            if( !childrenIt->is_array( ) && !childrenIt->is_null( ) )
+                return false;
+            flags |= EF_HasRelationship;
+        }
+
+        const uint32 index = writer.AddEntity( name, ( uidIt != node.end( ) ) ? ( &uid ) : ( nullptr ), parent, flags );
+        for( auto it = node.begin( ); it != node.end( ); it++ )
+            if( it.key( ) != "Name" && it.key( ) != "UID" && it.key( ) != "[ChildEntities]" )
+                if( !writer.AddComponent( index, it.key( ), it.value( ) ) )
+                    return false;
+
+        if( childrenIt != node.end( ) && childrenIt->is_array( ) )
+            for( const nlohmann::json & child : *childrenIt )
+                if( !ConvertJSONEntityRecursive( writer, child, index, 0 ) )
+                    return false;
+        return true;
+    }
+}
+
+bool Scene::BinarySave( entt::registry & registry, const string & filePath )
+{
+    VA_TRACE_CPU_SCOPE( SceneBinarySave );
+
+    SerializeArgs serializeArgs( registry.ctx<Scene::UIDRegistry>() );
+
+    // same as JSONSave
+    std::vector<entt::entity> rootEntities, unrootEntities;
+    registry.each( [&] ( entt::entity entity )
+    {
+        const Scene::Relationship * relationship = registry.try_get<Scene::Relationship>( entity );
+        if( relationship == nullptr )
+            unrootEntities.push_back( entity );
+        else if( relationship->Parent == entt::null )
+            rootEntities.push_back( entity );
+    } );
+    std::reverse( rootEntities.begin(), rootEntities.end() );       // registry.each iterates them in the reverse order, so invert that to preserve ordering
+    std::reverse( unrootEntities.begin(), unrootEntities.end() );   // registry.each iterates them in the reverse order, so invert that to preserve ordering
+
+    SceneBinaryWriter writer;
+    for( entt::entity entity : rootEntities )
+        if( !WriteEntityRecursive( writer, registry, serializeArgs, entity, c_none, 0 ) )
+            return false;
+    for( entt::entity entity : unrootEntities )
+        if( !WriteEntityRecursive( writer, registry, serializeArgs, entity, c_none, EF_Unrooted ) )
+            return false;
+
+    return writer.Write( &registry.ctx<Scene::Name>( ), filePath );
+}
+
+bool Scene::BinaryLoad( entt::registry & registry, const string & filePath )
+{
+    VA_TRACE_CPU_SCOPE( SceneBinaryLoad );
+
+    vaMappedFile file;
+    SceneBinaryView view;
+    if( !file.Open( filePath ) || !view.Open( file.Data( ), file.Size( ) ) )
+    {
+        VA_LOG_WARNING( "Error opening '%s' as a binary scene", filePath.c_str() );
+        return false;
+    }
+
+    SerializeArgs serializeArgs( registry.ctx<Scene::UIDRegistry>() );
+
+    // should sanitize name after this
+    registry.ctx<Scene::Name>( ) = ( view.SceneName( ) != nullptr ) ? ( *view.SceneName( ) ) : ( "UnnamedScene" );
+
+    const uint32 entityCount = view.EntityCount( );
+    std::vector<entt::entity> entities( entityCount );
+    registry.create( entities.begin( ), entities.end( ) );
+    for( uint32 i = 0; i < entityCount; i++ )
+    {
+        const EntityRecord & record = view.Entity( i );
+        if( record.Name != c_none )
+            registry.emplace<Scene::Name>( entities[i], view.String( record.Name ) );
+        if( record.UID != c_none )
+            registry.emplace<Scene::UID>( entities[i], Scene::UID( view.GUID( record.UID ) ) );
+    }
+
+    // components, one type at a time: all get emplaced in one go, then deserialized
+    std::vector<entt::entity> blockEntities;
+    for( const SceneBinaryView::Block & block : view.Blocks( ) )
+    {
+        const string & typeName = view.String( block.TypeName );
+        const int typeIndex = Scene::Components::TypeIndex( typeName );
+        if( typeIndex < 0 || !Scene::Components::HasSerialize( typeIndex ) )
+        {
+            VA_WARN( "Binary scene '%s' has %d components of unknown or non-serializable type '%s' - skipping.", filePath.c_str(), (int)block.Count, typeName.c_str() );
+            continue;
+        }
+        blockEntities.resize( block.Count );
+        for( uint32 i = 0; i < block.Count; i++ )
+            blockEntities[i] = entities[block.Entities[i]];
+        Scene::Components::EmplaceOrReplaceBulk( typeIndex, registry, blockEntities.data( ), blockEntities.data( ) + blockEntities.size( ) );
+
+        for( uint32 i = 0; i < block.Count; i++ )
+        {
+            nlohmann::json value;
+            bool success = view.DecodeComponent( block, i, value );
+            if( success )
+            {
+                vaSerializer node = vaSerializer::OpenReadDOM( std::move( value ) );
+                success = node.Type( ) == "" && Scene::Components::Serialize( typeIndex, registry, blockEntities[i], serializeArgs, node );
+            }
+            if( !success )
+            {
+                VA_WARN( "Error while trying to deserialize component name %s for entity name %s - skipping.", typeName.c_str(), Scene::GetName( registry, blockEntities[i] ).c_str() );
+                Scene::Components::Remove( typeIndex, registry, blockEntities[i] );
+            }
+        }
+    }
+
+    // hierarchy last, like JSONLoad does it (children are connected after their components are loaded)
+    for( uint32 i = 0; i < entityCount; i++ )
+        if( view.Entity( i ).Flags & EF_HasRelationship )
+            registry.emplace<Scene::Relationship>( entities[i] );
+    for( uint32 i = 0; i < entityCount; i++ )
+        if( view.Entity( i ).Parent != c_none )
+            Scene::SetParent( registry, entities[i], entities[view.Entity( i ).Parent], false );
+    for( uint32 i = 0; i < entityCount; i++ )
+        if( ( view.Entity( i ).Flags & EF_HasRelationship ) && view.Entity( i ).Parent == c_none )
+            Scene::SetTransformDirtyRecursiveUnsafe( registry, entities[i] );
+
+    // connect references
+    for( const auto & loadedReference : serializeArgs.LoadedReferences )
+        (*loadedReference.first) = Scene::EntityReference( serializeArgs.UIDRegistry, loadedReference.second );
+
+    return true;
+}
+
+bool Scene::BinaryIsSceneFile( const string & filePath )
+{
+    uint32 magic = 0;
+    return vaFileTools::ReadBuffer( filePath, &magic, sizeof( magic ) ) && magic == c_binaryMagic;
+}
+
+bool Scene::BinaryFromJSON( const string & jsonFilePath, const string & binaryFilePath )
+{
+    vaSerializer serializer = vaSerializer::OpenReadFile( jsonFilePath );
+    if( !serializer.IsReading( ) || serializer.Type( ) != "VanillaScene" )
+    {
+        VA_LOG_WARNING( "Error opening '%s' as a JSON scene", jsonFilePath.c_str() );
+        return false;
+    }
+    const nlohmann::json & document = serializer.DOM( );
+
+    // anything else wouldn't survive the conversion
+    for( auto it = document.begin( ); it != document.end( ); it++ )
+        if( it.key( ) != "!type" && it.key( ) != "Name" && it.key( ) != "ROOT" && it.key( ) != "UNROOT" )
+        {
+            VA_LOG_WARNING( "JSON scene '%s' has unexpected key '%s'", jsonFilePath.c_str(), it.key( ).c_str() );
+            return false;
+        }
+    auto nameIt = document.find( "Name" );
+    if( nameIt != document.end( ) && !nameIt->is_string( ) )
+        return false;
+
+    SceneBinaryWriter writer;
+    for( const char * listName : { "ROOT", "UNROOT" } )
+    {
+        auto listIt = document.find( listName );
+        if( listIt == document.end( ) || listIt->is_null( ) )
+            continue;
+        if( !listIt->is_array( ) )
+            return false;
+        for( const nlohmann::json & node : *listIt )
+            if( !ConvertJSONEntityRecursive( writer, node, c_none, ( listIt.key( ) == "UNROOT" ) ? ( (uint32)EF_Unrooted ) : ( 0u ) ) )
+            {
+                VA_LOG_WARNING( "JSON scene '%s' has an entity that can't be converted", jsonFilePath.c_str() );
+                return false;
+            }
+    }
+
+    return writer.Write( ( nameIt != document.end( ) ) ? ( &nameIt->get_ref<const string &>( ) ) : ( nullptr ), binaryFilePath );
+}
+
+bool Scene::BinaryToJSON( const string & binaryFilePath, const string & jsonFilePath )
+{
+    vaMappedFile file;
+    SceneBinaryView view;
+    if( !file.Open( binaryFilePath ) || !view.Open( file.Data( ), file.Size( ) ) )
+    {
+        VA_LOG_WARNING( "Error opening '%s' as a binary scene", binaryFilePath.c_str() );
+        return false;
+    }
+
+    const uint32 entityCount = view.EntityCount( );
+    std::vector<nlohmann::json> nodes( entityCount, nlohmann::json::object( ) );
+    std::vector<std::vector<uint32>> children( entityCount );
+    for( uint32 i = 0; i < entityCount; i++ )
+    {
+        const EntityRecord & record = view.Entity( i );
+        if( record.Name != c_none )
+            nodes[i]["Name"] = view.String( record.Name );
+        if( record.UID != c_none )
+            nodes[i]["UID"] = FormatGUIDString( view.GUID( record.UID ) );
+        if( record.Parent != c_none )
+            children[record.Parent].push_back( i );
+    }
+    for( const SceneBinaryView::Block & block : view.Blocks( ) )
+        for( uint32 i = 0; i < block.Count; i++ )
+            if( !view.DecodeComponent( block, i, nodes[block.Entities[i]][view.String( block.TypeName )] ) )
+            {
+                VA_LOG_WARNING( "Binary scene '%s' has corrupted component data", binaryFilePath.c_str() );
+                return false;
+            }
+
+    // children always come after parents so going backwards every subtree is complete before it gets moved into its parent
+    for( uint32 i = entityCount; i-- > 0; )
+    {
+        if( ( view.Entity( i ).Flags & EF_HasRelationship ) == 0 )
+            continue;
+        nlohmann::json childNodes;      // stays null if empty, like vaSerializer writes it
+        for( uint32 child : children[i] )
+            childNodes.push_back( std::move( nodes[child] ) );
+        nodes[i]["[ChildEntities]"] = std::move( childNodes );
+    }
+
+    nlohmann::json document;
+    document["!type"] = "VanillaScene";
+    if( view.SceneName( ) != nullptr )
+        document["Name"] = *view.SceneName( );
+    nlohmann::json roots, unroots;
+    for( uint32 i = 0; i < entityCount; i++ )
+        if( view.Entity( i ).Parent == c_none )
+            ( ( view.Entity( i ).Flags & EF_Unrooted ) ? ( unroots ) : ( roots ) ).push_back( std::move( nodes[i] ) );
+    document["ROOT"]    = std::move( roots );
+    document["UNROOT"]  = std::move( unroots );
+
+    // same formatting as vaSerializer::Dump; strings in a corrupted file might not be valid UTF-8, which would otherwise throw
+    return vaFileTools::WriteText( jsonFilePath, document.dump( 4, ' ', false, nlohmann::json::error_handler_t::replace ) );
+}
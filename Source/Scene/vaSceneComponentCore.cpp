@@ -79,12 +79,25 @@ void Components::EmplaceOrReplace( int typeIndex, entt::registry & registry, ent
     vaSceneComponentRegistry::GetInstance( ).m_components[typeIndex].EmplaceOrReplaceCallback( registry, entity );
 }
 
+void Components::EmplaceOrReplaceBulk( int typeIndex, entt::registry & registry, const entt::entity * first, const entt::entity * last )
+{
+    assert( typeIndex >= 0 && typeIndex < TypeCount( ) );
+    vaSceneComponentRegistry::GetInstance( ).m_components[typeIndex].EmplaceOrReplaceBulkCallback( registry, first, last );
+}
+
 void Components::Remove( int typeIndex, entt::registry & registry, entt::entity entity )
 {
     assert( typeIndex >= 0 && typeIndex < TypeCount( ) );
     vaSceneComponentRegistry::GetInstance( ).m_components[typeIndex].RemoveCallback( registry, entity );
 }
 
+void Components::Move( int typeIndex, entt::registry & fromRegistry, entt::entity fromEntity, entt::registry & toRegistry, entt::entity toEntity )
+{
+    assert( typeIndex >= 0 && typeIndex < TypeCount( ) );
+    assert( &fromRegistry != &toRegistry );
+    vaSceneComponentRegistry::GetInstance( ).m_components[typeIndex].MoveCallback( fromRegistry, fromEntity, toRegistry, toEntity );
+}
+
 bool Components::HasSerialize( int typeIndex )
 {
     assert( typeIndex >= 0 && typeIndex < TypeCount( ) );
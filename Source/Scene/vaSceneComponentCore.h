@@ -96,15 +96,13 @@ namespace Vanilla
             void                            OnEmplace( entt::registry &, entt::entity );
         };
 
-        bool JSONLoad( entt::registry & registry, const string & filePath );
-        int JSONLoadSubtree( const string & jsonData, entt::registry & registry, entt::entity parentEntity, bool regenerateUIDs );
+        bool BinaryLoad( entt::registry & registry, const string & filePath );
         struct SerializeArgs
         {
         private:
             friend class EntityReference;
-            friend struct EntitySerializeHelper;
-            friend bool Scene::JSONLoad( entt::registry & registry, const string & filePath );
-            friend int Scene::JSONLoadSubtree( const string & jsonData, entt::registry & registry, entt::entity parentEntity, bool regenerateUIDs );
+            friend struct StagedSceneLoad;                  // JSONLoad/JSONLoadSubtree
+            friend bool Scene::BinaryLoad( entt::registry & registry, const string & filePath );
             std::vector<std::pair<class EntityReference *, UID>>   
                                             LoadedReferences;
             const Scene::UIDRegistry &      UIDRegistry;
@@ -237,7 +235,11 @@ namespace Vanilla
 
             static bool             Has( int typeIndex, const entt::registry & registry, entt::entity entity );
             static void             EmplaceOrReplace( int typeIndex, entt::registry & registry, entt::entity entity );
+            // same as EmplaceOrReplace on each but a lot faster when none have it yet (freshly created entities, when loading)
+            static void             EmplaceOrReplaceBulk( int typeIndex, entt::registry & registry, const entt::entity * first, const entt::entity * last );
             static void             Remove( int typeIndex, entt::registry & registry, entt::entity entity );
+            // emplaces or replaces it on 'toEntity' by moving it from 'fromEntity' (that must have it) of another registry
+            static void             Move( int typeIndex, entt::registry & fromRegistry, entt::entity fromEntity, entt::registry & toRegistry, entt::entity toEntity );
 
             static bool             UIVisible( int typeIndex );
             static bool             UIAddRemoveResetDisabled( int typeIndex );
@@ -297,8 +299,12 @@ namespace Vanilla
                         HasCallback                 = {};
             std::function<void( entt::registry & registry, entt::entity entity ) >
                         EmplaceOrReplaceCallback    = {};
+            std::function<void( entt::registry & registry, const entt::entity * first, const entt::entity * last ) >
+                        EmplaceOrReplaceBulkCallback= {};
             std::function<void( entt::registry & registry, entt::entity entity ) >
                         RemoveCallback              = {};
+            std::function<void( entt::registry & fromRegistry, entt::entity fromEntity, entt::registry & toRegistry, entt::entity toEntity ) >
+                        MoveCallback                = {};
             std::function<int( entt::registry & registry ) >
                         TotalCountCallback          = {};
 
@@ -519,7 +525,25 @@ namespace Vanilla
         typeInfo.HasCallback        = [ ] ( const entt::registry & registry, entt::entity entity )    { return registry.any_of<ComponentType>( entity ); };
         typeInfo.EmplaceOrReplaceCallback 
                                     = [ ] ( entt::registry & registry, entt::entity entity )    { registry.emplace_or_replace<ComponentType>( entity ); };
+        typeInfo.EmplaceOrReplaceBulkCallback
+                                    = [ ] ( entt::registry & registry, const entt::entity * first, const entt::entity * last )
+        {
+            // insert needs all of them to not have it already - reactive systems could have added it to some
+            if( std::none_of( first, last, [&registry]( entt::entity entity ) { return registry.any_of<ComponentType>( entity ); } ) )
+                registry.insert<ComponentType>( first, last );
+            else
+                for( const entt::entity * it = first; it != last; it++ )
+                    registry.emplace_or_replace<ComponentType>( *it );
+        };
         typeInfo.RemoveCallback     = [ ] ( entt::registry & registry, entt::entity entity )    { registry.remove<ComponentType>( entity ); };
+        typeInfo.MoveCallback       = [ ] ( entt::registry & fromRegistry, entt::entity fromEntity, entt::registry & toRegistry, entt::entity toEntity )
+        {
+            // registry.get doesn't work on empty types
+            if constexpr( std::is_empty_v<ComponentType> )
+                { toRegistry.emplace_or_replace<ComponentType>( toEntity ); fromRegistry; fromEntity; }
+            else
+                toRegistry.emplace_or_replace<ComponentType>( toEntity, std::move( fromRegistry.get<ComponentType>( fromEntity ) ) );
+        };
         typeInfo.TotalCountCallback = [ ] ( entt::registry & registry )                         { return (int)registry.size<ComponentType>( ); };
         static_assert( ! (constexpr( component_has_serialize<ComponentType>::value ) && constexpr( component_has_serialize_with_args<ComponentType>::value ) ) ); //shouldn't have both versions of Serialize!
         if constexpr( component_has_serialize<ComponentType>::value )
@@ -0,0 +1,257 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "vaSceneHeadlessRunner.h"
+
+#include "Rendering/vaRenderInstanceList.h"
+#include "Rendering/vaSceneRenderInstanceProcessor.h"
+
+#ifdef VA_TASKFLOW_INTEGRATION_ENABLED
+#include "IntegratedExternals/vaTaskflowIntegration.h"
+#endif
+
+using namespace Vanilla;
+
+namespace
+{
+    // same as in vaRenderInstanceListSorterInstance
+    constexpr uint32    c_parallelSortMinCount  = 16384;
+    constexpr uint32    c_parallelSortChunkSize = 8192;
+
+    void ParallelFor( int count, const std::function<void( int )> & callable )
+    {
+#ifdef VA_TASKFLOW_INTEGRATION_ENABLED
+        if( count > 1 )
+        {
+            vaTF::parallel_for( 0, count, callable, 1 ).wait( );
+            return;
+        }
+#endif
+        for( int i = 0; i < count; i++ )
+            callable( i );
+    }
+}
+
+vaSceneHeadlessRunner::vaSceneHeadlessRunner( const shared_ptr<vaScene> & scene, float fixedDeltaTime )
+    : m_scene( scene ), m_camera( std::make_shared<vaCameraBase>( ) ), m_fixedDeltaTime( fixedDeltaTime )
+{
+    assert( vaThreading::IsMainThread( ) );
+    assert( m_scene != nullptr && fixedDeltaTime > 0.0f );
+    m_camera->SetAspect( 16.0f / 9.0f );
+    m_camera->SetNearPlaneDistance( 0.1f );
+    m_camera->SetFarPlaneDistance( 1000.0f );
+}
+
+vaSceneHeadlessRunner::~vaSceneHeadlessRunner( )
+{
+    assert( vaThreading::IsMainThread( ) );
+}
+
+bool vaSceneHeadlessRunner::Run( const ScriptFunction & scriptFunction, int64 maxFrames )
+{
+    assert( vaThreading::IsMainThread( ) );
+
+    vaMiniScript script;
+    if( !script.Start( [this, &scriptFunction]( vaMiniScriptInterface & scriptInterface ) { scriptFunction( scriptInterface, *this ); } ) )
+        return false;
+
+    for( int64 i = 0; i < maxFrames && script.IsActive( ); i++ )
+        TickFrame( script );
+
+    if( !script.IsActive( ) )
+        return true;
+
+    VA_LOG_ERROR( "vaSceneHeadlessRunner: script still running after %lld frames, stopping it", (long long)maxFrames );
+    script.Stop( );
+    vaBenchmarkTool::GetInstance( ).Stop( );
+    m_beforeNextTick.clear( );
+    return false;
+}
+
+void vaSceneHeadlessRunner::TickFrame( vaMiniScript & script )
+{
+    VA_TRACE_CPU_SCOPE( HeadlessFrame );
+    const float deltaTime = m_fixedDeltaTime;
+
+    // the script decides what happens in this frame
+    script.TickScript( deltaTime );
+
+    // callbacks can queue more - those run before the next tick
+    std::vector<std::function<void( vaSceneHeadlessRunner & )>> callbacks;
+    callbacks.swap( m_beforeNextTick );
+    for( const auto & callback : callbacks )
+        callback( *this );
+
+    m_camera->Tick( deltaTime, false );
+
+    m_frameIndex++;
+    const double tickStart = vaCore::TimeFromAppStart( );
+    m_scene->TickBegin( deltaTime, m_frameIndex );
+    m_scene->TickEnd( );
+    m_lastFrame.TickMS      = (float)( ( vaCore::TimeFromAppStart( ) - tickStart ) * 1000.0 );
+    m_lastFrame.AsyncNodeMS = m_scene->Async( ).LastNodeTimes( );
+
+    SelectAndSort( );
+
+    // samples are taken from m_lastFrame so this has to be last
+    vaBenchmarkTool::GetInstance( ).Tick( deltaTime );
+}
+
+void vaSceneHeadlessRunner::SelectAndSort( )
+{
+    VA_TRACE_CPU_SCOPE( HeadlessSelectAndSort );
+    constexpr uint32 c_chunkSize = vaSceneRenderInstanceProcessor::c_ConcurrentChuckMaxItemCount;
+
+    // single view version of vaSceneRenderer::PrepareInstanceBatchProcessing
+    const vaRenderInstanceList::FilterSettings filter = vaRenderInstanceList::FilterSettings::FrustumCull( *m_camera );
+    m_cullingViews.Clear( );
+    m_cullingViews.AddView( filter.FrustumPlanes.data( ), (int)filter.FrustumPlanes.size( ) );
+    const vaVector3 reference = m_camera->GetPosition( );
+
+    const entt::registry & registry = m_scene->CRegistry( );
+    entt::basic_view< entt::entity, entt::exclude_t<>, const Scene::WorldBounds> boundsView = registry.view<const Scene::WorldBounds>( );
+    const uint32 boundsCount = (uint32)boundsView.size( );
+
+    // vaSceneRenderInstanceProcessor::SelectionProc minus meshes, materials and LODs, then vaSceneRenderer::ProcessInstanceBatch
+    const double selectionStart = vaCore::TimeFromAppStart( );
+    m_chunkSelections.resize( ( boundsCount + c_chunkSize - 1 ) / c_chunkSize );
+    ParallelFor( (int)m_chunkSelections.size( ), [&]( int chunk )
+    {
+        vaCullingBoundsStorage<c_chunkSize> localBounds;
+        entt::entity    localEntities[c_chunkSize];
+        float           localDistances[c_chunkSize];
+        int             localCount = 0;
+
+        const uint32 entityEnd = std::min( boundsCount, ( (uint32)chunk + 1 ) * c_chunkSize );
+        for( uint32 index = (uint32)chunk * c_chunkSize; index < entityEnd; index++ )
+        {
+            const entt::entity entity = boundsView[index];
+            const Scene::WorldBounds & worldBounds = registry.get<Scene::WorldBounds>( entity );
+            const float dist = ( worldBounds.BS.Center - reference ).Length( );
+            const Scene::RenderMesh * renderMeshComponent = registry.try_get<Scene::RenderMesh>( entity );
+            if( renderMeshComponent != nullptr && ( dist - worldBounds.BS.Radius ) > renderMeshComponent->VisibilityRange )
+                continue;
+            localEntities[localCount]   = entity;
+            localDistances[localCount]  = dist;
+            localCount++;
+            localBounds.Append( worldBounds.BS, worldBounds.AABB );
+        }
+
+        uint64 viewMasks[c_chunkSize];
+        uint32 visibleIndices[c_chunkSize];
+        vaFrustumCulling::CullMultiView( localBounds.SoA( ), m_cullingViews, true, viewMasks );
+        const uint32 visibleCount = vaFrustumCulling::ExtractVisible( viewMasks, (uint32)localCount, 0, visibleIndices );
+
+        std::vector<std::pair<entt::entity, float>> & chunkSelection = m_chunkSelections[chunk];
+        chunkSelection.clear( );
+        for( uint32 i = 0; i < visibleCount; i++ )
+            chunkSelection.push_back( { localEntities[visibleIndices[i]], localDistances[visibleIndices[i]] } );
+    } );
+    uint32 count = 0;
+    for( const auto & chunkSelection : m_chunkSelections )
+        count += (uint32)chunkSelection.size( );
+
+    // what vaRenderInstanceListSorterInstance::Start does with a front to back SortSettings::Standard
+    const double sortStart = vaCore::TimeFromAppStart( );
+    const vaRenderInstanceList::SortSettings sortSettings = vaRenderInstanceList::SortSettings::Standard( *m_camera, true );
+#ifdef VA_TASKFLOW_INTEGRATION_ENABLED
+    const int sortChunkCount = ( count < c_parallelSortMinCount ) ? ( 1 ) : ( std::max( 1, std::min( vaTF::ThreadCount( ), (int)( count / c_parallelSortChunkSize ) ) ) );
+#else
+    const int sortChunkCount = 1;
+#endif
+    m_sort.Begin( count, sortChunkCount );
+    m_unsortedSelection.resize( count );
+    {
+        uint32 i = 0;
+        for( const auto & chunkSelection : m_chunkSelections )
+            for( const auto & item : chunkSelection )
+            {
+                m_unsortedSelection[i]  = item.first;
+                m_sort.Keys( )[i]       = vaRenderInstanceList::MakeSortKey( false, 0, item.second, -1, sortSettings );
+                m_sort.Values( )[i]     = i;
+                i++;
+            }
+    }
+    if( sortChunkCount == 1 )
+        m_sort.SortSerial( );
+    else
+    {
+        for( int pass = 0; pass < vaRadixSort::c_PassCount; pass++ )
+        {
+            ParallelFor( sortChunkCount, [&]( int chunk ) { m_sort.Histogram( pass, chunk ); } );
+            m_sort.PrefixSum( pass );
+            ParallelFor( sortChunkCount, [&]( int chunk ) { m_sort.Scatter( pass, chunk ); } );
+        }
+    }
+    const uint32 * sortedValues = m_sort.SortedValues( );
+    m_selection.resize( count );
+    for( uint32 i = 0; i < count; i++ )
+        m_selection[i] = m_unsortedSelection[sortedValues[i]];
+    const double sortEnd = vaCore::TimeFromAppStart( );
+
+    m_lastFrame.SelectionTested     = boundsCount;
+    m_lastFrame.SelectedCount       = count;
+    m_lastFrame.SelectionMS         = (float)( ( sortStart - selectionStart ) * 1000.0 );
+    m_lastFrame.SortMS              = (float)( ( sortEnd - sortStart ) * 1000.0 );
+}
+
+vaBenchmarkTool::RunDefinition vaSceneHeadlessRunner::MakeRun( const string & name, int sampleFrames, int warmupFrames, const std::function<void( vaSceneHeadlessRunner & )> & setup )
+{
+    std::vector<string> nodeNames;
+    for( const auto & node : m_lastFrame.AsyncNodeMS )
+        nodeNames.push_back( node.first );
+
+    vaBenchmarkTool::RunDefinition run;
+    run.Name                = name;
+    run.SamplingPeriod      = m_fixedDeltaTime;
+    run.SamplingTotalCount  = sampleFrames;
+    // setup happens on the first vaBenchmarkTool::Tick, after that frame was measured, so it takes effect one frame later;
+    // the extra half a frame keeps sampling times away from period boundaries (exactly one sample per frame)
+    run.DelayStartTime      = ( warmupFrames + 0.5f ) * m_fixedDeltaTime;
+    run.MetricNames         = { "tick ms", "selection ms", "sort ms", "tested", "selected" };
+    for( const string & nodeName : nodeNames )
+        run.MetricNames.push_back( "async " + nodeName + " ms" );
+    run.MetricHigherIsBetter.resize( run.MetricNames.size( ), false );
+
+    run.SettingsSetupCallback = [this, setup]( const vaBenchmarkTool::RunDefinition & )
+    {
+        if( setup )
+            setup( *this );
+    };
+    run.CollectSamplesCallback = [this, nodeNames]( const vaBenchmarkTool::RunDefinition &, std::vector<float> & outSamples )
+    {
+        outSamples[0] = m_lastFrame.TickMS;
+        outSamples[1] = m_lastFrame.SelectionMS;
+        outSamples[2] = m_lastFrame.SortMS;
+        outSamples[3] = (float)m_lastFrame.SelectionTested;
+        outSamples[4] = (float)m_lastFrame.SelectedCount;
+        for( size_t i = 0; i < nodeNames.size( ); i++ )
+        {
+            auto it = std::find_if( m_lastFrame.AsyncNodeMS.begin( ), m_lastFrame.AsyncNodeMS.end( ), [&]( const std::pair<string, float> & node ) { return node.first == nodeNames[i]; } );
+            outSamples[5 + i] = ( it != m_lastFrame.AsyncNodeMS.end( ) ) ? ( it->second ) : ( 0.0f );
+        }
+    };
+    run.FinishedCallback = []( const vaBenchmarkTool::RunDefinition & runDef, int, int, const std::vector<std::vector<float>> &, const std::vector<vaBenchmarkTool::AverageMinMax> &, const std::vector<vaBenchmarkTool::MetricStatistics> & statistics )
+    {
+        for( size_t i = 0; i < statistics.size( ); i++ )
+            VA_LOG( "%s: %s mean %.3f p99 %.3f", runDef.Name.c_str( ), runDef.MetricNames[i].c_str( ), statistics[i].Mean, statistics[i].P99 );
+    };
+    return run;
+}
+
+bool vaSceneHeadlessRunner::RunBenchmark( vaMiniScriptInterface & script, const std::vector<vaBenchmarkTool::RunDefinition> & runs )
+{
+    if( !vaBenchmarkTool::GetInstance( ).Run( runs ) )
+        return false;
+    while( vaBenchmarkTool::GetInstance( ).IsRunning( ) )
+        if( !script.YieldExecution( ) )
+            return false;
+    return true;
+}
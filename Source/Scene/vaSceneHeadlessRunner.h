@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Core/vaCoreIncludes.h"
+
+#include "Core/Misc/vaMiniScript.h"
+#include "Core/Misc/vaBenchmarkTool.h"
+#include "Core/Misc/vaRadixSort.h"
+
+#include "Rendering/vaFrustumCulling.h"
+
+#include "vaScene.h"
+#include "vaCameraBase.h"
+
+namespace Vanilla
+{
+    // Runs a vaScene without a window or a render device, for benchmarks and regression runs:
+    // * every frame is TickBegin/TickEnd with the same fixed delta time, so a run is the same sequence of frames on every
+    //   machine (only the measured times differ)
+    // * a vaMiniScript drives the run - camera paths (attach a controller to Camera(), usually vaCameraControllerFlythrough),
+    //   settings sweeps and vaBenchmarkTool runs (RunBenchmark), all in simulated time
+    // * after each tick, the renderer's CPU selection and sort of the main view are done and measured, through the same code
+    //   but without anything that needs a render device (meshes, materials, LODs, instance storage):
+    //   - selection: Scene::WorldBounds in vaSceneRenderInstanceProcessor sized chunks, each copied into vaCullingBoundsStorage
+    //     and culled with vaFrustumCulling::CullMultiView / ExtractVisible (as in vaSceneRenderer::ProcessInstanceBatch) against
+    //     vaRenderInstanceList::FilterSettings::FrustumCull of the camera
+    //   - sort: vaRenderInstanceList::MakeSortKey keys (front to back, no material) sorted with vaRadixSort, chunked the same way
+    //     as the vaRenderInstanceList sorter
+    // Scripts run on their own thread but never concurrently with the main thread (see vaMiniScript); anything that has to be
+    // on the main thread (most vaScene calls) goes through ExecuteBeforeNextTick.
+    class vaSceneHeadlessRunner
+    {
+    public:
+        // CPU-side measurements of one frame; times are wall-clock milliseconds
+        struct FrameMetrics
+        {
+            float                                   TickMS                  = 0;    // TickBegin + TickEnd
+            float                                   SelectionMS             = 0;
+            float                                   SortMS                  = 0;
+            uint32                                  SelectionTested         = 0;    // entities with Scene::WorldBounds
+            uint32                                  SelectedCount           = 0;    // not culled
+            std::vector<std::pair<string, float>>   AsyncNodeMS;                    // vaSceneAsync::LastNodeTimes
+        };
+
+        typedef std::function< void( vaMiniScriptInterface & script, vaSceneHeadlessRunner & runner ) >    ScriptFunction;
+
+    private:
+        shared_ptr<vaScene>                         m_scene;
+        shared_ptr<vaCameraBase>                    m_camera;
+        const float                                 m_fixedDeltaTime;
+        int64                                       m_frameIndex            = 0;
+
+        FrameMetrics                                m_lastFrame;
+
+        std::vector<std::function<void( vaSceneHeadlessRunner & )>>
+                                                    m_beforeNextTick;
+
+        vaCullingViewSet                            m_cullingViews;
+        // per selection chunk, visible entities and their distance from the camera
+        std::vector<std::vector<std::pair<entt::entity, float>>>
+                                                    m_chunkSelections;
+        std::vector<entt::entity>                   m_unsortedSelection;
+        std::vector<entt::entity>                   m_selection;
+        vaRadixSort                                 m_sort;
+
+    public:
+        vaSceneHeadlessRunner( const shared_ptr<vaScene> & scene, float fixedDeltaTime = 1.0f / 60.0f );
+        ~vaSceneHeadlessRunner( );
+
+        const shared_ptr<vaScene> &                 Scene( ) const                      { return m_scene; }
+        vaCameraBase &                              Camera( )                           { return *m_camera; }
+        float                                       FixedDeltaTime( ) const             { return m_fixedDeltaTime; }
+        int64                                       FrameIndex( ) const                 { return m_frameIndex; }
+        const FrameMetrics &                        LastFrameMetrics( ) const           { return m_lastFrame; }
+        // front to back, from the last frame
+        const std::vector<entt::entity> &           LastSelection( ) const              { return m_selection; }
+
+        // Starts the script and ticks frames until it finishes; returns false (and stops the script) if it's still running after
+        // maxFrames frames. Main thread only.
+        bool                                        Run( const ScriptFunction & script, int64 maxFrames );
+
+        // Callable from the script; executed on the main thread in order, just before the next scene tick
+        void                                        ExecuteBeforeNextTick( const std::function<void( vaSceneHeadlessRunner & )> & callback )   { m_beforeNextTick.push_back( callback ); }
+
+        // Run definition that samples every frame (SamplingPeriod is the fixed delta time) after warmupFrames frames, with
+        // metrics: tick, selection and sort times, selection counts and the time of each vaSceneAsync node present in the last
+        // frame (so call it after at least one frame was ticked). 'setup' is called on the main thread before the first frame.
+        vaBenchmarkTool::RunDefinition              MakeRun( const string & name, int sampleFrames, int warmupFrames, const std::function<void( vaSceneHeadlessRunner & )> & setup );
+
+        // Callable from the script: runs them through vaBenchmarkTool and yields until they're all done; false if the script
+        // got stopped
+        bool                                        RunBenchmark( vaMiniScriptInterface & script, const std::vector<vaBenchmarkTool::RunDefinition> & runs );
+
+    private:
+        void                                        TickFrame( vaMiniScript & script );
+        void                                        SelectAndSort( );
+    };
+}
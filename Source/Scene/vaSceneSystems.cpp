@@ -507,6 +507,7 @@ bool Scene::UniqueStaticAppendConsumeList::StartAppending( uint32 maxCount ) noe
 
 namespace Vanilla::Scene
 {
+    // Saving only - loading goes through StagedSceneLoad
     struct EntitySerializeHelper
     {
         Scene::SerializeArgs *  SerializeArgs;
@@ -520,25 +521,106 @@ namespace Vanilla::Scene
 
         bool                S_Serialize( vaSerializer & serializer )
         {
+            if( !serializer.IsWriting( ) )
+                { assert( false ); return false; }
+
             std::vector< EntitySerializeHelper > childEntities;
-            if( serializer.IsReading( ) )
+            auto name = Registry->try_get<Scene::Name>( Entity );
+            if( name != nullptr )
+                serializer.Serialize( "Name", *static_cast<std::string*>(name) );
+            auto uid = Registry->try_get<Scene::UID>( Entity );
+            if( uid != nullptr )
+                serializer.Serialize( "UID", *static_cast<vaGUID*>(uid) );
+
+            bool hasRelationship = Registry->any_of<Scene::Relationship>( Entity );
+            bool hasSkipChildren = Registry->any_of<Scene::SerializationSkipChildrenTag>( Entity );
+            if( hasRelationship )
             {
-                Entity = Registry->create( );
+                if( !hasSkipChildren )
+                {
+                    Scene::VisitChildren( *Registry, Entity, [&](entt::entity child) { if( !Registry->any_of<Scene::SerializationSkipTag>(child) ) childEntities.push_back( EntitySerializeHelper( SerializeArgs, Registry, child) ); } );
+                    std::reverse( childEntities.begin(), childEntities.end() ); // reverse because children get added in reverse so this preserves the original order
+                }
+                serializer.SerializeVector( "[ChildEntities]", childEntities, EntitySerializeHelper( SerializeArgs, Registry ) );
+            }
+
+            const int componentTypeCount = Scene::Components::TypeCount( );
+            for( int i = 0; i < componentTypeCount; i++ )
+            {
+                if( Scene::Components::HasSerialize( i ) && Scene::Components::Has( i, *Registry, Entity ) )
+                {
+                    const string & typeName = Scene::Components::TypeName(i);
+                    if( !serializer.Serialize( typeName, /*typeName*/"", [i, &r=*Registry, args = SerializeArgs, e=Entity]( vaSerializer & snode ) { return Scene::Components::Serialize( i, r, e, *args, snode ); } ) )
+                        { assert( false ); return false; }
+                }
+            }
+
+            return true;
+        }
+
+    };
+
+    // JSONLoad/JSONLoadSubtree in two phases:
+    //  * decode: the top level entities (each with all its children) are split into consecutive ranges and each range is
+    //    deserialized by a vaTF task into its own staging registry, with its own SerializeArgs; no scene state is touched
+    //  * commit: on the calling thread, range by range, entities get created in the scene registry in file order and their
+    //    components moved over (Components::Move), then the hierarchy gets connected; EntityReference-s are resolved through
+    //    the UIDRegistry once everything is in, like before (with UIDs remapped across all ranges when regenerating them).
+    // Entities end up created in the same order as when loading serially so the result doesn't depend on the thread count.
+    struct StagedSceneLoad
+    {
+        struct StagedEntity
+        {
+            entt::entity                    Entity;                 // in the staging registry
+            int                             Parent;                 // index into Chunk::Entities, -1 for top level
+            bool                            HasRelationship;        // had "[ChildEntities]" (even if empty)
+        };
+
+        struct Chunk
+        {
+            entt::registry                  Registry;
+            std::vector<StagedEntity>       Entities;               // depth-first, parents before their children
+            std::unordered_map< vaGUID, vaGUID, vaGUIDHasher >
+                                            UIDRemapping;
+            Scene::SerializeArgs            SerializeArgs;
+            bool                            Result                  = true;
+
+            Chunk( const Scene::UIDRegistry & uidRegistry, bool regenerateUIDs ) : SerializeArgs( uidRegistry, (regenerateUIDs)?(&UIDRemapping):(nullptr) ) { }
+        };
+
+        struct EntityHelper
+        {
+            StagedSceneLoad::Chunk *        Staging;
+            int                             Parent;
+
+            EntityHelper( StagedSceneLoad::Chunk * staging, int parent ) : Staging( staging ), Parent( parent ) { }
+
+            static const char * S_Type( )   { return ""; }          // same as EntitySerializeHelper
+
+            bool                S_Serialize( vaSerializer & serializer )
+            {
+                if( !serializer.IsReading( ) )
+                    { assert( false ); return false; }
+
+                entt::registry & registry = Staging->Registry;
+                const entt::entity entity = registry.create( );
+                const int index = (int)Staging->Entities.size( );
+                Staging->Entities.push_back( { entity, Parent, false } );
 
                 string name;
                 if( serializer.Serialize( "Name", name ) )
-                    Registry->emplace<Scene::Name>( Entity, name );
+                    registry.emplace<Scene::Name>( entity, name );
                 vaGUID uid;
                 if( serializer.Serialize( "UID", uid ) )
                 {
                     // change to new UIDs during loading
-                    if( SerializeArgs->UIDRemapper != nullptr )
+                    if( Staging->SerializeArgs.UIDRemapper != nullptr )
                     {
                         vaGUID newUID = vaGUID::Create();
-                        SerializeArgs->UIDRemapper->emplace( std::make_pair(uid, newUID) );
+                        Staging->SerializeArgs.UIDRemapper->emplace( std::make_pair(uid, newUID) );
                         uid = newUID;
                     }
-                    Registry->emplace<Scene::UID>( Entity, Scene::UID(uid) );
+                    registry.emplace<Scene::UID>( entity, Scene::UID(uid) );
                 }
 
                 const int componentTypeCount = Scene::Components::TypeCount( );
@@ -549,64 +631,163 @@ namespace Vanilla::Scene
                         const string & typeName = Scene::Components::TypeName(i);
                         if( serializer.Has( typeName ) )
                         {
-                            assert( !Scene::Components::Has( i, *Registry, Entity ) ); // <- this is fine actually due to reactive nature
-                            Scene::Components::EmplaceOrReplace( i, *Registry, Entity );
-                            if( !serializer.Serialize( typeName, /*typeName*/"", [i, &r=*Registry, args = SerializeArgs, e=Entity]( vaSerializer & snode ) { return Scene::Components::Serialize( i, r, e, *args, snode ); } ) )
+                            Scene::Components::EmplaceOrReplace( i, registry, entity );
+                            if( !serializer.Serialize( typeName, /*typeName*/"", [i, &registry, args = &Staging->SerializeArgs, entity]( vaSerializer & snode ) { return Scene::Components::Serialize( i, registry, entity, *args, snode ); } ) )
                             {  
                                 VA_WARN( "Error while trying to deserialize component name %s for entity name %s - skipping.", typeName.c_str(), name.c_str() );
-                                Scene::Components::Remove( i, *Registry, Entity );
+                                Scene::Components::Remove( i, registry, entity );
                             }
                         }
                     }
                 }
 
-                if( serializer.SerializeVector( "[ChildEntities]", childEntities, EntitySerializeHelper( SerializeArgs, Registry ) ) )
-                {
-                    Registry->emplace<Scene::Relationship>( Entity );
-                    for( int i = 0; i < childEntities.size( ); i++ )
-                        Scene::SetParent( *Registry, childEntities[i].Entity, Entity, false );
-                    Scene::SetTransformDirtyRecursiveUnsafe( *Registry, Entity );
-                }
+                std::vector< EntityHelper > childEntities;
+                if( serializer.SerializeVector( "[ChildEntities]", childEntities, EntityHelper( Staging, index ) ) )
+                    Staging->Entities[index].HasRelationship = true;
+                return true;
             }
-            else if( serializer.IsWriting( ) )
+        };
+
+        entt::registry &                    Registry;
+        Scene::UIDRegistry &                UIDRegistry;
+        const bool                          RegenerateUIDs;
+        std::vector<entt::entity>           TopLevelEntities;
+        int                                 TotalCount              = 0;
+        std::vector<std::pair<Scene::EntityReference *, Scene::UID>>
+                                            LoadedReferences;
+        std::unordered_map< vaGUID, vaGUID, vaGUIDHasher >
+                                            UIDRemapping;
+
+        StagedSceneLoad( entt::registry & registry, bool regenerateUIDs ) : Registry( registry ), UIDRegistry( registry.ctx<Scene::UIDRegistry>() ), RegenerateUIDs( regenerateUIDs ) { }
+
+        // Decodes and commits 'items' (nodes from vaSerializer::ReadVectorItems); false if any failed to decode, but whatever
+        // did decode is still committed (like the serial load would leave it)
+        bool                                Load( std::vector<vaSerializer> & items, bool parallel )
+        {
+            VA_TRACE_CPU_SCOPE( SceneLoad );
+            if( items.size( ) == 0 )
+                return true;
+
+            // a few ranges per worker for balancing as top level subtrees can differ in size a lot
+            const int itemCount     = (int)items.size( );
+            const int chunkCount    = ( parallel ) ? ( std::min( itemCount, vaTF::ThreadCount( ) * 4 ) ) : ( 1 );
+            std::vector<std::unique_ptr<Chunk>> chunks( chunkCount );
+
+            // entt hands out type IDs on first use and that isn't thread-safe, so the first staging registry gets created
+            // here, with storage for everything the decode can emplace
+            chunks[0] = std::make_unique<Chunk>( UIDRegistry, RegenerateUIDs );
+            chunks[0]->Registry.reserve<Scene::Name, Scene::UID>( 0 );
+            const int componentTypeCount = Scene::Components::TypeCount( );
+            for( int t = 0; t < componentTypeCount; t++ )
+                if( Scene::Components::HasSerialize( t ) )
+                    Scene::Components::EmplaceOrReplaceBulk( t, chunks[0]->Registry, nullptr, nullptr );
+
+            auto decodeChunk = [&]( int chunkIndex )
             {
-                auto name = Registry->try_get<Scene::Name>( Entity );
-                if( name != nullptr )
-                    serializer.Serialize( "Name", *static_cast<std::string*>(name) );
-                auto uid = Registry->try_get<Scene::UID>( Entity );
-                if( uid != nullptr )
-                    serializer.Serialize( "UID", *static_cast<vaGUID*>(uid) );
-
-                bool hasRelationship = Registry->any_of<Scene::Relationship>( Entity );
-                bool hasSkipChildren = Registry->any_of<Scene::SerializationSkipChildrenTag>( Entity );
-                if( hasRelationship )
+                VA_TRACE_CPU_SCOPE( SceneLoadDecode );
+                if( chunks[chunkIndex] == nullptr )
+                    chunks[chunkIndex] = std::make_unique<Chunk>( UIDRegistry, RegenerateUIDs );
+                Chunk & chunk = *chunks[chunkIndex];
+                const int first = (int)( (int64)itemCount * chunkIndex / chunkCount );
+                const int last  = (int)( (int64)itemCount * ( chunkIndex + 1 ) / chunkCount );
+                for( int i = first; i < last; i++ )
                 {
-                    if( !hasSkipChildren )
-                    {
-                        Scene::VisitChildren( *Registry, Entity, [&](entt::entity child) { if( !Registry->any_of<Scene::SerializationSkipTag>(child) ) childEntities.push_back( EntitySerializeHelper( SerializeArgs, Registry, child) ); } );
-                        std::reverse( childEntities.begin(), childEntities.end() ); // reverse because children get added in reverse so this preserves the original order
-                    }
-                    serializer.SerializeVector( "[ChildEntities]", childEntities, EntitySerializeHelper( SerializeArgs, Registry ) );
+                    EntityHelper helper( &chunk, -1 );
+                    if( !helper.S_Serialize( items[i] ) )
+                        { assert( false ); chunk.Result = false; }
                 }
+            };
+            if( chunkCount == 1 )
+                decodeChunk( 0 );
+            else
+                vaTF::parallel_for( 0, chunkCount, decodeChunk, 1, "SceneLoadDecode" ).wait( );
 
-                const int componentTypeCount = Scene::Components::TypeCount( );
-                for( int i = 0; i < componentTypeCount; i++ )
+            bool retVal = true;
+            for( std::unique_ptr<Chunk> & chunk : chunks )
+            {
+                retVal &= chunk->Result;
+                Commit( *chunk );
+                chunk = nullptr;
+            }
+            return retVal;
+        }
+
+        void                                Commit( Chunk & chunk )
+        {
+            VA_TRACE_CPU_SCOPE( SceneLoadCommit );
+
+            // references were recorded as pointers into the staging registry; ListReferences before and after the move
+            // gives where each one ended up
+            std::unordered_map< Scene::EntityReference *, Scene::UID > stagedReferences( chunk.SerializeArgs.LoadedReferences.begin( ), chunk.SerializeArgs.LoadedReferences.end( ) );
+            std::vector<Scene::EntityReference*> stagedList, committedList;
+            size_t foundReferences = 0;
+
+            std::vector<entt::entity> committed( chunk.Entities.size( ) );
+            const int componentTypeCount = Scene::Components::TypeCount( );
+            for( size_t i = 0; i < chunk.Entities.size( ); i++ )
+            {
+                const StagedEntity & staged = chunk.Entities[i];
+                const entt::entity entity = committed[i] = Registry.create( );
+
+                stagedList.clear( );
+                if( !stagedReferences.empty( ) )
+                    Scene::ListReferences( chunk.Registry, staged.Entity, stagedList );
+
+                if( Scene::Name * name = chunk.Registry.try_get<Scene::Name>( staged.Entity ); name != nullptr )
+                    Registry.emplace<Scene::Name>( entity, std::move( *name ) );
+                if( const Scene::UID * uid = chunk.Registry.try_get<Scene::UID>( staged.Entity ); uid != nullptr )
+                    Registry.emplace<Scene::UID>( entity, *uid );
+                for( int t = 0; t < componentTypeCount; t++ )
+                    if( Scene::Components::HasSerialize( t ) && Scene::Components::Has( t, chunk.Registry, staged.Entity ) )
+                        Scene::Components::Move( t, chunk.Registry, staged.Entity, Registry, entity );
+                if( staged.HasRelationship )
+                    Registry.emplace<Scene::Relationship>( entity );
+
+                if( !stagedList.empty( ) )
                 {
-                    if( Scene::Components::HasSerialize( i ) && Scene::Components::Has( i, *Registry, Entity ) )
+                    committedList.clear( );
+                    Scene::ListReferences( Registry, entity, committedList );
+                    assert( committedList.size( ) == stagedList.size( ) );
+                    for( size_t r = 0; r < stagedList.size( ) && r < committedList.size( ); r++ )
                     {
-                        const string & typeName = Scene::Components::TypeName(i);
-                        if( !serializer.Serialize( typeName, /*typeName*/"", [i, &r=*Registry, args = SerializeArgs, e=Entity]( vaSerializer & snode ) { return Scene::Components::Serialize( i, r, e, *args, snode ); } ) )
-                            { assert( false ); return false; }
+                        auto it = stagedReferences.find( stagedList[r] );
+                        if( it == stagedReferences.end( ) )
+                            continue;
+                        LoadedReferences.push_back( { committedList[r], it->second } );
+                        foundReferences++;
                     }
                 }
-            }
-            else
-                { assert( false ); return false; }
-
 
-            return true;
+                if( staged.Parent == -1 )
+                    TopLevelEntities.push_back( entity );
+            }
+            // if this fires, a component that uses EntityReference most likely doesn't implement ListReferences
+            assert( foundReferences == stagedReferences.size( ) );
+
+            // same SetParent order as the serial load had: each parent's children in file order
+            for( size_t i = 0; i < chunk.Entities.size( ); i++ )
+                if( chunk.Entities[i].Parent != -1 )
+                    Scene::SetParent( Registry, committed[i], committed[chunk.Entities[i].Parent], false );
+            for( size_t i = 0; i < chunk.Entities.size( ); i++ )
+                if( chunk.Entities[i].HasRelationship )
+                    Scene::SetTransformDirtyRecursiveUnsafe( Registry, committed[i] );
+
+            UIDRemapping.insert( chunk.UIDRemapping.begin( ), chunk.UIDRemapping.end( ) );
+            TotalCount += (int)chunk.Entities.size( );
         }
 
+        // connect references (and update to remapped UIDs) - only after all chunks are in as they can point anywhere
+        void                                ResolveReferences( )
+        {
+            for( const std::pair<Scene::EntityReference *, Scene::UID> & loadedReference : LoadedReferences )
+            {
+                vaGUID referenceID = loadedReference.second;
+                auto it = UIDRemapping.find( referenceID );
+                if( it != UIDRemapping.end( ) )
+                    referenceID = it->second;
+                (*loadedReference.first) = Scene::EntityReference( UIDRegistry, referenceID );
+            }
+        }
     };
 }
 
@@ -647,10 +828,12 @@ string Scene::JSONSaveSubtree( entt::registry & registry, entt::entity entity )
     { assert( false ); return ""; }
 }
 
-bool Scene::JSONSave( entt::registry & registry, const string & filePath, std::function<bool( entt::entity entity )> filter )
+bool Scene::JSONSave( entt::registry & registry, const string & filePath, std::function<bool( entt::entity entity )> filter, bool streaming )
 {
     registry; filter;
-    vaSerializer serializer = vaSerializer::OpenWrite( "VanillaScene" );
+    vaSerializer serializer = ( streaming ) ? ( vaSerializer::OpenWriteStream( filePath, "VanillaScene" ) ) : ( vaSerializer::OpenWrite( "VanillaScene" ) );
+    if( !serializer.IsWriting( ) )
+        return false;
 
     bool retVal = true;
 
@@ -673,7 +856,11 @@ bool Scene::JSONSave( entt::registry & registry, const string & filePath, std::f
     retVal &= serializer.SerializeVector( "ROOT", rootEntities, EntitySerializeHelper( &serializeArgs, &registry ) );
     retVal &= serializer.SerializeVector( "UNROOT", unrootEntities, EntitySerializeHelper( &serializeArgs, &registry ) );
     
-    retVal &= serializer.Write( filePath );
+    // (streaming: on failure the file is left as it was)
+    if( streaming )
+        retVal = serializer.Close( retVal );
+    else
+        retVal &= serializer.Write( filePath );
 
     assert( retVal );
     
@@ -682,56 +869,34 @@ bool Scene::JSONSave( entt::registry & registry, const string & filePath, std::f
 
 int Scene::JSONLoadSubtree( const string & jsonData, entt::registry & registry, entt::entity parentEntity, bool regenerateUIDs )
 {
-    jsonData; registry; regenerateUIDs;
-
     vaSerializer serializer = vaSerializer::OpenReadString( jsonData );
     if( !serializer.IsReading( ) )
         return -1;
 
-    std::unordered_map< vaGUID, vaGUID, vaGUIDHasher > UIDRemapping;
-
     assert( regenerateUIDs ); // <- never tested without this, I'm not sure it will work
-    SerializeArgs serializeArgs( registry.ctx<Scene::UIDRegistry>(), (regenerateUIDs)?(&UIDRemapping):(nullptr) );
 
-    bool retVal = true;
-
-    std::vector< EntitySerializeHelper > subtreeEntities;
-    retVal &= serializer.SerializeVector( c_JSONSubtreeID, subtreeEntities, EntitySerializeHelper( &serializeArgs, &registry ) );
+    std::vector<vaSerializer> subtreeItems;
+    if( !serializer.ReadVectorItems( c_JSONSubtreeID, subtreeItems ) )
+        return -1;
 
-    if( !retVal )
+    StagedSceneLoad load( registry, regenerateUIDs );
+    if( !load.Load( subtreeItems, true ) )
     {
         assert( false ); // TODO: gracefully exit and cleanup all currently loaded entities
         return -1;
     }
+    load.ResolveReferences( );
 
-    // connect references and update to remapped UID
-    assert( serializeArgs.UIDRemapper != nullptr );
-    for( int i = 0; i < serializeArgs.LoadedReferences.size( ); i++ )
-    {
-        vaGUID referenceID = serializeArgs.LoadedReferences[i].second;
-        if( serializeArgs.UIDRemapper != nullptr )
-        {
-            auto it = serializeArgs.UIDRemapper->find( serializeArgs.LoadedReferences[i].second );
-            if( it != serializeArgs.UIDRemapper->end() )
-                referenceID = it->second;
-        }
-        (*serializeArgs.LoadedReferences[i].first) = Scene::EntityReference( serializeArgs.UIDRegistry, referenceID );
-    }
+    if( parentEntity != entt::null )
+        for( entt::entity loadedEntity : load.TopLevelEntities )
+            Scene::SetParent( registry, loadedEntity, parentEntity, false );
 
-    int totalCount = 0;
-    for( EntitySerializeHelper & loadedEntity : subtreeEntities )
-    {
-        if( parentEntity != entt::null )
-            Scene::SetParent( registry, loadedEntity.Entity, parentEntity, false );
-        totalCount += 1 + Scene::CountChildren( registry, loadedEntity.Entity, true );
-    }
-
-    return totalCount;
+    return load.TotalCount;
 }
 
-bool Scene::JSONLoad( entt::registry & registry, const string & filePath )
+bool Scene::JSONLoad( entt::registry & registry, const string & filePath, bool streaming, bool parallel )
 {
-    vaSerializer serializer = vaSerializer::OpenReadFile( filePath, "VanillaScene" );
+    vaSerializer serializer = ( streaming ) ? ( vaSerializer::OpenReadStream( filePath, "VanillaScene" ) ) : ( vaSerializer::OpenReadFile( filePath, "VanillaScene" ) );
 
     if( !serializer.IsReading( ) )
     {
@@ -739,43 +904,23 @@ bool Scene::JSONLoad( entt::registry & registry, const string & filePath )
         return false;
     }
 
-    SerializeArgs serializeArgs( registry.ctx<Scene::UIDRegistry>() );
-
     // should sanitize name after this
     serializer.Serialize<string>( "Name", registry.ctx<Scene::Name>( ), "UnnamedScene" );
 
     bool retVal = true;
 
-    std::vector< EntitySerializeHelper > rootEntities, unrootEntities;
-    retVal &= serializer.SerializeVector( "ROOT", rootEntities, EntitySerializeHelper( &serializeArgs, &registry ) );
-    retVal &= serializer.SerializeVector( "UNROOT", unrootEntities, EntitySerializeHelper( &serializeArgs, &registry ) );
-
-    // connect references
-    assert( serializeArgs.UIDRemapper == nullptr );
-    for( int i = 0; i < serializeArgs.LoadedReferences.size( ); i++ )
-        (*serializeArgs.LoadedReferences[i].first) = Scene::EntityReference( serializeArgs.UIDRegistry, serializeArgs.LoadedReferences[i].second );
-
-#ifdef _DEBUG
-    // validate 'ListReferences' coverage
-    std::unordered_set<Scene::EntityReference*> referenceSet;
-    // go through all entities
-    registry.each( [ & ]( entt::entity entity ) 
-    { 
-        std::vector<Scene::EntityReference*> referenceList;
-        Scene::ListReferences( registry, entity, referenceList );
-        for( Scene::EntityReference * ref : referenceList )
-        {
-            auto ret = referenceSet.emplace( ref );
-            assert( ret.second );   // if this fires, 
-        }
-    } );
-    // now we should have a list of all EntityReference-s used by our components, let's make sure the ones we just serialized are in
-    for( std::pair<class EntityReference *, UID> & loadedRef : serializeArgs.LoadedReferences )
-    {
-        // this most likely means you forgot to add ListReferences to your component that uses EntityReference
-        assert( referenceSet.find( loadedRef.first ) != referenceSet.end() );
-    }
-#endif
+    // one batch so the ranges get balanced across both
+    std::vector<vaSerializer> rootItems, unrootItems;
+    retVal &= serializer.ReadVectorItems( "ROOT", rootItems );
+    retVal &= serializer.ReadVectorItems( "UNROOT", unrootItems );
+    rootItems.reserve( rootItems.size( ) + unrootItems.size( ) );
+    for( vaSerializer & item : unrootItems )
+        rootItems.push_back( std::move( item ) );
+    unrootItems.clear( );
+
+    StagedSceneLoad load( registry, false );
+    retVal &= load.Load( rootItems, parallel );
+    load.ResolveReferences( );
     
     assert( retVal );
     
@@ -62,14 +62,28 @@ namespace Vanilla
         void                        SetTransformDirtyRecursiveUnsafe( entt::registry & registry, entt::entity entity );     // same as SetTransformDirtyRecursive but does not check for relationship
 
         // Load/Save to JSON format using a hierarchical representation; entities can be skipped by returning false from the 'filter', but it will also skip their children.
-        bool                        JSONSave( entt::registry & registry, const string & filePath, std::function<bool( entt::entity entity )> filter = nullptr );
-        bool                        JSONLoad( entt::registry & registry, const string & filePath );
-
-        // Load/Save a subtree to JSON format using a hierarchical representation
+        // By default these go through the streaming vaSerializer modes (OpenReadStream/OpenWriteStream) so the whole JSON tree
+        // never exists in memory; 'streaming = false' builds it like before (same content, keys sorted).
+        // Loading decodes the root entities (with their children) on vaTF worker threads into staging registries and then
+        // commits them to 'registry' on the calling thread, in file order, so the result is the same as with 'parallel = false'.
+        bool                        JSONSave( entt::registry & registry, const string & filePath, std::function<bool( entt::entity entity )> filter = nullptr, bool streaming = true );
+        bool                        JSONLoad( entt::registry & registry, const string & filePath, bool streaming = true, bool parallel = true );
+
+        // Load/Save a subtree to JSON format using a hierarchical representation (loading works the same as JSONLoad)
         string                      JSONSaveSubtree( entt::registry & registry, entt::entity entity );
         int                         JSONLoadSubtree( const string & jsonData, entt::registry & registry, entt::entity parentEntity, bool regenerateUIDs = true );
         // Test whether a text looks like a subtree JSON format
         bool                        JSONIsSubtree( const char * text );
+
+        // Same content as JSONSave/JSONLoad in a compact binary format (components still go through their Serialize) that loads
+        // several times faster from a memory mapped file and without building the whole JSON tree; see vaSceneBinaryIO.cpp.
+        bool                        BinarySave( entt::registry & registry, const string & filePath );
+        bool                        BinaryLoad( entt::registry & registry, const string & filePath );
+        bool                        BinaryIsSceneFile( const string & filePath );
+        // Lossless conversion between the JSON and binary formats; works on files directly (no registry involved) so it also
+        // keeps components that aren't registered
+        bool                        BinaryFromJSON( const string & jsonFilePath, const string & binaryFilePath );
+        bool                        BinaryToJSON( const string & binaryFilePath, const string & jsonFilePath );
         // Name helpers
         const string &              GetName( const entt::registry & registry, entt::entity entity );
         string                      GetNameAndID( const entt::registry & registry, entt::entity entity );
@@ -0,0 +1,222 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "vaSceneTransformHierarchy.h"
+
+#include "vaSceneSystems.h"
+
+#include "Core/vaProfiler.h"
+
+#include <xmmintrin.h>
+
+using namespace Vanilla;
+
+namespace
+{
+    // same as vaMatrix4x4::Multiply( a, b ) (and with the same order of operations, so bit-exact), one row per SSE register
+    inline void MultiplySIMD( const vaMatrix4x4 & a, const vaMatrix4x4 & b, vaMatrix4x4 & out )
+    {
+        const __m128 b0 = _mm_loadu_ps( &b.m[0][0] );
+        const __m128 b1 = _mm_loadu_ps( &b.m[1][0] );
+        const __m128 b2 = _mm_loadu_ps( &b.m[2][0] );
+        const __m128 b3 = _mm_loadu_ps( &b.m[3][0] );
+        for( int i = 0; i < 4; i++ )
+        {
+            __m128 row =              _mm_mul_ps( _mm_set1_ps( a.m[i][0] ), b0 );
+            row = _mm_add_ps( row,    _mm_mul_ps( _mm_set1_ps( a.m[i][1] ), b1 ) );
+            row = _mm_add_ps( row,    _mm_mul_ps( _mm_set1_ps( a.m[i][2] ), b2 ) );
+            row = _mm_add_ps( row,    _mm_mul_ps( _mm_set1_ps( a.m[i][3] ), b3 ) );
+            _mm_storeu_ps( &out.m[i][0], row );
+        }
+    }
+
+    inline void AtomicMin( std::atomic<uint32> & target, uint32 value )
+    {
+        uint32 prev = target.load( std::memory_order_relaxed );
+        while( value < prev && !target.compare_exchange_weak( prev, value, std::memory_order_relaxed ) ) { }
+    }
+    inline void AtomicMax( std::atomic<uint32> & target, uint32 value )
+    {
+        uint32 prev = target.load( std::memory_order_relaxed );
+        while( value > prev && !target.compare_exchange_weak( prev, value, std::memory_order_relaxed ) ) { }
+    }
+}
+
+vaSceneTransformHierarchy::vaSceneTransformHierarchy( )
+{
+    Clear( );
+}
+
+void vaSceneTransformHierarchy::Clear( )
+{
+    m_entities.clear( );
+    m_parents.clear( );
+    m_relationshipParents.clear( );
+    m_depths.clear( );
+    m_hasBounds.clear( );
+    m_dirty.clear( );
+    m_local.clear( );
+    m_world.clear( );
+    m_entityToIndex.clear( );
+    for( int depth = 0; depth <= c_MaxDepthLevels; depth++ )
+        m_levelBegin[depth] = 0;
+    EndUpdate( );
+    Invalidate( );
+}
+
+void vaSceneTransformHierarchy::Rebuild( const entt::registry & registry )
+{
+    VA_TRACE_CPU_SCOPE( TransformHierarchyRebuild );
+
+    // bucket by depth first; level 0 stays in registry order, deeper levels get sorted by their parent's flat index
+    std::vector<std::pair<int32, entt::entity>> levels[c_MaxDepthLevels];
+    size_t maxEntityIndex = 0;
+    registry.view<const Scene::Relationship, const Scene::TransformLocal, const Scene::TransformWorld>( ).each( [ & ]( entt::entity entity, const Scene::Relationship & relationship, const Scene::TransformLocal &, const Scene::TransformWorld & )
+    {
+        assert( relationship.Depth >= 0 && relationship.Depth < c_MaxDepthLevels );
+        levels[relationship.Depth].push_back( { -1, entity } );
+        maxEntityIndex = std::max( maxEntityIndex, (size_t)entt::entt_traits<entt::entity>::to_entity( entity ) );
+    } );
+
+    m_entities.clear( );
+    m_parents.clear( );
+    m_relationshipParents.clear( );
+    m_depths.clear( );
+    m_hasBounds.clear( );
+    m_entityToIndex.assign( maxEntityIndex + 1, -1 );
+    for( int depth = 0; depth < c_MaxDepthLevels; depth++ )
+    {
+        auto & level = levels[depth];
+        for( auto & item : level )
+        {
+            const Scene::Relationship & relationship = registry.get<Scene::Relationship>( item.second );
+            if( relationship.Parent != entt::null && !registry.any_of<Scene::TransformLocalIsWorldTag>( item.second ) )
+            {
+                item.first = FindIndex( relationship.Parent );
+                assert( item.first >= 0 );  // parent without transforms?
+            }
+        }
+        std::stable_sort( level.begin( ), level.end( ), [ ]( const auto & a, const auto & b ) { return a.first < b.first; } );
+
+        m_levelBegin[depth] = (uint32)m_entities.size( );
+        for( const auto & item : level )
+        {
+            m_entityToIndex[(size_t)entt::entt_traits<entt::entity>::to_entity( item.second )] = (int32)m_entities.size( );
+            m_entities.push_back( item.second );
+            m_parents.push_back( item.first );
+            m_relationshipParents.push_back( registry.get<Scene::Relationship>( item.second ).Parent );
+            m_depths.push_back( (uint8)depth );
+            m_hasBounds.push_back( registry.any_of<Scene::WorldBounds>( item.second ) ? 1 : 0 );
+        }
+    }
+    m_levelBegin[c_MaxDepthLevels] = (uint32)m_entities.size( );
+
+    const size_t count = m_entities.size( );
+    m_local.resize( count );
+    m_world.resize( count );
+    m_dirty.assign( count, 1 );
+    for( size_t i = 0; i < count; i++ )
+    {
+        m_local[i] = registry.get<Scene::TransformLocal>( m_entities[i] );
+        m_world[i] = registry.get<Scene::TransformWorld>( m_entities[i] );
+    }
+
+    for( int depth = 0; depth < c_MaxDepthLevels; depth++ )
+    {
+        m_dirtyBegin[depth].store( m_levelBegin[depth], std::memory_order_relaxed );
+        m_dirtyEnd[depth].store( m_levelBegin[depth+1], std::memory_order_relaxed );
+    }
+
+    m_structureChanged.store( false, std::memory_order_relaxed );
+}
+
+bool vaSceneTransformHierarchy::MarkDirty( const entt::registry & registry, entt::entity entity, DirtyRanges & ranges )
+{
+    if( NeedsRebuild( ) )
+        return false;
+
+    const int32 index = FindIndex( entity );
+    if( index < 0 )
+    {
+        Invalidate( );
+        return false;
+    }
+
+    const Scene::Relationship & relationship = registry.get<Scene::Relationship>( entity );
+    if( relationship.Depth != (int32)m_depths[index] || relationship.Parent != m_relationshipParents[index] )
+    {
+        Invalidate( );
+        return false;
+    }
+
+    m_local[index]  = registry.get<Scene::TransformLocal>( entity );
+    m_dirty[index]  = 1;
+    ranges.Add( relationship.Depth, (uint32)index );
+    return true;
+}
+
+void vaSceneTransformHierarchy::MergeDirtyRanges( const DirtyRanges & ranges )
+{
+    for( int depth = 0; depth < c_MaxDepthLevels; depth++ )
+    {
+        if( ranges.Begin[depth] >= ranges.End[depth] )
+            continue;
+        AtomicMin( m_dirtyBegin[depth], ranges.Begin[depth] );
+        AtomicMax( m_dirtyEnd[depth], ranges.End[depth] );
+    }
+}
+
+std::pair<uint32, uint32> vaSceneTransformHierarchy::DirtyRange( int depth ) const
+{
+    assert( depth >= 0 && depth < c_MaxDepthLevels );
+    const uint32 begin  = m_dirtyBegin[depth].load( std::memory_order_relaxed );
+    const uint32 end    = m_dirtyEnd[depth].load( std::memory_order_relaxed );
+    return ( begin < end ) ? ( std::make_pair( begin, end ) ) : ( std::make_pair( 0u, 0u ) );
+}
+
+void vaSceneTransformHierarchy::Update( entt::registry & registry, uint32 begin, uint32 end, Scene::UniqueStaticAppendConsumeList & outBoundsDirtyList )
+{
+    assert( end <= Count( ) );
+    for( uint32 i = begin; i < end; i++ )
+    {
+        if( !m_dirty[i] )
+            continue;
+        m_dirty[i] = 0;
+
+        vaMatrix4x4 newWorld;
+        const int32 parent = m_parents[i];
+        if( parent < 0 )
+            newWorld = m_local[i];
+        else
+        {
+            assert( (uint32)parent < i );
+            MultiplySIMD( m_local[i], m_world[parent], newWorld );
+        }
+
+        // update only if different
+        if( newWorld != m_world[i] )
+        {
+            m_world[i] = newWorld;
+            const entt::entity entity = m_entities[i];
+            registry.get<Scene::TransformWorld>( entity ) = newWorld;
+            if( m_hasBounds[i] )
+                outBoundsDirtyList.Append( entity );
+        }
+    }
+}
+
+void vaSceneTransformHierarchy::EndUpdate( )
+{
+    for( int depth = 0; depth < c_MaxDepthLevels; depth++ )
+    {
+        m_dirtyBegin[depth].store( std::numeric_limits<uint32>::max( ), std::memory_order_relaxed );
+        m_dirtyEnd[depth].store( 0, std::memory_order_relaxed );
+    }
+}
@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2016-2021, Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Author(s):  Filip Strugar (filip.strugar@intel.com)
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Core/vaCoreIncludes.h"
+
+#include "IntegratedExternals/vaEnTTIntegration.h"
+
+#include "vaSceneComponents.h"
+
+namespace Vanilla
+{
+    namespace Scene { class UniqueStaticAppendConsumeList; }
+
+    // Flat copy of the transform hierarchy (Scene::TransformLocal -> Scene::TransformWorld), as an alternative to updating it
+    // through the registry with Scene::UpdateTransforms.
+    // * items are sorted by Relationship::Depth (each depth level is one contiguous range) and, within a level, by parent, so
+    //   siblings are next to each other and parents are always at lower indices
+    // * locals, worlds, parent indices and dirty flags are separate arrays; the world transform of the parent is read from the
+    //   flat array instead of the registry
+    // * a dirty entity's TransformLocal is copied in (MarkDirty), then each level's dirty range is updated with SIMD matrix
+    //   multiplies (Update) and only worlds that actually changed are written back to Scene::TransformWorld
+    // The structure is validated on every MarkDirty (any parent change dirties the affected transforms) and rebuilt from the
+    // registry when it no longer matches. Whoever owns it must also call Invalidate when TransformWorld is destroyed and when
+    // TransformLocalIsWorldTag or WorldBounds are added or removed (vaScene does this through registry callbacks).
+    // MarkDirty and Update on different items can run concurrently; everything else is single threaded.
+    class vaSceneTransformHierarchy
+    {
+    public:
+        static constexpr int                c_MaxDepthLevels    = Scene::Relationship::c_MaxDepthLevels;
+
+        // dirty [Begin, End) flat index range per depth level; collect locally (per chunk of work) and merge with MergeDirtyRanges
+        struct DirtyRanges
+        {
+            uint32                          Begin[c_MaxDepthLevels];
+            uint32                          End[c_MaxDepthLevels];
+
+            DirtyRanges( )                  { Reset( ); }
+            void                            Reset( )            { for( int i = 0; i < c_MaxDepthLevels; i++ ) { Begin[i] = std::numeric_limits<uint32>::max( ); End[i] = 0; } }
+            void                            Add( int depth, uint32 index )  { Begin[depth] = std::min( Begin[depth], index ); End[depth] = std::max( End[depth], index + 1 ); }
+        };
+
+    private:
+        std::vector<entt::entity>           m_entities;
+        std::vector<int32>                  m_parents;          // flat index of the parent, -1 for roots and Scene::TransformLocalIsWorldTag
+        std::vector<entt::entity>           m_relationshipParents;  // Relationship::Parent at the time of the rebuild, for validation
+        std::vector<uint8>                  m_depths;
+        std::vector<uint8>                  m_hasBounds;        // has Scene::WorldBounds
+        std::vector<uint8>                  m_dirty;
+        std::vector<vaMatrix4x4>            m_local;
+        std::vector<vaMatrix4x4>            m_world;
+        std::vector<int32>                  m_entityToIndex;    // entity index (entt::entt_traits::to_entity) -> flat index, -1 if none
+
+        uint32                              m_levelBegin[c_MaxDepthLevels+1];
+        std::atomic<uint32>                 m_dirtyBegin[c_MaxDepthLevels];
+        std::atomic<uint32>                 m_dirtyEnd[c_MaxDepthLevels];
+
+        std::atomic_bool                    m_structureChanged  = true;
+
+    public:
+        vaSceneTransformHierarchy( );
+
+        // structure has to be rebuilt before the next update
+        void                                Invalidate( )                           { m_structureChanged.store( true, std::memory_order_relaxed ); }
+        bool                                NeedsRebuild( ) const                   { return m_structureChanged.load( std::memory_order_relaxed ); }
+
+        void                                Clear( );
+        uint32                              Count( ) const                          { return (uint32)m_entities.size( ); }
+
+        // Rebuilds from all entities with Relationship, TransformLocal and TransformWorld; everything is marked dirty
+        void                                Rebuild( const entt::registry & registry );
+
+        // Copies the entity's TransformLocal in and flags it dirty. Returns false (and invalidates) if the entity is not in the
+        // flat storage or its parent or depth no longer match - Rebuild picks it up in that case.
+        bool                                MarkDirty( const entt::registry & registry, entt::entity entity, DirtyRanges & ranges );
+        void                                MergeDirtyRanges( const DirtyRanges & ranges );
+
+        // [begin, end) range to Update for the depth level - everything dirty is inside of it
+        std::pair<uint32, uint32>           DirtyRange( int depth ) const;
+
+        // Computes world transforms of dirty items in [begin, end); all lower depth levels must be up to date. Changed worlds are
+        // written to Scene::TransformWorld, and if the entity has Scene::WorldBounds, it gets appended to outBoundsDirtyList.
+        void                                Update( entt::registry & registry, uint32 begin, uint32 end, Scene::UniqueStaticAppendConsumeList & outBoundsDirtyList );
+
+        // after all levels were updated
+        void                                EndUpdate( );
+
+        // flat world transform of the entity, nullptr if not in the storage
+        const vaMatrix4x4 *                 FindWorld( entt::entity entity ) const  { const int32 index = FindIndex( entity ); return ( index < 0 ) ? ( nullptr ) : ( &m_world[index] ); }
+
+    private:
+        int32                               FindIndex( entt::entity entity ) const
+        {
+            const size_t entityIndex = (size_t)entt::entt_traits<entt::entity>::to_entity( entity );
+            if( entityIndex >= m_entityToIndex.size( ) )
+                return -1;
+            const int32 index = m_entityToIndex[entityIndex];
+            return ( index >= 0 && m_entities[index] == entity ) ? ( index ) : ( -1 );
+        }
+    };
+}